@@ -301,6 +301,138 @@ extern "C" {
     "\r\n%s"
 #endif
 
+/**
+ * @brief Number of chunk buffers for the storage writer thread.
+ *
+ * When non-zero, FLASH writes are done by a separate thread while the next
+ * chunk is received. Each buffer uses CY_OTA_CHUNK_SIZE bytes of RAM.
+ * Use 0 to write from the receiving thread.
+ */
+#define CY_OTA_WRITER_NUM_BUFFERS               (0)             /* Write from the receiving thread. */
+
+/**
+ * @brief Accept compressed OTA Images.
+ *
+ * Set to 1 to decompress OTA Images made with scripts/ota_compress.py as they
+ * are downloaded. Uses (1 << CY_OTA_DECOMPRESS_WINDOW_BITS) bytes of RAM.
+ */
+#define CY_OTA_DECOMPRESS                       (0)             /* Uncompressed OTA Images only. */
+
+/**
+ * @brief Accept delta patches.
+ *
+ * Set to 1 to apply patches made with scripts/ota_delta.py from the image in
+ * the Primary Slot. Uses CY_OTA_DELTA_BUFFER_SIZE bytes of RAM.
+ */
+#define CY_OTA_DELTA                            (0)             /* Full OTA Images only. */
+
+/**
+ * @brief Keep a download progress journal in FLASH.
+ *
+ * Set to 1 to continue an interrupted download of the same image from the
+ * last recorded offset. The last CY_OTA_JOURNAL_OFFSET_FROM_END bytes of the
+ * Secondary Slot are then not available for the OTA Image.
+ */
+#define CY_OTA_JOURNAL                          (0)             /* No journal. */
+
+/**
+ * @brief Erase the Secondary Slot as it is written.
+ *
+ * Set to 1 to erase each sector just before the first write into it instead of
+ * erasing the whole slot before the download. Set CY_OTA_ERASE_SECTOR_SIZE to
+ * the erase size of the FLASH.
+ */
+#define CY_OTA_LAZY_ERASE                       (0)             /* Erase the whole slot at storage open. */
+
+/**
+ * @brief Sectors to erase ahead of the download with CY_OTA_LAZY_ERASE.
+ *
+ * Set to 1 or more to erase sectors in a separate thread while the next data is
+ * received. 2 covers a chunk arriving during an erase on large sector FLASH.
+ */
+#define CY_OTA_ERASE_AHEAD_SECTORS              (0)             /* Erase in the writer. */
+
+/**
+ * @brief Check the MCUboot image hash before the boot magic is written.
+ *
+ * The hash is computed while the image is written, verify only reads the TLV area.
+ * Set CY_OTA_IMAGE_SIGNATURE to 1 to also check the ECDSA P-256 signature,
+ * the application provides ecdsa_pub_key[] and ecdsa_pub_key_len.
+ */
+#define CY_OTA_IMAGE_HASH                       (0)             /* Bootloader checks the image. */
+#define CY_OTA_IMAGE_SIGNATURE                  (0)             /* Hash only. */
+
+/**
+ * @brief Reuse unchanged blocks of the image in the Primary Slot.
+ *
+ * Set to 1 to download only the blocks that changed when the HTTP Job document
+ * names a "Manifest" made by scripts/ota_blocks.py.
+ */
+#define CY_OTA_BLOCK_REUSE                      (0)             /* Download all blocks. */
+
+/**
+ * @brief FW Data Block in external FLASH can be read in place (XIP).
+ *
+ * Set to 1 when SMIF is in memory mapped mode while the BT FW Patch is loaded,
+ * to use cy_ota_fwdb_get_bt_fw_mapped() with external FLASH.
+ */
+#define CY_OTA_FWDB_XIP                         (0)             /* Copy from external FLASH. */
+
+/**
+ * @brief State timing histograms, see cy_ota_get_stats().
+ *
+ * Bucket n counts the state times below CY_OTA_STATS_BUCKET_MS << n milliseconds.
+ */
+#define CY_OTA_STATS_BUCKETS                    (12)
+#define CY_OTA_STATS_BUCKET_MS                  (16)            /* 16 ms to 16 seconds. */
+
+/**********************************************************************
+ * HTTP Defines
+ **********************************************************************/
+
+/**
+ * @brief Number of HTTP range requests kept in flight on one connection.
+ *
+ * Larger values wait for fewer round trips to the server, at the cost of
+ * (CY_OTA_HTTP_RANGE_WINDOW - 1) * CY_OTA_CHUNK_SIZE bytes of RAM.
+ * TLS connections ask for the window with one range request.
+ */
+#define CY_OTA_HTTP_RANGE_WINDOW                (1)             /* 1 range request at a time. */
+
+/**
+ * @brief Smallest HTTP range request (bytes) when adapting the range size.
+ *
+ * Set smaller than CY_OTA_CHUNK_SIZE * CY_OTA_HTTP_RANGE_WINDOW to let the range
+ * size adapt to the measured request time and failures.
+ */
+#define CY_OTA_HTTP_RANGE_MIN_SIZE              (CY_OTA_CHUNK_SIZE * CY_OTA_HTTP_RANGE_WINDOW)  /* Adaptive sizing off. */
+
+/**
+ * @brief Get the HTTP OTA Image with one GET request.
+ *
+ * Set to 1 to stream the whole file with one GET on non-TLS connections.
+ * Range requests are used after a broken connection.
+ */
+#define CY_OTA_HTTP_STREAMING                   (0)             /* Range requests. */
+
+/**
+ * @brief Number of HTTP connections used for the data download.
+ *
+ * Set greater than 1 to fetch ranges on several connections at the same time,
+ * optionally to the mirrors listed in the Job document. Each extra connection
+ * uses a thread and CY_OTA_CHUNK_BUFFER_SIZE bytes of RAM.
+ */
+#define CY_OTA_HTTP_CONNECTIONS                 (1)             /* One connection. */
+
+/**
+ * @brief Conditional HTTP Job document polling.
+ *
+ * Set to 1 to send If-None-Match / If-Modified-Since when polling for a Job document
+ * that did not lead to an update, and end the session on "304 Not Modified".
+ * Set to 0 to get and parse the whole Job document on every poll.
+ */
+#define CY_OTA_HTTP_JOB_CACHE                   (0)             /* Always get the whole Job document. */
+
 /**********************************************************************
  * MQTT Defines
  **********************************************************************/
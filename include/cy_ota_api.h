@@ -194,6 +194,7 @@ extern "C" {
 #define CY_RSLT_OTA_USE_JOB_FLOW                (CY_RSLT_SUCCESS          ) /**< Use Job flow for update.                 */
 #define CY_RSLT_OTA_USE_DIRECT_FLOW             (CY_RSLT_OTA_INFO_BASE + 4) /**< Use Direct flow for update.              */
 #define CY_RSLT_OTA_NO_UPDATE_AVAILABLE         (CY_RSLT_OTA_INFO_BASE + 5) /**< No OTA update on the server.             */
+#define CY_RSLT_OTA_JOB_NOT_MODIFIED            (CY_RSLT_OTA_INFO_BASE + 6) /**< Job document same as the last poll.      */
 
 /** \} group_ota_macros */
 
@@ -240,8 +241,12 @@ extern "C" {
 
 /**
  * @brief Size of data chunks for each transfer.
+ *
+ * Can be set on the compiler command line, e.g. to benchmark other chunk sizes.
  */
+#ifndef CY_OTA_CHUNK_SIZE
 #define CY_OTA_CHUNK_SIZE                       (4096)
+#endif
 
 /**
  * @brief Size of the string for the HTTP file name.
@@ -364,6 +369,67 @@ extern "C" {
     #error  "CY_OTA_PACKET_INTERVAL_SECS must be less than CY_OTA_INTERVAL_SECS_MAX."
 #endif
 
+#if (CY_OTA_HTTP_RANGE_WINDOW < 1)
+    #error  "CY_OTA_HTTP_RANGE_WINDOW must be 1 or greater."
+#endif
+
+#if (CY_OTA_HTTP_RANGE_MIN_SIZE < 512) || (CY_OTA_HTTP_RANGE_MIN_SIZE > (CY_OTA_CHUNK_SIZE * CY_OTA_HTTP_RANGE_WINDOW))
+    #error  "CY_OTA_HTTP_RANGE_MIN_SIZE must be between 512 and (CY_OTA_CHUNK_SIZE * CY_OTA_HTTP_RANGE_WINDOW)."
+#endif
+
+#if (CY_OTA_WRITER_NUM_BUFFERS == 1)
+    #error  "CY_OTA_WRITER_NUM_BUFFERS must be 0 (disabled) or 2 or greater."
+#endif
+
+#if (CY_OTA_DECOMPRESS == 1) && ( (CY_OTA_DECOMPRESS_WINDOW_BITS < 8) || (CY_OTA_DECOMPRESS_WINDOW_BITS > 12) )
+    #error  "CY_OTA_DECOMPRESS_WINDOW_BITS must be between 8 and 12."
+#endif
+
+#if (CY_OTA_LAZY_ERASE == 1) && ( (CY_OTA_ERASE_SECTOR_SIZE < 512) || ((CY_OTA_ERASE_SECTOR_SIZE % 512) != 0) )
+    #error  "CY_OTA_ERASE_SECTOR_SIZE must be a multiple of 512."
+#endif
+
+#if (CY_OTA_ERASE_AHEAD_SECTORS > 0) && (CY_OTA_LAZY_ERASE != 1)
+    #error  "CY_OTA_ERASE_AHEAD_SECTORS needs CY_OTA_LAZY_ERASE 1."
+#endif
+
+#if (CY_OTA_DELTA == 1) && (CY_OTA_DELTA_BUFFER_SIZE < 512)
+    #error  "CY_OTA_DELTA_BUFFER_SIZE must be 512 or greater."
+#endif
+
+#if (CY_OTA_IMAGE_SIGNATURE == 1) && (CY_OTA_IMAGE_HASH != 1)
+    #error  "CY_OTA_IMAGE_SIGNATURE needs CY_OTA_IMAGE_HASH 1."
+#endif
+
+#if (CY_OTA_BLOCK_REUSE == 1) && (CY_OTA_BLOCK_REUSE_MAX_BLOCKS < 1)
+    #error  "CY_OTA_BLOCK_REUSE_MAX_BLOCKS must be 1 or greater."
+#endif
+
+#if (CY_OTA_HTTP_CONNECTIONS < 1)
+    #error  "CY_OTA_HTTP_CONNECTIONS must be 1 or greater."
+#endif
+
+#if ( (CY_OTA_HTTP_JOB_CACHE == 1) && (CY_OTA_HTTP_JOB_VALIDATOR_LEN < 8) )
+    #error  "CY_OTA_HTTP_JOB_VALIDATOR_LEN must be 8 or greater."
+#endif
+
+#if (CY_OTA_JOURNAL == 1)
+#if (CY_OTA_JOURNAL_OFFSET_FROM_END < CY_OTA_JOURNAL_SIZE)
+    #error  "CY_OTA_JOURNAL_OFFSET_FROM_END must be CY_OTA_JOURNAL_SIZE or greater."
+#endif
+#if (CY_OTA_JOURNAL_COMMIT_SIZE < CY_OTA_CHUNK_SIZE)
+    #error  "CY_OTA_JOURNAL_COMMIT_SIZE must be CY_OTA_CHUNK_SIZE or greater."
+#endif
+#endif
+
+#if (CY_OTA_STATS_BUCKETS < 2) || (CY_OTA_STATS_BUCKETS > 24)
+    #error  "CY_OTA_STATS_BUCKETS must be between 2 and 24."
+#endif
+
+#if (CY_OTA_STATS_BUCKET_MS < 1)
+    #error  "CY_OTA_STATS_BUCKET_MS must be 1 or greater."
+#endif
+
 /***********************************************************************
  *
  * defines & enums
@@ -454,6 +520,23 @@ extern "C" {
  */
 #define CY_OTA_FILE_FIELD                   "File"
 
+/**
+ * @brief The Mirrors field is for HTTP connection in a JSON Job document.
+ *
+ * Optional comma separated list of other HTTP servers with the same File, as "<host>[:<port>]".
+ * The extra connections of a parallel download are spread over the Server and the mirrors,
+ * see CY_OTA_HTTP_CONNECTIONS.
+ */
+#define CY_OTA_MIRRORS_FIELD                "Mirrors"
+
+/**
+ * @brief The Manifest field is for HTTP connection in a JSON Job document.
+ *
+ * Optional name of the block manifest of the File on the HTTP server, made by scripts/ota_blocks.py.
+ * Used with CY_OTA_BLOCK_REUSE to copy unchanged blocks from the Primary Slot.
+ */
+#define CY_OTA_MANIFEST_FIELD               "Manifest"
+
 /**
  * @brief The Offset field is for a JSON Chunk Request document.
  *
@@ -534,6 +617,11 @@ extern "C" {
  */
 #define CY_OTA_JOB_URL_BROKER_LEN           (256)
 
+/**
+ *  @brief The Max length of the "Mirrors" field in a JSON Job document.
+ */
+#define CY_OTA_JOB_MIRRORS_LEN              (128)
+
 /**
  * @brief The MQTT Broker port for a non-TLS connection.
  */
@@ -650,6 +738,21 @@ typedef enum
     CY_OTA_NUM_STATES                   /**< Not used, placeholder. */
 } cy_ota_agent_state_t;
 
+/**
+ * @brief OTA Agent state timing categories, see @ref cy_ota_stats_t.
+ */
+typedef enum
+{
+    CY_OTA_STATS_CONNECT = 0,           /**< Connecting for the Job, the Data or the Result.         */
+    CY_OTA_STATS_JOB_DOWNLOAD,          /**< Getting the Job document.                               */
+    CY_OTA_STATS_DATA_DOWNLOAD,         /**< Downloading the OTA Image, including storage writes.    */
+    CY_OTA_STATS_STORAGE_OPEN,          /**< Opening (and erasing) the storage.                      */
+    CY_OTA_STATS_STORAGE_CLOSE,         /**< Closing the storage.                                    */
+    CY_OTA_STATS_VERIFY,                /**< Verifying the download.                                 */
+
+    CY_OTA_NUM_STATS                    /**< Not used, placeholder. */
+} cy_ota_stats_category_t;
+
 #ifdef COMPONENT_OTA_BLUETOOTH
 
 /* Command definitions for the OTA FW upgrade */
@@ -928,6 +1031,74 @@ typedef struct
     void                *cb_arg;            /**< Opaque argument passed to the notification callback function.  */
 } cy_ota_agent_params_t;
 
+/**
+ * @brief HTTP range request statistics.
+ *
+ * Sizes chosen for the HTTP data download range requests, see CY_OTA_HTTP_RANGE_MIN_SIZE,
+ * the use of the single GET download, see CY_OTA_HTTP_STREAMING,
+ * of the pipelined range requests, see CY_OTA_HTTP_RANGE_WINDOW,
+ * and of the parallel download, see CY_OTA_HTTP_CONNECTIONS.
+ * Cleared at the start of each HTTP data download.
+ * \struct cy_ota_http_range_stats_t
+ */
+typedef struct
+{
+    bool        adaptive;           /**< true = range size adapts between min_size and max_size.   */
+    uint32_t    min_size;           /**< Smallest range size allowed (bytes).                      */
+    uint32_t    max_size;           /**< Largest range size allowed (bytes).                       */
+    uint32_t    current_size;       /**< Range size for the next request (bytes).                  */
+    uint32_t    smallest_size;      /**< Smallest range size used so far (bytes).                  */
+    uint32_t    largest_size;       /**< Largest range size used so far (bytes).                   */
+    uint32_t    requests;           /**< Number of range requests sent.                            */
+    uint32_t    failures;           /**< Number of range requests that failed.                     */
+    uint32_t    retries;            /**< Number of failed range requests that were retried.        */
+    uint32_t    grow_count;         /**< Number of times the range size was increased.             */
+    uint32_t    shrink_count;       /**< Number of times the range size was decreased.             */
+    uint32_t    last_request_ms;    /**< Time for the last successful request (milliseconds).      */
+    uint32_t    avg_request_ms;     /**< Smoothed time for successful requests (milliseconds).     */
+    uint32_t    stream_bytes;       /**< Bytes received by the single GET, see CY_OTA_HTTP_STREAMING. */
+    uint32_t    stream_fallbacks;   /**< Number of times the single GET broke and range requests were used. */
+    uint32_t    pipelined_bytes;    /**< Bytes received by pipelined range requests, see CY_OTA_HTTP_RANGE_WINDOW. */
+    uint32_t    pipeline_fallbacks; /**< Number of times the pipeline broke and single range requests were used. */
+    uint32_t    connections;        /**< Connections used by the parallel download, see CY_OTA_HTTP_CONNECTIONS. */
+    uint32_t    parallel_bytes;     /**< Bytes received by the parallel download.                  */
+    uint32_t    requeued;           /**< Ranges handed to another connection after a failure or stall. */
+    uint32_t    parked;             /**< Connections stopped for being much slower than the fastest. */
+} cy_ota_http_range_stats_t;
+
+/**
+ * @brief Time histogram for one @ref cy_ota_stats_category_t.
+ *
+ * buckets[n] counts the times below CY_OTA_STATS_BUCKET_MS << n milliseconds,
+ * the last bucket counts the rest.
+ * \struct cy_ota_stats_histogram_t
+ */
+typedef struct
+{
+    uint32_t    count;                          /**< Number of times the state was left.          */
+    uint32_t    total_ms;                       /**< Sum of the times (milliseconds).             */
+    uint32_t    min_ms;                         /**< Shortest time (milliseconds).                */
+    uint32_t    max_ms;                         /**< Longest time (milliseconds).                 */
+    uint32_t    last_ms;                        /**< Most recent time (milliseconds).             */
+    uint32_t    buckets[CY_OTA_STATS_BUCKETS];  /**< Count of times in each bucket.               */
+} cy_ota_stats_histogram_t;
+
+/**
+ * @brief OTA Agent state timing statistics.
+ *
+ * Every state change of the OTA Agent is timed with cy_rtos_get_time(). The time spent in a
+ * state is added when the Agent leaves it. Kept from cy_ota_agent_start() over all sessions.
+ * \struct cy_ota_stats_t
+ */
+typedef struct
+{
+    uint32_t                    sessions;                       /**< Number of update sessions started.     */
+    uint32_t                    transitions;                    /**< Number of state changes.               */
+    uint32_t                    state_count[CY_OTA_NUM_STATES]; /**< Times each state was left.             */
+    uint32_t                    state_ms[CY_OTA_NUM_STATES];    /**< Time spent in each state (milliseconds). */
+    cy_ota_stats_histogram_t    histogram[CY_OTA_NUM_STATS];    /**< Histograms, see @ref cy_ota_stats_category_t. */
+} cy_ota_stats_t;
+
 /** \} group_ota_structures */
 
 
@@ -1233,25 +1404,63 @@ cy_rslt_t cy_ota_fwdb_get_clm_blob_info(cy_ota_fwdb_clm_blob_info_t *clm_blob_in
  */
 cy_rslt_t cy_ota_fwdb_get_bt_fw_info(cy_ota_fwdb_bt_fw_info_t *bt_fw_info);
 
+/**
+ * @brief Read part of the BT FW Patch from the FW Data Block
+ *
+ * Use this call to pass the BT FW Patch to the BT module in pieces,
+ * without a buffer for the whole patch. Get BT_FW_size with
+ * cy_ota_fwdb_get_bt_fw_info(), then read from offset 0 up to BT_FW_size.
+ *
+ * @param[in]   offset - offset into the BT FW Patch
+ * @param[in]   size   - amount to copy
+ * @param[in]   dest   - destination buffer for the read
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_BADARG
+ *          CY_RSLT_OTA_ERROR_OPEN_STORAGE
+ *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ */
+cy_rslt_t cy_ota_fwdb_get_bt_fw_data(uint32_t offset, uint32_t size, uint8_t *dest);
+
 /**
  * @brief Get BT FW for transfer to BT module
  *
  * Use this call to get the external flash BT FW Patch info
- * NOTES: This allocates RAM, Expected to be < 48k
+ * NOTES: This allocates RAM for the whole patch, Expected to be < 48k,
+ *        and copies the patch into it. Use cy_ota_fwdb_get_bt_fw_data() to read
+ *        it in pieces, or cy_ota_fwdb_get_bt_fw_mapped() to use it in place.
  *        The User must call cy_ota_fwdb_free_bt_fw() after use.
  *
  * @param   bt_fw   - ptr to cy_ota_fwdb_bt_fw_t
  *
  * @return  CY_RSLT_SUCCESS
  *          CY_RSLT_OTA_ERROR_GENERAL
+ *          CY_RSLT_OTA_ERROR_OUT_OF_MEMORY
  */
 cy_rslt_t cy_ota_fwdb_get_bt_fw(cy_ota_fwdb_bt_fw_t *bt_fw);
 
+/**
+ * @brief Get BT FW in place for transfer to BT module
+ *
+ * NOTES: Only when the FW Data Block is memory mapped (internal FLASH, or
+ *        CY_OTA_FWDB_XIP with SMIF in XIP mode). BT_FW_buffer points at the patch
+ *        in FLASH and no RAM is used. The pointer is good until the Primary Slot
+ *        is written or SMIF leaves XIP mode.
+ *
+ * @param   bt_fw   - ptr to cy_ota_fwdb_bt_fw_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GENERAL
+ *          CY_RSLT_OTA_ERROR_UNSUPPORTED   - not memory mapped, use cy_ota_fwdb_get_bt_fw()
+ */
+cy_rslt_t cy_ota_fwdb_get_bt_fw_mapped(cy_ota_fwdb_bt_fw_t *bt_fw);
+
 /**
  * @brief Free BT FW for transfer to BT module
  *
  * Use this call to free the external flash BT FW Patch info
- * NOTES: This frees RAM, Expected to be < 48k
+ * NOTES: This frees the RAM copy from cy_ota_fwdb_get_bt_fw(), Expected to be < 48k.
+ *        After cy_ota_fwdb_get_bt_fw_mapped() there is nothing to free.
  *
  * @param   bt_fw   - ptr to cy_ota_fwdb_bt_fw_t
  *
@@ -1260,6 +1469,17 @@ cy_rslt_t cy_ota_fwdb_get_bt_fw(cy_ota_fwdb_bt_fw_t *bt_fw);
  */
 cy_rslt_t cy_ota_fwdb_free_bt_fw(cy_ota_fwdb_bt_fw_t *bt_fw);
 
+/**
+ * @brief Drop the cached FW Data Block header
+ *
+ * The FW Data Block header is read from FLASH once and kept for the
+ * cy_ota_fwdb_get_*() calls. The OTA Agent calls this after an update is
+ * verified and validated; call it after writing the Primary Slot in any other way.
+ *
+ * @return  N/A
+ */
+void cy_ota_fwdb_invalidate(void);
+
 #endif
 /**
  * @brief Set the OTA log output level.
@@ -1287,6 +1507,34 @@ void cy_ota_set_log_level(CY_LOG_LEVEL_T level);
  */
 cy_rslt_t cy_ota_get_state(cy_ota_context_ptr ota_ptr, cy_ota_agent_state_t *state);
 
+/**
+ * @brief Get the HTTP range request statistics.
+ *
+ * Use this function to see the range request sizes chosen during the HTTP data download.
+ *
+ * @param[in]  ota_ptr          Pointer to the OTA Agent context returned from @ref cy_ota_agent_start();
+ * @param[out] stats            Range request statistics @ref cy_ota_http_range_stats_t.
+ *
+ * @result  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_BADARG
+ *          CY_RSLT_OTA_ERROR_TRANSPORT_UNSUPPORTED
+ */
+cy_rslt_t cy_ota_get_http_range_stats(cy_ota_context_ptr ota_ptr, cy_ota_http_range_stats_t *stats);
+
+/**
+ * @brief Get the OTA Agent state timing statistics.
+ *
+ * Use this function to see where the time goes in an update session, for instance to upload
+ * the histograms with the result when the callback reports CY_OTA_STATE_RESULT_SEND.
+ *
+ * @param[in]  ota_ptr          Pointer to the OTA Agent context returned from @ref cy_ota_agent_start();
+ * @param[out] stats            State timing statistics @ref cy_ota_stats_t.
+ *
+ * @result  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_BADARG
+ */
+cy_rslt_t cy_ota_get_stats(cy_ota_context_ptr ota_ptr, cy_ota_stats_t *stats);
+
 /**
  * @brief Get the last OTA error.
  *
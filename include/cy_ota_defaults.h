@@ -181,6 +181,378 @@ extern "C" {
 #define CY_OTA_HTTP_TIMEOUT_RECEIVE             (3000)         /* 3 second receive timeout. */
 #endif
 
+/**
+ * @brief Number of HTTP range requests kept in flight on one connection.
+ *
+ * On a plain TCP connection the HTTP data download sends this many range requests
+ * of CY_OTA_CHUNK_SIZE bytes back to back, then writes each response to storage
+ * as it arrives and sends the next request. On links with a long round trip time
+ * this pays the round trip once per window instead of once per chunk.
+ * TLS and Application connections, block reuse and the parallel download
+ * (CY_OTA_HTTP_CONNECTIONS) ask for the window with one range request instead.
+ * The receive buffer in the OTA context grows by (CY_OTA_HTTP_RANGE_WINDOW - 1) * CY_OTA_CHUNK_SIZE bytes.
+ * Use 1 to request one chunk at a time.
+ */
+#ifndef CY_OTA_HTTP_RANGE_WINDOW
+#define CY_OTA_HTTP_RANGE_WINDOW                (1)            /* 1 range request at a time. */
+#endif
+
+/**
+ * @brief Smallest HTTP range request (bytes) when adapting the range size.
+ *
+ * The largest range request is CY_OTA_CHUNK_SIZE * CY_OTA_HTTP_RANGE_WINDOW bytes.
+ * When this is smaller than that, the range size adapts to the link, starting at this size:
+ * - a request faster than CY_OTA_HTTP_RANGE_TARGET_MS / 2 doubles the size,
+ * - a request slower than CY_OTA_HTTP_RANGE_TARGET_MS halves the size,
+ * - a failed request halves the size and is retried up to CY_OTA_HTTP_RANGE_RETRIES times.
+ * Use cy_ota_get_http_range_stats() to see the sizes chosen.
+ * Default is the largest range size, which turns adaptive sizing off.
+ */
+#ifndef CY_OTA_HTTP_RANGE_MIN_SIZE
+#define CY_OTA_HTTP_RANGE_MIN_SIZE              (CY_OTA_CHUNK_SIZE * CY_OTA_HTTP_RANGE_WINDOW)
+#endif
+
+/**
+ * @brief Target time for one HTTP range request when adapting the range size.
+ */
+#ifndef CY_OTA_HTTP_RANGE_TARGET_MS
+#define CY_OTA_HTTP_RANGE_TARGET_MS             (1000)         /* 1 second. */
+#endif
+
+/**
+ * @brief Number of times a failed HTTP range request is retried when adapting the range size.
+ */
+#ifndef CY_OTA_HTTP_RANGE_RETRIES
+#define CY_OTA_HTTP_RANGE_RETRIES               (3)
+#endif
+
+/**
+ * @brief Get the HTTP OTA Image with one GET request.
+ *
+ * When 1, the HTTP data download sends one GET for the whole file on a plain TCP socket and
+ * writes the body to storage as it arrives, without a request / response header per chunk.
+ * If the connection breaks, the rest of the file is downloaded with range requests.
+ * TLS connections and connections passed in by the Application always use range requests.
+ * Use 0 to always use range requests.
+ */
+#ifndef CY_OTA_HTTP_STREAMING
+#define CY_OTA_HTTP_STREAMING                   (0)            /* Range requests. */
+#endif
+
+/**
+ * @brief Number of HTTP connections used for the data download.
+ *
+ * When greater than 1, once the image size is known, the rest of the image is fetched with
+ * range requests of CY_OTA_CHUNK_SIZE * CY_OTA_HTTP_RANGE_WINDOW bytes on this many connections
+ * at the same time, each in its own thread. The extra connections go to the Server and the
+ * mirrors listed in the Job document (see CY_OTA_MIRRORS_FIELD), in turn. Ranges are written
+ * to storage in order, so tar archives work as before.
+ * Each extra connection adds a CY_OTA_CHUNK_BUFFER_SIZE buffer to the OTA context.
+ * Connections passed in by the Application always use one connection.
+ */
+#ifndef CY_OTA_HTTP_CONNECTIONS
+#define CY_OTA_HTTP_CONNECTIONS                 (1)            /* One connection. */
+#endif
+
+/**
+ * @brief Stack size for each HTTP parallel download thread.
+ */
+#ifndef CY_OTA_HTTP_FETCH_THREAD_STACK_SIZE
+#define CY_OTA_HTTP_FETCH_THREAD_STACK_SIZE     (6 * 1024)
+#endif
+
+/**
+ * @brief Conditional HTTP Job document polling.
+ *
+ * Default is 0: every poll gets and parses the whole Job document.
+ * Set to 1 in the application's cy_ota_config.h to keep the ETag / Last-Modified of
+ * a Job document that did not lead to an update (wrong board, or version not newer),
+ * and send If-None-Match / If-Modified-Since on the next poll. A "304 Not Modified"
+ * response, or a 200 with the same Job document, then ends the session without
+ * parsing the Job or connecting to the data server.
+ */
+#ifndef CY_OTA_HTTP_JOB_CACHE
+#define CY_OTA_HTTP_JOB_CACHE                   (0)            /* Always get the whole Job document. */
+#endif
+
+/**
+ * @brief Size of the saved ETag and Last-Modified values, including the terminating 0.
+ *
+ * Longer values are not saved, and the next poll is not conditional.
+ */
+#ifndef CY_OTA_HTTP_JOB_VALIDATOR_LEN
+#define CY_OTA_HTTP_JOB_VALIDATOR_LEN           (64)
+#endif
+
+/**
+ * @brief Stop using a connection that is this many times slower than the fastest one.
+ *
+ * Its remaining ranges are fetched by the other connections.
+ */
+#ifndef CY_OTA_HTTP_SLOW_FACTOR
+#define CY_OTA_HTTP_SLOW_FACTOR                 (4)
+#endif
+
+/**
+ * @brief Number of chunk buffers for the storage writer thread.
+ *
+ * When non-zero, received data is copied into one of these CY_OTA_CHUNK_SIZE buffers and
+ * written to FLASH by a separate writer thread, so the next chunk can be received while
+ * the previous one is being programmed. Used by the HTTP, MQTT and Bluetooth® transports.
+ * Each buffer adds CY_OTA_CHUNK_SIZE bytes to the OTA context.
+ * Use 0 to write from the receiving thread.
+ */
+#ifndef CY_OTA_WRITER_NUM_BUFFERS
+#define CY_OTA_WRITER_NUM_BUFFERS               (0)            /* Write from the receiving thread. */
+#endif
+
+/**
+ * @brief Stack size for the storage writer thread.
+ */
+#ifndef CY_OTA_WRITER_THREAD_STACK_SIZE
+#define CY_OTA_WRITER_THREAD_STACK_SIZE         (4 * 1024)
+#endif
+
+/**
+ * @brief Time to wait for the storage writer thread to free a buffer.
+ */
+#ifndef CY_OTA_WRITER_WAIT_MS
+#define CY_OTA_WRITER_WAIT_MS                   (10 * 1000)    /* 10 seconds. */
+#endif
+
+/**
+ * @brief Accept compressed OTA Images.
+ *
+ * When 1, a download that starts with the "CYLZ" magic (see scripts/ota_compress.py) is
+ * decompressed as it arrives, and the uncompressed data is written to the Secondary Slot.
+ * Works for single file images and tar archives, over HTTP, MQTT and Bluetooth®.
+ * The compressed data must arrive in order, and a compressed download is not recorded in the
+ * progress journal. Other downloads are written as before.
+ * Adds (1 << CY_OTA_DECOMPRESS_WINDOW_BITS) bytes plus about 80 bytes to the OTA context.
+ */
+#ifndef CY_OTA_DECOMPRESS
+#define CY_OTA_DECOMPRESS                       (0)            /* Uncompressed OTA Images only. */
+#endif
+
+/**
+ * @brief Largest decompression window, as a power of 2 (8 - 12).
+ *
+ * Compressed OTA Images made with a larger window (ota_compress.py "-w") are rejected.
+ * Larger windows compress better and use more RAM.
+ */
+#ifndef CY_OTA_DECOMPRESS_WINDOW_BITS
+#define CY_OTA_DECOMPRESS_WINDOW_BITS           (10)           /* 1 KB window. */
+#endif
+
+/**
+ * @brief Accept delta patches.
+ *
+ * When 1, a download that starts with the "CYDP" magic (see scripts/ota_delta.py) is a patch
+ * from the image in the Primary Slot. The old image is read from the Primary Slot as the patch
+ * arrives, and the new image is written to the Secondary Slot. A patch made for another image
+ * is rejected before anything is written. A patch can also be compressed (CY_OTA_DECOMPRESS).
+ * The patch must arrive in order, and is not recorded in the progress journal.
+ * Adds CY_OTA_DELTA_BUFFER_SIZE bytes plus about 100 bytes to the OTA context.
+ */
+#ifndef CY_OTA_DELTA
+#define CY_OTA_DELTA                            (0)            /* Full OTA Images only. */
+#endif
+
+/**
+ * @brief Size of the buffer for the new image when applying a delta patch.
+ *
+ * The new image is written in pieces of this size. At least 512 (one tar header).
+ */
+#ifndef CY_OTA_DELTA_BUFFER_SIZE
+#define CY_OTA_DELTA_BUFFER_SIZE                (1024)
+#endif
+
+/**
+ * @brief Keep a download progress journal in FLASH.
+ *
+ * When 1, the offset of the data durably written to the Secondary Slot is recorded in a small
+ * journal area at the end of the slot. After a reset or a broken connection, a download of the
+ * same image (same server, file and version) continues from the recorded offset instead of
+ * erasing the slot and starting over. Tar archives are not resumed.
+ * The journal area is not available for the OTA Image, see CY_OTA_JOURNAL_OFFSET_FROM_END.
+ * Use 0 to always start the download from the beginning.
+ */
+#ifndef CY_OTA_JOURNAL
+#define CY_OTA_JOURNAL                          (0)            /* No journal. */
+#endif
+
+/**
+ * @brief Size of the progress journal area (bytes).
+ *
+ * Must be a multiple of the erase size of the Secondary Slot FLASH and hold at least two
+ * FLASH rows, each record uses one row.
+ */
+#ifndef CY_OTA_JOURNAL_SIZE
+#define CY_OTA_JOURNAL_SIZE                     (8 * 1024)
+#endif
+
+/**
+ * @brief Start of the progress journal area, counted back from the end of the Secondary Slot.
+ *
+ * The space between the end of the journal and the end of the slot is left for the MCUboot trailer.
+ */
+#ifndef CY_OTA_JOURNAL_OFFSET_FROM_END
+#define CY_OTA_JOURNAL_OFFSET_FROM_END          (CY_OTA_JOURNAL_SIZE + (4 * 1024))
+#endif
+
+/**
+ * @brief Number of bytes downloaded between progress journal records.
+ *
+ * Smaller values lose less data on a reset, at the cost of more FLASH writes.
+ */
+#ifndef CY_OTA_JOURNAL_COMMIT_SIZE
+#define CY_OTA_JOURNAL_COMMIT_SIZE              (16 * 1024)
+#endif
+
+/**
+ * @brief Erase the Secondary Slot as it is written.
+ *
+ * When 1, cy_ota_storage_open() only erases the end of the Secondary Slot (MCUboot trailer and
+ * progress journal). Each other sector is erased just before the first write into it, so the
+ * download starts without waiting for a full slot erase, and sectors a small OTA Image does not
+ * use are not erased. Erased sectors are tracked in a bitmap of CY_OTA_LAZY_ERASE_MAX_SECTORS bits.
+ * Files in a tar archive for other images (multi-image) are written as before.
+ * Use 0 to erase the whole Secondary Slot before the download.
+ */
+#ifndef CY_OTA_LAZY_ERASE
+#define CY_OTA_LAZY_ERASE                       (0)            /* Erase the whole slot at storage open. */
+#endif
+
+/**
+ * @brief Erase size of the Secondary Slot FLASH (bytes).
+ *
+ * Smallest erase size used with CY_OTA_LAZY_ERASE. On external FLASH the size reported by
+ * ota_smif_get_erase_size() is used when larger (e.g. 256 KB for S25FL512S).
+ */
+#ifndef CY_OTA_ERASE_SECTOR_SIZE
+#define CY_OTA_ERASE_SECTOR_SIZE                (4 * 1024)
+#endif
+
+/**
+ * @brief Largest Secondary Slot for CY_OTA_LAZY_ERASE, in CY_OTA_ERASE_SECTOR_SIZE sectors.
+ *
+ * Uses one bit of RAM per sector. A larger slot is erased at storage open.
+ */
+#ifndef CY_OTA_LAZY_ERASE_MAX_SECTORS
+#define CY_OTA_LAZY_ERASE_MAX_SECTORS           (2048)         /* 8 MB of 4 KB sectors. */
+#endif
+
+/**
+ * @brief End of the Secondary Slot erased at storage open with CY_OTA_LAZY_ERASE (bytes).
+ *
+ * Holds the MCUboot image trailer, must not hold stale data from an earlier image.
+ * With CY_OTA_JOURNAL, at least the last CY_OTA_JOURNAL_OFFSET_FROM_END bytes (journal area and trailer).
+ */
+#ifndef CY_OTA_LAZY_ERASE_TRAILER_SIZE
+#define CY_OTA_LAZY_ERASE_TRAILER_SIZE          (4 * 1024)
+#endif
+
+/**
+ * @brief Sectors to erase ahead of the download with CY_OTA_LAZY_ERASE.
+ *
+ * When > 0, an "CY OTA Erase" thread erases up to this many sectors past the last write while
+ * the next data is received, so writes find their sectors erased. FLASH reads, writes and erases
+ * of the Secondary Slot are serialized with a mutex; time the writer still waits on an erase is
+ * logged and counted. Needs RAM for a thread stack of CY_OTA_ERASE_THREAD_STACK_SIZE.
+ * Use 0 to erase in the writer.
+ */
+#ifndef CY_OTA_ERASE_AHEAD_SECTORS
+#define CY_OTA_ERASE_AHEAD_SECTORS              (0)            /* Erase in the writer. */
+#endif
+
+/**
+ * @brief Stack size of the erase-ahead thread (bytes).
+ */
+#ifndef CY_OTA_ERASE_THREAD_STACK_SIZE
+#define CY_OTA_ERASE_THREAD_STACK_SIZE          (2 * 1024)
+#endif
+
+/**
+ * @brief Check the MCUboot image hash before the boot magic is written.
+ *
+ * When 1, the SHA-256 of the image in Secondary Slot 0 (header, image and protected TLVs)
+ * is computed as the data is written, and cy_ota_storage_verify() compares it with the
+ * SHA256 TLV of the image. Only data that did not arrive in order (resumed download,
+ * parallel connections) is read back from FLASH. A mismatch fails the OTA with
+ * CY_RSLT_OTA_ERROR_VERIFY and the image is not marked for the update.
+ * Adds about 150 bytes to the OTA context. Uses mbedtls.
+ */
+#ifndef CY_OTA_IMAGE_HASH
+#define CY_OTA_IMAGE_HASH                       (0)            /* Bootloader checks the image. */
+#endif
+
+/**
+ * @brief Also check the ECDSA P-256 signature TLV of the image.
+ *
+ * Needs CY_OTA_IMAGE_HASH 1. The application provides the public key as
+ * imgtool writes it for the bootloader (keys.c):
+ *      const unsigned char ecdsa_pub_key[];
+ *      const unsigned int ecdsa_pub_key_len;
+ * mbedtls needs MBEDTLS_PK_PARSE_C and MBEDTLS_ECDSA_C.
+ */
+#ifndef CY_OTA_IMAGE_SIGNATURE
+#define CY_OTA_IMAGE_SIGNATURE                  (0)            /* Hash only. */
+#endif
+
+/**
+ * @brief Reuse unchanged blocks of the image in the Primary Slot.
+ *
+ * When 1 and the HTTP Job document has a "Manifest" file (made by scripts/ota_blocks.py),
+ * the manifest of CY_OTA_CHUNK_SIZE block hashes is downloaded first. Blocks that hash the
+ * same in the Primary Slot are copied from there instead of downloaded, only the other
+ * blocks are requested with HTTP range requests. For plain (not tar, compressed or delta)
+ * OTA Images. Uses mbedtls SHA-256.
+ */
+#ifndef CY_OTA_BLOCK_REUSE
+#define CY_OTA_BLOCK_REUSE                      (0)            /* Download all blocks. */
+#endif
+
+/**
+ * @brief Largest number of CY_OTA_CHUNK_SIZE blocks in an image for block reuse.
+ *
+ * One bit of RAM per block. Larger images are downloaded in full.
+ */
+#ifndef CY_OTA_BLOCK_REUSE_MAX_BLOCKS
+#define CY_OTA_BLOCK_REUSE_MAX_BLOCKS           (512)          /* 2 MB of 4 KB blocks. */
+#endif
+
+/**
+ * @brief FW Data Block in external FLASH can be read in place (XIP).
+ *
+ * Set to 1 when SMIF stays in memory mapped (XIP) mode while the application
+ * reads the FW Data Block. cy_ota_fwdb_get_bt_fw_mapped() then returns a pointer
+ * to the BT FW Patch in FLASH, and cy_ota_fwdb_get_bt_fw_data() reads it with memcpy().
+ * A FW Data Block in internal FLASH is always memory mapped.
+ * cy_ota_fwdb_get_bt_fw() returns a RAM copy either way.
+ */
+#ifndef CY_OTA_FWDB_XIP
+#define CY_OTA_FWDB_XIP                         (0)            /* Copy from external FLASH. */
+#endif
+
+/**
+ * @brief Number of buckets in each state timing histogram.
+ *
+ * The OTA Agent times the connect, Job download, Data download, storage open / close and
+ * verify states. Bucket n counts the times below CY_OTA_STATS_BUCKET_MS << n milliseconds,
+ * the last bucket counts the rest. Use cy_ota_get_stats() to read them.
+ * Each histogram takes (CY_OTA_STATS_BUCKETS + 5) * 4 bytes of RAM in the OTA context.
+ */
+#ifndef CY_OTA_STATS_BUCKETS
+#define CY_OTA_STATS_BUCKETS                    (12)           /* Up to 16 ms << 10 = 16 seconds, then the rest. */
+#endif
+
+/**
+ * @brief Upper limit of the first state timing histogram bucket (milliseconds).
+ */
+#ifndef CY_OTA_STATS_BUCKET_MS
+#define CY_OTA_STATS_BUCKET_MS                  (16)
+#endif
+
 /**********************************************************************
  * Message Defines
  **********************************************************************/
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *   Streaming delta patch benchmark.
+ *
+ *   Applies a patch made by ota_delta.py the way the OTA Agent does with
+ *   CY_OTA_DELTA: the patch is fed in pieces of "-s" bytes (CY_OTA_CHUNK_SIZE by
+ *   default), the old image is read through the read callback and the new
+ *   image is handed over one output buffer ("-b", CY_OTA_DELTA_BUFFER_SIZE) at
+ *   a time. A patch made with "ota_delta.py -c" is LZSS decoded first, as with
+ *   CY_OTA_DECOMPRESS. The first pass compares the output with the new image,
+ *   the timed passes only count it.
+ *
+ *   Build and run on the host:
+ *       gcc -O2 -I source/port_support/delta -I source/port_support/lzss -o delta_bench \
+ *           scripts/delta_bench.c source/port_support/delta/delta.c source/port_support/lzss/lzss.c
+ *       python3 scripts/ota_delta.py [-c] <old image> <new image> <patch>
+ *       ./delta_bench [-s <piece size>] [-b <buffer size>] [-n <iterations>] <old image> <new image> <patch>
+ *
+ *   Output is CSV:  old,new,patch,ratio,decoder_ram,reads,writes,output_mb_per_sec,verify_ok
+ *   ratio is the patch size over the new image size; decoder_ram is the delta
+ *   decoder structure plus its buffer (and the LZSS decoder and window if used).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "delta.h"
+#include "lzss.h"
+
+typedef struct
+{
+    const uint8_t       *old;
+    uint32_t            old_size;
+    const uint8_t       *expected;
+    uint32_t            expected_size;
+    uint32_t            output;
+    uint32_t            reads;
+    uint32_t            writes;
+    bool                verify;
+    bool                ok;
+    cy_delta_decoder_t  delta;
+    cy_delta_result_t   delta_result;
+} bench_state_t;
+
+static int bench_read(void *cb_arg, uint32_t offset, uint8_t *buffer, uint32_t size)
+{
+    bench_state_t   *state = (bench_state_t *)cb_arg;
+
+    if ((offset + size) > state->old_size)
+    {
+        return -1;
+    }
+    memcpy(buffer, &state->old[offset], size);
+    state->reads++;
+    return 0;
+}
+
+static int bench_write(void *cb_arg, uint32_t offset, const uint8_t *buffer, uint32_t size)
+{
+    bench_state_t   *state = (bench_state_t *)cb_arg;
+
+    if (state->verify)
+    {
+        if ( (offset != state->output) || ((offset + size) > state->expected_size) ||
+             (memcmp(&state->expected[offset], buffer, size) != 0) )
+        {
+            state->ok = false;
+            return -1;
+        }
+    }
+    state->output += size;
+    state->writes++;
+    return 0;
+}
+
+/* LZSS output is the patch */
+static int bench_patch(void *cb_arg, uint32_t offset, const uint8_t *buffer, uint32_t size)
+{
+    bench_state_t   *state = (bench_state_t *)cb_arg;
+
+    (void)offset;
+    state->delta_result = cy_delta_apply(&state->delta, buffer, size);
+    return ( (state->delta_result == CY_DELTA_SUCCESS) || (state->delta_result == CY_DELTA_DONE) ) ? 0 : -1;
+}
+
+static uint8_t *read_file(const char *name, uint32_t *size)
+{
+    FILE    *f = fopen(name, "rb");
+    uint8_t *data;
+    long    len;
+
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc((size_t)len + 1);
+    if ( (data == NULL) || (fread(data, 1, (size_t)len, f) != (size_t)len) )
+    {
+        fclose(f);
+        free(data);
+        return NULL;
+    }
+    fclose(f);
+    *size = (uint32_t)len;
+    return data;
+}
+
+static cy_delta_result_t apply(bench_state_t *state, uint8_t *buffer, uint32_t buffer_size, const uint8_t *patch,
+                               uint32_t patch_size, uint32_t piece)
+{
+    static uint8_t      window[1UL << CY_LZSS_MAX_WINDOW_BITS];
+    cy_lzss_decoder_t   lzss;
+    bool                compressed = cy_lzss_is_compressed(patch, patch_size);
+    uint32_t            offset;
+
+    state->output = 0;
+    state->reads = 0;
+    state->writes = 0;
+    state->delta_result = CY_DELTA_SUCCESS;
+    if ( (cy_delta_init(&state->delta, buffer, buffer_size, bench_read, bench_write, state) != CY_DELTA_SUCCESS) ||
+         (compressed && (cy_lzss_init(&lzss, window, sizeof(window), bench_patch, state) != CY_LZSS_SUCCESS)) )
+    {
+        return CY_DELTA_ERROR;
+    }
+    for (offset = 0; offset < patch_size; offset += piece)
+    {
+        uint32_t    size = ((patch_size - offset) < piece) ? (patch_size - offset) : piece;
+        if (compressed)
+        {
+            if (cy_lzss_decode(&lzss, &patch[offset], size) == CY_LZSS_ERROR)
+            {
+                break;
+            }
+        }
+        else
+        {
+            state->delta_result = cy_delta_apply(&state->delta, &patch[offset], size);
+        }
+        if (state->delta_result != CY_DELTA_SUCCESS)
+        {
+            break;
+        }
+    }
+    return state->delta_result;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+    static bench_state_t    state;
+    uint8_t                 *buffer;
+    uint8_t                 *patch;
+    uint32_t                patch_size = 0;
+    uint32_t                buffer_size = 1024;         /* CY_OTA_DELTA_BUFFER_SIZE */
+    uint32_t                piece = 4096;               /* CY_OTA_CHUNK_SIZE */
+    uint32_t                iterations = 50;
+    uint32_t                decoder_ram;
+    uint32_t                loop;
+    double                  start;
+    double                  elapsed;
+    bool                    verify_ok;
+    int                     arg;
+
+    for (arg = 1; arg < argc - 3; arg++)
+    {
+        if (strcmp(argv[arg], "-s") == 0)
+        {
+            piece = (uint32_t)atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "-b") == 0)
+        {
+            buffer_size = (uint32_t)atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "-n") == 0)
+        {
+            iterations = (uint32_t)atoi(argv[++arg]);
+        }
+    }
+    if ( (argc < 4) || (piece == 0) || (buffer_size < CY_DELTA_MIN_BUFFER_SIZE) || (iterations == 0) )
+    {
+        printf("usage: %s [-s <piece size>] [-b <buffer size>] [-n <iterations>] <old image> <new image> <patch>\n", argv[0]);
+        return 1;
+    }
+
+    state.old = read_file(argv[argc - 3], &state.old_size);
+    state.expected = read_file(argv[argc - 2], &state.expected_size);
+    patch = read_file(argv[argc - 1], &patch_size);
+    buffer = malloc(buffer_size);
+    if ( (state.old == NULL) || (state.expected == NULL) || (patch == NULL) || (buffer == NULL) )
+    {
+        printf("could not read %s, %s and %s\n", argv[argc - 3], argv[argc - 2], argv[argc - 1]);
+        return 1;
+    }
+
+    state.verify = true;
+    state.ok = true;
+    verify_ok = (apply(&state, buffer, buffer_size, patch, patch_size, piece) == CY_DELTA_DONE) &&
+                state.ok && (state.output == state.expected_size);
+
+    decoder_ram = (uint32_t)sizeof(cy_delta_decoder_t) + buffer_size;
+    if (cy_lzss_is_compressed(patch, patch_size))
+    {
+        decoder_ram += (uint32_t)sizeof(cy_lzss_decoder_t) + (1UL << patch[5]);
+    }
+    printf("old,new,patch,ratio,decoder_ram,reads,writes,output_mb_per_sec,verify_ok\n");
+
+    state.verify = false;
+    start = now_sec();
+    for (loop = 0; loop < iterations; loop++)
+    {
+        apply(&state, buffer, buffer_size, patch, patch_size, piece);
+    }
+    elapsed = now_sec() - start;
+
+    printf("%u,%u,%u,%.3f,%u,%u,%u,%.1f,%d\n", state.old_size, state.expected_size, patch_size,
+           (double)patch_size / (double)state.expected_size, decoder_ram, state.reads, state.writes,
+           ((double)state.expected_size * iterations) / elapsed / 1e6, (int)verify_ok);
+
+    free((void *)state.old);
+    free((void *)state.expected);
+    free(patch);
+    free(buffer);
+    return verify_ok ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: the FreeRTOS heap and delay calls used by the OTA Agent
+ *
+ * The heap calls are counted so host runs can report the OTA heap use.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t TickType_t;
+
+#define portTICK_PERIOD_MS      (1)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+void vTaskDelay(TickType_t ticks);
+
+/* bytes allocated now and the most allocated at any time */
+size_t cy_host_heap_in_use(void);
+size_t cy_host_heap_peak(void);
+void cy_host_heap_reset_peak(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: the http-client calls used by the OTA Agent, on BSD sockets
+ *
+ * As in the http-client library, cy_http_client_send() reads the whole
+ * response into the request buffer, and cy_http_client_read_header()
+ * copies the values of the asked-for header fields.
+ */
+
+#ifndef CY_HTTP_CLIENT_API_H__
+#define CY_HTTP_CLIENT_API_H__ 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "cy_result.h"
+#include "cy_result_mw.h"
+#include "cy_tcpip_port_secure_sockets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CY_RSLT_HTTP_CLIENT_ERROR_INIT_FAIL         CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 1)
+#define CY_RSLT_HTTP_CLIENT_ERROR_BADARG            CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 3)
+#define CY_RSLT_HTTP_CLIENT_ERROR_NOMEM             CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 4)
+#define CY_RSLT_HTTP_CLIENT_ERROR_NOT_CONNECTED     CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 6)
+#define CY_RSLT_HTTP_CLIENT_ERROR_CONNECT_FAIL      CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 7)
+#define CY_RSLT_HTTP_CLIENT_ERROR_NO_BUFFER         CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 9)
+#define CY_RSLT_HTTP_CLIENT_ERROR_NO_RESPONSE       CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 10)
+#define CY_RSLT_HTTP_CLIENT_ERROR_PARSER            CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 11)
+#define CY_RSLT_HTTP_CLIENT_ERROR_UNSUPPORTED       CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_HTTP_CLIENT, 13)
+
+typedef void *cy_http_client_t;
+
+typedef enum
+{
+    CY_HTTP_CLIENT_METHOD_GET,
+    CY_HTTP_CLIENT_METHOD_PUT,
+    CY_HTTP_CLIENT_METHOD_POST,
+    CY_HTTP_CLIENT_METHOD_HEAD,
+} cy_http_client_method_t;
+
+typedef enum
+{
+    CY_HTTP_CLIENT_DISCONN_TYPE_SERVER_INITIATED = 1,
+    CY_HTTP_CLIENT_DISCONN_TYPE_NETWORK_DOWN,
+} cy_http_client_disconn_type_t;
+
+typedef void (*cy_http_disconnect_callback_t)(cy_http_client_t handle, cy_http_client_disconn_type_t type, void *user_data);
+
+typedef struct
+{
+    char        *field;                     /**< Header field name          */
+    size_t      field_len;
+    char        *value;                     /**< Header value               */
+    size_t      value_len;                  /**< read_header(): in: value buffer size, out: value length */
+} cy_http_client_header_t;
+
+typedef struct
+{
+    cy_http_client_method_t method;
+    const char              *resource_path;
+    uint8_t                 *buffer;        /**< Request headers, then the response */
+    size_t                  buffer_len;
+    size_t                  headers_len;    /**< Set by cy_http_client_write_header() */
+    int32_t                 range_start;    /**< 0 and -1 for no Range header */
+    int32_t                 range_end;      /**< -1 = to the end of the file  */
+} cy_http_client_request_header_t;
+
+typedef struct
+{
+    uint16_t        status_code;
+    uint8_t         *buffer;
+    size_t          buffer_len;
+    const uint8_t   *header;
+    size_t          headers_len;
+    size_t          header_count;
+    const uint8_t   *body;
+    size_t          body_len;
+    size_t          content_len;
+} cy_http_client_response_t;
+
+cy_rslt_t cy_http_client_init(void);
+cy_rslt_t cy_http_client_create(cy_awsport_ssl_credentials_t *security, cy_awsport_server_info_t *server_info,
+                                cy_http_disconnect_callback_t disconn_cb, void *user_data, cy_http_client_t *handle);
+cy_rslt_t cy_http_client_connect(cy_http_client_t handle, uint32_t send_timeout_ms, uint32_t receive_timeout_ms);
+cy_rslt_t cy_http_client_write_header(cy_http_client_t handle, cy_http_client_request_header_t *request,
+                                      cy_http_client_header_t *header, uint32_t num_header);
+cy_rslt_t cy_http_client_send(cy_http_client_t handle, cy_http_client_request_header_t *request,
+                              uint8_t *payload, uint32_t payload_len, cy_http_client_response_t *response);
+cy_rslt_t cy_http_client_read_header(cy_http_client_t handle, cy_http_client_response_t *response,
+                                     cy_http_client_header_t *header, uint32_t num_header);
+cy_rslt_t cy_http_client_disconnect(cy_http_client_t handle);
+cy_rslt_t cy_http_client_delete(cy_http_client_t handle);
+cy_rslt_t cy_http_client_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CY_HTTP_CLIENT_API_H__ */
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: JSON parser, as in connectivity-utilities cy_json_parser.h
+ *
+ * The callback is called for each name / value pair, values of nested
+ * objects and arrays are walked into.
+ */
+
+#ifndef CY_JSON_PARSER_H__
+#define CY_JSON_PARSER_H__ 1
+
+#include <stdint.h>
+
+#include "cy_result.h"
+#include "cy_result_mw.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CY_RSLT_JSON_GENERIC_ERROR      CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_JSON, 1)
+
+typedef enum
+{
+    JSON_STRING_TYPE,
+    JSON_NUMBER_TYPE,
+    JSON_VALUE_TYPE,
+    JSON_ARRAY_TYPE,
+    JSON_OBJECT_TYPE,
+    JSON_BOOLEAN_TYPE,
+    JSON_NULL_TYPE,
+    JSON_FLOAT_TYPE,
+    UNKNOWN_JSON_TYPE
+} cy_JSON_type_t;
+
+typedef struct cy_JSON_object
+{
+    char                    *object_string;
+    uint8_t                 object_string_length;
+    cy_JSON_type_t          value_type;
+    char                    *value;
+    uint16_t                value_length;
+    struct cy_JSON_object   *parent_object;
+} cy_JSON_object_t;
+
+typedef cy_rslt_t (*cy_JSON_callback_t)(cy_JSON_object_t *json_object, void *arg);
+
+cy_rslt_t cy_JSON_parser_register_callback(cy_JSON_callback_t json_callback, void *arg);
+cy_JSON_callback_t cy_JSON_parser_get_callback(void);
+cy_rslt_t cy_JSON_parser(const char *json_input, uint32_t input_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CY_JSON_PARSER_H__ */
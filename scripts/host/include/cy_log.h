@@ -0,0 +1,72 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: logging, as in connectivity-utilities cy_log.h
+ */
+
+#ifndef CY_LOG_H__
+#define CY_LOG_H__ 1
+
+#include <stdint.h>
+#include "cy_result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    CYLF_DEF = 0,
+    CYLF_TEST,
+    CYLF_DRIVERS,
+    CYLF_MIDDLEWARE,
+    CYLF_AUDIO,
+    CYLF_MAX
+} CY_LOG_FACILITY_T;
+
+typedef enum
+{
+    CY_LOG_OFF = 0,
+    CY_LOG_ERR,
+    CY_LOG_WARNING,
+    CY_LOG_NOTICE,
+    CY_LOG_INFO,
+    CY_LOG_DEBUG,
+    CY_LOG_DEBUG1,
+    CY_LOG_DEBUG2,
+    CY_LOG_DEBUG3,
+    CY_LOG_DEBUG4,
+    CY_LOG_PRINTF,
+    CY_LOG_MAX
+} CY_LOG_LEVEL_T;
+
+typedef int (*log_output)(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level, char *logmsg);
+typedef cy_rslt_t (*platform_get_time)(uint32_t *time);
+
+cy_rslt_t cy_log_init(CY_LOG_LEVEL_T level, log_output platform_output, platform_get_time platform_time);
+cy_rslt_t cy_log_shutdown(void);
+cy_rslt_t cy_log_set_facility_level(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level);
+cy_rslt_t cy_log_set_all_levels(CY_LOG_LEVEL_T level);
+CY_LOG_LEVEL_T cy_log_get_facility_level(CY_LOG_FACILITY_T facility);
+cy_rslt_t cy_log_msg(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level, const char *fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CY_LOG_H__ */
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: the mqtt library calls used by the OTA Agent
+ *
+ * An MQTT 3.1.1 client on BSD sockets with a receive thread, QoS 0 and 1.
+ * Received PUBLISH messages are handed to the callback from that thread.
+ */
+
+#ifndef CY_MQTT_API_H__
+#define CY_MQTT_API_H__ 1
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cy_result.h"
+#include "cy_result_mw.h"
+#include "cy_tcpip_port_secure_sockets.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CY_RSLT_MODULE_MQTT_ERROR                   CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MQTT, 1)
+#define CY_RSLT_MODULE_MQTT_BADARG                  CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MQTT, 3)
+#define CY_RSLT_MODULE_MQTT_NOMEM                   CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MQTT, 5)
+#define CY_RSLT_MODULE_MQTT_CONNECT_FAIL            CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MQTT, 8)
+#define CY_RSLT_MODULE_MQTT_NOT_CONNECTED           CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MQTT, 10)
+#define CY_RSLT_MODULE_MQTT_PUBLISH_FAIL            CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MQTT, 12)
+#define CY_RSLT_MODULE_MQTT_SUBSCRIBE_FAIL          CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MQTT, 13)
+#define CY_RSLT_MODULE_MQTT_UNSUBSCRIBE_FAIL        CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_MQTT, 14)
+
+#define CY_MQTT_MIN_NETWORK_BUFFER_SIZE             (256)
+
+typedef void *cy_mqtt_t;
+
+typedef enum
+{
+    CY_MQTT_QOS0 = 0,
+    CY_MQTT_QOS1,
+    CY_MQTT_QOS2,
+    CY_MQTT_QOS_INVALID = 0xFF
+} cy_mqtt_qos_t;
+
+typedef enum
+{
+    CY_MQTT_EVENT_TYPE_DISCONNECT = 0,
+    CY_MQTT_EVENT_TYPE_PUBLISH_RECEIVE,
+} cy_mqtt_event_type_t;
+
+typedef enum
+{
+    CY_MQTT_DISCONN_TYPE_BROKER_DOWN = 0,
+    CY_MQTT_DISCONN_TYPE_NETWORK_DOWN,
+    CY_MQTT_DISCONN_TYPE_BAD_RESPONSE,
+    CY_MQTT_DISCONN_TYPE_SND_RCV_FAIL,
+} cy_mqtt_disconn_type_t;
+
+typedef struct
+{
+    cy_mqtt_qos_t   qos;
+    bool            retain;
+    bool            dup;
+    const char      *topic;
+    uint16_t        topic_len;
+    const char      *payload;
+    size_t          payload_len;
+} cy_mqtt_publish_info_t;
+
+typedef struct
+{
+    cy_mqtt_qos_t   qos;
+    const char      *topic;
+    uint16_t        topic_len;
+    cy_mqtt_qos_t   allocated_qos;
+} cy_mqtt_subscribe_info_t;
+
+typedef cy_mqtt_subscribe_info_t cy_mqtt_unsubscribe_info_t;
+
+typedef struct
+{
+    const char              *client_id;
+    uint16_t                client_id_len;
+    const char              *username;
+    uint16_t                username_len;
+    const char              *password;
+    uint16_t                password_len;
+    bool                    clean_session;
+    uint16_t                keep_alive_sec;
+    cy_mqtt_publish_info_t  *will_info;
+} cy_mqtt_connect_info_t;
+
+typedef struct
+{
+    const char      *hostname;
+    uint16_t        hostname_len;
+    uint16_t        port;
+} cy_mqtt_broker_info_t;
+
+typedef struct
+{
+    uint16_t                packet_id;
+    cy_mqtt_publish_info_t  received_message;
+} cy_mqtt_received_msg_info_t;
+
+typedef struct
+{
+    cy_mqtt_event_type_t    type;
+    union
+    {
+        cy_mqtt_disconn_type_t      reason;
+        cy_mqtt_received_msg_info_t pub_msg;
+    } data;
+} cy_mqtt_event_t;
+
+typedef void (*cy_mqtt_callback_t)(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *user_data);
+
+cy_rslt_t cy_mqtt_init(void);
+cy_rslt_t cy_mqtt_create(uint8_t *buffer, uint32_t buff_len, cy_awsport_ssl_credentials_t *security,
+                         cy_mqtt_broker_info_t *broker_info, cy_mqtt_callback_t event_callback,
+                         void *user_data, cy_mqtt_t *mqtt_handle);
+cy_rslt_t cy_mqtt_connect(cy_mqtt_t mqtt_handle, cy_mqtt_connect_info_t *connect_info);
+cy_rslt_t cy_mqtt_publish(cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pub_msg);
+cy_rslt_t cy_mqtt_subscribe(cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *sub_info, uint8_t sub_count);
+cy_rslt_t cy_mqtt_unsubscribe(cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t *unsub_info, uint8_t unsub_count);
+cy_rslt_t cy_mqtt_disconnect(cy_mqtt_t mqtt_handle);
+cy_rslt_t cy_mqtt_delete(cy_mqtt_t mqtt_handle);
+cy_rslt_t cy_mqtt_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CY_MQTT_API_H__ */
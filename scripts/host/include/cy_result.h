@@ -0,0 +1,65 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: result codes, as in core-lib cy_result.h
+ */
+
+#ifndef CY_RESULT_H__
+#define CY_RESULT_H__ 1
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+typedef uint32_t cy_rslt_t;
+
+#define CY_RSLT_SUCCESS                 ((cy_rslt_t)0x00000000U)
+
+#define CY_RSLT_TYPE_POSITION           (16U)
+#define CY_RSLT_TYPE_WIDTH              (2U)
+#define CY_RSLT_MODULE_POSITION         (18U)
+#define CY_RSLT_MODULE_WIDTH            (14U)
+#define CY_RSLT_CODE_POSITION           (0U)
+#define CY_RSLT_CODE_WIDTH              (16U)
+
+#define CY_RSLT_TYPE_MASK               ((1U << CY_RSLT_TYPE_WIDTH) - 1U)
+#define CY_RSLT_MODULE_MASK             ((1U << CY_RSLT_MODULE_WIDTH) - 1U)
+#define CY_RSLT_CODE_MASK               ((1U << CY_RSLT_CODE_WIDTH) - 1U)
+
+#define CY_RSLT_TYPE_INFO               (0U)
+#define CY_RSLT_TYPE_WARNING            (1U)
+#define CY_RSLT_TYPE_ERROR              (2U)
+#define CY_RSLT_TYPE_FATAL              (3U)
+
+#define CY_RSLT_GET_TYPE(x)             (((x) >> CY_RSLT_TYPE_POSITION) & CY_RSLT_TYPE_MASK)
+#define CY_RSLT_GET_MODULE(x)           (((x) >> CY_RSLT_MODULE_POSITION) & CY_RSLT_MODULE_MASK)
+#define CY_RSLT_GET_CODE(x)             (((x) >> CY_RSLT_CODE_POSITION) & CY_RSLT_CODE_MASK)
+
+#define CY_RSLT_CREATE(type, module, code) \
+    ((((module) & CY_RSLT_MODULE_MASK) << CY_RSLT_MODULE_POSITION) | \
+     (((code) & CY_RSLT_CODE_MASK) << CY_RSLT_CODE_POSITION) | \
+     (((type) & CY_RSLT_TYPE_MASK) << CY_RSLT_TYPE_POSITION))
+
+#define CY_RSLT_MODULE_ABSTRACTION_OS   (0x0100U)
+#define CY_RSLT_MODULE_MIDDLEWARE_BASE  (0x0200U)
+#define CY_RSLT_MODULE_BOARD_LIB_SERIAL_FLASH   (0x01C3U)
+
+#define CY_ASSERT(x)                    assert(x)
+#define CY_UNUSED_PARAMETER(x)          ((void)(x))
+
+#endif /* CY_RESULT_H__ */
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: middleware module bases, as in connectivity-utilities cy_result_mw.h
+ */
+
+#ifndef CY_RESULT_MW_H__
+#define CY_RESULT_MW_H__ 1
+
+#include "cy_result.h"
+
+#define CY_RSLT_MODULE_SECURE_SOCKETS               (CY_RSLT_MODULE_MIDDLEWARE_BASE + 3)
+#define CY_RSLT_MODULE_JSON                         (CY_RSLT_MODULE_MIDDLEWARE_BASE + 10)
+#define CY_RSLT_MODULE_MIDDLEWARE_OTA_UPDATE        (CY_RSLT_MODULE_MIDDLEWARE_BASE + 13)
+#define CY_RSLT_MODULE_HTTP_CLIENT                  (CY_RSLT_MODULE_MIDDLEWARE_BASE + 15)
+#define CY_RSLT_MODULE_MQTT                         (CY_RSLT_MODULE_MIDDLEWARE_BASE + 16)
+
+#endif /* CY_RESULT_MW_H__ */
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: the secure sockets calls used by the OTA Agent, on BSD sockets
+ *
+ * TCP only, no TLS.
+ */
+
+#ifndef CY_SECURE_SOCKETS_H__
+#define CY_SECURE_SOCKETS_H__ 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "cy_result.h"
+#include "cy_result_mw.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT       CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 5)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_BADARG        CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 6)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_NOMEM         CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 7)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED        CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 8)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_HOST_NOT_FOUND CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 10)
+#define CY_RSLT_MODULE_SECURE_SOCKETS_TCPIP_ERROR   CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_SECURE_SOCKETS, 11)
+
+#define CY_SOCKET_DOMAIN_AF_INET        (1)
+#define CY_SOCKET_TYPE_STREAM           (1)
+#define CY_SOCKET_IPPROTO_TCP           (1)
+#define CY_SOCKET_SOL_SOCKET            (1)
+#define CY_SOCKET_SO_RCVTIMEO           (1)
+#define CY_SOCKET_SO_SNDTIMEO           (2)
+#define CY_SOCKET_FLAGS_NONE            (0)
+
+typedef void *cy_socket_t;
+
+typedef enum
+{
+    CY_SOCKET_IP_VER_V4 = 4,
+    CY_SOCKET_IP_VER_V6 = 6
+} cy_socket_ip_version_t;
+
+typedef struct
+{
+    cy_socket_ip_version_t  version;
+    union
+    {
+        uint32_t            v4;             /**< network byte order */
+        uint32_t            v6[4];
+    } ip;
+} cy_socket_ip_address_t;
+
+typedef struct
+{
+    uint16_t                port;           /**< host byte order */
+    cy_socket_ip_address_t  ip_address;
+} cy_socket_sockaddr_t;
+
+cy_rslt_t cy_socket_init(void);
+cy_rslt_t cy_socket_deinit(void);
+cy_rslt_t cy_socket_create(int domain, int type, int protocol, cy_socket_t *handle);
+cy_rslt_t cy_socket_setsockopt(cy_socket_t handle, int level, int optname, const void *optval, uint32_t optlen);
+cy_rslt_t cy_socket_connect(cy_socket_t handle, cy_socket_sockaddr_t *address, uint32_t address_length);
+cy_rslt_t cy_socket_send(cy_socket_t handle, const void *buffer, uint32_t length, int flags, uint32_t *bytes_sent);
+cy_rslt_t cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t length, int flags, uint32_t *bytes_received);
+cy_rslt_t cy_socket_gethostbyname(const char *hostname, cy_socket_ip_version_t ip_ver, cy_socket_ip_address_t *addr);
+cy_rslt_t cy_socket_disconnect(cy_socket_t handle, uint32_t timeout);
+cy_rslt_t cy_socket_delete(cy_socket_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CY_SECURE_SOCKETS_H__ */
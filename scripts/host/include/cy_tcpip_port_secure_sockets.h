@@ -0,0 +1,58 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: server and credential types, as in aws-iot-device-sdk-port
+ *
+ * The host transports do not support TLS, a connection with credentials fails.
+ */
+
+#ifndef CY_TCPIP_PORT_SECURE_SOCKETS_H__
+#define CY_TCPIP_PORT_SECURE_SOCKETS_H__ 1
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct
+{
+    const char  *host_name;                 /**< Server host name                */
+    uint16_t    port;                       /**< Server port in host order       */
+} cy_awsport_server_info_t;
+
+typedef struct
+{
+    const char  *client_cert;               /**< Client certificate (PEM)        */
+    size_t      client_cert_size;
+    const char  *private_key;               /**< Client private key (PEM)        */
+    size_t      private_key_size;
+    const char  *root_ca;                   /**< Trusted server root CA (PEM)    */
+    size_t      root_ca_size;
+    const char  *username;                  /**< MQTT user name                  */
+    size_t      username_size;
+    const char  *password;                  /**< MQTT password                   */
+    size_t      password_size;
+    const char  **alpnprotos;               /**< ALPN protocols                  */
+    size_t      alpnprotoslen;
+    char        *sni_host_name;             /**< SNI host name                   */
+    size_t      sni_host_name_size;
+    bool        root_ca_verify_mode;
+    bool        root_ca_location;
+    bool        cert_key_location;
+} cy_awsport_ssl_credentials_t;
+
+#endif /* CY_TCPIP_PORT_SECURE_SOCKETS_H__ */
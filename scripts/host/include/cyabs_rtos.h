@@ -0,0 +1,143 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: abstraction-rtos API on POSIX threads
+ *
+ * Same calls and semantics as abstraction-rtos cyabs_rtos.h, the objects
+ * are pthread based structures instead of FreeRTOS handles.
+ */
+
+#ifndef CYABS_RTOS_H__
+#define CYABS_RTOS_H__ 1
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "cy_result.h"
+#include "FreeRTOS.h"              /* cyabs_rtos_impl.h pulls in FreeRTOS on the target */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CY_RTOS_NEVER_TIMEOUT           ( (uint32_t)0xffffffffUL )
+
+#define CY_RTOS_TIMEOUT                 CY_RSLT_CREATE(CY_RSLT_TYPE_INFO, CY_RSLT_MODULE_ABSTRACTION_OS, 1)
+#define CY_RTOS_NO_MEMORY               CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_OS, 2)
+#define CY_RTOS_GENERAL_ERROR           CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_OS, 3)
+#define CY_RTOS_BAD_PARAM               CY_RSLT_CREATE(CY_RSLT_TYPE_ERROR, CY_RSLT_MODULE_ABSTRACTION_OS, 5)
+
+typedef enum
+{
+    CY_RTOS_PRIORITY_MIN,
+    CY_RTOS_PRIORITY_LOW,
+    CY_RTOS_PRIORITY_BELOWNORMAL,
+    CY_RTOS_PRIORITY_NORMAL,
+    CY_RTOS_PRIORITY_ABOVENORMAL,
+    CY_RTOS_PRIORITY_HIGH,
+    CY_RTOS_PRIORITY_REALTIME,
+    CY_RTOS_PRIORITY_MAX
+} cy_thread_priority_t;
+
+typedef enum
+{
+    CY_TIMER_TYPE_PERIODIC,
+    CY_TIMER_TYPE_ONCE,
+} cy_timer_trigger_type_t;
+
+typedef uint32_t    cy_time_t;
+typedef void        *cy_thread_arg_t;
+typedef void        (*cy_thread_entry_fn_t)(cy_thread_arg_t arg);
+typedef void        *cy_timer_callback_arg_t;
+typedef void        (*cy_timer_callback_t)(cy_timer_callback_arg_t arg);
+
+/* a started thread, the handle is NULL when not running */
+typedef struct cy_host_thread_s *cy_thread_t;
+
+typedef struct
+{
+    pthread_mutex_t     mutex;
+} cy_mutex_t;
+
+typedef struct
+{
+    pthread_mutex_t     mutex;
+    pthread_cond_t      cond;
+    uint32_t            count;
+    uint32_t            maxcount;
+} cy_semaphore_t;
+
+typedef struct
+{
+    pthread_mutex_t     mutex;
+    pthread_cond_t      cond;
+    uint32_t            bits;
+} cy_event_t;
+
+/* a timer runs its callback on its own thread, the handle is NULL when deinitialized */
+typedef struct cy_host_timer_s *cy_timer_t;
+
+/* Threads */
+cy_rslt_t cy_rtos_create_thread(cy_thread_t *thread, cy_thread_entry_fn_t entry_function,
+                                const char *name, void *stack, uint32_t stack_size,
+                                cy_thread_priority_t priority, cy_thread_arg_t arg);
+cy_rslt_t cy_rtos_exit_thread(void);
+cy_rslt_t cy_rtos_terminate_thread(cy_thread_t *thread);
+cy_rslt_t cy_rtos_join_thread(cy_thread_t *thread);
+cy_rslt_t cy_rtos_is_thread_running(cy_thread_t *thread, bool *running);
+
+/* Mutexes */
+cy_rslt_t cy_rtos_init_mutex2(cy_mutex_t *mutex, bool recursive);
+#define cy_rtos_init_mutex(mutex)       cy_rtos_init_mutex2(mutex, true)
+cy_rslt_t cy_rtos_get_mutex(cy_mutex_t *mutex, cy_time_t timeout_ms);
+cy_rslt_t cy_rtos_set_mutex(cy_mutex_t *mutex);
+cy_rslt_t cy_rtos_deinit_mutex(cy_mutex_t *mutex);
+
+/* Semaphores */
+cy_rslt_t cy_rtos_init_semaphore(cy_semaphore_t *semaphore, uint32_t maxcount, uint32_t initcount);
+cy_rslt_t cy_rtos_get_semaphore(cy_semaphore_t *semaphore, cy_time_t timeout_ms, bool in_isr);
+cy_rslt_t cy_rtos_set_semaphore(cy_semaphore_t *semaphore, bool in_isr);
+cy_rslt_t cy_rtos_get_count_semaphore(cy_semaphore_t *semaphore, size_t *count);
+cy_rslt_t cy_rtos_deinit_semaphore(cy_semaphore_t *semaphore);
+
+/* Events */
+cy_rslt_t cy_rtos_init_event(cy_event_t *event);
+cy_rslt_t cy_rtos_setbits_event(cy_event_t *event, uint32_t bits, bool in_isr);
+cy_rslt_t cy_rtos_clearbits_event(cy_event_t *event, uint32_t bits, bool in_isr);
+cy_rslt_t cy_rtos_getbits_event(cy_event_t *event, uint32_t *bits);
+cy_rslt_t cy_rtos_waitbits_event(cy_event_t *event, uint32_t *bits, bool clear, bool all, cy_time_t timeout);
+cy_rslt_t cy_rtos_deinit_event(cy_event_t *event);
+
+/* Timers */
+cy_rslt_t cy_rtos_init_timer(cy_timer_t *timer, cy_timer_trigger_type_t type,
+                             cy_timer_callback_t fun, cy_timer_callback_arg_t arg);
+cy_rslt_t cy_rtos_start_timer(cy_timer_t *timer, cy_time_t num_ms);
+cy_rslt_t cy_rtos_stop_timer(cy_timer_t *timer);
+cy_rslt_t cy_rtos_is_running_timer(cy_timer_t *timer, bool *state);
+cy_rslt_t cy_rtos_deinit_timer(cy_timer_t *timer);
+
+/* Time */
+cy_rslt_t cy_rtos_get_time(cy_time_t *tval);
+cy_rslt_t cy_rtos_delay_milliseconds(cy_time_t num_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYABS_RTOS_H__ */
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: the HAL and device definitions used by the OTA Agent
+ *
+ * The host models a PSoC 6 with 512 byte internal FLASH rows and a SMIF
+ * (QSPI) block for external FLASH.
+ */
+
+#ifndef CYHAL_H__
+#define CYHAL_H__ 1
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cy_result.h"
+
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE             static inline
+#endif
+
+#define CY_FLASH_BASE               (0x10000000UL)
+#define CY_FLASH_SIZE               (0x00200000UL)
+#define CY_FLASH_SIZEOF_ROW         (512UL)
+
+#ifndef CY_IP_MXSMIF
+#define CY_IP_MXSMIF                (1u)
+#endif
+
+/* reboot after an update, ota_host.c exits the process */
+void NVIC_SystemReset(void);
+
+#endif /* CYHAL_H__ */
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: FLASH emulator
+ *
+ * The flash_area_*() and ota_smif_*() calls work on a memory mapped file
+ * holding the Primary and Secondary Slots, the way the PSoC 6 parts do:
+ *
+ * Internal FLASH (0x10xxxxxx)
+ *  - Erases to 0x00, a row (CY_FLASH_SIZEOF_ROW) at a time.
+ *  - A write programs whole rows; a partial row is read, merged and
+ *    programmed (read-modify-write). Rows that would not change are not
+ *    programmed, as in psoc6_flash_write_hal().
+ *
+ * External FLASH (0x18xxxxxx, SMIF)
+ *  - Erases to 0xFF, whole sectors only; an erase that does not start or
+ *    end on a sector boundary erases the whole first / last sector, as
+ *    ota_smif_erase() does.
+ *  - A write can only clear bits (new = old & data). Bytes that needed a
+ *    bit set are counted as program violations: the data read back differs.
+ *
+ * The file keeps its contents between runs, so a run can start with the
+ * Slots left by an interrupted one.
+ *
+ * Internal FLASH is also mapped read only at its CPU address (fa_off), so
+ * code that reads memory mapped FLASH in place works as on the device.
+ * Those reads are not counted in the stats.
+ *
+ * Power loss
+ *  - power_cut_op cuts power during that program or erase operation
+ *    (1 = the first since init, the "ops" stat). The rows, pages or sectors
+ *    before the cut point are done, the one being worked on is left half
+ *    done: an internal row holds random data, an external page has some of
+ *    its bits programmed, an external sector some of its bits erased. The
+ *    process then exits with CY_FLASH_EMU_POWER_CUT_EXIT, the backing file
+ *    keeps the state for the next run.
+ *
+ * Timing and wear
+ *  - With a timing preset each operation adds its modelled device time to
+ *    the stats: Cy_Flash_WriteRow() / Cy_Flash_EraseRow() per internal row,
+ *    page program / sector erase / read per external operation, plus the
+ *    XIP off / on switch ota_serial_flash.c does around each SMIF access.
+ *    timing_scale > 0 also sleeps for that time (1.0 = real time), so the
+ *    OTA Agent state times match the device.
+ *  - Erase cycles are counted per internal row (a row write is an erase +
+ *    program) and per external sector. cy_flash_emu_get_erase_counts()
+ *    reports them per sector.
+ */
+
+#ifndef FLASH_EMU_H__
+#define FLASH_EMU_H__ 1
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cy_result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CY_FLASH_EMU_INTERNAL_ERASED_VAL    (0x00)
+#define CY_FLASH_EMU_EXTERNAL_ERASED_VAL    (0xFF)
+
+#define CY_FLASH_EMU_PRIMARY_OFFSET         (0x00018000UL)  /* after the bootloader   */
+#define CY_FLASH_EMU_SLOT_SIZE              (0x001C0000UL)  /* 1.75 MB                */
+#define CY_FLASH_EMU_EXT_SECTOR_SIZE        (0x00040000UL)  /* S25FL512S: 256 KB      */
+
+#define CY_FLASH_EMU_INT_SECTOR_SIZE        (0x00040000UL)  /* PSoC 6 256 KB sector   */
+
+#define CY_FLASH_EMU_POWER_CUT_EXIT         (3)             /* exit status after a power cut */
+
+/* Device timing, typical datasheet values. Internal is PSoC 6, external is a QSPI part. */
+typedef struct
+{
+    const char  *name;              /**< Preset name, the external part             */
+    uint32_t    row_write_us;       /**< Cy_Flash_WriteRow(), erase + program       */
+    uint32_t    row_erase_us;       /**< Cy_Flash_EraseRow()                        */
+    uint32_t    int_read_ns_per_byte; /**< internal read                            */
+    uint32_t    ext_page_size;      /**< external program page                      */
+    uint32_t    ext_page_program_us; /**< one page                                  */
+    uint32_t    ext_sector_size;    /**< external erase sector                      */
+    uint32_t    ext_sector_erase_us; /**< one sector                                */
+    uint32_t    ext_read_ns_per_byte; /**< quad SPI read                            */
+    uint32_t    ext_command_us;     /**< command + status polling per operation     */
+    uint32_t    xip_switch_us;      /**< one Cy_SMIF_SetMode() XIP off or on        */
+} cy_flash_emu_timing_t;
+
+typedef struct
+{
+    const char  *file;              /**< Backing file, created if missing           */
+    uint32_t    slot_size;          /**< Primary and Secondary Slot size            */
+    bool        secondary_external; /**< Secondary Slot in external (SMIF) FLASH    */
+    uint32_t    ext_sector_size;    /**< External erase sector, 0 = from the timing */
+    bool        erase;              /**< Erase both Slots at init                   */
+    const cy_flash_emu_timing_t *timing; /**< NULL = no timing model                */
+    double      timing_scale;       /**< > 0: sleep for the modelled time * scale   */
+    uint32_t    power_cut_op;       /**< Cut power in this program / erase, 0 = no  */
+    uint32_t    power_cut_seed;     /**< Where in the operation power is cut        */
+} cy_flash_emu_config_t;
+
+typedef struct
+{
+    uint32_t    reads;              /**< flash_area_read() / ota_smif_read() calls  */
+    uint64_t    read_bytes;
+    uint32_t    writes;             /**< write calls                                */
+    uint64_t    write_bytes;
+    uint32_t    rows_programmed;    /**< internal rows programmed                   */
+    uint32_t    rows_unchanged;     /**< internal rows skipped, data already there  */
+    uint32_t    rows_merged;        /**< internal rows written partially (RMW)      */
+    uint32_t    ext_pages_programmed; /**< external 256 byte pages programmed       */
+    uint32_t    erases;             /**< erase calls                                */
+    uint64_t    erase_bytes;        /**< bytes asked to be erased                   */
+    uint32_t    rows_erased;        /**< internal rows erased                       */
+    uint32_t    sectors_erased;     /**< external sectors erased                    */
+    uint32_t    program_violations; /**< external bytes written without an erase    */
+    uint32_t    xip_switches;       /**< XIP off / on switches                      */
+    uint32_t    ops;                /**< program and erase operations since init,
+                                         not cleared by cy_flash_emu_reset_stats()  */
+    uint64_t    read_us;            /**< modelled device time                       */
+    uint64_t    program_us;
+    uint64_t    erase_us;
+    uint64_t    xip_us;
+    uint64_t    busy_us;            /**< sum of the above                           */
+} cy_flash_emu_stats_t;
+
+cy_rslt_t cy_flash_emu_init(const cy_flash_emu_config_t *config);
+void cy_flash_emu_deinit(void);
+void cy_flash_emu_get_stats(cy_flash_emu_stats_t *stats);
+void cy_flash_emu_reset_stats(void);
+
+/* Timing presets, NULL terminated; NULL if the name is not known */
+extern const cy_flash_emu_timing_t cy_flash_emu_timing_presets[];
+const cy_flash_emu_timing_t *cy_flash_emu_find_timing(const char *name);
+
+/*
+ * Erase cycles per sector of a Slot (0 = Primary, 1 = Secondary).
+ * Internal FLASH reports the most cycled row of each 256 KB sector.
+ * Returns the number of sectors, fills up to max_counts of them.
+ */
+uint32_t cy_flash_emu_get_erase_counts(uint32_t slot, uint32_t *counts, uint32_t max_counts, uint32_t *sector_size);
+void cy_flash_emu_reset_wear(void);
+
+/* Write an image to the Primary Slot, as if it were programmed */
+cy_rslt_t cy_flash_emu_load_primary(const uint8_t *data, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLASH_EMU_H__ */
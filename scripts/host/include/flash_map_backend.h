@@ -0,0 +1,57 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: MCUboot flash map API, as in cy_flash_pal flash_map_backend.h
+ *
+ * Implemented by flash_emu.c on a memory mapped file.
+ */
+
+#ifndef __FLASH_MAP_BACKEND_H__
+#define __FLASH_MAP_BACKEND_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FLASH_DEVICE_INDEX_MASK                 (0x7F)
+#define FLASH_DEVICE_GET_EXT_INDEX(n)           ((n) & FLASH_DEVICE_INDEX_MASK)
+#define FLASH_DEVICE_EXTERNAL_FLAG              (0x80)
+#define FLASH_DEVICE_INTERNAL_FLASH             (0x7F)
+#define FLASH_DEVICE_EXTERNAL_FLASH(index)      (FLASH_DEVICE_EXTERNAL_FLAG | index)
+
+#ifndef CY_BOOT_EXTERNAL_DEVICE_INDEX
+#define CY_BOOT_EXTERNAL_DEVICE_INDEX           (0)
+#endif
+
+struct flash_area {
+    uint8_t fa_id;              /**< This flash area's ID; unique in the system */
+    uint8_t fa_device_id;       /**< ID of the flash device this area is a part of */
+    uint16_t pad16;
+    uint32_t fa_off;            /**< Absolute address, 0x18xxxxxx for external FLASH */
+    uint32_t fa_size;           /**< This area's size, in bytes */
+};
+
+int flash_area_open(uint8_t id, const struct flash_area **);
+void flash_area_close(const struct flash_area *);
+int flash_area_read(const struct flash_area *, uint32_t off, void *dst, uint32_t len);
+int flash_area_write(const struct flash_area *, uint32_t off, const void *src, uint32_t len);
+int flash_area_erase(const struct flash_area *, uint32_t off, uint32_t len);
+size_t flash_area_align(const struct flash_area *);
+uint8_t flash_area_erased_val(const struct flash_area *fap);
+int flash_area_read_is_empty(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len);
+
+#endif /* __FLASH_MAP_BACKEND_H__ */
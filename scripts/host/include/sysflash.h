@@ -0,0 +1,42 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: flash area IDs, as in the PSoC 6 MCUboot sysflash.h
+ *
+ * cy_ota_storage.c defines FLASH_AREA_IMAGE_PRIMARY() / _SECONDARY() itself.
+ */
+
+#ifndef __SYSFLASH_H__
+#define __SYSFLASH_H__
+
+#ifndef MCUBOOT_IMAGE_NUMBER
+#define MCUBOOT_IMAGE_NUMBER                (1)
+#endif
+
+#define FLASH_AREA_BOOTLOADER               (0)
+#define FLASH_AREA_IMAGE_0                  (1u)
+#define FLASH_AREA_IMAGE_1                  (2u)
+#define FLASH_AREA_IMAGE_SCRATCH            (3u)
+#define FLASH_AREA_IMAGE_2                  (4u)
+#define FLASH_AREA_IMAGE_3                  (5u)
+#define FLASH_AREA_IMAGE_SWAP_STATUS        (7u)
+
+#define CY_SMIF_BASE_MEM_OFFSET             (0x18000000)
+#define CY_FLASH_ALIGN                      (128)
+
+#endif /* __SYSFLASH_H__ */
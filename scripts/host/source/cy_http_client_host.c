@@ -0,0 +1,489 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: the http-client calls used by the OTA Agent, on BSD sockets
+ *
+ * HTTP/1.1 without TLS. cy_http_client_send() sends the request and reads
+ * the whole response into the request buffer, as the http-client library
+ * does with coreHTTP. A response that does not fit the buffer fails with
+ * CY_RSLT_HTTP_CLIENT_ERROR_NO_BUFFER.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "cy_http_client_api.h"
+#include "cy_log.h"
+
+#define HTTP_HOST_NAME_LEN      (128)
+#define HTTP_HEADER_END         "\r\n\r\n"
+
+typedef struct
+{
+    char                            host_name[HTTP_HOST_NAME_LEN];
+    uint16_t                        port;
+    int                             fd;                 /* -1 when not connected */
+    uint32_t                        send_timeout_ms;
+    uint32_t                        receive_timeout_ms;
+    cy_http_disconnect_callback_t   disconn_cb;
+    void                            *user_data;
+} host_http_client_t;
+
+static const char *http_method_string(cy_http_client_method_t method)
+{
+    switch (method)
+    {
+        case CY_HTTP_CLIENT_METHOD_PUT:  return "PUT";
+        case CY_HTTP_CLIENT_METHOD_POST: return "POST";
+        case CY_HTTP_CLIENT_METHOD_HEAD: return "HEAD";
+        case CY_HTTP_CLIENT_METHOD_GET:
+        default:                         return "GET";
+    }
+}
+
+static void http_set_timeout(int fd, int optname, uint32_t timeout_ms)
+{
+    struct timeval  tv;
+
+    tv.tv_sec  = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, optname, &tv, sizeof(tv));
+}
+
+static void http_close(host_http_client_t *client, bool notify)
+{
+    if (client->fd >= 0)
+    {
+        close(client->fd);
+        client->fd = -1;
+        if (notify && (client->disconn_cb != NULL) )
+        {
+            client->disconn_cb( (cy_http_client_t)client, CY_HTTP_CLIENT_DISCONN_TYPE_SERVER_INITIATED, client->user_data);
+        }
+    }
+}
+
+static bool http_send_all(int fd, const void *data, size_t len)
+{
+    const uint8_t   *ptr = (const uint8_t *)data;
+    ssize_t         sent;
+
+    while (len > 0)
+    {
+        sent = send(fd, ptr, len, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        ptr += sent;
+        len -= (size_t)sent;
+    }
+    return true;
+}
+
+/* case-insensitive search for "\r\n<field>:" in the response header, returns the value */
+static const char *http_find_field(const char *header, size_t header_len, const char *field, size_t field_len, size_t *value_len)
+{
+    const char  *line = header;
+    const char  *end = header + header_len;
+    const char  *eol;
+    const char  *value;
+
+    while (line < end)
+    {
+        eol = memchr(line, '\n', (size_t)(end - line));
+        if (eol == NULL)
+        {
+            eol = end;
+        }
+        if ( ( (size_t)(eol - line) > field_len) && (line[field_len] == ':') &&
+             (strncasecmp(line, field, field_len) == 0) )
+        {
+            value = &line[field_len + 1];
+            while ( (value < eol) && ( (*value == ' ') || (*value == '\t') ) )
+            {
+                value++;
+            }
+            *value_len = (size_t)(eol - value);
+            while ( (*value_len > 0) && isspace( (unsigned char)value[*value_len - 1]) )
+            {
+                (*value_len)--;
+            }
+            return value;
+        }
+        line = eol + 1;
+    }
+    return NULL;
+}
+
+cy_rslt_t cy_http_client_init(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_http_client_deinit(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_http_client_create(cy_awsport_ssl_credentials_t *security, cy_awsport_server_info_t *server_info,
+                                cy_http_disconnect_callback_t disconn_cb, void *user_data, cy_http_client_t *handle)
+{
+    host_http_client_t  *client;
+
+    if ( (server_info == NULL) || (server_info->host_name == NULL) || (handle == NULL) )
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_BADARG;
+    }
+    if (security != NULL)
+    {
+        cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() TLS is not supported on the host\n", __func__);
+        return CY_RSLT_HTTP_CLIENT_ERROR_UNSUPPORTED;
+    }
+
+    client = (host_http_client_t *)calloc(1, sizeof(host_http_client_t));
+    if (client == NULL)
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_NOMEM;
+    }
+    strncpy(client->host_name, server_info->host_name, sizeof(client->host_name) - 1);
+    client->port       = server_info->port;
+    client->fd         = -1;
+    client->disconn_cb = disconn_cb;
+    client->user_data  = user_data;
+    *handle = (cy_http_client_t)client;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_http_client_connect(cy_http_client_t handle, uint32_t send_timeout_ms, uint32_t receive_timeout_ms)
+{
+    host_http_client_t  *client = (host_http_client_t *)handle;
+    struct addrinfo     hints;
+    struct addrinfo     *info = NULL;
+    char                port[8];
+    int                 one = 1;
+
+    if (client == NULL)
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_BADARG;
+    }
+    if (client->fd >= 0)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    memset(&hints, 0x00, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port, sizeof(port), "%u", client->port);
+    if ( (getaddrinfo(client->host_name, port, &hints, &info) != 0) || (info == NULL) )
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_CONNECT_FAIL;
+    }
+    client->fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if ( (client->fd < 0) || (connect(client->fd, info->ai_addr, info->ai_addrlen) != 0) )
+    {
+        freeaddrinfo(info);
+        http_close(client, false);
+        return CY_RSLT_HTTP_CLIENT_ERROR_CONNECT_FAIL;
+    }
+    freeaddrinfo(info);
+
+    setsockopt(client->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    client->send_timeout_ms    = send_timeout_ms;
+    client->receive_timeout_ms = receive_timeout_ms;
+    http_set_timeout(client->fd, SO_SNDTIMEO, send_timeout_ms);
+    http_set_timeout(client->fd, SO_RCVTIMEO, receive_timeout_ms);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_http_client_write_header(cy_http_client_t handle, cy_http_client_request_header_t *request,
+                                      cy_http_client_header_t *header, uint32_t num_header)
+{
+    host_http_client_t  *client = (host_http_client_t *)handle;
+    char                *buf;
+    size_t              size;
+    size_t              len;
+    uint32_t            i;
+    int                 ret;
+
+    if ( (client == NULL) || (request == NULL) || (request->buffer == NULL) || (request->resource_path == NULL) )
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_BADARG;
+    }
+    buf  = (char *)request->buffer;
+    size = request->buffer_len;
+
+    ret = snprintf(buf, size, "%s %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: anycloud-ota-host\r\n",
+                   http_method_string(request->method), request->resource_path, client->host_name);
+    if ( (ret < 0) || ( (size_t)ret >= size) )
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_NO_BUFFER;
+    }
+    len = (size_t)ret;
+
+    if ( (request->range_start != 0) || (request->range_end != -1) )
+    {
+        if (request->range_end == -1)
+        {
+            ret = snprintf(&buf[len], size - len, "Range: bytes=%ld-\r\n", (long)request->range_start);
+        }
+        else
+        {
+            ret = snprintf(&buf[len], size - len, "Range: bytes=%ld-%ld\r\n", (long)request->range_start, (long)request->range_end);
+        }
+        if ( (ret < 0) || ( (size_t)ret >= (size - len) ) )
+        {
+            return CY_RSLT_HTTP_CLIENT_ERROR_NO_BUFFER;
+        }
+        len += (size_t)ret;
+    }
+
+    for (i = 0; (header != NULL) && (i < num_header); i++)
+    {
+        ret = snprintf(&buf[len], size - len, "%.*s: %.*s\r\n", (int)header[i].field_len, header[i].field,
+                       (int)header[i].value_len, header[i].value);
+        if ( (ret < 0) || ( (size_t)ret >= (size - len) ) )
+        {
+            return CY_RSLT_HTTP_CLIENT_ERROR_NO_BUFFER;
+        }
+        len += (size_t)ret;
+    }
+
+    /* the empty line is added by cy_http_client_send(), after Content-Length */
+    request->headers_len = len;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_http_client_send(cy_http_client_t handle, cy_http_client_request_header_t *request,
+                              uint8_t *payload, uint32_t payload_len, cy_http_client_response_t *response)
+{
+    host_http_client_t  *client = (host_http_client_t *)handle;
+    char                end_of_header[48];
+    char                *buf;
+    const char          *value;
+    const char          *header_end = NULL;
+    size_t              value_len;
+    size_t              fill = 0;
+    size_t              header_len = 0;
+    size_t              body_len = 0;
+    bool                have_length = false;
+    bool                close_after = false;
+    ssize_t             got;
+    unsigned int        status = 0;
+
+    if ( (client == NULL) || (request == NULL) || (request->buffer == NULL) || (response == NULL) )
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_BADARG;
+    }
+    if (client->fd < 0)
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_NOT_CONNECTED;
+    }
+    memset(response, 0x00, sizeof(cy_http_client_response_t));
+
+    if (payload_len > 0)
+    {
+        snprintf(end_of_header, sizeof(end_of_header), "Content-Length: %lu\r\n\r\n", (unsigned long)payload_len);
+    }
+    else
+    {
+        snprintf(end_of_header, sizeof(end_of_header), "\r\n");
+    }
+    if (!http_send_all(client->fd, request->buffer, request->headers_len) ||
+        !http_send_all(client->fd, end_of_header, strlen(end_of_header)) ||
+        ( (payload_len > 0) && !http_send_all(client->fd, payload, payload_len) ) )
+    {
+        http_close(client, true);
+        return CY_RSLT_HTTP_CLIENT_ERROR_NO_RESPONSE;
+    }
+
+    /* read the response into the request buffer, keep one byte for a terminating NUL */
+    buf = (char *)request->buffer;
+    for ( ; ; )
+    {
+        if (header_end != NULL)
+        {
+            if (have_length && (fill >= (header_len + body_len)) )
+            {
+                break;
+            }
+        }
+        if (fill >= (request->buffer_len - 1) )
+        {
+            cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() response does not fit the %ld byte buffer\n", __func__, request->buffer_len);
+            http_close(client, false);
+            return CY_RSLT_HTTP_CLIENT_ERROR_NO_BUFFER;
+        }
+
+        got = recv(client->fd, &buf[fill], request->buffer_len - 1 - fill, 0);
+        if ( (got < 0) && (errno == EINTR) )
+        {
+            continue;
+        }
+        if (got <= 0)
+        {
+            if ( (got == 0) && (header_end != NULL) && !have_length)
+            {
+                /* no Content-Length, the body ends with the connection */
+                body_len = fill - header_len;
+                close_after = true;
+                break;
+            }
+            http_close(client, true);
+            return CY_RSLT_HTTP_CLIENT_ERROR_NO_RESPONSE;
+        }
+        fill += (size_t)got;
+        buf[fill] = '\0';
+
+        if (header_end == NULL)
+        {
+            header_end = strstr(buf, HTTP_HEADER_END);
+            if (header_end == NULL)
+            {
+                continue;
+            }
+            header_len = (size_t)(header_end - buf) + strlen(HTTP_HEADER_END);
+            if (sscanf(buf, "HTTP/%*d.%*d %u", &status) != 1)
+            {
+                http_close(client, false);
+                return CY_RSLT_HTTP_CLIENT_ERROR_PARSER;
+            }
+
+            value = http_find_field(buf, header_len, "Connection", strlen("Connection"), &value_len);
+            close_after = ( (value != NULL) && (value_len == 5) && (strncasecmp(value, "close", 5) == 0) );
+
+            if ( (request->method == CY_HTTP_CLIENT_METHOD_HEAD) || (status == 204) || (status == 304) ||
+                 ( (status >= 100) && (status < 200) ) )
+            {
+                have_length = true;
+                body_len = 0;
+            }
+            else
+            {
+                value = http_find_field(buf, header_len, "Content-Length", strlen("Content-Length"), &value_len);
+                if (value != NULL)
+                {
+                    have_length = true;
+                    body_len = strtoul(value, NULL, 10);
+                }
+            }
+        }
+    }
+
+    response->status_code  = (uint16_t)status;
+    response->buffer       = request->buffer;
+    response->buffer_len   = request->buffer_len;
+    response->header       = request->buffer;
+    response->headers_len  = header_len;
+    response->body         = &request->buffer[header_len];
+    response->body_len     = body_len;
+    response->content_len  = body_len;
+    for (value = buf; (value = strstr(value, "\r\n")) != NULL && (value < &buf[header_len - 2]); value += 2)
+    {
+        response->header_count++;
+    }
+
+    if (close_after)
+    {
+        http_close(client, true);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_http_client_read_header(cy_http_client_t handle, cy_http_client_response_t *response,
+                                     cy_http_client_header_t *header, uint32_t num_header)
+{
+    const char  *value;
+    size_t      value_len;
+    uint32_t    i;
+
+    if ( (handle == NULL) || (response == NULL) || (response->header == NULL) || (header == NULL) )
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_BADARG;
+    }
+
+    for (i = 0; i < num_header; i++)
+    {
+        value = http_find_field( (const char *)response->header, response->headers_len,
+                                 header[i].field, header[i].field_len, &value_len);
+        if (value == NULL)
+        {
+            value_len = 0;
+            value = "";
+        }
+        if (header[i].value == NULL)
+        {
+            /* no buffer given, point into the response */
+            header[i].value     = (char *)value;
+            header[i].value_len = value_len;
+            continue;
+        }
+        if (header[i].value_len == 0)
+        {
+            continue;
+        }
+        if (value_len >= header[i].value_len)
+        {
+            value_len = header[i].value_len - 1;
+        }
+        memcpy(header[i].value, value, value_len);
+        header[i].value[value_len] = '\0';
+        header[i].value_len = value_len;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_http_client_disconnect(cy_http_client_t handle)
+{
+    host_http_client_t  *client = (host_http_client_t *)handle;
+
+    if (client == NULL)
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_BADARG;
+    }
+    http_close(client, false);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_http_client_delete(cy_http_client_t handle)
+{
+    host_http_client_t  *client = (host_http_client_t *)handle;
+
+    if (client == NULL)
+    {
+        return CY_RSLT_HTTP_CLIENT_ERROR_BADARG;
+    }
+    http_close(client, false);
+    free(client);
+    return CY_RSLT_SUCCESS;
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: JSON parser, as in connectivity-utilities cy_json_parser.c
+ *
+ * The registered callback is called with each name / value pair. Members of
+ * nested objects are reported with parent_object set; array elements have no
+ * name and are not reported. The input does not need to be NUL terminated.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "cy_json_parser.h"
+
+#define JSON_MAX_DEPTH      (8)
+
+typedef struct
+{
+    const char  *pos;
+    const char  *end;
+    int         depth;
+} json_parse_t;
+
+static cy_JSON_callback_t   json_callback;
+static void                 *json_callback_arg;
+
+static cy_rslt_t json_parse_value(json_parse_t *p, cy_JSON_object_t *object);
+
+static void json_skip_space(json_parse_t *p)
+{
+    while ( (p->pos < p->end) &&
+            ( (*p->pos == ' ') || (*p->pos == '\t') || (*p->pos == '\r') || (*p->pos == '\n') ) )
+    {
+        p->pos++;
+    }
+}
+
+/* string at p->pos (on the opening quote), returns the contents without the quotes */
+static cy_rslt_t json_parse_string(json_parse_t *p, char **str, uint32_t *len)
+{
+    const char  *start;
+
+    if ( (p->pos >= p->end) || (*p->pos != '"') )
+    {
+        return CY_RSLT_JSON_GENERIC_ERROR;
+    }
+    start = ++p->pos;
+    while ( (p->pos < p->end) && (*p->pos != '"') )
+    {
+        if (*p->pos == '\\')
+        {
+            p->pos++;
+        }
+        p->pos++;
+    }
+    if (p->pos >= p->end)
+    {
+        return CY_RSLT_JSON_GENERIC_ERROR;
+    }
+    *str = (char *)start;
+    *len = (uint32_t)(p->pos - start);
+    p->pos++;
+    return CY_RSLT_SUCCESS;
+}
+
+/* object or array at p->pos, object members are reported with parent set */
+static cy_rslt_t json_parse_container(json_parse_t *p, cy_JSON_object_t *parent)
+{
+    cy_JSON_object_t    member;
+    cy_rslt_t           result;
+    uint32_t            len;
+    char                close;
+    bool                is_object;
+
+    is_object = (*p->pos == '{');
+    close = is_object ? '}' : ']';
+    if (++p->depth > JSON_MAX_DEPTH)
+    {
+        return CY_RSLT_JSON_GENERIC_ERROR;
+    }
+    p->pos++;
+
+    json_skip_space(p);
+    if ( (p->pos < p->end) && (*p->pos == close) )
+    {
+        p->pos++;
+        p->depth--;
+        return CY_RSLT_SUCCESS;
+    }
+
+    while (p->pos < p->end)
+    {
+        memset(&member, 0x00, sizeof(member));
+        member.parent_object = parent;
+
+        json_skip_space(p);
+        if (is_object)
+        {
+            result = json_parse_string(p, &member.object_string, &len);
+            if (result != CY_RSLT_SUCCESS)
+            {
+                return result;
+            }
+            member.object_string_length = (len > UINT8_MAX) ? UINT8_MAX : (uint8_t)len;
+            json_skip_space(p);
+            if ( (p->pos >= p->end) || (*p->pos != ':') )
+            {
+                return CY_RSLT_JSON_GENERIC_ERROR;
+            }
+            p->pos++;
+        }
+
+        result = json_parse_value(p, &member);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            return result;
+        }
+        if (is_object && (member.value_type != JSON_OBJECT_TYPE) && (member.value_type != JSON_ARRAY_TYPE) &&
+            (json_callback != NULL) )
+        {
+            result = json_callback(&member, json_callback_arg);
+            if (result != CY_RSLT_SUCCESS)
+            {
+                return result;
+            }
+        }
+
+        json_skip_space(p);
+        if (p->pos >= p->end)
+        {
+            break;
+        }
+        if (*p->pos == ',')
+        {
+            p->pos++;
+            continue;
+        }
+        if (*p->pos == close)
+        {
+            p->pos++;
+            p->depth--;
+            return CY_RSLT_SUCCESS;
+        }
+        break;
+    }
+    return CY_RSLT_JSON_GENERIC_ERROR;
+}
+
+static cy_rslt_t json_parse_value(json_parse_t *p, cy_JSON_object_t *object)
+{
+    cy_rslt_t   result;
+    uint32_t    len;
+    const char  *start;
+
+    json_skip_space(p);
+    if (p->pos >= p->end)
+    {
+        return CY_RSLT_JSON_GENERIC_ERROR;
+    }
+
+    start = p->pos;
+    switch (*p->pos)
+    {
+        case '"':
+            object->value_type = JSON_STRING_TYPE;
+            result = json_parse_string(p, &object->value, &len);
+            object->value_length = (uint16_t)len;
+            return result;
+
+        case '{':
+        case '[':
+            object->value_type = (*p->pos == '{') ? JSON_OBJECT_TYPE : JSON_ARRAY_TYPE;
+            object->value = (char *)start;
+            result = json_parse_container(p, object);
+            object->value_length = (uint16_t)(p->pos - start);
+            return result;
+
+        default:
+            break;
+    }
+
+    /* number, true, false, null */
+    object->value_type = JSON_NUMBER_TYPE;
+    while ( (p->pos < p->end) && (strchr(",}] \t\r\n", *p->pos) == NULL) )
+    {
+        if ( (*p->pos == '.') || (*p->pos == 'e') || (*p->pos == 'E') )
+        {
+            object->value_type = JSON_FLOAT_TYPE;
+        }
+        p->pos++;
+    }
+    len = (uint32_t)(p->pos - start);
+    if (len == 0)
+    {
+        return CY_RSLT_JSON_GENERIC_ERROR;
+    }
+    if ( ( (len == 4) && (strncmp(start, "true", 4) == 0) ) || ( (len == 5) && (strncmp(start, "false", 5) == 0) ) )
+    {
+        object->value_type = JSON_BOOLEAN_TYPE;
+    }
+    else if ( (len == 4) && (strncmp(start, "null", 4) == 0) )
+    {
+        object->value_type = JSON_NULL_TYPE;
+    }
+    else if ( (*start != '-') && ( (*start < '0') || (*start > '9') ) )
+    {
+        return CY_RSLT_JSON_GENERIC_ERROR;
+    }
+    object->value = (char *)start;
+    object->value_length = (uint16_t)len;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_JSON_parser_register_callback(cy_JSON_callback_t callback, void *arg)
+{
+    json_callback     = callback;
+    json_callback_arg = arg;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_JSON_callback_t cy_JSON_parser_get_callback(void)
+{
+    return json_callback;
+}
+
+cy_rslt_t cy_JSON_parser(const char *json_input, uint32_t input_length)
+{
+    json_parse_t    p;
+
+    if ( (json_input == NULL) || (input_length == 0) )
+    {
+        return CY_RSLT_JSON_GENERIC_ERROR;
+    }
+    p.pos   = json_input;
+    p.end   = json_input + strnlen(json_input, input_length);
+    p.depth = 0;
+
+    json_skip_space(&p);
+    if ( (p.pos >= p.end) || (*p.pos != '{') )
+    {
+        return CY_RSLT_JSON_GENERIC_ERROR;
+    }
+    return json_parse_container(&p, NULL);
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: logging, as in connectivity-utilities cy_log.c
+ *
+ * Messages go to the platform output function given to cy_log_init(), or
+ * to stderr, with a millisecond time stamp in front.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "cyabs_rtos.h"
+#include "cy_log.h"
+
+#define CY_LOG_BUFFER_SIZE      (1024)
+
+static pthread_mutex_t      log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CY_LOG_LEVEL_T       log_levels[CYLF_MAX];
+static log_output           log_platform_output;
+static platform_get_time    log_platform_time;
+static char                 log_buffer[CY_LOG_BUFFER_SIZE];
+
+cy_rslt_t cy_log_init(CY_LOG_LEVEL_T level, log_output platform_output, platform_get_time platform_time)
+{
+    log_platform_output = platform_output;
+    log_platform_time   = platform_time;
+    return cy_log_set_all_levels(level);
+}
+
+cy_rslt_t cy_log_shutdown(void)
+{
+    log_platform_output = NULL;
+    log_platform_time   = NULL;
+    return cy_log_set_all_levels(CY_LOG_OFF);
+}
+
+cy_rslt_t cy_log_set_facility_level(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level)
+{
+    if ( (facility >= CYLF_MAX) || (level >= CY_LOG_MAX) )
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+    log_levels[facility] = level;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_log_set_all_levels(CY_LOG_LEVEL_T level)
+{
+    int facility;
+
+    if (level >= CY_LOG_MAX)
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+    for (facility = 0; facility < CYLF_MAX; facility++)
+    {
+        log_levels[facility] = level;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+CY_LOG_LEVEL_T cy_log_get_facility_level(CY_LOG_FACILITY_T facility)
+{
+    if (facility >= CYLF_MAX)
+    {
+        return CY_LOG_OFF;
+    }
+    return log_levels[facility];
+}
+
+cy_rslt_t cy_log_msg(CY_LOG_FACILITY_T facility, CY_LOG_LEVEL_T level, const char *fmt, ...)
+{
+    va_list     args;
+    uint32_t    time_ms;
+    int         len;
+
+    if ( (facility >= CYLF_MAX) || (level == CY_LOG_OFF) || (fmt == NULL) )
+    {
+        return CY_RSLT_TYPE_ERROR;
+    }
+    if ( (level != CY_LOG_PRINTF) && (level > log_levels[facility]) )
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    if (log_platform_time != NULL)
+    {
+        log_platform_time(&time_ms);
+    }
+    else
+    {
+        cy_rtos_get_time(&time_ms);
+    }
+
+    pthread_mutex_lock(&log_mutex);
+    len = snprintf(log_buffer, sizeof(log_buffer), "%02u:%02u:%02u.%03u ",
+                   (unsigned)( (time_ms / 3600000) % 24), (unsigned)( (time_ms / 60000) % 60),
+                   (unsigned)( (time_ms / 1000) % 60), (unsigned)(time_ms % 1000) );
+    va_start(args, fmt);
+    vsnprintf(&log_buffer[len], sizeof(log_buffer) - len, fmt, args);
+    va_end(args);
+
+    if (log_platform_output != NULL)
+    {
+        log_platform_output(facility, level, log_buffer);
+    }
+    else
+    {
+        fputs(log_buffer, stderr);
+    }
+    pthread_mutex_unlock(&log_mutex);
+
+    return CY_RSLT_SUCCESS;
+}
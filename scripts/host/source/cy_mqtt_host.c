@@ -0,0 +1,748 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: the mqtt library calls used by the OTA Agent
+ *
+ * A small MQTT 3.1.1 client on BSD sockets, no TLS, QoS 0 and 1.
+ * A receive thread reads all packets from the broker; PUBLISH messages are
+ * handed to the event callback from that thread and acknowledged after it
+ * returns. PUBACK, SUBACK and UNSUBACK wake the calling thread.
+ * A PINGREQ is sent when nothing was sent for half the keep alive time.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "cyabs_rtos.h"
+#include "cy_mqtt_api.h"
+#include "cy_log.h"
+
+#define MQTT_HOST_NAME_LEN          (128)
+#define MQTT_ACK_TIMEOUT_MS         (5000)
+#define MQTT_POLL_MS                (250)
+
+#define MQTT_PACKET_CONNECT         (0x10)
+#define MQTT_PACKET_CONNACK         (0x20)
+#define MQTT_PACKET_PUBLISH         (0x30)
+#define MQTT_PACKET_PUBACK          (0x40)
+#define MQTT_PACKET_SUBSCRIBE       (0x82)
+#define MQTT_PACKET_SUBACK          (0x90)
+#define MQTT_PACKET_UNSUBSCRIBE     (0xA2)
+#define MQTT_PACKET_UNSUBACK        (0xB0)
+#define MQTT_PACKET_PINGREQ         (0xC0)
+#define MQTT_PACKET_PINGRESP        (0xD0)
+#define MQTT_PACKET_DISCONNECT      (0xE0)
+
+typedef struct
+{
+    char                hostname[MQTT_HOST_NAME_LEN];
+    uint16_t            port;
+    cy_mqtt_callback_t  callback;
+    void                *user_data;
+
+    int                 fd;                 /* -1 when not connected */
+    pthread_t           rx_thread;
+    bool                rx_running;
+    volatile bool       stop;
+
+    pthread_mutex_t     send_mutex;         /* one packet at a time on the socket */
+    pthread_mutex_t     ack_mutex;
+    pthread_cond_t      ack_cond;
+    uint16_t            next_packet_id;
+    uint16_t            ack_packet_id;      /* last acknowledged packet id */
+    uint8_t             ack_type;
+    uint8_t             ack_code;           /* SUBACK return code */
+
+    uint16_t            keep_alive_sec;
+    cy_time_t           last_send_ms;
+} host_mqtt_t;
+
+/*-----------------------------------------------------------*/
+
+static size_t mqtt_put_length(uint8_t *out, size_t length)
+{
+    size_t  n = 0;
+
+    do
+    {
+        out[n] = (uint8_t)(length % 128);
+        length /= 128;
+        if (length > 0)
+        {
+            out[n] |= 0x80;
+        }
+        n++;
+    } while (length > 0);
+    return n;
+}
+
+static size_t mqtt_put_string(uint8_t *out, const char *str, uint16_t len)
+{
+    out[0] = (uint8_t)(len >> 8);
+    out[1] = (uint8_t)(len & 0xFF);
+    if (len > 0)
+    {
+        memcpy(&out[2], str, len);
+    }
+    return 2 + (size_t)len;
+}
+
+static bool mqtt_send_all(host_mqtt_t *mqtt, const uint8_t *data, size_t len)
+{
+    ssize_t sent;
+
+    while (len > 0)
+    {
+        sent = send(mqtt->fd, data, len, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        len  -= (size_t)sent;
+    }
+    cy_rtos_get_time(&mqtt->last_send_ms);
+    return true;
+}
+
+/* send fixed header type + body */
+static bool mqtt_send_packet(host_mqtt_t *mqtt, uint8_t type, const uint8_t *body, size_t body_len)
+{
+    uint8_t header[5];
+    size_t  header_len;
+    bool    ok;
+
+    header[0]  = type;
+    header_len = 1 + mqtt_put_length(&header[1], body_len);
+
+    pthread_mutex_lock(&mqtt->send_mutex);
+    ok = (mqtt->fd >= 0) && mqtt_send_all(mqtt, header, header_len) &&
+         ( (body_len == 0) || mqtt_send_all(mqtt, body, body_len) );
+    pthread_mutex_unlock(&mqtt->send_mutex);
+    return ok;
+}
+
+static bool mqtt_recv_all(int fd, uint8_t *data, size_t len, int *error)
+{
+    ssize_t got;
+
+    while (len > 0)
+    {
+        got = recv(fd, data, len, 0);
+        if (got < 0)
+        {
+            if ( (errno == EINTR) || (errno == EAGAIN) )
+            {
+                continue;
+            }
+            *error = errno;
+            return false;
+        }
+        if (got == 0)
+        {
+            *error = 0;
+            return false;
+        }
+        data += got;
+        len  -= (size_t)got;
+    }
+    return true;
+}
+
+/* read one packet, *body is malloc()ed */
+static bool mqtt_recv_packet(int fd, uint8_t *type, uint8_t **body, size_t *body_len, int *error)
+{
+    uint8_t byte;
+    size_t  length = 0;
+    size_t  multiplier = 1;
+    int     i;
+
+    *body = NULL;
+    if (!mqtt_recv_all(fd, type, 1, error) )
+    {
+        return false;
+    }
+    for (i = 0; i < 4; i++)
+    {
+        if (!mqtt_recv_all(fd, &byte, 1, error) )
+        {
+            return false;
+        }
+        length += (size_t)(byte & 0x7F) * multiplier;
+        multiplier *= 128;
+        if ( (byte & 0x80) == 0)
+        {
+            break;
+        }
+    }
+    *body_len = length;
+    *body = (uint8_t *)malloc(length + 1);
+    if (*body == NULL)
+    {
+        *error = ENOMEM;
+        return false;
+    }
+    if ( (length > 0) && !mqtt_recv_all(fd, *body, length, error) )
+    {
+        free(*body);
+        *body = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void mqtt_signal_ack(host_mqtt_t *mqtt, uint8_t type, uint16_t packet_id, uint8_t code)
+{
+    pthread_mutex_lock(&mqtt->ack_mutex);
+    mqtt->ack_type      = type;
+    mqtt->ack_packet_id = packet_id;
+    mqtt->ack_code      = code;
+    pthread_cond_broadcast(&mqtt->ack_cond);
+    pthread_mutex_unlock(&mqtt->ack_mutex);
+}
+
+/* wait for the ack of packet_id, false on timeout or disconnect */
+static bool mqtt_wait_ack(host_mqtt_t *mqtt, uint8_t type, uint16_t packet_id, uint8_t *code)
+{
+    struct timespec deadline;
+    bool            acked;
+
+    if (pthread_equal(pthread_self(), mqtt->rx_thread) )
+    {
+        /* called from the event callback, the ack is read after it returns */
+        return true;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += MQTT_ACK_TIMEOUT_MS / 1000;
+
+    pthread_mutex_lock(&mqtt->ack_mutex);
+    while ( !( (mqtt->ack_type == type) && (mqtt->ack_packet_id == packet_id) ) && (mqtt->fd >= 0) )
+    {
+        if (pthread_cond_timedwait(&mqtt->ack_cond, &mqtt->ack_mutex, &deadline) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    acked = (mqtt->ack_type == type) && (mqtt->ack_packet_id == packet_id);
+    if (code != NULL)
+    {
+        *code = mqtt->ack_code;
+    }
+    pthread_mutex_unlock(&mqtt->ack_mutex);
+    return acked;
+}
+
+static uint16_t mqtt_packet_id(host_mqtt_t *mqtt)
+{
+    uint16_t    id;
+
+    pthread_mutex_lock(&mqtt->ack_mutex);
+    mqtt->next_packet_id++;
+    if (mqtt->next_packet_id == 0)
+    {
+        mqtt->next_packet_id = 1;
+    }
+    id = mqtt->next_packet_id;
+    pthread_mutex_unlock(&mqtt->ack_mutex);
+    return id;
+}
+
+static void mqtt_handle_publish(host_mqtt_t *mqtt, uint8_t type, uint8_t *body, size_t body_len)
+{
+    cy_mqtt_event_t event;
+    uint8_t         ack[2];
+    uint16_t        topic_len;
+    size_t          pos;
+
+    if (body_len < 2)
+    {
+        return;
+    }
+    topic_len = (uint16_t)( (body[0] << 8) | body[1]);
+    pos = 2 + (size_t)topic_len;
+    if (pos > body_len)
+    {
+        return;
+    }
+
+    memset(&event, 0x00, sizeof(event));
+    event.type = CY_MQTT_EVENT_TYPE_PUBLISH_RECEIVE;
+    event.data.pub_msg.received_message.qos       = (cy_mqtt_qos_t)( (type >> 1) & 0x03);
+    event.data.pub_msg.received_message.retain    = ( (type & 0x01) != 0);
+    event.data.pub_msg.received_message.dup       = ( (type & 0x08) != 0);
+    event.data.pub_msg.received_message.topic     = (const char *)&body[2];
+    event.data.pub_msg.received_message.topic_len = topic_len;
+    if (event.data.pub_msg.received_message.qos > CY_MQTT_QOS0)
+    {
+        if ( (pos + 2) > body_len)
+        {
+            return;
+        }
+        event.data.pub_msg.packet_id = (uint16_t)( (body[pos] << 8) | body[pos + 1]);
+        pos += 2;
+    }
+    event.data.pub_msg.received_message.payload     = (const char *)&body[pos];
+    event.data.pub_msg.received_message.payload_len = body_len - pos;
+
+    if (mqtt->callback != NULL)
+    {
+        mqtt->callback( (cy_mqtt_t)mqtt, event, mqtt->user_data);
+    }
+
+    if (event.data.pub_msg.received_message.qos == CY_MQTT_QOS1)
+    {
+        ack[0] = (uint8_t)(event.data.pub_msg.packet_id >> 8);
+        ack[1] = (uint8_t)(event.data.pub_msg.packet_id & 0xFF);
+        mqtt_send_packet(mqtt, MQTT_PACKET_PUBACK, ack, sizeof(ack));
+    }
+}
+
+static void *mqtt_rx_thread(void *arg)
+{
+    host_mqtt_t     *mqtt = (host_mqtt_t *)arg;
+    struct pollfd   pfd;
+    cy_mqtt_event_t event;
+    cy_time_t       now;
+    uint8_t         type;
+    uint8_t         *body;
+    size_t          body_len;
+    int             error = 0;
+    int             ret;
+
+    pfd.fd     = mqtt->fd;
+    pfd.events = POLLIN;
+    while (!mqtt->stop)
+    {
+        ret = poll(&pfd, 1, MQTT_POLL_MS);
+        if (ret == 0)
+        {
+            cy_rtos_get_time(&now);
+            if ( (mqtt->keep_alive_sec > 0) && ( (now - mqtt->last_send_ms) > (mqtt->keep_alive_sec * 500U) ) )
+            {
+                mqtt_send_packet(mqtt, MQTT_PACKET_PINGREQ, NULL, 0);
+            }
+            continue;
+        }
+        if ( (ret < 0) && (errno == EINTR) )
+        {
+            continue;
+        }
+        if ( (ret < 0) || !mqtt_recv_packet(mqtt->fd, &type, &body, &body_len, &error) )
+        {
+            break;
+        }
+
+        switch (type & 0xF0)
+        {
+            case MQTT_PACKET_PUBLISH:
+                mqtt_handle_publish(mqtt, type, body, body_len);
+                break;
+            case MQTT_PACKET_PUBACK:
+            case MQTT_PACKET_UNSUBACK:
+                if (body_len >= 2)
+                {
+                    mqtt_signal_ack(mqtt, type & 0xF0, (uint16_t)( (body[0] << 8) | body[1]), 0);
+                }
+                break;
+            case MQTT_PACKET_SUBACK:
+                if (body_len >= 3)
+                {
+                    mqtt_signal_ack(mqtt, MQTT_PACKET_SUBACK, (uint16_t)( (body[0] << 8) | body[1]), body[2]);
+                }
+                break;
+            default:
+                break;
+        }
+        free(body);
+    }
+
+    if (!mqtt->stop)
+    {
+        /* connection lost, not a cy_mqtt_disconnect() */
+        cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_NOTICE, "%s() connection lost errno:%d\n", __func__, error);
+        pthread_mutex_lock(&mqtt->send_mutex);
+        shutdown(mqtt->fd, SHUT_RDWR);
+        pthread_mutex_unlock(&mqtt->send_mutex);
+        mqtt_signal_ack(mqtt, 0, 0, 0);
+
+        memset(&event, 0x00, sizeof(event));
+        event.type = CY_MQTT_EVENT_TYPE_DISCONNECT;
+        event.data.reason = (error == 0) ? CY_MQTT_DISCONN_TYPE_BROKER_DOWN : CY_MQTT_DISCONN_TYPE_NETWORK_DOWN;
+        if (mqtt->callback != NULL)
+        {
+            mqtt->callback( (cy_mqtt_t)mqtt, event, mqtt->user_data);
+        }
+    }
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_init(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_mqtt_deinit(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_mqtt_create(uint8_t *buffer, uint32_t buff_len, cy_awsport_ssl_credentials_t *security,
+                         cy_mqtt_broker_info_t *broker_info, cy_mqtt_callback_t event_callback,
+                         void *user_data, cy_mqtt_t *mqtt_handle)
+{
+    host_mqtt_t *mqtt;
+
+    (void)buffer;
+    if ( (broker_info == NULL) || (broker_info->hostname == NULL) || (mqtt_handle == NULL) ||
+         (buff_len < CY_MQTT_MIN_NETWORK_BUFFER_SIZE) )
+    {
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+    /* cy_ota_mqtt_connect() passes empty credentials for any port but 1883, that is plain MQTT here */
+    if ( (security != NULL) &&
+         ( (security->root_ca != NULL) || (security->client_cert != NULL) || (security->private_key != NULL) ) )
+    {
+        cy_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s() TLS is not supported on the host\n", __func__);
+        return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+    }
+
+    mqtt = (host_mqtt_t *)calloc(1, sizeof(host_mqtt_t));
+    if (mqtt == NULL)
+    {
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    snprintf(mqtt->hostname, sizeof(mqtt->hostname), "%.*s", broker_info->hostname_len, broker_info->hostname);
+    mqtt->port      = broker_info->port;
+    mqtt->callback  = event_callback;
+    mqtt->user_data = user_data;
+    mqtt->fd        = -1;
+    pthread_mutex_init(&mqtt->send_mutex, NULL);
+    pthread_mutex_init(&mqtt->ack_mutex, NULL);
+    pthread_cond_init(&mqtt->ack_cond, NULL);
+    *mqtt_handle = (cy_mqtt_t)mqtt;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_mqtt_connect(cy_mqtt_t mqtt_handle, cy_mqtt_connect_info_t *connect_info)
+{
+    host_mqtt_t     *mqtt = (host_mqtt_t *)mqtt_handle;
+    struct addrinfo hints;
+    struct addrinfo *info = NULL;
+    char            port[8];
+    uint8_t         *body;
+    uint8_t         type;
+    uint8_t         *ack = NULL;
+    size_t          ack_len;
+    size_t          len = 0;
+    uint8_t         flags = 0;
+    int             one = 1;
+    int             error;
+    bool            ok;
+
+    if ( (mqtt == NULL) || (connect_info == NULL) || (connect_info->client_id == NULL) )
+    {
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+    if (mqtt->fd >= 0)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    memset(&hints, 0x00, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port, sizeof(port), "%u", mqtt->port);
+    if ( (getaddrinfo(mqtt->hostname, port, &hints, &info) != 0) || (info == NULL) )
+    {
+        return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+    }
+    mqtt->fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if ( (mqtt->fd < 0) || (connect(mqtt->fd, info->ai_addr, info->ai_addrlen) != 0) )
+    {
+        freeaddrinfo(info);
+        if (mqtt->fd >= 0)
+        {
+            close(mqtt->fd);
+        }
+        mqtt->fd = -1;
+        return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+    }
+    freeaddrinfo(info);
+    setsockopt(mqtt->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    /* CONNECT */
+    body = (uint8_t *)malloc(64 + connect_info->client_id_len + connect_info->username_len + connect_info->password_len +
+                             ( (connect_info->will_info != NULL) ?
+                               (connect_info->will_info->topic_len + connect_info->will_info->payload_len) : 0) );
+    if (body == NULL)
+    {
+        close(mqtt->fd);
+        mqtt->fd = -1;
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    len += mqtt_put_string(&body[len], "MQTT", 4);
+    body[len++] = 4;                                        /* protocol level 3.1.1 */
+    if (connect_info->clean_session)
+    {
+        flags |= 0x02;
+    }
+    if (connect_info->will_info != NULL)
+    {
+        flags |= 0x04 | (uint8_t)( (connect_info->will_info->qos & 0x03) << 3);
+        if (connect_info->will_info->retain)
+        {
+            flags |= 0x20;
+        }
+    }
+    if ( (connect_info->username != NULL) && (connect_info->username_len > 0) )
+    {
+        flags |= 0x80;
+    }
+    if ( (connect_info->password != NULL) && (connect_info->password_len > 0) )
+    {
+        flags |= 0x40;
+    }
+    body[len++] = flags;
+    body[len++] = (uint8_t)(connect_info->keep_alive_sec >> 8);
+    body[len++] = (uint8_t)(connect_info->keep_alive_sec & 0xFF);
+    len += mqtt_put_string(&body[len], connect_info->client_id, connect_info->client_id_len);
+    if (connect_info->will_info != NULL)
+    {
+        len += mqtt_put_string(&body[len], connect_info->will_info->topic, connect_info->will_info->topic_len);
+        len += mqtt_put_string(&body[len], connect_info->will_info->payload, (uint16_t)connect_info->will_info->payload_len);
+    }
+    if (flags & 0x80)
+    {
+        len += mqtt_put_string(&body[len], connect_info->username, connect_info->username_len);
+    }
+    if (flags & 0x40)
+    {
+        len += mqtt_put_string(&body[len], connect_info->password, connect_info->password_len);
+    }
+    mqtt->keep_alive_sec = connect_info->keep_alive_sec;
+    ok = mqtt_send_packet(mqtt, MQTT_PACKET_CONNECT, body, len);
+    free(body);
+
+    /* CONNACK, before the receive thread starts */
+    ok = ok && mqtt_recv_packet(mqtt->fd, &type, &ack, &ack_len, &error) &&
+         ( (type & 0xF0) == MQTT_PACKET_CONNACK) && (ack_len >= 2) && (ack[1] == 0);
+    free(ack);
+    if (!ok)
+    {
+        close(mqtt->fd);
+        mqtt->fd = -1;
+        return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+    }
+
+    mqtt->stop = false;
+    if (pthread_create(&mqtt->rx_thread, NULL, mqtt_rx_thread, mqtt) != 0)
+    {
+        close(mqtt->fd);
+        mqtt->fd = -1;
+        return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+    }
+    mqtt->rx_running = true;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_mqtt_publish(cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pub_msg)
+{
+    host_mqtt_t *mqtt = (host_mqtt_t *)mqtt_handle;
+    uint8_t     *body;
+    size_t      len;
+    uint16_t    packet_id = 0;
+    uint8_t     type;
+    bool        ok;
+
+    if ( (mqtt == NULL) || (pub_msg == NULL) || (pub_msg->topic == NULL) || (pub_msg->qos > CY_MQTT_QOS1) )
+    {
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+    if (mqtt->fd < 0)
+    {
+        return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
+    }
+
+    body = (uint8_t *)malloc(4 + pub_msg->topic_len + pub_msg->payload_len);
+    if (body == NULL)
+    {
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    len = mqtt_put_string(body, pub_msg->topic, pub_msg->topic_len);
+    if (pub_msg->qos == CY_MQTT_QOS1)
+    {
+        packet_id = mqtt_packet_id(mqtt);
+        body[len++] = (uint8_t)(packet_id >> 8);
+        body[len++] = (uint8_t)(packet_id & 0xFF);
+    }
+    if (pub_msg->payload_len > 0)
+    {
+        memcpy(&body[len], pub_msg->payload, pub_msg->payload_len);
+        len += pub_msg->payload_len;
+    }
+    type = MQTT_PACKET_PUBLISH | (uint8_t)(pub_msg->qos << 1) | (pub_msg->retain ? 0x01 : 0x00) | (pub_msg->dup ? 0x08 : 0x00);
+    ok = mqtt_send_packet(mqtt, type, body, len);
+    free(body);
+
+    if (ok && (pub_msg->qos == CY_MQTT_QOS1) )
+    {
+        ok = mqtt_wait_ack(mqtt, MQTT_PACKET_PUBACK, packet_id, NULL);
+    }
+    return ok ? CY_RSLT_SUCCESS : CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+}
+
+/* SUBSCRIBE or UNSUBSCRIBE all topics in one packet */
+static cy_rslt_t mqtt_subscription(host_mqtt_t *mqtt, bool subscribe, cy_mqtt_subscribe_info_t *info, uint8_t count)
+{
+    uint8_t     *body;
+    size_t      len = 0;
+    size_t      size = 2;
+    uint16_t    packet_id;
+    uint8_t     code = 0;
+    uint8_t     i;
+    bool        ok;
+
+    if ( (mqtt == NULL) || (info == NULL) || (count == 0) )
+    {
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+    if (mqtt->fd < 0)
+    {
+        return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
+    }
+    for (i = 0; i < count; i++)
+    {
+        size += 3 + info[i].topic_len;
+    }
+    body = (uint8_t *)malloc(size);
+    if (body == NULL)
+    {
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+
+    packet_id = mqtt_packet_id(mqtt);
+    body[len++] = (uint8_t)(packet_id >> 8);
+    body[len++] = (uint8_t)(packet_id & 0xFF);
+    for (i = 0; i < count; i++)
+    {
+        len += mqtt_put_string(&body[len], info[i].topic, info[i].topic_len);
+        if (subscribe)
+        {
+            body[len++] = (uint8_t)info[i].qos;
+        }
+    }
+    ok = mqtt_send_packet(mqtt, subscribe ? MQTT_PACKET_SUBSCRIBE : MQTT_PACKET_UNSUBSCRIBE, body, len);
+    free(body);
+
+    if (ok)
+    {
+        ok = mqtt_wait_ack(mqtt, subscribe ? MQTT_PACKET_SUBACK : MQTT_PACKET_UNSUBACK, packet_id, &code);
+    }
+    if (subscribe)
+    {
+        ok = ok && (code != 0x80);
+        for (i = 0; i < count; i++)
+        {
+            info[i].allocated_qos = ok ? (cy_mqtt_qos_t)code : CY_MQTT_QOS_INVALID;
+        }
+        return ok ? CY_RSLT_SUCCESS : CY_RSLT_MODULE_MQTT_SUBSCRIBE_FAIL;
+    }
+    return ok ? CY_RSLT_SUCCESS : CY_RSLT_MODULE_MQTT_UNSUBSCRIBE_FAIL;
+}
+
+cy_rslt_t cy_mqtt_subscribe(cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *sub_info, uint8_t sub_count)
+{
+    return mqtt_subscription( (host_mqtt_t *)mqtt_handle, true, sub_info, sub_count);
+}
+
+cy_rslt_t cy_mqtt_unsubscribe(cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t *unsub_info, uint8_t unsub_count)
+{
+    return mqtt_subscription( (host_mqtt_t *)mqtt_handle, false, unsub_info, unsub_count);
+}
+
+cy_rslt_t cy_mqtt_disconnect(cy_mqtt_t mqtt_handle)
+{
+    host_mqtt_t *mqtt = (host_mqtt_t *)mqtt_handle;
+
+    if (mqtt == NULL)
+    {
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+    if (mqtt->fd < 0)
+    {
+        return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
+    }
+    mqtt->stop = true;
+    mqtt_send_packet(mqtt, MQTT_PACKET_DISCONNECT, NULL, 0);
+
+    pthread_mutex_lock(&mqtt->send_mutex);
+    shutdown(mqtt->fd, SHUT_RDWR);
+    pthread_mutex_unlock(&mqtt->send_mutex);
+    if (mqtt->rx_running && !pthread_equal(pthread_self(), mqtt->rx_thread) )
+    {
+        pthread_join(mqtt->rx_thread, NULL);
+        mqtt->rx_running = false;
+    }
+
+    pthread_mutex_lock(&mqtt->send_mutex);
+    close(mqtt->fd);
+    mqtt->fd = -1;
+    pthread_mutex_unlock(&mqtt->send_mutex);
+    mqtt_signal_ack(mqtt, 0, 0, 0);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_mqtt_delete(cy_mqtt_t mqtt_handle)
+{
+    host_mqtt_t *mqtt = (host_mqtt_t *)mqtt_handle;
+
+    if (mqtt == NULL)
+    {
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+    if (mqtt->fd >= 0)
+    {
+        cy_mqtt_disconnect(mqtt_handle);
+    }
+    if (mqtt->rx_running)
+    {
+        /* the connection was lost, the receive thread has ended */
+        pthread_join(mqtt->rx_thread, NULL);
+    }
+    pthread_cond_destroy(&mqtt->ack_cond);
+    pthread_mutex_destroy(&mqtt->ack_mutex);
+    pthread_mutex_destroy(&mqtt->send_mutex);
+    free(mqtt);
+    return CY_RSLT_SUCCESS;
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: the secure sockets calls used by the OTA Agent, on BSD sockets
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "cy_secure_sockets.h"
+
+typedef struct
+{
+    int     fd;
+} host_socket_t;
+
+static void host_socket_timeout(int fd, int optname, uint32_t timeout_ms)
+{
+    struct timeval  tv;
+
+    tv.tv_sec  = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, optname, &tv, sizeof(tv));
+}
+
+cy_rslt_t cy_socket_init(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_deinit(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_create(int domain, int type, int protocol, cy_socket_t *handle)
+{
+    host_socket_t   *sock;
+    int             one = 1;
+
+    if ( (domain != CY_SOCKET_DOMAIN_AF_INET) || (type != CY_SOCKET_TYPE_STREAM) ||
+         (protocol != CY_SOCKET_IPPROTO_TCP) || (handle == NULL) )
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_BADARG;
+    }
+    sock = (host_socket_t *)calloc(1, sizeof(host_socket_t));
+    if (sock == NULL)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_NOMEM;
+    }
+    sock->fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock->fd < 0)
+    {
+        free(sock);
+        return CY_RSLT_MODULE_SECURE_SOCKETS_TCPIP_ERROR;
+    }
+    setsockopt(sock->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    *handle = sock;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_setsockopt(cy_socket_t handle, int level, int optname, const void *optval, uint32_t optlen)
+{
+    host_socket_t   *sock = (host_socket_t *)handle;
+
+    if ( (sock == NULL) || (level != CY_SOCKET_SOL_SOCKET) || (optval == NULL) || (optlen < sizeof(uint32_t)) )
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_BADARG;
+    }
+    if (optname == CY_SOCKET_SO_RCVTIMEO)
+    {
+        host_socket_timeout(sock->fd, SO_RCVTIMEO, *(const uint32_t *)optval);
+    }
+    else if (optname == CY_SOCKET_SO_SNDTIMEO)
+    {
+        host_socket_timeout(sock->fd, SO_SNDTIMEO, *(const uint32_t *)optval);
+    }
+    else
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_BADARG;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_connect(cy_socket_t handle, cy_socket_sockaddr_t *address, uint32_t address_length)
+{
+    host_socket_t       *sock = (host_socket_t *)handle;
+    struct sockaddr_in  addr;
+
+    if ( (sock == NULL) || (address == NULL) || (address_length < sizeof(cy_socket_sockaddr_t)) )
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_BADARG;
+    }
+    memset(&addr, 0x00, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(address->port);
+    addr.sin_addr.s_addr = address->ip_address.ip.v4;
+    if (connect(sock->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_TCPIP_ERROR;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_send(cy_socket_t handle, const void *buffer, uint32_t length, int flags, uint32_t *bytes_sent)
+{
+    host_socket_t   *sock = (host_socket_t *)handle;
+    const uint8_t   *data = (const uint8_t *)buffer;
+    ssize_t         sent;
+    uint32_t        total = 0;
+
+    (void)flags;
+    if ( (sock == NULL) || (buffer == NULL) || (bytes_sent == NULL) )
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_BADARG;
+    }
+    while (total < length)
+    {
+        sent = send(sock->fd, &data[total], length - total, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            if ( (sent < 0) && (errno == EINTR) )
+            {
+                continue;
+            }
+            *bytes_sent = total;
+            return ( (sent < 0) && ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) ) ?
+                    CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT : CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+        }
+        total += (uint32_t)sent;
+    }
+    *bytes_sent = total;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_recv(cy_socket_t handle, void *buffer, uint32_t length, int flags, uint32_t *bytes_received)
+{
+    host_socket_t   *sock = (host_socket_t *)handle;
+    ssize_t         got;
+
+    (void)flags;
+    if ( (sock == NULL) || (buffer == NULL) || (bytes_received == NULL) )
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_BADARG;
+    }
+    *bytes_received = 0;
+    do
+    {
+        got = recv(sock->fd, buffer, length, 0);
+    } while ( (got < 0) && (errno == EINTR) );
+
+    if (got < 0)
+    {
+        return ( (errno == EAGAIN) || (errno == EWOULDBLOCK) ) ?
+                CY_RSLT_MODULE_SECURE_SOCKETS_TIMEOUT : CY_RSLT_MODULE_SECURE_SOCKETS_TCPIP_ERROR;
+    }
+    if (got == 0)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_CLOSED;
+    }
+    *bytes_received = (uint32_t)got;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_gethostbyname(const char *hostname, cy_socket_ip_version_t ip_ver, cy_socket_ip_address_t *addr)
+{
+    struct addrinfo hints;
+    struct addrinfo *info = NULL;
+
+    if ( (hostname == NULL) || (ip_ver != CY_SOCKET_IP_VER_V4) || (addr == NULL) )
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_BADARG;
+    }
+    memset(&hints, 0x00, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if ( (getaddrinfo(hostname, NULL, &hints, &info) != 0) || (info == NULL) )
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_HOST_NOT_FOUND;
+    }
+    addr->version = CY_SOCKET_IP_VER_V4;
+    addr->ip.v4   = ( (struct sockaddr_in *)info->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(info);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_disconnect(cy_socket_t handle, uint32_t timeout)
+{
+    host_socket_t   *sock = (host_socket_t *)handle;
+
+    (void)timeout;
+    if (sock == NULL)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_BADARG;
+    }
+    shutdown(sock->fd, SHUT_RDWR);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_socket_delete(cy_socket_t handle)
+{
+    host_socket_t   *sock = (host_socket_t *)handle;
+
+    if (sock == NULL)
+    {
+        return CY_RSLT_MODULE_SECURE_SOCKETS_BADARG;
+    }
+    close(sock->fd);
+    free(sock);
+    return CY_RSLT_SUCCESS;
+}
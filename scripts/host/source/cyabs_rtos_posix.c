@@ -0,0 +1,720 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: abstraction-rtos API on POSIX threads, and the FreeRTOS heap
+ *
+ * Timers run their callback from a thread of their own, as the FreeRTOS
+ * timer task would. Time is CLOCK_MONOTONIC in milliseconds.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "FreeRTOS.h"
+#include "cyabs_rtos.h"
+
+/***********************************************************************
+ *
+ * defines & structures
+ *
+ **********************************************************************/
+
+struct cy_host_thread_s
+{
+    pthread_t               thread;
+    cy_thread_entry_fn_t    entry;
+    cy_thread_arg_t         arg;
+};
+
+/* stored in front of each pvPortMalloc() block, keeps 16 byte alignment */
+typedef union
+{
+    size_t      size;
+    uint8_t     align[16];
+} heap_block_t;
+
+/***********************************************************************
+ *
+ * Variables
+ *
+ **********************************************************************/
+
+static pthread_mutex_t  heap_mutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t           heap_in_use;
+static size_t           heap_peak;
+
+/***********************************************************************
+ *
+ * Functions
+ *
+ **********************************************************************/
+
+static uint64_t host_time_ms(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ( (uint64_t)now.tv_sec * 1000) + ( (uint64_t)now.tv_nsec / 1000000);
+}
+
+/* absolute CLOCK_MONOTONIC time timeout_ms from now, for pthread_cond_timedwait() */
+static void host_deadline(struct timespec *ts, cy_time_t timeout_ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec  += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void host_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t  attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/* wait on cond, false on timeout; mutex is held */
+static bool host_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *deadline)
+{
+    if (deadline == NULL)
+    {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+    return (pthread_cond_timedwait(cond, mutex, deadline) != ETIMEDOUT);
+}
+
+/*-----------------------------------------------------------*/
+/* FreeRTOS heap */
+
+void *pvPortMalloc(size_t size)
+{
+    heap_block_t    *block;
+
+    block = (heap_block_t *)malloc(sizeof(heap_block_t) + size);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+    block->size = size;
+
+    pthread_mutex_lock(&heap_mutex);
+    heap_in_use += size;
+    if (heap_in_use > heap_peak)
+    {
+        heap_peak = heap_in_use;
+    }
+    pthread_mutex_unlock(&heap_mutex);
+
+    return (void *)(block + 1);
+}
+
+void vPortFree(void *ptr)
+{
+    heap_block_t    *block;
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+    block = ( (heap_block_t *)ptr) - 1;
+
+    pthread_mutex_lock(&heap_mutex);
+    heap_in_use -= block->size;
+    pthread_mutex_unlock(&heap_mutex);
+
+    free(block);
+}
+
+size_t cy_host_heap_in_use(void)
+{
+    return heap_in_use;
+}
+
+size_t cy_host_heap_peak(void)
+{
+    return heap_peak;
+}
+
+void cy_host_heap_reset_peak(void)
+{
+    pthread_mutex_lock(&heap_mutex);
+    heap_peak = heap_in_use;
+    pthread_mutex_unlock(&heap_mutex);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    cy_rtos_delay_milliseconds(ticks * portTICK_PERIOD_MS);
+}
+
+/*-----------------------------------------------------------*/
+/* Threads */
+
+static void *host_thread_main(void *arg)
+{
+    struct cy_host_thread_s *thread = (struct cy_host_thread_s *)arg;
+
+    thread->entry(thread->arg);
+    return NULL;
+}
+
+cy_rslt_t cy_rtos_create_thread(cy_thread_t *thread, cy_thread_entry_fn_t entry_function,
+                                const char *name, void *stack, uint32_t stack_size,
+                                cy_thread_priority_t priority, cy_thread_arg_t arg)
+{
+    struct cy_host_thread_s *new_thread;
+
+    (void)name;
+    (void)stack;
+    (void)stack_size;
+    (void)priority;
+
+    if ( (thread == NULL) || (entry_function == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+
+    new_thread = (struct cy_host_thread_s *)calloc(1, sizeof(struct cy_host_thread_s));
+    if (new_thread == NULL)
+    {
+        return CY_RTOS_NO_MEMORY;
+    }
+    new_thread->entry = entry_function;
+    new_thread->arg   = arg;
+
+    /* set the handle first, the new thread may look at it */
+    *thread = new_thread;
+    if (pthread_create(&new_thread->thread, NULL, host_thread_main, new_thread) != 0)
+    {
+        *thread = NULL;
+        free(new_thread);
+        return CY_RTOS_GENERAL_ERROR;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_exit_thread(void)
+{
+    pthread_exit(NULL);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_terminate_thread(cy_thread_t *thread)
+{
+    if ( (thread == NULL) || (*thread == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_cancel( (*thread)->thread);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_join_thread(cy_thread_t *thread)
+{
+    if ( (thread == NULL) || (*thread == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_join( (*thread)->thread, NULL);
+    free(*thread);
+    *thread = NULL;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_is_thread_running(cy_thread_t *thread, bool *running)
+{
+    if ( (thread == NULL) || (running == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    *running = (*thread != NULL);
+    return CY_RSLT_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Mutexes */
+
+cy_rslt_t cy_rtos_init_mutex2(cy_mutex_t *mutex, bool recursive)
+{
+    pthread_mutexattr_t attr;
+
+    if (mutex == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, recursive ? PTHREAD_MUTEX_RECURSIVE : PTHREAD_MUTEX_NORMAL);
+    pthread_mutex_init(&mutex->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_mutex(cy_mutex_t *mutex, cy_time_t timeout_ms)
+{
+    struct timespec deadline;
+
+    if (mutex == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    if (timeout_ms == CY_RTOS_NEVER_TIMEOUT)
+    {
+        pthread_mutex_lock(&mutex->mutex);
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* pthread_mutex_timedlock() uses CLOCK_REALTIME */
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec  += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return (pthread_mutex_timedlock(&mutex->mutex, &deadline) == 0) ? CY_RSLT_SUCCESS : CY_RTOS_TIMEOUT;
+}
+
+cy_rslt_t cy_rtos_set_mutex(cy_mutex_t *mutex)
+{
+    if (mutex == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    return (pthread_mutex_unlock(&mutex->mutex) == 0) ? CY_RSLT_SUCCESS : CY_RTOS_GENERAL_ERROR;
+}
+
+cy_rslt_t cy_rtos_deinit_mutex(cy_mutex_t *mutex)
+{
+    if (mutex == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_mutex_destroy(&mutex->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Semaphores */
+
+cy_rslt_t cy_rtos_init_semaphore(cy_semaphore_t *semaphore, uint32_t maxcount, uint32_t initcount)
+{
+    if ( (semaphore == NULL) || (maxcount == 0) || (initcount > maxcount) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_mutex_init(&semaphore->mutex, NULL);
+    host_cond_init(&semaphore->cond);
+    semaphore->count    = initcount;
+    semaphore->maxcount = maxcount;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_semaphore(cy_semaphore_t *semaphore, cy_time_t timeout_ms, bool in_isr)
+{
+    struct timespec deadline;
+    cy_rslt_t       result = CY_RSLT_SUCCESS;
+
+    (void)in_isr;
+    if (semaphore == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    if (timeout_ms != CY_RTOS_NEVER_TIMEOUT)
+    {
+        host_deadline(&deadline, timeout_ms);
+    }
+
+    pthread_mutex_lock(&semaphore->mutex);
+    while (semaphore->count == 0)
+    {
+        if (!host_cond_wait(&semaphore->cond, &semaphore->mutex,
+                            (timeout_ms == CY_RTOS_NEVER_TIMEOUT) ? NULL : &deadline) )
+        {
+            break;
+        }
+    }
+    if (semaphore->count > 0)
+    {
+        semaphore->count--;
+    }
+    else
+    {
+        result = CY_RTOS_TIMEOUT;
+    }
+    pthread_mutex_unlock(&semaphore->mutex);
+    return result;
+}
+
+cy_rslt_t cy_rtos_set_semaphore(cy_semaphore_t *semaphore, bool in_isr)
+{
+    cy_rslt_t   result = CY_RSLT_SUCCESS;
+
+    (void)in_isr;
+    if (semaphore == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_mutex_lock(&semaphore->mutex);
+    if (semaphore->count < semaphore->maxcount)
+    {
+        semaphore->count++;
+        pthread_cond_signal(&semaphore->cond);
+    }
+    else
+    {
+        /* xSemaphoreGive() fails on a full semaphore */
+        result = CY_RTOS_GENERAL_ERROR;
+    }
+    pthread_mutex_unlock(&semaphore->mutex);
+    return result;
+}
+
+cy_rslt_t cy_rtos_get_count_semaphore(cy_semaphore_t *semaphore, size_t *count)
+{
+    if ( (semaphore == NULL) || (count == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_mutex_lock(&semaphore->mutex);
+    *count = semaphore->count;
+    pthread_mutex_unlock(&semaphore->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_deinit_semaphore(cy_semaphore_t *semaphore)
+{
+    if (semaphore == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_cond_destroy(&semaphore->cond);
+    pthread_mutex_destroy(&semaphore->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Events */
+
+cy_rslt_t cy_rtos_init_event(cy_event_t *event)
+{
+    if (event == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_mutex_init(&event->mutex, NULL);
+    host_cond_init(&event->cond);
+    event->bits = 0;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_setbits_event(cy_event_t *event, uint32_t bits, bool in_isr)
+{
+    (void)in_isr;
+    if (event == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_mutex_lock(&event->mutex);
+    event->bits |= bits;
+    pthread_cond_broadcast(&event->cond);
+    pthread_mutex_unlock(&event->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_clearbits_event(cy_event_t *event, uint32_t bits, bool in_isr)
+{
+    (void)in_isr;
+    if (event == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_mutex_lock(&event->mutex);
+    event->bits &= ~bits;
+    pthread_mutex_unlock(&event->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_getbits_event(cy_event_t *event, uint32_t *bits)
+{
+    if ( (event == NULL) || (bits == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_mutex_lock(&event->mutex);
+    *bits = event->bits;
+    pthread_mutex_unlock(&event->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_waitbits_event(cy_event_t *event, uint32_t *bits, bool clear, bool all, cy_time_t timeout)
+{
+    struct timespec deadline;
+    uint32_t        wanted;
+    bool            done;
+
+    if ( (event == NULL) || (bits == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    wanted = *bits;
+    if (timeout != CY_RTOS_NEVER_TIMEOUT)
+    {
+        host_deadline(&deadline, timeout);
+    }
+
+    pthread_mutex_lock(&event->mutex);
+    for ( ; ; )
+    {
+        done = all ? ( (event->bits & wanted) == wanted) : ( (event->bits & wanted) != 0);
+        if (done || (timeout == 0) )
+        {
+            break;
+        }
+        if (!host_cond_wait(&event->cond, &event->mutex, (timeout == CY_RTOS_NEVER_TIMEOUT) ? NULL : &deadline) )
+        {
+            done = all ? ( (event->bits & wanted) == wanted) : ( (event->bits & wanted) != 0);
+            break;
+        }
+    }
+    /* as xEventGroupWaitBits(), the bits at the time the wait ended */
+    *bits = event->bits;
+    if (done && clear)
+    {
+        event->bits &= ~wanted;
+    }
+    pthread_mutex_unlock(&event->mutex);
+
+    return done ? CY_RSLT_SUCCESS : CY_RTOS_TIMEOUT;
+}
+
+cy_rslt_t cy_rtos_deinit_event(cy_event_t *event)
+{
+    if (event == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    pthread_cond_destroy(&event->cond);
+    pthread_mutex_destroy(&event->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Timers */
+
+struct cy_host_timer_s
+{
+    pthread_t               thread;
+    pthread_mutex_t         mutex;
+    pthread_cond_t          cond;
+    cy_timer_trigger_type_t type;
+    cy_timer_callback_t     callback;
+    cy_timer_callback_arg_t arg;
+    uint64_t                deadline_ms;    /* 0 = not running */
+    cy_time_t               period_ms;
+    bool                    exit;
+    bool                    detached;       /* deinit from the callback, the thread frees the timer */
+};
+
+static void host_timer_free(struct cy_host_timer_s *t)
+{
+    pthread_cond_destroy(&t->cond);
+    pthread_mutex_destroy(&t->mutex);
+    free(t);
+}
+
+static void *host_timer_thread(void *arg)
+{
+    struct cy_host_timer_s  *t = (struct cy_host_timer_s *)arg;
+    struct timespec         deadline;
+    uint64_t                now;
+    bool                    detached;
+
+    pthread_mutex_lock(&t->mutex);
+    while (!t->exit)
+    {
+        if (t->deadline_ms == 0)
+        {
+            pthread_cond_wait(&t->cond, &t->mutex);
+            continue;
+        }
+
+        now = host_time_ms();
+        if (now < t->deadline_ms)
+        {
+            host_deadline(&deadline, (cy_time_t)(t->deadline_ms - now));
+            host_cond_wait(&t->cond, &t->mutex, &deadline);
+            continue;
+        }
+
+        /* expired */
+        t->deadline_ms = (t->type == CY_TIMER_TYPE_PERIODIC) ? (now + t->period_ms) : 0;
+        pthread_mutex_unlock(&t->mutex);
+        t->callback(t->arg);
+        pthread_mutex_lock(&t->mutex);
+    }
+    detached = t->detached;
+    pthread_mutex_unlock(&t->mutex);
+    if (detached)
+    {
+        host_timer_free(t);
+    }
+    return NULL;
+}
+
+cy_rslt_t cy_rtos_init_timer(cy_timer_t *timer, cy_timer_trigger_type_t type,
+                             cy_timer_callback_t fun, cy_timer_callback_arg_t arg)
+{
+    struct cy_host_timer_s  *t;
+
+    if ( (timer == NULL) || (fun == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    t = (struct cy_host_timer_s *)calloc(1, sizeof(struct cy_host_timer_s));
+    if (t == NULL)
+    {
+        return CY_RTOS_NO_MEMORY;
+    }
+    pthread_mutex_init(&t->mutex, NULL);
+    host_cond_init(&t->cond);
+    t->type     = type;
+    t->callback = fun;
+    t->arg      = arg;
+    if (pthread_create(&t->thread, NULL, host_timer_thread, t) != 0)
+    {
+        host_timer_free(t);
+        return CY_RTOS_GENERAL_ERROR;
+    }
+    *timer = t;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_start_timer(cy_timer_t *timer, cy_time_t num_ms)
+{
+    struct cy_host_timer_s  *t;
+
+    if ( (timer == NULL) || (*timer == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    t = *timer;
+    pthread_mutex_lock(&t->mutex);
+    t->period_ms   = (num_ms == 0) ? 1 : num_ms;
+    t->deadline_ms = host_time_ms() + t->period_ms;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_stop_timer(cy_timer_t *timer)
+{
+    struct cy_host_timer_s  *t;
+
+    if ( (timer == NULL) || (*timer == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    t = *timer;
+    pthread_mutex_lock(&t->mutex);
+    t->deadline_ms = 0;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_is_running_timer(cy_timer_t *timer, bool *state)
+{
+    struct cy_host_timer_s  *t;
+
+    if ( (timer == NULL) || (*timer == NULL) || (state == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    t = *timer;
+    pthread_mutex_lock(&t->mutex);
+    *state = (t->deadline_ms != 0);
+    pthread_mutex_unlock(&t->mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_deinit_timer(cy_timer_t *timer)
+{
+    struct cy_host_timer_s  *t;
+
+    if ( (timer == NULL) || (*timer == NULL) )
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    t = *timer;
+    *timer = NULL;
+
+    pthread_mutex_lock(&t->mutex);
+    t->exit = true;
+    t->deadline_ms = 0;
+    t->detached = pthread_equal(pthread_self(), t->thread);
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->mutex);
+
+    if (t->detached)
+    {
+        /* deinit from the timer callback, the thread ends when the callback returns */
+        pthread_detach(t->thread);
+        return CY_RSLT_SUCCESS;
+    }
+    pthread_join(t->thread, NULL);
+    host_timer_free(t);
+    return CY_RSLT_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* Time */
+
+cy_rslt_t cy_rtos_get_time(cy_time_t *tval)
+{
+    if (tval == NULL)
+    {
+        return CY_RTOS_BAD_PARAM;
+    }
+    *tval = (cy_time_t)host_time_ms();
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_delay_milliseconds(cy_time_t num_ms)
+{
+    struct timespec delay;
+
+    delay.tv_sec  = num_ms / 1000;
+    delay.tv_nsec = (long)(num_ms % 1000) * 1000000L;
+    while ( (nanosleep(&delay, &delay) != 0) && (errno == EINTR) )
+    {
+    }
+    return CY_RSLT_SUCCESS;
+}
@@ -0,0 +1,830 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: FLASH emulator, see flash_emu.h
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "cyhal.h"
+#include "sysflash.h"
+#include "flash_map_backend.h"
+#include "ota_serial_flash.h"
+#include "flash_emu.h"
+#include "cy_log.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE     (0)         /* older C library: a hint, the address is checked */
+#endif
+
+#define FLASH_EMU_EXT_PAGE_SIZE     (256UL)
+
+/* modelled time buckets */
+#define FLASH_EMU_TIME_READ         (0)
+#define FLASH_EMU_TIME_PROGRAM      (1)
+#define FLASH_EMU_TIME_ERASE        (2)
+#define FLASH_EMU_TIME_XIP          (3)
+#define FLASH_EMU_TIME_BUCKETS      (4)
+
+#define FLASH_EMU_NO_CUT            (0xFFFFFFFFUL)
+
+typedef struct
+{
+    cy_flash_emu_config_t   config;
+    int                     fd;
+    uint8_t                 *map;           /* Primary Slot, then Secondary Slot */
+    uint8_t                 *cpu_map;       /* read only view at the internal FLASH address */
+    size_t                  map_size;
+    struct flash_area       primary;
+    struct flash_area       secondary;
+    cy_flash_emu_stats_t    stats;
+    pthread_mutex_t         mutex;
+
+    const cy_flash_emu_timing_t *timing;
+    uint32_t                ext_page_size;
+    uint64_t                time_ns[FLASH_EMU_TIME_BUCKETS];
+    uint32_t                *row_cycles[2];     /* erase cycles per internal row of each Slot */
+    uint32_t                *sector_cycles;     /* erase cycles per external sector           */
+    uint32_t                ops;                /* program and erase operations since init    */
+    unsigned int            noise_seed;         /* rand_r() state for the power cut           */
+} flash_emu_t;
+
+static flash_emu_t flash_emu = { .fd = -1 };
+
+/* Typical datasheet values: PSoC 6 internal FLASH with the QSPI part in the name */
+const cy_flash_emu_timing_t cy_flash_emu_timing_presets[] =
+{
+    /* name          row write  row erase  int rd  page  program  sector   sector erase  ext rd  cmd  xip */
+    { "psoc6",       16000,     11000,     5,      256,  0,       0x40000, 0,            0,      0,   0  },
+    { "s25fl512s",   16000,     11000,     5,      512,  340,     0x40000, 520000,       40,     5,   10 },
+    { "s25fl128s",   16000,     11000,     5,      256,  250,     0x10000, 130000,       40,     5,   10 },
+    { "s25fl064l",   16000,     11000,     5,      256,  450,     0x01000, 50000,        40,     5,   10 },
+    { NULL,          0,         0,         0,      0,    0,       0,       0,            0,      0,   0  },
+};
+
+/*-----------------------------------------------------------*/
+
+static inline bool flash_emu_is_external(const struct flash_area *fap)
+{
+    return (fap->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) != 0;
+}
+
+/* backing store for a flash area */
+static uint8_t *flash_emu_area_base(const struct flash_area *fap)
+{
+    return (fap->fa_id == flash_emu.primary.fa_id) ? flash_emu.map : (flash_emu.map + flash_emu.config.slot_size);
+}
+
+static inline uint32_t flash_emu_slot(const struct flash_area *fap)
+{
+    return (fap->fa_id == flash_emu.primary.fa_id) ? 0 : 1;
+}
+
+/* add modelled device time, sleep for it when asked to */
+static void flash_emu_delay(uint32_t bucket, uint64_t ns)
+{
+    struct timespec ts;
+    double          sleep_ns;
+
+    if ( (flash_emu.timing == NULL) || (ns == 0) )
+    {
+        return;
+    }
+    flash_emu.time_ns[bucket] += ns;
+    if (flash_emu.config.timing_scale > 0.0)
+    {
+        sleep_ns = (double)ns * flash_emu.config.timing_scale;
+        ts.tv_sec  = (time_t)(sleep_ns / 1e9);
+        ts.tv_nsec = (long)(sleep_ns - ( (double)ts.tv_sec * 1e9) );
+        while (nanosleep(&ts, &ts) != 0)
+        {
+        }
+    }
+}
+
+/* ota_serial_flash.c turns XIP off before and on after each SMIF access */
+static void flash_emu_xip_switch(void)
+{
+    if (flash_emu.timing != NULL)
+    {
+        flash_emu.stats.xip_switches += 2;
+        flash_emu_delay(FLASH_EMU_TIME_XIP, 2000ULL * flash_emu.timing->xip_switch_us);
+    }
+}
+
+/* count a program or erase operation of "units" rows, pages or sectors, returns the unit power is cut in */
+static uint32_t flash_emu_next_op(uint32_t units)
+{
+    flash_emu.ops++;
+    if ( (flash_emu.config.power_cut_op == 0) || (flash_emu.ops != flash_emu.config.power_cut_op) || (units == 0) )
+    {
+        return FLASH_EMU_NO_CUT;
+    }
+    flash_emu.noise_seed = flash_emu.config.power_cut_seed;
+    return (uint32_t)rand_r(&flash_emu.noise_seed) % units;
+}
+
+/* bits of the unit power was cut in: 1 = got to the new value, 0 = kept the old one */
+static inline uint8_t flash_emu_noise(void)
+{
+    return (uint8_t)rand_r(&flash_emu.noise_seed);
+}
+
+/* the backing file keeps what was done, the process stops as a reset would */
+static void flash_emu_power_off(void)
+{
+    msync(flash_emu.map, flash_emu.map_size, MS_SYNC);
+    printf("FLASH power cut in operation %lu\n", (unsigned long)flash_emu.ops);
+    fflush(stdout);
+    _exit(CY_FLASH_EMU_POWER_CUT_EXIT);
+}
+
+static bool flash_emu_area_check(const struct flash_area *fap, uint32_t off, uint32_t len)
+{
+    if ( (flash_emu.map == NULL) || (fap == NULL) ||
+         ( (fap != &flash_emu.primary) && (fap != &flash_emu.secondary) ) )
+    {
+        return false;
+    }
+    return (off <= fap->fa_size) && (len <= (fap->fa_size - off) );
+}
+
+/* internal FLASH: program whole rows, merging partial rows and skipping unchanged ones */
+static void flash_emu_internal_write(const struct flash_area *fap, uint32_t off, const uint8_t *src, uint32_t len)
+{
+    uint8_t     *base = flash_emu_area_base(fap);
+    uint8_t     row[CY_FLASH_SIZEOF_ROW];
+    uint8_t     *dst;
+    uint32_t    addr = fap->fa_off + off;
+    uint32_t    row_start;
+    uint32_t    chunk;
+    uint32_t    cut;
+    uint32_t    i;
+    uint8_t     noise;
+
+    cut = flash_emu_next_op( (len == 0) ? 0 : ( ( (addr + len - 1) / CY_FLASH_SIZEOF_ROW) - (addr / CY_FLASH_SIZEOF_ROW) + 1) );
+    while (len > 0)
+    {
+        row_start = addr & ~(CY_FLASH_SIZEOF_ROW - 1);
+        chunk = (uint32_t)(row_start + CY_FLASH_SIZEOF_ROW - addr);
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        if (cut-- == 0)
+        {
+            /* Cy_Flash_WriteRow() erases and programs the whole row */
+            dst = &base[row_start - fap->fa_off];
+            memcpy(row, dst, CY_FLASH_SIZEOF_ROW);
+            memcpy(&row[addr - row_start], src, chunk);
+            for (i = 0; i < CY_FLASH_SIZEOF_ROW; i++)
+            {
+                noise  = flash_emu_noise();
+                dst[i] = (uint8_t)( (dst[i] & ~noise) | (row[i] & noise) );
+            }
+            flash_emu_power_off();
+        }
+        if (memcmp(&base[addr - fap->fa_off], src, chunk) == 0)
+        {
+            flash_emu.stats.rows_unchanged++;
+        }
+        else
+        {
+            if (chunk != CY_FLASH_SIZEOF_ROW)
+            {
+                flash_emu.stats.rows_merged++;
+            }
+            memcpy(&base[addr - fap->fa_off], src, chunk);
+            flash_emu.stats.rows_programmed++;
+            flash_emu.row_cycles[flash_emu_slot(fap)][(row_start - fap->fa_off) / CY_FLASH_SIZEOF_ROW]++;
+            if (flash_emu.timing != NULL)
+            {
+                flash_emu_delay(FLASH_EMU_TIME_PROGRAM, 1000ULL * flash_emu.timing->row_write_us);
+            }
+        }
+        addr += chunk;
+        src  += chunk;
+        len  -= chunk;
+    }
+}
+
+/* internal FLASH: erase rows, a partial row is erased and the rest written back (psoc6_flash_erase()) */
+static void flash_emu_internal_erase(const struct flash_area *fap, uint32_t off, uint32_t len)
+{
+    uint32_t    *cycles = flash_emu.row_cycles[flash_emu_slot(fap)];
+    uint8_t     *base = flash_emu_area_base(fap);
+    uint32_t    start = fap->fa_off + off;
+    uint32_t    end   = start + len;
+    uint32_t    row;
+    uint32_t    row_start;
+    uint32_t    from;
+    uint32_t    to;
+    uint32_t    cut;
+
+    cut = flash_emu_next_op( ( (end + CY_FLASH_SIZEOF_ROW - 1) / CY_FLASH_SIZEOF_ROW) - (start / CY_FLASH_SIZEOF_ROW) );
+    for (row = start / CY_FLASH_SIZEOF_ROW; (row * CY_FLASH_SIZEOF_ROW) < end; row++)
+    {
+        row_start = row * CY_FLASH_SIZEOF_ROW;
+        from = (row_start < start) ? start : row_start;
+        to   = ( (row_start + CY_FLASH_SIZEOF_ROW) > end) ? end : (row_start + CY_FLASH_SIZEOF_ROW);
+        if (cut-- == 0)
+        {
+            for ( ; from < to; from++)
+            {
+                base[from - fap->fa_off] &= (uint8_t)~flash_emu_noise();
+            }
+            flash_emu_power_off();
+        }
+        memset(&base[from - fap->fa_off], CY_FLASH_EMU_INTERNAL_ERASED_VAL, to - from);
+        cycles[(row_start - fap->fa_off) / CY_FLASH_SIZEOF_ROW]++;
+        flash_emu.stats.rows_erased++;
+        if (flash_emu.timing != NULL)
+        {
+            flash_emu_delay(FLASH_EMU_TIME_ERASE, 1000ULL * flash_emu.timing->row_erase_us);
+        }
+        if ( (row_start < start) || ( (row_start + CY_FLASH_SIZEOF_ROW) > end) )
+        {
+            /* kept part of the row is written back */
+            cycles[(row_start - fap->fa_off) / CY_FLASH_SIZEOF_ROW]++;
+            if (flash_emu.timing != NULL)
+            {
+                flash_emu_delay(FLASH_EMU_TIME_PROGRAM, 1000ULL * flash_emu.timing->row_write_us);
+            }
+        }
+    }
+}
+
+/* external address or XIP address to an offset in the Secondary Slot */
+static bool flash_emu_ext_offset(uint32_t *addr, size_t len)
+{
+    if (*addr >= CY_SMIF_BASE_MEM_OFFSET)
+    {
+        *addr -= CY_SMIF_BASE_MEM_OFFSET;
+    }
+    return (flash_emu.map != NULL) && flash_emu.config.secondary_external &&
+           (*addr <= flash_emu.config.slot_size) && (len <= (flash_emu.config.slot_size - *addr) );
+}
+
+static void flash_emu_fill_erased(void)
+{
+    memset(flash_emu.map, CY_FLASH_EMU_INTERNAL_ERASED_VAL, flash_emu.config.slot_size);
+    memset(flash_emu.map + flash_emu.config.slot_size,
+           flash_emu.config.secondary_external ? CY_FLASH_EMU_EXTERNAL_ERASED_VAL : CY_FLASH_EMU_INTERNAL_ERASED_VAL,
+           flash_emu.config.slot_size);
+}
+
+/*-----------------------------------------------------------*/
+/* Emulator control */
+
+cy_rslt_t cy_flash_emu_init(const cy_flash_emu_config_t *config)
+{
+    struct stat st;
+    bool        fresh;
+
+    if ( (config == NULL) || (config->file == NULL) || (flash_emu.map != NULL) )
+    {
+        return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+    }
+    flash_emu.config = *config;
+    if (flash_emu.config.slot_size == 0)
+    {
+        flash_emu.config.slot_size = CY_FLASH_EMU_SLOT_SIZE;
+    }
+    flash_emu.timing = config->timing;
+    if (flash_emu.config.ext_sector_size == 0)
+    {
+        flash_emu.config.ext_sector_size = ( (flash_emu.timing != NULL) && (flash_emu.timing->ext_sector_size != 0) ) ?
+                                           flash_emu.timing->ext_sector_size : CY_FLASH_EMU_EXT_SECTOR_SIZE;
+    }
+    flash_emu.ext_page_size = ( (flash_emu.timing != NULL) && (flash_emu.timing->ext_page_size != 0) ) ?
+                              flash_emu.timing->ext_page_size : FLASH_EMU_EXT_PAGE_SIZE;
+    if ( ( (flash_emu.config.slot_size % CY_FLASH_SIZEOF_ROW) != 0) ||
+         (flash_emu.config.secondary_external && ( (flash_emu.config.slot_size % flash_emu.config.ext_sector_size) != 0) ) )
+    {
+        cy_log_msg(CYLF_DRIVERS, CY_LOG_ERR, "%s() slot size 0x%x is not a multiple of the row / sector size\n",
+                   __func__, flash_emu.config.slot_size);
+        return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+    }
+
+    flash_emu.map_size = 2 * (size_t)flash_emu.config.slot_size;
+    flash_emu.fd = open(config->file, O_RDWR | O_CREAT, 0644);
+    if ( (flash_emu.fd < 0) || (fstat(flash_emu.fd, &st) != 0) )
+    {
+        cy_log_msg(CYLF_DRIVERS, CY_LOG_ERR, "%s() open(%s) failed errno:%d\n", __func__, config->file, errno);
+        return CY_RSLT_SERIAL_FLASH_ERR_NOT_INITED;
+    }
+    fresh = ( (size_t)st.st_size != flash_emu.map_size);
+    if ( fresh && (ftruncate(flash_emu.fd, (off_t)flash_emu.map_size) != 0) )
+    {
+        close(flash_emu.fd);
+        flash_emu.fd = -1;
+        return CY_RSLT_SERIAL_FLASH_ERR_NOT_INITED;
+    }
+    flash_emu.map = (uint8_t *)mmap(NULL, flash_emu.map_size, PROT_READ | PROT_WRITE, MAP_SHARED, flash_emu.fd, 0);
+    if (flash_emu.map == MAP_FAILED)
+    {
+        flash_emu.map = NULL;
+        close(flash_emu.fd);
+        flash_emu.fd = -1;
+        return CY_RSLT_SERIAL_FLASH_ERR_NOT_INITED;
+    }
+    if (fresh || config->erase)
+    {
+        flash_emu_fill_erased();
+    }
+
+    flash_emu.primary.fa_id        = FLASH_AREA_IMAGE_0;
+    flash_emu.primary.fa_device_id = FLASH_DEVICE_INTERNAL_FLASH;
+    flash_emu.primary.fa_off       = CY_FLASH_BASE + CY_FLASH_EMU_PRIMARY_OFFSET;
+    flash_emu.primary.fa_size      = flash_emu.config.slot_size;
+
+    /* internal FLASH is memory mapped on the device, reads in place need it at its address */
+    flash_emu.cpu_map = (uint8_t *)mmap((void *)(uintptr_t)flash_emu.primary.fa_off, flash_emu.map_size, PROT_READ,
+                                        MAP_SHARED | MAP_FIXED_NOREPLACE, flash_emu.fd, 0);
+    if (flash_emu.cpu_map == MAP_FAILED)
+    {
+        flash_emu.cpu_map = NULL;
+    }
+    else if ( (uintptr_t)flash_emu.cpu_map != flash_emu.primary.fa_off)
+    {
+        munmap(flash_emu.cpu_map, flash_emu.map_size);
+        flash_emu.cpu_map = NULL;
+    }
+    if (flash_emu.cpu_map == NULL)
+    {
+        cy_log_msg(CYLF_DRIVERS, CY_LOG_WARNING, "%s() internal FLASH not mapped at 0x%lx\n", __func__,
+                   (unsigned long)flash_emu.primary.fa_off);
+    }
+
+    flash_emu.secondary.fa_id      = FLASH_AREA_IMAGE_1;
+    flash_emu.secondary.fa_size    = flash_emu.config.slot_size;
+    if (flash_emu.config.secondary_external)
+    {
+        flash_emu.secondary.fa_device_id = FLASH_DEVICE_EXTERNAL_FLASH(CY_BOOT_EXTERNAL_DEVICE_INDEX);
+        flash_emu.secondary.fa_off       = CY_SMIF_BASE_MEM_OFFSET;
+    }
+    else
+    {
+        flash_emu.secondary.fa_device_id = FLASH_DEVICE_INTERNAL_FLASH;
+        flash_emu.secondary.fa_off       = flash_emu.primary.fa_off + flash_emu.config.slot_size;
+    }
+
+    pthread_mutex_init(&flash_emu.mutex, NULL);
+    flash_emu.row_cycles[0] = (uint32_t *)calloc(flash_emu.config.slot_size / CY_FLASH_SIZEOF_ROW, sizeof(uint32_t));
+    flash_emu.row_cycles[1] = (uint32_t *)calloc(flash_emu.config.slot_size / CY_FLASH_SIZEOF_ROW, sizeof(uint32_t));
+    flash_emu.sector_cycles = (uint32_t *)calloc(flash_emu.config.slot_size / flash_emu.config.ext_sector_size, sizeof(uint32_t));
+    if ( (flash_emu.row_cycles[0] == NULL) || (flash_emu.row_cycles[1] == NULL) || (flash_emu.sector_cycles == NULL) )
+    {
+        cy_flash_emu_deinit();
+        return CY_RSLT_SERIAL_FLASH_ERR_NOT_INITED;
+    }
+
+    memset(&flash_emu.stats, 0x00, sizeof(flash_emu.stats));
+    memset(flash_emu.time_ns, 0x00, sizeof(flash_emu.time_ns));
+    flash_emu.ops = 0;
+    return CY_RSLT_SUCCESS;
+}
+
+void cy_flash_emu_deinit(void)
+{
+    if (flash_emu.map != NULL)
+    {
+        msync(flash_emu.map, flash_emu.map_size, MS_SYNC);
+        munmap(flash_emu.map, flash_emu.map_size);
+        flash_emu.map = NULL;
+        if (flash_emu.cpu_map != NULL)
+        {
+            munmap(flash_emu.cpu_map, flash_emu.map_size);
+            flash_emu.cpu_map = NULL;
+        }
+        pthread_mutex_destroy(&flash_emu.mutex);
+    }
+    if (flash_emu.fd >= 0)
+    {
+        close(flash_emu.fd);
+        flash_emu.fd = -1;
+    }
+    free(flash_emu.row_cycles[0]);
+    free(flash_emu.row_cycles[1]);
+    free(flash_emu.sector_cycles);
+    flash_emu.row_cycles[0] = NULL;
+    flash_emu.row_cycles[1] = NULL;
+    flash_emu.sector_cycles = NULL;
+}
+
+void cy_flash_emu_get_stats(cy_flash_emu_stats_t *stats)
+{
+    if ( (stats != NULL) && (flash_emu.map != NULL) )
+    {
+        pthread_mutex_lock(&flash_emu.mutex);
+        *stats = flash_emu.stats;
+        stats->ops        = flash_emu.ops;
+        stats->read_us    = flash_emu.time_ns[FLASH_EMU_TIME_READ] / 1000;
+        stats->program_us = flash_emu.time_ns[FLASH_EMU_TIME_PROGRAM] / 1000;
+        stats->erase_us   = flash_emu.time_ns[FLASH_EMU_TIME_ERASE] / 1000;
+        stats->xip_us     = flash_emu.time_ns[FLASH_EMU_TIME_XIP] / 1000;
+        stats->busy_us    = stats->read_us + stats->program_us + stats->erase_us + stats->xip_us;
+        pthread_mutex_unlock(&flash_emu.mutex);
+    }
+}
+
+void cy_flash_emu_reset_stats(void)
+{
+    if (flash_emu.map != NULL)
+    {
+        pthread_mutex_lock(&flash_emu.mutex);
+        memset(&flash_emu.stats, 0x00, sizeof(flash_emu.stats));
+        memset(flash_emu.time_ns, 0x00, sizeof(flash_emu.time_ns));
+        pthread_mutex_unlock(&flash_emu.mutex);
+    }
+}
+
+const cy_flash_emu_timing_t *cy_flash_emu_find_timing(const char *name)
+{
+    const cy_flash_emu_timing_t *timing;
+
+    for (timing = cy_flash_emu_timing_presets; (name != NULL) && (timing->name != NULL); timing++)
+    {
+        if (strcmp(timing->name, name) == 0)
+        {
+            return timing;
+        }
+    }
+    return NULL;
+}
+
+uint32_t cy_flash_emu_get_erase_counts(uint32_t slot, uint32_t *counts, uint32_t max_counts, uint32_t *sector_size)
+{
+    uint32_t    rows_per_sector = CY_FLASH_EMU_INT_SECTOR_SIZE / CY_FLASH_SIZEOF_ROW;
+    uint32_t    num_sectors;
+    uint32_t    sector;
+    uint32_t    row;
+    uint32_t    most;
+
+    if ( (flash_emu.map == NULL) || (slot > 1) )
+    {
+        return 0;
+    }
+    pthread_mutex_lock(&flash_emu.mutex);
+    if ( (slot == 1) && flash_emu.config.secondary_external)
+    {
+        num_sectors = flash_emu.config.slot_size / flash_emu.config.ext_sector_size;
+        for (sector = 0; (counts != NULL) && (sector < num_sectors) && (sector < max_counts); sector++)
+        {
+            counts[sector] = flash_emu.sector_cycles[sector];
+        }
+        if (sector_size != NULL)
+        {
+            *sector_size = flash_emu.config.ext_sector_size;
+        }
+    }
+    else
+    {
+        num_sectors = (flash_emu.config.slot_size + CY_FLASH_EMU_INT_SECTOR_SIZE - 1) / CY_FLASH_EMU_INT_SECTOR_SIZE;
+        for (sector = 0; (counts != NULL) && (sector < num_sectors) && (sector < max_counts); sector++)
+        {
+            most = 0;
+            for (row = sector * rows_per_sector;
+                 (row < ( (sector + 1) * rows_per_sector) ) && (row < (flash_emu.config.slot_size / CY_FLASH_SIZEOF_ROW) );
+                 row++)
+            {
+                if (flash_emu.row_cycles[slot][row] > most)
+                {
+                    most = flash_emu.row_cycles[slot][row];
+                }
+            }
+            counts[sector] = most;
+        }
+        if (sector_size != NULL)
+        {
+            *sector_size = CY_FLASH_EMU_INT_SECTOR_SIZE;
+        }
+    }
+    pthread_mutex_unlock(&flash_emu.mutex);
+    return num_sectors;
+}
+
+void cy_flash_emu_reset_wear(void)
+{
+    if (flash_emu.map != NULL)
+    {
+        pthread_mutex_lock(&flash_emu.mutex);
+        memset(flash_emu.row_cycles[0], 0x00, (flash_emu.config.slot_size / CY_FLASH_SIZEOF_ROW) * sizeof(uint32_t));
+        memset(flash_emu.row_cycles[1], 0x00, (flash_emu.config.slot_size / CY_FLASH_SIZEOF_ROW) * sizeof(uint32_t));
+        memset(flash_emu.sector_cycles, 0x00, (flash_emu.config.slot_size / flash_emu.config.ext_sector_size) * sizeof(uint32_t));
+        pthread_mutex_unlock(&flash_emu.mutex);
+    }
+}
+
+cy_rslt_t cy_flash_emu_load_primary(const uint8_t *data, uint32_t size)
+{
+    if ( (data == NULL) || (flash_emu.map == NULL) || (size > flash_emu.config.slot_size) )
+    {
+        return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+    }
+    memset(flash_emu.map, CY_FLASH_EMU_INTERNAL_ERASED_VAL, flash_emu.config.slot_size);
+    memcpy(flash_emu.map, data, size);
+    return CY_RSLT_SUCCESS;
+}
+
+/*-----------------------------------------------------------*/
+/* flash_map_backend.h */
+
+int flash_area_open(uint8_t id, const struct flash_area **fa)
+{
+    if ( (fa == NULL) || (flash_emu.map == NULL) )
+    {
+        return -1;
+    }
+    if (id == FLASH_AREA_IMAGE_0)
+    {
+        *fa = &flash_emu.primary;
+        return 0;
+    }
+    if (id == FLASH_AREA_IMAGE_1)
+    {
+        *fa = &flash_emu.secondary;
+        return 0;
+    }
+    return -1;
+}
+
+void flash_area_close(const struct flash_area *fa)
+{
+    (void)fa;
+}
+
+int flash_area_read(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len)
+{
+    if ( (dst == NULL) || !flash_emu_area_check(fa, off, len) )
+    {
+        return -1;
+    }
+    if (flash_emu_is_external(fa) )
+    {
+        return (ota_smif_read(fa->fa_off + off, (uint8_t *)dst, len) == CY_RSLT_SUCCESS) ? 0 : -1;
+    }
+    pthread_mutex_lock(&flash_emu.mutex);
+    memcpy(dst, flash_emu_area_base(fa) + off, len);
+    if (flash_emu.timing != NULL)
+    {
+        flash_emu_delay(FLASH_EMU_TIME_READ, (uint64_t)len * flash_emu.timing->int_read_ns_per_byte);
+    }
+    flash_emu.stats.reads++;
+    flash_emu.stats.read_bytes += len;
+    pthread_mutex_unlock(&flash_emu.mutex);
+    return 0;
+}
+
+int flash_area_write(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len)
+{
+    if ( (src == NULL) || !flash_emu_area_check(fa, off, len) )
+    {
+        return -1;
+    }
+    if (flash_emu_is_external(fa) )
+    {
+        return (ota_smif_write(fa->fa_off + off, (const uint8_t *)src, len) == CY_RSLT_SUCCESS) ? 0 : -1;
+    }
+    pthread_mutex_lock(&flash_emu.mutex);
+    flash_emu_internal_write(fa, off, (const uint8_t *)src, len);
+    flash_emu.stats.writes++;
+    flash_emu.stats.write_bytes += len;
+    pthread_mutex_unlock(&flash_emu.mutex);
+    return 0;
+}
+
+int flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+    if (!flash_emu_area_check(fa, off, len) )
+    {
+        return -1;
+    }
+    if (len == 0)
+    {
+        return 0;
+    }
+    if (flash_emu_is_external(fa) )
+    {
+        return (ota_smif_erase(fa->fa_off + off, len) == CY_RSLT_SUCCESS) ? 0 : -1;
+    }
+    pthread_mutex_lock(&flash_emu.mutex);
+    flash_emu_internal_erase(fa, off, len);
+    flash_emu.stats.erases++;
+    flash_emu.stats.erase_bytes += len;
+    pthread_mutex_unlock(&flash_emu.mutex);
+    return 0;
+}
+
+size_t flash_area_align(const struct flash_area *fa)
+{
+    if ( (fa != NULL) && flash_emu_is_external(fa) )
+    {
+        return ota_smif_get_prog_size(fa->fa_off);
+    }
+    return CY_FLASH_ALIGN;
+}
+
+uint8_t flash_area_erased_val(const struct flash_area *fa)
+{
+    if ( (fa != NULL) && flash_emu_is_external(fa) )
+    {
+        return CY_FLASH_EMU_EXTERNAL_ERASED_VAL;
+    }
+    return CY_FLASH_EMU_INTERNAL_ERASED_VAL;
+}
+
+int flash_area_read_is_empty(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len)
+{
+    uint8_t     erased_val = flash_area_erased_val(fa);
+    uint8_t     *data = (uint8_t *)dst;
+    uint32_t    i;
+
+    if (flash_area_read(fa, off, dst, len) != 0)
+    {
+        return -1;
+    }
+    for (i = 0; i < len; i++)
+    {
+        if (data[i] != erased_val)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*-----------------------------------------------------------*/
+/* ota_serial_flash.h */
+
+cy_rslt_t ota_smif_initialize(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+uint32_t ota_smif_get_prog_size(uint32_t addr)
+{
+    (void)addr;
+    return (flash_emu.ext_page_size != 0) ? flash_emu.ext_page_size : FLASH_EMU_EXT_PAGE_SIZE;
+}
+
+uint32_t ota_smif_get_erase_size(uint32_t addr)
+{
+    (void)addr;
+    return (flash_emu.config.ext_sector_size != 0) ? flash_emu.config.ext_sector_size : CY_FLASH_EMU_EXT_SECTOR_SIZE;
+}
+
+cy_rslt_t ota_smif_read(uint32_t offset, uint8_t *data, size_t len)
+{
+    if ( (data == NULL) || !flash_emu_ext_offset(&offset, len) )
+    {
+        return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+    }
+    pthread_mutex_lock(&flash_emu.mutex);
+    memcpy(data, flash_emu.map + flash_emu.config.slot_size + offset, len);
+    flash_emu_xip_switch();
+    if (flash_emu.timing != NULL)
+    {
+        flash_emu_delay(FLASH_EMU_TIME_READ, (1000ULL * flash_emu.timing->ext_command_us) +
+                                             ( (uint64_t)len * flash_emu.timing->ext_read_ns_per_byte) );
+    }
+    flash_emu.stats.reads++;
+    flash_emu.stats.read_bytes += len;
+    pthread_mutex_unlock(&flash_emu.mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t ota_smif_write(uint32_t offset, const uint8_t *data, size_t length)
+{
+    uint8_t     *dst;
+    uint32_t    pages;
+    uint32_t    cut;
+    uint32_t    cut_at;
+    uint32_t    cut_end;
+    size_t      i;
+
+    if ( (data == NULL) || !flash_emu_ext_offset(&offset, length) )
+    {
+        return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+    }
+    if (length == 0)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+    pthread_mutex_lock(&flash_emu.mutex);
+    dst = flash_emu.map + flash_emu.config.slot_size + offset;
+    pages = (uint32_t)( ( (offset + length - 1) / flash_emu.ext_page_size) - (offset / flash_emu.ext_page_size) + 1);
+    cut = flash_emu_next_op(pages);
+    if (cut != FLASH_EMU_NO_CUT)
+    {
+        /* pages before the cut are programmed, the cut page has some of its bits programmed */
+        cut_at = (cut == 0) ? 0 : (uint32_t)( ( (offset / flash_emu.ext_page_size) + cut) * flash_emu.ext_page_size - offset);
+        cut_end = (uint32_t)( ( (offset / flash_emu.ext_page_size) + cut + 1) * flash_emu.ext_page_size - offset);
+        for (i = 0; (i < cut_end) && (i < length); i++)
+        {
+            dst[i] &= (i < cut_at) ? data[i] : (uint8_t)(data[i] | ~flash_emu_noise());
+        }
+        flash_emu_power_off();
+    }
+    for (i = 0; i < length; i++)
+    {
+        /* programming can only clear bits */
+        if ( (dst[i] & data[i]) != data[i])
+        {
+            flash_emu.stats.program_violations++;
+        }
+        dst[i] &= data[i];
+    }
+    flash_emu.stats.writes++;
+    flash_emu.stats.write_bytes += length;
+    flash_emu.stats.ext_pages_programmed += pages;
+    flash_emu_xip_switch();
+    if (flash_emu.timing != NULL)
+    {
+        flash_emu_delay(FLASH_EMU_TIME_PROGRAM, 1000ULL * pages *
+                        ( (uint64_t)flash_emu.timing->ext_page_program_us + flash_emu.timing->ext_command_us) );
+    }
+    pthread_mutex_unlock(&flash_emu.mutex);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t ota_smif_erase(uint32_t offset, uint32_t length)
+{
+    uint8_t     *dst;
+    uint32_t    cut;
+    uint32_t    sector_size;
+    uint32_t    start;
+    uint32_t    end;
+    uint32_t    i;
+
+    if (!flash_emu_ext_offset(&offset, length) )
+    {
+        return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+    }
+    if (length == 0)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+    /* whole sectors: round the start down and the end up */
+    sector_size = ota_smif_get_erase_size(offset);
+    start = offset & ~(sector_size - 1);
+    end   = (offset + length + sector_size - 1) & ~(sector_size - 1);
+    if (end > flash_emu.config.slot_size)
+    {
+        return CY_RSLT_SERIAL_FLASH_ERR_BAD_PARAM;
+    }
+
+    pthread_mutex_lock(&flash_emu.mutex);
+    cut = flash_emu_next_op( (end - start) / sector_size);
+    if (cut != FLASH_EMU_NO_CUT)
+    {
+        /* sectors before the cut are erased, the cut sector has some of its bits erased */
+        dst = flash_emu.map + flash_emu.config.slot_size + start;
+        memset(dst, CY_FLASH_EMU_EXTERNAL_ERASED_VAL, cut * sector_size);
+        for (i = cut * sector_size; i < ( (cut + 1) * sector_size); i++)
+        {
+            dst[i] |= flash_emu_noise();
+        }
+        flash_emu_power_off();
+    }
+    memset(flash_emu.map + flash_emu.config.slot_size + start, CY_FLASH_EMU_EXTERNAL_ERASED_VAL, end - start);
+    flash_emu.stats.erases++;
+    flash_emu.stats.erase_bytes += length;
+    flash_emu.stats.sectors_erased += (end - start) / sector_size;
+    for (i = start / sector_size; i < (end / sector_size); i++)
+    {
+        flash_emu.sector_cycles[i]++;
+    }
+    flash_emu_xip_switch();
+    if (flash_emu.timing != NULL)
+    {
+        flash_emu_delay(FLASH_EMU_TIME_ERASE, 1000ULL * ( (end - start) / sector_size) *
+                        ( (uint64_t)flash_emu.timing->ext_sector_erase_us + flash_emu.timing->ext_command_us) );
+    }
+    pthread_mutex_unlock(&flash_emu.mutex);
+    return CY_RSLT_SUCCESS;
+}
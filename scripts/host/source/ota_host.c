@@ -0,0 +1,641 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host build: OTA Agent test application
+ *
+ * Starts the OTA Agent against a local HTTP server (ota_http_server.py) or
+ * MQTT Broker + publisher.py, waits for the update session to complete and
+ * prints a summary: time in each state, bytes, FLASH operations, heap use,
+ * the Agent state timing histograms from cy_ota_get_stats() and, for HTTP,
+ * the range request counts from cy_ota_get_http_range_stats().
+ *
+ *   ./ota_host [-m] [-s <server>] [-p <port>] [-d] [-f <file>] [-T <topic>]
+ *              [-F <flash file>] [-x] [-E] [-P <image>] [-M <timing>] [-R <scale>] [-l <log level>]
+ *              [-C <op>[:<seed>]] [-B <mode>[:<piece>]] [-t <timeout secs>] [-j <json file>]
+ *
+ *   -m     use MQTT (default HTTP)
+ *   -d     Direct flow, get the OTA Image without a Job document
+ *   -f     file to GET for HTTP (default CY_OTA_HTTP_JOB_FILE or CY_OTA_HTTP_DATA_FILE)
+ *   -T     MQTT topic filter for the Direct flow (default "anycloud/<board>/OTAImage",
+ *          the publisher.py PUBLISHER_DIRECT_REQUEST_TOPIC)
+ *   -F     FLASH emulator backing file (default ota_flash.bin)
+ *   -x     Secondary Slot in external (SMIF) FLASH
+ *   -E     erase both Slots before starting
+ *   -P     program <image> into the Primary Slot before starting, the old image for a delta patch
+ *   -M     FLASH timing model: psoc6, s25fl512s, s25fl128s, s25fl064l (default none)
+ *   -R     sleep for the modelled FLASH time times <scale> (1.0 = device speed)
+ *   -C     cut power during FLASH program or erase operation <op> (1 = first), <seed> picks
+ *          where in the operation; exits with CY_FLASH_EMU_POWER_CUT_EXIT (3), run again
+ *          without -E to continue from what is in FLASH
+ *   -B     no update: load the BT FW Patch from the FW Data Block in the Primary Slot (see -P)
+ *          the way the application does at boot, and report heap peak and time.
+ *          <mode> is copy (cy_ota_fwdb_get_bt_fw()), mapped (cy_ota_fwdb_get_bt_fw_mapped())
+ *          or pieces (cy_ota_fwdb_get_bt_fw_data() into one <piece> byte buffer).
+ *          Needs a build with FW_DATBLOCK_SEPARATE_FROM_APPLICATION.
+ *   -j     also write the summary as one JSON object to <json file> ("-" for stdout),
+ *          for ota_host_bench.py and ota_fwdb_bt_bench.py
+ *
+ * Exit status is 0 when the update (or BT FW Patch load) completed without an error,
+ * 3 after a power cut.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cy_ota_api.h"
+#include "cyabs_rtos.h"
+#include "cy_log.h"
+#include "FreeRTOS.h"
+#include "flash_emu.h"
+#include "cy_ota_internal.h"        /* sizeof(cy_ota_context_t) */
+
+#define OTA_HOST_DEFAULT_SERVER     "127.0.0.1"
+#define OTA_HOST_DEFAULT_FLASH_FILE "ota_flash.bin"
+#define OTA_HOST_DEFAULT_TIMEOUT    (120)
+#define OTA_HOST_MAX_SECTORS        (512)
+#define OTA_HOST_DEFAULT_TOPIC      COMPANY_TOPIC_PREPEND "/" CY_TARGET_BOARD_STRING "/OTAImage"
+#define OTA_HOST_FNV_OFFSET         (0x811C9DC5UL)
+#define OTA_HOST_FNV_PRIME          (0x01000193UL)
+
+typedef struct
+{
+    cy_semaphore_t          done;
+    cy_ota_agent_state_t    state;
+    cy_time_t               state_start_ms;
+    cy_time_t               state_ms[CY_OTA_NUM_STATES];
+    uint32_t                state_count[CY_OTA_NUM_STATES];
+    uint32_t                total_size;
+    uint32_t                bytes_written;
+    cy_rslt_t               error;
+    uint32_t                failures;           /* FAILURE callbacks, including the ones the Agent retried */
+    bool                    complete;
+} ota_host_session_t;
+
+static ota_host_session_t   session;
+static cy_ota_stats_t       ota_stats;      /* read before cy_ota_agent_stop() frees the context */
+static cy_ota_http_range_stats_t range_stats;
+
+static const char *ota_host_stats_names[CY_OTA_NUM_STATS] =
+{
+    "connect", "job_download", "data_download", "storage_open", "storage_close", "verify"
+};
+
+/*-----------------------------------------------------------*/
+
+void NVIC_SystemReset(void)
+{
+    printf("NVIC_SystemReset(): reboot requested, exiting\n");
+    exit(0);
+}
+
+static cy_ota_callback_results_t ota_host_callback(cy_ota_cb_struct_t *cb_data)
+{
+    ota_host_session_t  *s = (ota_host_session_t *)cb_data->cb_arg;
+    cy_time_t           now;
+
+    if (cb_data->reason == CY_OTA_REASON_STATE_CHANGE)
+    {
+        cy_rtos_get_time(&now);
+        if (s->state < CY_OTA_NUM_STATES)
+        {
+            s->state_ms[s->state] += now - s->state_start_ms;
+        }
+        s->state          = cb_data->state;
+        s->state_start_ms = now;
+        if (cb_data->state < CY_OTA_NUM_STATES)
+        {
+            s->state_count[cb_data->state]++;
+        }
+    }
+    if (cb_data->total_size != 0)
+    {
+        s->total_size = cb_data->total_size;
+    }
+    if (cb_data->bytes_written != 0)
+    {
+        s->bytes_written = cb_data->bytes_written;
+    }
+    /* the Agent reports "exiting" when cy_ota_agent_stop() ends a completed session */
+    if ( (cb_data->reason == CY_OTA_REASON_FAILURE) && !s->complete)
+    {
+        s->failures++;
+    }
+
+    /* A failed connect or download may be retried, the last error at the end decides */
+    if ( (cb_data->reason == CY_OTA_REASON_STATE_CHANGE) && (cb_data->state == CY_OTA_STATE_OTA_COMPLETE) &&
+         !s->complete)
+    {
+        s->complete = true;
+        if (s->error == CY_RSLT_SUCCESS)                /* not timed out */
+        {
+            s->error = cy_ota_get_last_error();
+        }
+        cy_rtos_set_semaphore(&s->done, false);
+    }
+    return CY_OTA_CB_RSLT_OTA_CONTINUE;
+}
+
+static void ota_host_erase_counts(uint32_t slot)
+{
+    static uint32_t counts[OTA_HOST_MAX_SECTORS];
+    uint32_t        num_sectors;
+    uint32_t        sector_size = 0;
+    uint32_t        most = 0;
+    uint32_t        total = 0;
+    uint32_t        i;
+
+    num_sectors = cy_flash_emu_get_erase_counts(slot, counts, OTA_HOST_MAX_SECTORS, &sector_size);
+    if (num_sectors > OTA_HOST_MAX_SECTORS)
+    {
+        num_sectors = OTA_HOST_MAX_SECTORS;
+    }
+    for (i = 0; i < num_sectors; i++)
+    {
+        total += counts[i];
+        most = (counts[i] > most) ? counts[i] : most;
+    }
+    if (total == 0)
+    {
+        return;
+    }
+    printf("  %s wear:  %lu sectors of %lu KB, most erase cycles %lu:", (slot == 0) ? "primary  " : "secondary",
+           (unsigned long)num_sectors, (unsigned long)(sector_size / 1024), (unsigned long)most);
+    for (i = 0; (i < num_sectors) && (i < 64); i++)
+    {
+        printf(" %lu", (unsigned long)counts[i]);
+    }
+    printf("%s\n", (num_sectors > 64) ? " ..." : "");
+}
+
+static void ota_host_summary(cy_time_t elapsed_ms)
+{
+    cy_flash_emu_stats_t    flash;
+    int                     i;
+
+    cy_flash_emu_get_stats(&flash);
+
+    printf("\nResult:          %s (0x%08lx)\n", (session.error == CY_RSLT_SUCCESS) ? "success" :
+           cy_ota_get_error_string(session.error), (unsigned long)session.error);
+    printf("Elapsed:         %lu ms\n", (unsigned long)elapsed_ms);
+    printf("Failures:        %lu\n", (unsigned long)session.failures);
+    printf("Bytes:           %lu of %lu\n", (unsigned long)session.bytes_written, (unsigned long)session.total_size);
+    if (elapsed_ms > 0)
+    {
+        printf("Throughput:      %.1f KB/s\n", (double)session.bytes_written / (double)elapsed_ms * 1000.0 / 1024.0);
+    }
+    printf("Heap peak:       %lu bytes\n", (unsigned long)cy_host_heap_peak() );
+
+    printf("\nFLASH:           reads %lu (%llu bytes)  writes %lu (%llu bytes)  erases %lu (%llu bytes)\n",
+           (unsigned long)flash.reads, (unsigned long long)flash.read_bytes,
+           (unsigned long)flash.writes, (unsigned long long)flash.write_bytes,
+           (unsigned long)flash.erases, (unsigned long long)flash.erase_bytes);
+    printf("  internal:      rows programmed %lu  unchanged %lu  merged %lu  erased %lu\n",
+           (unsigned long)flash.rows_programmed, (unsigned long)flash.rows_unchanged,
+           (unsigned long)flash.rows_merged, (unsigned long)flash.rows_erased);
+    printf("  external:      pages programmed %lu  sectors erased %lu  program violations %lu\n",
+           (unsigned long)flash.ext_pages_programmed, (unsigned long)flash.sectors_erased,
+           (unsigned long)flash.program_violations);
+    if (flash.busy_us != 0)
+    {
+        printf("  device time:   %.1f ms  (read %.1f  program %.1f  erase %.1f  XIP switch %.1f, %lu switches)\n",
+               flash.busy_us / 1000.0, flash.read_us / 1000.0, flash.program_us / 1000.0,
+               flash.erase_us / 1000.0, flash.xip_us / 1000.0, (unsigned long)flash.xip_switches);
+    }
+    ota_host_erase_counts(0);
+    ota_host_erase_counts(1);
+
+    printf("\n%-48s %8s %10s\n", "State", "Count", "ms");
+    for (i = 0; i < CY_OTA_NUM_STATES; i++)
+    {
+        if (session.state_count[i] != 0)
+        {
+            printf("%-48s %8lu %10lu\n", cy_ota_get_state_string( (cy_ota_agent_state_t)i),
+                   (unsigned long)session.state_count[i], (unsigned long)session.state_ms[i]);
+        }
+    }
+
+    printf("\n%-16s %6s %8s %8s %8s   buckets < %u ms << n\n", "Timing", "Count", "min ms", "avg ms", "max ms",
+           (unsigned int)CY_OTA_STATS_BUCKET_MS);
+    for (i = 0; i < CY_OTA_NUM_STATS; i++)
+    {
+        const cy_ota_stats_histogram_t *histogram = &ota_stats.histogram[i];
+        int                             bucket;
+
+        if (histogram->count == 0)
+        {
+            continue;
+        }
+        printf("%-16s %6lu %8lu %8lu %8lu  ", ota_host_stats_names[i], (unsigned long)histogram->count,
+               (unsigned long)histogram->min_ms, (unsigned long)(histogram->total_ms / histogram->count),
+               (unsigned long)histogram->max_ms);
+        for (bucket = 0; bucket < CY_OTA_STATS_BUCKETS; bucket++)
+        {
+            printf(" %lu", (unsigned long)histogram->buckets[bucket]);
+        }
+        printf("\n");
+    }
+}
+
+static void ota_host_json(const char *name, cy_time_t elapsed_ms)
+{
+    cy_flash_emu_stats_t    flash;
+    FILE                    *fp;
+    int                     i;
+    bool                    first = true;
+
+    fp = (strcmp(name, "-") == 0) ? stdout : fopen(name, "w");
+    if (fp == NULL)
+    {
+        printf("Could not write %s\n", name);
+        return;
+    }
+    cy_flash_emu_get_stats(&flash);
+
+    fprintf(fp, "{\"result\": \"%s\", \"error\": %lu, \"elapsed_ms\": %lu, \"bytes\": %lu, \"total_size\": %lu, ",
+            (session.error == CY_RSLT_SUCCESS) ? "success" : cy_ota_get_error_string(session.error),
+            (unsigned long)session.error, (unsigned long)elapsed_ms,
+            (unsigned long)session.bytes_written, (unsigned long)session.total_size);
+    fprintf(fp, "\"failures\": %lu, \"chunk_size\": %u, \"context_size\": %lu, \"heap_peak\": %lu, ",
+            (unsigned long)session.failures, (unsigned int)CY_OTA_CHUNK_SIZE,
+            (unsigned long)sizeof(cy_ota_context_t), (unsigned long)cy_host_heap_peak() );
+    fprintf(fp, "\"flash\": {\"reads\": %lu, \"read_bytes\": %llu, \"writes\": %lu, \"write_bytes\": %llu, "
+            "\"erases\": %lu, \"erase_bytes\": %llu, \"rows_programmed\": %lu, \"rows_erased\": %lu, "
+            "\"ext_pages_programmed\": %lu, \"sectors_erased\": %lu, \"program_violations\": %lu, "
+            "\"ops\": %lu, \"busy_us\": %llu}, ",
+            (unsigned long)flash.reads, (unsigned long long)flash.read_bytes,
+            (unsigned long)flash.writes, (unsigned long long)flash.write_bytes,
+            (unsigned long)flash.erases, (unsigned long long)flash.erase_bytes,
+            (unsigned long)flash.rows_programmed, (unsigned long)flash.rows_erased,
+            (unsigned long)flash.ext_pages_programmed, (unsigned long)flash.sectors_erased,
+            (unsigned long)flash.program_violations, (unsigned long)flash.ops,
+            (unsigned long long)flash.busy_us);
+    fprintf(fp, "\"range_stats\": {\"requests\": %lu, \"failures\": %lu, \"stream_bytes\": %lu, "
+            "\"stream_fallbacks\": %lu, \"pipelined_bytes\": %lu, \"pipeline_fallbacks\": %lu, "
+            "\"parallel_bytes\": %lu}, ",
+            (unsigned long)range_stats.requests, (unsigned long)range_stats.failures,
+            (unsigned long)range_stats.stream_bytes, (unsigned long)range_stats.stream_fallbacks,
+            (unsigned long)range_stats.pipelined_bytes, (unsigned long)range_stats.pipeline_fallbacks,
+            (unsigned long)range_stats.parallel_bytes);
+    fprintf(fp, "\"states\": {");
+    for (i = 0; i < CY_OTA_NUM_STATES; i++)
+    {
+        if (session.state_count[i] != 0)
+        {
+            fprintf(fp, "%s\"%s\": {\"count\": %lu, \"ms\": %lu}", first ? "" : ", ",
+                    cy_ota_get_state_string( (cy_ota_agent_state_t)i),
+                    (unsigned long)session.state_count[i], (unsigned long)session.state_ms[i]);
+            first = false;
+        }
+    }
+    fprintf(fp, "}, \"agent_stats\": {\"sessions\": %lu, \"transitions\": %lu, \"bucket_ms\": %u",
+            (unsigned long)ota_stats.sessions, (unsigned long)ota_stats.transitions,
+            (unsigned int)CY_OTA_STATS_BUCKET_MS);
+    for (i = 0; i < CY_OTA_NUM_STATS; i++)
+    {
+        const cy_ota_stats_histogram_t *histogram = &ota_stats.histogram[i];
+        int                             bucket;
+
+        fprintf(fp, ", \"%s\": {\"count\": %lu, \"total_ms\": %lu, \"min_ms\": %lu, \"max_ms\": %lu, \"buckets\": [",
+                ota_host_stats_names[i], (unsigned long)histogram->count, (unsigned long)histogram->total_ms,
+                (unsigned long)histogram->min_ms, (unsigned long)histogram->max_ms);
+        for (bucket = 0; bucket < CY_OTA_STATS_BUCKETS; bucket++)
+        {
+            fprintf(fp, "%s%lu", (bucket == 0) ? "" : ", ", (unsigned long)histogram->buckets[bucket]);
+        }
+        fprintf(fp, "]}");
+    }
+    fprintf(fp, "}}\n");
+
+    if (fp != stdout)
+    {
+        fclose(fp);
+    }
+}
+
+static bool ota_host_load_primary(const char *name)
+{
+    uint8_t     *data;
+    FILE        *fp;
+    long        size;
+    bool        loaded = false;
+
+    fp = fopen(name, "rb");
+    if (fp == NULL)
+    {
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data = (size > 0) ? malloc(size) : NULL;
+    if ( (data != NULL) && (fread(data, 1, size, fp) == (size_t)size) )
+    {
+        loaded = (cy_flash_emu_load_primary(data, (uint32_t)size) == CY_RSLT_SUCCESS);
+    }
+    free(data);
+    fclose(fp);
+    return loaded;
+}
+
+#ifdef FW_DATBLOCK_SEPARATE_FROM_APPLICATION
+/* FNV-1a over the BT FW Patch, stands in for sending it to the BT module */
+static uint32_t ota_host_fnv1a(uint32_t hash, const uint8_t *data, uint32_t size)
+{
+    uint32_t    i;
+
+    for (i = 0; i < size; i++)
+    {
+        hash = (hash ^ data[i]) * OTA_HOST_FNV_PRIME;
+    }
+    return hash;
+}
+
+static int ota_host_bt_fw_load(const char *spec, const char *json_file)
+{
+    cy_ota_fwdb_bt_fw_t         bt_fw;
+    cy_ota_fwdb_bt_fw_info_t    bt_fw_info;
+    cy_flash_emu_stats_t        flash;
+    struct timespec             start;
+    struct timespec             end;
+    const char                  *sep;
+    char                        mode[16];
+    uint32_t                    piece = 0;
+    uint32_t                    hash = OTA_HOST_FNV_OFFSET;
+    uint32_t                    patch_size = 0;
+    uint32_t                    offset;
+    uint32_t                    size;
+    uint8_t                     *buffer;
+    uint64_t                    call_us;
+    cy_rslt_t                   result;
+    FILE                        *fp;
+
+    sep = strchr(spec, ':');
+    snprintf(mode, sizeof(mode), "%.*s", (sep != NULL) ? (int)(sep - spec) : (int)strlen(spec), spec);
+    if (sep != NULL)
+    {
+        piece = (uint32_t)strtoul(sep + 1, NULL, 0);
+    }
+
+    cy_flash_emu_reset_stats();
+    cy_host_heap_reset_peak();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if ( (strcmp(mode, "copy") == 0) || (strcmp(mode, "mapped") == 0) )
+    {
+        result = (mode[0] == 'c') ? cy_ota_fwdb_get_bt_fw(&bt_fw) : cy_ota_fwdb_get_bt_fw_mapped(&bt_fw);
+        if (result == CY_RSLT_SUCCESS)
+        {
+            patch_size = bt_fw.BT_FW_size;
+            hash = ota_host_fnv1a(hash, bt_fw.BT_FW_buffer, bt_fw.BT_FW_size);
+            cy_ota_fwdb_free_bt_fw(&bt_fw);
+        }
+    }
+    else if ( (strcmp(mode, "pieces") == 0) && (piece > 0) )
+    {
+        memset(&bt_fw_info, 0x00, sizeof(bt_fw_info));
+        result = cy_ota_fwdb_get_bt_fw_info(&bt_fw_info);
+        patch_size = bt_fw_info.BT_FW_size;
+        buffer = (uint8_t *)pvPortMalloc(piece);
+        if ( (result == CY_RSLT_SUCCESS) && (patch_size == 0) )
+        {
+            result = CY_RSLT_OTA_ERROR_GENERAL;
+        }
+        if (buffer == NULL)
+        {
+            result = CY_RSLT_OTA_ERROR_OUT_OF_MEMORY;
+        }
+        for (offset = 0; (result == CY_RSLT_SUCCESS) && (offset < patch_size); offset += size)
+        {
+            size = ( (patch_size - offset) < piece) ? (patch_size - offset) : piece;
+            result = cy_ota_fwdb_get_bt_fw_data(offset, size, buffer);
+            hash = ota_host_fnv1a(hash, buffer, size);
+        }
+        vPortFree(buffer);
+    }
+    else
+    {
+        printf("Unknown BT FW load %s, use copy, mapped or pieces:<size>\n", spec);
+        return 2;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    call_us = ( (uint64_t)(end.tv_sec - start.tv_sec) * 1000000ULL) + (end.tv_nsec / 1000) - (start.tv_nsec / 1000);
+    cy_flash_emu_get_stats(&flash);
+
+    printf("BT FW %s: %s, %lu bytes, heap peak %lu, %llu us, %lu reads\n", spec,
+           (result == CY_RSLT_SUCCESS) ? "success" : cy_ota_get_error_string(result), (unsigned long)patch_size,
+           (unsigned long)cy_host_heap_peak(), (unsigned long long)call_us, (unsigned long)flash.reads);
+    if (json_file != NULL)
+    {
+        fp = (strcmp(json_file, "-") == 0) ? stdout : fopen(json_file, "w");
+        if (fp != NULL)
+        {
+            fprintf(fp, "{\"result\": \"%s\", \"mode\": \"%s\", \"piece\": %lu, \"patch_bytes\": %lu, "
+                    "\"heap_peak\": %lu, \"heap_in_use\": %lu, \"call_us\": %llu, \"hash\": %lu, "
+                    "\"flash\": {\"reads\": %lu, \"read_bytes\": %llu, \"read_us\": %llu}}\n",
+                    (result == CY_RSLT_SUCCESS) ? "success" : cy_ota_get_error_string(result), mode,
+                    (unsigned long)piece, (unsigned long)patch_size, (unsigned long)cy_host_heap_peak(),
+                    (unsigned long)cy_host_heap_in_use(), (unsigned long long)call_us, (unsigned long)hash,
+                    (unsigned long)flash.reads, (unsigned long long)flash.read_bytes,
+                    (unsigned long long)flash.read_us);
+            if (fp != stdout)
+            {
+                fclose(fp);
+            }
+        }
+    }
+    return (result == CY_RSLT_SUCCESS) ? 0 : 1;
+}
+#endif  /* FW_DATBLOCK_SEPARATE_FROM_APPLICATION */
+
+static void ota_host_usage(const char *name)
+{
+    printf("Usage: %s [-m] [-s <server>] [-p <port>] [-d] [-f <file>] [-T <topic>]\n"
+           "          [-F <flash file>] [-x] [-E] [-P <image>] [-M <timing>] [-R <scale>] [-l <log level 0-9>]\n"
+           "          [-C <op>[:<seed>]] [-B <mode>[:<piece>]] [-t <timeout secs>] [-j <json file>]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static cy_ota_network_params_t  network_params;
+    static cy_ota_agent_params_t    agent_params;
+    static const char               *topic_filters[1];
+    cy_flash_emu_config_t           flash_config;
+    cy_ota_context_ptr              ota_context = NULL;
+    const char                      *server = OTA_HOST_DEFAULT_SERVER;
+    const char                      *file = NULL;
+    const char                      *topic = OTA_HOST_DEFAULT_TOPIC;
+    const char                      *json_file = NULL;
+    const char                      *primary_file = NULL;
+    const char                      *bt_fw_load = NULL;
+    char                            *end;
+    cy_time_t                       start_ms;
+    cy_time_t                       end_ms;
+    cy_rslt_t                       result;
+    uint32_t                        timeout_secs = OTA_HOST_DEFAULT_TIMEOUT;
+    int                             log_level = CY_LOG_WARNING;
+    int                             port = -1;
+    bool                            use_mqtt = false;
+    bool                            direct = false;
+    int                             opt;
+    int                             i;
+
+    memset(&flash_config, 0x00, sizeof(flash_config));
+    flash_config.file = OTA_HOST_DEFAULT_FLASH_FILE;
+
+    while ( (opt = getopt(argc, argv, "ms:p:df:T:F:xEP:M:R:C:B:l:t:j:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': use_mqtt = true;                          break;
+            case 's': server = optarg;                          break;
+            case 'p': port = atoi(optarg);                      break;
+            case 'd': direct = true;                            break;
+            case 'f': file = optarg;                            break;
+            case 'T': topic = optarg;                           break;
+            case 'F': flash_config.file = optarg;               break;
+            case 'x': flash_config.secondary_external = true;   break;
+            case 'E': flash_config.erase = true;                break;
+            case 'P': primary_file = optarg;                    break;
+            case 'M':
+                flash_config.timing = cy_flash_emu_find_timing(optarg);
+                if (flash_config.timing == NULL)
+                {
+                    printf("Unknown FLASH timing %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'R': flash_config.timing_scale = atof(optarg); break;
+            case 'C':
+                flash_config.power_cut_op = (uint32_t)strtoul(optarg, &end, 0);
+                flash_config.power_cut_seed = (*end == ':') ? (uint32_t)strtoul(end + 1, NULL, 0) : 0;
+                break;
+            case 'B': bt_fw_load = optarg;                      break;
+            case 'l': log_level = atoi(optarg);                 break;
+            case 't': timeout_secs = (uint32_t)atoi(optarg);    break;
+            case 'j': json_file = optarg;                       break;
+            default:
+                ota_host_usage(argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    cy_log_init( (CY_LOG_LEVEL_T)log_level, NULL, NULL);
+    cy_ota_set_log_level( (CY_LOG_LEVEL_T)log_level);
+    result = cy_flash_emu_init(&flash_config);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("cy_flash_emu_init(%s) failed 0x%lx\n", flash_config.file, (unsigned long)result);
+        return 1;
+    }
+    if ( (primary_file != NULL) && !ota_host_load_primary(primary_file) )
+    {
+        printf("Could not load %s into the Primary Slot\n", primary_file);
+        cy_flash_emu_deinit();
+        return 1;
+    }
+    if (bt_fw_load != NULL)
+    {
+#ifdef FW_DATBLOCK_SEPARATE_FROM_APPLICATION
+        i = ota_host_bt_fw_load(bt_fw_load, json_file);
+#else
+        printf("-B needs a build with FW_DATBLOCK_SEPARATE_FROM_APPLICATION\n");
+        i = 2;
+#endif
+        cy_flash_emu_deinit();
+        return i;
+    }
+
+    network_params.use_get_job_flow = direct ? CY_OTA_DIRECT_FLOW : CY_OTA_JOB_FLOW;
+    if (use_mqtt)
+    {
+        topic_filters[0] = topic;
+        network_params.initial_connection         = CY_OTA_CONNECTION_MQTT;
+        network_params.mqtt.broker.host_name      = server;
+        network_params.mqtt.broker.port           = (port > 0) ? (uint16_t)port : CY_OTA_MQTT_BROKER_PORT;
+        network_params.mqtt.pIdentifier           = "ota_host";
+        network_params.mqtt.numTopicFilters       = 1;
+        network_params.mqtt.pTopicFilters         = topic_filters;
+        network_params.mqtt.session_type          = CY_OTA_MQTT_SESSION_CLEAN;
+    }
+    else
+    {
+        network_params.initial_connection         = CY_OTA_CONNECTION_HTTP;
+        network_params.http.server.host_name      = server;
+        network_params.http.server.port           = (port > 0) ? (uint16_t)port : CY_OTA_HTTP_SERVER_PORT;
+        network_params.http.file                  = (file != NULL) ? file :
+                                                    (direct ? CY_OTA_HTTP_DATA_FILE : CY_OTA_HTTP_JOB_FILE);
+    }
+
+    agent_params.reboot_upon_completion = 0;
+    agent_params.validate_after_reboot  = 1;
+    agent_params.do_not_send_result     = true;
+    agent_params.cb_func                = ota_host_callback;
+    agent_params.cb_arg                 = &session;
+
+    memset(&session, 0x00, sizeof(session));
+    session.state = CY_OTA_NUM_STATES;
+    cy_rtos_init_semaphore(&session.done, 1, 0);
+    cy_host_heap_reset_peak();
+
+    cy_rtos_get_time(&start_ms);
+    result = cy_ota_agent_start(&network_params, &agent_params, &ota_context);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("cy_ota_agent_start() failed 0x%lx\n", (unsigned long)result);
+        cy_flash_emu_deinit();
+        return 1;
+    }
+    /* Do not wait for CY_OTA_INITIAL_CHECK_SECS. The Agent clears old events when it starts
+     * waiting, so ask until it has left CY_OTA_STATE_AGENT_WAITING.
+     */
+    for (i = 0; (i < 200) && !session.complete; i++)
+    {
+        if (cy_ota_get_update_now(ota_context) == CY_RSLT_OTA_ERROR_ALREADY_STARTED)
+        {
+            break;
+        }
+        cy_rtos_delay_milliseconds(10);
+    }
+
+    result = cy_rtos_get_semaphore(&session.done, timeout_secs * 1000, false);
+    cy_rtos_get_time(&end_ms);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("Timed out after %lu seconds in state %s\n", (unsigned long)timeout_secs,
+               (session.state < CY_OTA_NUM_STATES) ? cy_ota_get_state_string(session.state) : "-");
+        session.error = CY_RSLT_OTA_ERROR_GENERAL;
+    }
+
+    cy_ota_get_stats(ota_context, &ota_stats);
+    cy_ota_get_http_range_stats(ota_context, &range_stats);     /* stays zero for MQTT */
+    cy_ota_agent_stop(&ota_context);
+    ota_host_summary(end_ms - start_ms);
+    if (json_file != NULL)
+    {
+        ota_host_json(json_file, end_ms - start_ms);
+    }
+
+    cy_rtos_deinit_semaphore(&session.done);
+    cy_flash_emu_deinit();
+    cy_log_shutdown();
+    return (session.error == CY_RSLT_SUCCESS) ? 0 : 1;
+}
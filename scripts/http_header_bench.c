@@ -0,0 +1,417 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *   HTTP response header parser microbenchmark.
+ *
+ *   Compares the incremental parser in source/port_support/http_header against
+ *   the previous streaming path parser (strnstrn() searches for the header end
+ *   after every receive, then cy_ota_http_parse_header()).
+ *
+ *   For each response the header is delivered in pieces of "-s" bytes, the
+ *   way cy_ota_http_stream_data() receives it, and both parsers are timed.
+ *   Before timing, every split point of every response is checked against the
+ *   expected fields.
+ *
+ *   Build and run on the host:
+ *       gcc -O2 -I source/port_support/http_header -o http_header_bench \
+ *           scripts/http_header_bench.c source/port_support/http_header/http_header.c
+ *       ./http_header_bench [-s <piece size>] [-n <iterations>]
+ *
+ *   Output is CSV:  response,header_bytes,piece,legacy_ok,legacy_ns,incremental_ns,speedup
+ *   legacy_ok is 0 when the previous parser did not find the header fields
+ *   (it only matches "Content-Length" exactly as written).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "http_header.h"
+
+/*************************************************************
+ * Test responses
+ ************************************************************/
+typedef struct
+{
+    const char  *name;
+    const char  *text;
+    uint16_t    status_code;
+    uint32_t    content_length;
+    bool        has_content_range;
+    uint32_t    range_start;
+    uint32_t    range_end;
+    uint32_t    range_total;
+    const char  *etag;
+    bool        has_retry_after;
+    uint32_t    retry_after;
+} test_response_t;
+
+static const test_response_t responses[] =
+{
+    {
+        "mini_httpd",
+        "HTTP/1.1 200 Ok\r\n"
+        "Server: mini_httpd/1.23 28Dec2015\r\n"
+        "Date: Tue, 03 Mar 2020 18:49:23 GMT\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Length: 830544\r\n"
+        "Last-Modified: Tue, 03 Mar 2020 18:40:01 GMT\r\n"
+        "Connection: close\r\n"
+        "\r\n",
+        200, 830544, false, 0, 0, 0, NULL, false, 0
+    },
+    {
+        "nginx",
+        "HTTP/1.1 200 OK\r\n"
+        "Server: nginx/1.18.0 (Ubuntu)\r\n"
+        "Date: Mon, 14 Mar 2022 09:12:45 GMT\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Length: 1048576\r\n"
+        "Last-Modified: Mon, 14 Mar 2022 08:58:10 GMT\r\n"
+        "Connection: keep-alive\r\n"
+        "ETag: \"622f0402-100000\"\r\n"
+        "Accept-Ranges: bytes\r\n"
+        "\r\n",
+        200, 1048576, false, 0, 0, 0, "\"622f0402-100000\"", false, 0
+    },
+    {
+        "s3_range",
+        "HTTP/1.1 206 Partial Content\r\n"
+        "x-amz-id-2: 4ZtGz7p1lH0m0c3u9yq8YhCmF0m1lZ6uM1vE1q3bY0wT3cXl0QkJ2fU8aR9nS7dL4eE6gH2iK0=\r\n"
+        "x-amz-request-id: 7C9D3E1F2A4B6C8D\r\n"
+        "Date: Wed, 16 Mar 2022 21:03:11 GMT\r\n"
+        "Last-Modified: Wed, 16 Mar 2022 20:55:02 GMT\r\n"
+        "ETag: \"9b2cf535f27731c974343645a3985328\"\r\n"
+        "x-amz-server-side-encryption: AES256\r\n"
+        "Accept-Ranges: bytes\r\n"
+        "Content-Range: bytes 16384-32767/830544\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Server: AmazonS3\r\n"
+        "Content-Length: 16384\r\n"
+        "\r\n",
+        206, 16384, true, 16384, 32767, 830544, "\"9b2cf535f27731c974343645a3985328\"", false, 0
+    },
+    {
+        "cloudfront_503",
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "Content-Type: text/html\r\n"
+        "content-length: 1033\r\n"
+        "Connection: keep-alive\r\n"
+        "Server: CloudFront\r\n"
+        "Date: Thu, 17 Mar 2022 02:40:18 GMT\r\n"
+        "retry-after: 120\r\n"
+        "X-Cache: Error from cloudfront\r\n"
+        "Via: 1.1 3f4e8a2c9d1b7e6f5a4c3b2d1e0f9a8b.cloudfront.net (CloudFront)\r\n"
+        "X-Amz-Cf-Pop: FRA56-P5\r\n"
+        "X-Amz-Cf-Id: Zq1pW8vB4nT0yR6uE2kL9xC3mV7hJ5gF1dS8aQ0wZ3eX6rT9yU2iO4p==\r\n"
+        "\r\n",
+        503, 1033, false, 0, 0, 0, NULL, true, 120
+    },
+};
+
+#define NUM_RESPONSES   (sizeof(responses) / sizeof(responses[0]))
+#define BODY_TEXT       "BODYBYTES"
+
+/*************************************************************
+ * Previous parser, from cy_ota_http.c
+ ************************************************************/
+#define HTTP_HEADER_STR                 "HTTP/"
+#define HTTP_HEADERS_BODY_SEPARATOR     "\r\n\r\n"
+#define HTTP_HEADER_CONTENT_LENGTH      "Content-Length"
+
+static char* strnstrn(const char *s, uint16_t s_len, const char *substr, uint16_t substr_len)
+{
+    for (; s_len >= substr_len; s++, s_len--)
+    {
+        if (strncmp(s, substr, substr_len) == 0)
+        {
+            return (char*)s;
+        }
+    }
+
+    return NULL;
+}
+
+static int legacy_parse_header(uint8_t **ptr, uint16_t *data_len, uint32_t *file_len, int *response_code)
+{
+    char    *response_status;
+    uint8_t *header_end;
+
+    *response_code = 403;
+    if (*data_len < 12)
+    {
+        return -1;
+    }
+    response_status = strnstrn( (char *)*ptr, *data_len, HTTP_HEADER_STR, sizeof(HTTP_HEADER_STR) - 1);
+    if (response_status == NULL)
+    {
+        return -1;
+    }
+    response_status = strchr(response_status, ' ');
+    if (response_status == NULL)
+    {
+        return -1;
+    }
+    *response_code = atoi(response_status + 1);
+
+    response_status = strnstrn( (char *)*ptr, *data_len, HTTP_HEADER_CONTENT_LENGTH, sizeof(HTTP_HEADER_CONTENT_LENGTH) - 1);
+    if (response_status == NULL)
+    {
+        return -1;
+    }
+    response_status += sizeof(HTTP_HEADER_CONTENT_LENGTH);
+    *file_len = atoi(response_status);
+
+    header_end = (uint8_t *)strnstrn( (char *)*ptr, *data_len, HTTP_HEADERS_BODY_SEPARATOR, sizeof(HTTP_HEADERS_BODY_SEPARATOR) - 1);
+    if (header_end == NULL)
+    {
+        return -1;
+    }
+    header_end += sizeof(HTTP_HEADERS_BODY_SEPARATOR) - 1;
+    *data_len -= (header_end - *ptr);
+    *ptr = header_end;
+    return 0;
+}
+
+/* receive loop of the previous cy_ota_http_stream_data() */
+static uint32_t legacy_stream(uint8_t *buffer, const uint8_t *response, uint32_t size, uint32_t piece, int *status)
+{
+    uint32_t    fill = 0;
+    uint32_t    file_len = 0;
+    uint16_t    data_len;
+    uint8_t     *body;
+
+    while (strnstrn( (char *)buffer, fill, HTTP_HEADERS_BODY_SEPARATOR, sizeof(HTTP_HEADERS_BODY_SEPARATOR) - 1) == NULL)
+    {
+        uint32_t    get = (size - fill < piece) ? (size - fill) : piece;
+        if (get == 0)
+        {
+            return 0;
+        }
+        memcpy(&buffer[fill], &response[fill], get);
+        fill += get;
+        buffer[fill] = 0;
+    }
+    body = buffer;
+    data_len = (uint16_t)fill;
+    if (legacy_parse_header(&body, &data_len, &file_len, status) != 0)
+    {
+        return 0;
+    }
+    return (file_len > 0) ? (uint32_t)(body - buffer) : 0;
+}
+
+/* receive loop of the new cy_ota_http_stream_data() */
+static uint32_t incremental_stream(uint8_t *buffer, const uint8_t *response, uint32_t size, uint32_t piece,
+                                   cy_http_header_parser_t *parser)
+{
+    uint32_t                fill = 0;
+    cy_http_header_result_t result = CY_HTTP_HEADER_NEED_MORE;
+
+    cy_http_header_init(parser);
+    while (result == CY_HTTP_HEADER_NEED_MORE)
+    {
+        uint32_t    get = (size - fill < piece) ? (size - fill) : piece;
+        if (get == 0)
+        {
+            return 0;
+        }
+        memcpy(&buffer[fill], &response[fill], get);
+        result = cy_http_header_parse(parser, &buffer[fill], get, NULL);
+        fill += get;
+    }
+    return (result == CY_HTTP_HEADER_DONE) ? parser->header_len : 0;
+}
+
+/*************************************************************
+ * Checks
+ ************************************************************/
+static bool check_fields(const test_response_t *test, const cy_http_header_parser_t *parser, const uint8_t *buffer)
+{
+    if ( (parser->status_code != test->status_code) ||
+         !parser->has_content_length || (parser->content_length != test->content_length) ||
+         (parser->header_len != strlen(test->text)) ||
+         (parser->has_content_range != test->has_content_range) ||
+         (parser->has_retry_after != test->has_retry_after) )
+    {
+        return false;
+    }
+    if ( test->has_content_range &&
+         ( (parser->range_start != test->range_start) || (parser->range_end != test->range_end) ||
+           (parser->range_total != test->range_total) ) )
+    {
+        return false;
+    }
+    if (test->has_retry_after && (parser->retry_after != test->retry_after) )
+    {
+        return false;
+    }
+    if (test->etag == NULL)
+    {
+        return (parser->etag_len == 0);
+    }
+    return ( (parser->etag_len == strlen(test->etag)) &&
+             (memcmp(&buffer[parser->etag_offset], test->etag, parser->etag_len) == 0) );
+}
+
+/* split the response in two at every position */
+static bool check_splits(const test_response_t *test, const uint8_t *response, uint32_t size)
+{
+    cy_http_header_parser_t parser;
+    cy_http_header_result_t result;
+    uint32_t                split;
+    uint32_t                consumed;
+
+    for (split = 0; split <= size; split++)
+    {
+        cy_http_header_init(&parser);
+        result = cy_http_header_parse(&parser, response, split, &consumed);
+        if (result == CY_HTTP_HEADER_NEED_MORE)
+        {
+            uint32_t    first = consumed;
+            result = cy_http_header_parse(&parser, &response[split], size - split, &consumed);
+            consumed += first;
+        }
+        if ( (result != CY_HTTP_HEADER_DONE) || (consumed != strlen(test->text)) ||
+             !check_fields(test, &parser, response) )
+        {
+            printf("%s: split at %u failed result:%d consumed:%u\n", test->name, split, result, consumed);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_invalid(void)
+{
+    static const char *bad[] =
+    {
+        "<html>\r\n\r\n",
+        "HTTP/1.1 2x0 OK\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nBad Name: x\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: 99999999999\r\n\r\n",
+        "HTTP/1.1 200 OK\r\n\rX",
+    };
+    cy_http_header_parser_t parser;
+    uint32_t                index;
+
+    for (index = 0; index < sizeof(bad) / sizeof(bad[0]); index++)
+    {
+        cy_http_header_init(&parser);
+        if (cy_http_header_parse(&parser, (const uint8_t *)bad[index], (uint32_t)strlen(bad[index]), NULL) != CY_HTTP_HEADER_INVALID)
+        {
+            printf("invalid header %u accepted\n", index);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*************************************************************
+ * Timing
+ ************************************************************/
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t          response[4096];
+    static uint8_t          buffer[4096 + 1];
+    cy_http_header_parser_t parser;
+    uint32_t                piece = 536;        /* TCP MSS of a typical lwIP build */
+    uint32_t                iterations = 200000;
+    volatile uint32_t       sink = 0;
+    uint32_t                index;
+    int                     arg;
+
+    for (arg = 1; arg < argc - 1; arg++)
+    {
+        if (strcmp(argv[arg], "-s") == 0)
+        {
+            piece = (uint32_t)atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "-n") == 0)
+        {
+            iterations = (uint32_t)atoi(argv[++arg]);
+        }
+    }
+    if (piece == 0)
+    {
+        piece = 1;
+    }
+
+    if (!check_invalid())
+    {
+        return 1;
+    }
+
+    printf("response,header_bytes,piece,legacy_ok,legacy_ns,incremental_ns,speedup\n");
+    for (index = 0; index < NUM_RESPONSES; index++)
+    {
+        const test_response_t   *test = &responses[index];
+        uint32_t                header_len = (uint32_t)strlen(test->text);
+        uint32_t                size = header_len + (uint32_t)strlen(BODY_TEXT);
+        uint32_t                loop;
+        double                  start;
+        double                  legacy_ns;
+        double                  incremental_ns;
+        int                     status;
+        bool                    legacy_ok;
+
+        memcpy(response, test->text, header_len);
+        memcpy(&response[header_len], BODY_TEXT, strlen(BODY_TEXT));
+
+        if (!check_splits(test, response, size))
+        {
+            return 1;
+        }
+        if ( (incremental_stream(buffer, response, size, piece, &parser) != header_len) ||
+             !check_fields(test, &parser, buffer) )
+        {
+            printf("%s: stream check failed\n", test->name);
+            return 1;
+        }
+        legacy_ok = ( (legacy_stream(buffer, response, size, piece, &status) == header_len) &&
+                      (status == test->status_code) );
+
+        start = now_ns();
+        for (loop = 0; loop < iterations; loop++)
+        {
+            sink += legacy_stream(buffer, response, size, piece, &status);
+        }
+        legacy_ns = (now_ns() - start) / iterations;
+
+        start = now_ns();
+        for (loop = 0; loop < iterations; loop++)
+        {
+            sink += incremental_stream(buffer, response, size, piece, &parser);
+        }
+        incremental_ns = (now_ns() - start) / iterations;
+
+        printf("%s,%u,%u,%d,%.0f,%.0f,%.2f\n", test->name, header_len, piece, (int)legacy_ok, legacy_ns, incremental_ns,
+               legacy_ns / incremental_ns);
+    }
+    return (sink == 0) ? 1 : 0;
+}
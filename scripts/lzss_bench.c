@@ -0,0 +1,195 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *   Streaming LZSS decoder benchmark.
+ *
+ *   Decodes a file made by ota_compress.py the way the OTA Agent does with
+ *   CY_OTA_DECOMPRESS: the compressed stream is fed in pieces of "-s" bytes
+ *   (CY_OTA_CHUNK_SIZE by default), and the output is handed over one window
+ *   at a time. The first pass compares the output with the original file,
+ *   the timed passes only count it.
+ *
+ *   Build and run on the host:
+ *       gcc -O2 -I source/port_support/lzss -o lzss_bench \
+ *           scripts/lzss_bench.c source/port_support/lzss/lzss.c
+ *       python3 scripts/ota_compress.py -w 10 <image> <image>.lz
+ *       ./lzss_bench [-s <piece size>] [-n <iterations>] <image> <image>.lz
+ *
+ *   Output is CSV:  window_bits,original,compressed,ratio,decoder_ram,output_mb_per_sec,input_mb_per_sec,verify_ok
+ *   decoder_ram is the decoder structure plus the window.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lzss.h"
+
+typedef struct
+{
+    const uint8_t   *expected;
+    uint32_t        expected_size;
+    uint32_t        output;
+    bool            verify;
+    bool            ok;
+} bench_output_t;
+
+static int bench_write(void *cb_arg, uint32_t offset, const uint8_t *buffer, uint32_t size)
+{
+    bench_output_t  *out = (bench_output_t *)cb_arg;
+
+    if (out->verify)
+    {
+        if ( (offset != out->output) || ((offset + size) > out->expected_size) ||
+             (memcmp(&out->expected[offset], buffer, size) != 0) )
+        {
+            out->ok = false;
+            return -1;
+        }
+    }
+    out->output += size;
+    return 0;
+}
+
+static uint8_t *read_file(const char *name, uint32_t *size)
+{
+    FILE    *f = fopen(name, "rb");
+    uint8_t *data;
+    long    len;
+
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc((size_t)len + 1);
+    if ( (data == NULL) || (fread(data, 1, (size_t)len, f) != (size_t)len) )
+    {
+        fclose(f);
+        free(data);
+        return NULL;
+    }
+    fclose(f);
+    *size = (uint32_t)len;
+    return data;
+}
+
+static cy_lzss_result_t decode(cy_lzss_decoder_t *decoder, uint8_t *window, const uint8_t *stream,
+                               uint32_t stream_size, uint32_t piece, bench_output_t *out)
+{
+    cy_lzss_result_t    result = CY_LZSS_ERROR;
+    uint32_t            offset;
+
+    if (cy_lzss_init(decoder, window, (1UL << CY_LZSS_MAX_WINDOW_BITS), bench_write, out) != CY_LZSS_SUCCESS)
+    {
+        return CY_LZSS_ERROR;
+    }
+    for (offset = 0; offset < stream_size; offset += piece)
+    {
+        uint32_t    size = ((stream_size - offset) < piece) ? (stream_size - offset) : piece;
+        result = cy_lzss_decode(decoder, &stream[offset], size);
+        if (result != CY_LZSS_SUCCESS)
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t      window[1UL << CY_LZSS_MAX_WINDOW_BITS];
+    cy_lzss_decoder_t   decoder;
+    bench_output_t      out;
+    uint8_t             *original;
+    uint8_t             *stream;
+    uint32_t            original_size = 0;
+    uint32_t            stream_size = 0;
+    uint32_t            piece = 4096;           /* CY_OTA_CHUNK_SIZE */
+    uint32_t            iterations = 50;
+    uint32_t            loop;
+    double              start;
+    double              elapsed;
+    bool                verify_ok;
+    int                 arg;
+
+    for (arg = 1; arg < argc - 2; arg++)
+    {
+        if (strcmp(argv[arg], "-s") == 0)
+        {
+            piece = (uint32_t)atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "-n") == 0)
+        {
+            iterations = (uint32_t)atoi(argv[++arg]);
+        }
+    }
+    if ( (argc < 3) || (piece == 0) || (iterations == 0) )
+    {
+        printf("usage: %s [-s <piece size>] [-n <iterations>] <image> <compressed image>\n", argv[0]);
+        return 1;
+    }
+
+    original = read_file(argv[argc - 2], &original_size);
+    stream = read_file(argv[argc - 1], &stream_size);
+    if ( (original == NULL) || (stream == NULL) || !cy_lzss_is_compressed(stream, stream_size) )
+    {
+        printf("could not read %s and %s\n", argv[argc - 2], argv[argc - 1]);
+        return 1;
+    }
+
+    memset(&out, 0x00, sizeof(out));
+    out.expected = original;
+    out.expected_size = original_size;
+    out.verify = true;
+    out.ok = true;
+    verify_ok = (decode(&decoder, window, stream, stream_size, piece, &out) == CY_LZSS_DONE) &&
+                out.ok && (out.output == original_size);
+
+    out.verify = false;
+    start = now_sec();
+    for (loop = 0; loop < iterations; loop++)
+    {
+        out.output = 0;
+        decode(&decoder, window, stream, stream_size, piece, &out);
+    }
+    elapsed = now_sec() - start;
+
+    printf("window_bits,original,compressed,ratio,decoder_ram,output_mb_per_sec,input_mb_per_sec,verify_ok\n");
+    printf("%u,%u,%u,%.3f,%u,%.1f,%.1f,%d\n", decoder.window_bits, original_size, stream_size,
+           (double)stream_size / (double)original_size,
+           (unsigned)(sizeof(cy_lzss_decoder_t) + (1UL << decoder.window_bits)),
+           ((double)original_size * iterations) / elapsed / 1e6,
+           ((double)stream_size * iterations) / elapsed / 1e6, (int)verify_ok);
+
+    free(original);
+    free(stream);
+    return verify_ok ? 0 : 1;
+}
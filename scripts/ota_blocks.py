@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   Make the block manifest of an OTA Image for CY_OTA_BLOCK_REUSE, and
+#   report the bytes it saves over a series of releases.
+#
+#   The manifest holds the first 8 bytes of the SHA-256 of each CY_OTA_CHUNK_SIZE
+#   block of the image (format in source/cy_ota_internal.h). Put it on the HTTP
+#   server next to the OTA Image and name it in the Job document:
+#       "File": "/ota_image.bin", "Manifest": "/ota_image.bin.blk"
+#   The Device hashes the same blocks of its Primary Slot and copies the ones
+#   that match instead of downloading them. Only for plain images (not tar,
+#   compressed or delta).
+#
+#   bench takes a series of release images, oldest first, and reports for each
+#   consecutive pair what a Device running the older release downloads: the
+#   first range (before the image size is known), the manifest and the blocks
+#   that changed.
+#
+#   Usage:
+#       python3 ota_blocks.py manifest [-b <block size>] <image> <manifest>
+#       python3 ota_blocks.py bench [-b <block size>] [-f <first range>] <release> <release> [<release> ...]
+#
+#   bench output is CSV:  old,new,image_bytes,blocks,reused_blocks,downloaded_bytes,saved_bytes,saved_pct
+#
+
+import argparse
+import hashlib
+import os
+import struct
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+BLOCK_SIZE = 4096                   # matches CY_OTA_CHUNK_SIZE
+MAGIC = b"CYBM"
+HEADER_FORMAT = "<4sIII"            # magic, block size, image size, blocks
+HASH_SIZE = 8                       # CY_OTA_MANIFEST_HASH_SIZE
+
+
+def block_hashes(image, block_size):
+    return [hashlib.sha256(image[o:o + block_size]).digest()[:HASH_SIZE] for o in range(0, len(image), block_size)]
+
+
+def make_manifest(image, block_size):
+    hashes = block_hashes(image, block_size)
+    return struct.pack(HEADER_FORMAT, MAGIC, block_size, len(image), len(hashes)) + b"".join(hashes)
+
+
+def reused_blocks(old, new, block_size):
+    """ blocks of new that hash the same at the same offset of old (the Primary Slot) """
+    old_hashes = block_hashes(old, block_size)
+    return [i for i, h in enumerate(block_hashes(new, block_size)) if i < len(old_hashes) and old_hashes[i] == h]
+
+
+def bench(files, block_size, first):
+    print("old,new,image_bytes,blocks,reused_blocks,downloaded_bytes,saved_bytes,saved_pct")
+    total_image = 0
+    total_saved = 0
+    for old_name, new_name in zip(files, files[1:]):
+        with open(old_name, "rb") as f:
+            old = f.read()
+        with open(new_name, "rb") as f:
+            new = f.read()
+        blocks = (len(new) + block_size - 1) // block_size
+        reused = [i for i in reused_blocks(old, new, block_size) if (i + 1) * block_size > first]
+        reused_bytes = sum(min(block_size, len(new) - i * block_size) for i in reused)
+        # the manifest is downloaded in addition to the changed blocks
+        downloaded = len(new) - reused_bytes + len(make_manifest(new, block_size))
+        saved = len(new) - downloaded
+        total_image += len(new)
+        total_saved += saved
+        print("%s,%s,%d,%d,%d,%d,%d,%.1f" % (os.path.basename(old_name), os.path.basename(new_name), len(new), blocks,
+                                            len(reused), downloaded, saved, 100.0 * saved / len(new)))
+    if total_image > 0:
+        print("total,,%d,,,%d,%d,%.1f" % (total_image, total_image - total_saved, total_saved,
+                                         100.0 * total_saved / total_image))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Block manifest for CY_OTA_BLOCK_REUSE")
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("manifest", help="make the manifest of an image")
+    p.add_argument("-b", "--block", type=int, default=BLOCK_SIZE, help="block size, CY_OTA_CHUNK_SIZE (default 4096)")
+    p.add_argument("image")
+    p.add_argument("manifest")
+    p = sub.add_parser("bench", help="bytes saved over a series of releases")
+    p.add_argument("-b", "--block", type=int, default=BLOCK_SIZE, help="block size, CY_OTA_CHUNK_SIZE (default 4096)")
+    p.add_argument("-f", "--first", type=int, default=BLOCK_SIZE,
+                   help="first range, always downloaded (default 4096, CY_OTA_HTTP_RANGE_MIN_SIZE)")
+    p.add_argument("releases", nargs="+", help="release images, oldest first")
+    args = parser.parse_args()
+
+    if args.command == "manifest":
+        with open(args.image, "rb") as f:
+            image = f.read()
+        manifest = make_manifest(image, args.block)
+        with open(args.manifest, "wb") as f:
+            f.write(manifest)
+        print("%s: %d blocks, manifest %d bytes" % (args.manifest, (len(image) + args.block - 1) // args.block, len(manifest)))
+    else:
+        if len(args.releases) < 2:
+            parser.error("bench needs at least two releases")
+        bench(args.releases, args.block, args.first)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   Compress an OTA Image (or tar archive) for CY_OTA_DECOMPRESS.
+#
+#   The output is the LZSS stream described in
+#   source/port_support/lzss/lzss.h. Put the compressed file on the
+#   server (or publish it) in place of the OTA Image; the OTA Agent sees the
+#   "CYLZ" magic at the start of the download and writes the uncompressed
+#   data to the Secondary Slot.
+#
+#   The window bits must not be larger than CY_OTA_DECOMPRESS_WINDOW_BITS
+#   of the Device.
+#
+#   Usage:
+#       python3 ota_compress.py [-w <window bits>] <input> <output>
+#       python3 ota_compress.py -d <compressed input> <output>
+#
+
+import argparse
+import struct
+import sys
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+MAGIC = b"CYLZ"
+VERSION = 1
+HEADER_FORMAT = "<4sBBHI"           # magic, version, window bits, reserved, size
+MIN_WINDOW_BITS = 8
+MAX_WINDOW_BITS = 12
+MIN_MATCH = 3
+MAX_CHAIN = 64                      # match candidates tried per position
+
+
+def compress(data, window_bits):
+    window = 1 << window_bits
+    max_match = (1 << (16 - window_bits)) - 1 + MIN_MATCH
+    out = bytearray(struct.pack(HEADER_FORMAT, MAGIC, VERSION, window_bits, 0, len(data)))
+    heads = {}                      # 3 byte prefix -> most recent positions
+    pos = 0
+    items = []
+
+    def flush_items():
+        flags = 0
+        body = bytearray()
+        for bit, item in enumerate(items):
+            if isinstance(item, int):
+                flags |= 1 << bit
+                body.append(item)
+            else:
+                body += item
+        out.append(flags)
+        out.extend(body)
+        items.clear()
+
+    def insert(at):
+        if at + MIN_MATCH <= len(data):
+            key = data[at:at + MIN_MATCH]
+            chain = heads.setdefault(key, [])
+            chain.append(at)
+            if len(chain) > MAX_CHAIN:
+                del chain[0]
+
+    while pos < len(data):
+        best_len = 0
+        best_dist = 0
+        if pos + MIN_MATCH <= len(data):
+            limit = min(max_match, len(data) - pos)
+            for cand in reversed(heads.get(data[pos:pos + MIN_MATCH], ())):
+                dist = pos - cand
+                if dist > window:
+                    break
+                length = MIN_MATCH
+                while length < limit and data[cand + length] == data[pos + length]:
+                    length += 1
+                if length > best_len:
+                    best_len = length
+                    best_dist = dist
+                    if length == limit:
+                        break
+        if best_len >= MIN_MATCH:
+            code = (best_dist - 1) | ((best_len - MIN_MATCH) << window_bits)
+            items.append(struct.pack("<H", code))
+            for at in range(pos, pos + best_len):
+                insert(at)
+            pos += best_len
+        else:
+            items.append(data[pos])
+            insert(pos)
+            pos += 1
+        if len(items) == 8:
+            flush_items()
+    if items:
+        flush_items()
+    return bytes(out)
+
+
+def decompress(stream):
+    magic, version, window_bits, _, size = struct.unpack_from(HEADER_FORMAT, stream)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a compressed OTA Image")
+    mask = (1 << window_bits) - 1
+    out = bytearray()
+    pos = struct.calcsize(HEADER_FORMAT)
+    while len(out) < size:
+        flags = stream[pos]
+        pos += 1
+        for bit in range(8):
+            if len(out) >= size:
+                break
+            if flags & (1 << bit):
+                out.append(stream[pos])
+                pos += 1
+            else:
+                code = stream[pos] | (stream[pos + 1] << 8)
+                pos += 2
+                dist = (code & mask) + 1
+                for _ in range((code >> window_bits) + MIN_MATCH):
+                    out.append(out[-dist])
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compress an OTA Image for CY_OTA_DECOMPRESS")
+    parser.add_argument("-w", "--window-bits", type=int, default=10,
+                        help="window bits %d - %d (default 10, 1 KB window)" % (MIN_WINDOW_BITS, MAX_WINDOW_BITS))
+    parser.add_argument("-d", "--decompress", action="store_true", help="decompress instead")
+    parser.add_argument("input")
+    parser.add_argument("output")
+    args = parser.parse_args()
+
+    if not MIN_WINDOW_BITS <= args.window_bits <= MAX_WINDOW_BITS:
+        parser.error("window bits must be %d - %d" % (MIN_WINDOW_BITS, MAX_WINDOW_BITS))
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+    result = decompress(data) if args.decompress else compress(data, args.window_bits)
+    with open(args.output, "wb") as f:
+        f.write(result)
+    print("%s: %d -> %d bytes (%.1f%%)" % (args.output, len(data), len(result),
+                                          100.0 * len(result) / max(1, len(data))), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
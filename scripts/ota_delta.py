@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   Make a delta patch from the running OTA Image to a new one, for CY_OTA_DELTA.
+#
+#   The output is the patch described in source/port_support/delta/delta.h.
+#   Put the patch on the server (or publish it) in place of the OTA Image; the
+#   OTA Agent sees the "CYDP" magic at the start of the download, reads the
+#   old image from the Primary Slot and writes the new image to the Secondary
+#   Slot. The old image must be the exact image in the Primary Slot of the
+#   Device, the patch carries its size and CRC-32 and is refused otherwise.
+#
+#   Matching bytes are copied from the old image. Where the code only moved,
+#   most bytes still match and the rest differ by the same few values (the
+#   shifted addresses), so the region is sent as the byte differences (ADD).
+#   Those differences are mostly zero, use "-c" to LZSS compress the patch
+#   (needs CY_OTA_DECOMPRESS on the Device as well).
+#
+#   Usage:
+#       python3 ota_delta.py [-c] [-w <window bits>] <old image> <new image> <patch>
+#       python3 ota_delta.py -a <old image> <patch> <new image>
+#
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import ota_compress                 # noqa: E402
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+MAGIC = b"CYDP"
+VERSION = 1
+HEADER_FORMAT = "<4sB3xIII"         # magic, version, reserved, old size, old CRC-32, new size
+OP_COPY = 1
+OP_ADD = 2
+OP_INSERT = 3
+
+KEY_SIZE = 12                       # bytes that must match to start a copy
+INDEX_STEP = 4                      # old image positions indexed
+MIN_COPY = 16                       # shorter exact runs stay in the ADD
+
+
+def make_index(old):
+    index = {}
+    for pos in range(0, len(old) - KEY_SIZE + 1, INDEX_STEP):
+        index.setdefault(old[pos:pos + KEY_SIZE], pos)
+    return index
+
+
+def extend_approximate(old, new, old_pos, new_pos):
+    """ Length from the positions where at least half of the bytes match (as bsdiff) """
+    score = 0
+    best_score = 0
+    best_len = 0
+    limit = min(len(old) - old_pos, len(new) - new_pos)
+    i = 0
+    while i < limit:
+        if old[old_pos + i] == new[new_pos + i]:
+            score += 1
+        i += 1
+        if score * 2 - i > best_score * 2 - best_len:
+            best_score = score
+            best_len = i
+        elif i - best_len > 64:
+            break
+    return best_len
+
+
+def make_patch(old, new):
+    out = bytearray(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(old), zlib.crc32(old), len(new)))
+    index = make_index(old)
+    insert = bytearray()
+
+    def put_insert():
+        if insert:
+            out.extend(struct.pack("<BI", OP_INSERT, len(insert)))
+            out.extend(insert)
+            insert.clear()
+
+    def put_copy(old_pos, length):
+        put_insert()
+        out.extend(struct.pack("<BII", OP_COPY, old_pos, length))
+
+    def put_add(old_pos, new_pos, length):
+        put_insert()
+        out.extend(struct.pack("<BII", OP_ADD, old_pos, length))
+        out.extend(bytes((new[new_pos + i] - old[old_pos + i]) & 0xFF for i in range(length)))
+
+    pos = 0
+    while pos < len(new):
+        cand = index.get(new[pos:pos + KEY_SIZE])
+        if cand is None:
+            insert.append(new[pos])
+            pos += 1
+            continue
+
+        # grow the exact match back into the pending insert, then forward
+        while insert and cand > 0 and old[cand - 1] == insert[-1]:
+            insert.pop()
+            cand -= 1
+            pos -= 1
+        length = 0
+        while pos + length < len(new) and cand + length < len(old) and old[cand + length] == new[pos + length]:
+            length += 1
+        put_copy(cand, length)
+        pos += length
+        cand += length
+
+        # same old position onwards: differences, with long exact runs copied
+        while pos < len(new):
+            approx = extend_approximate(old, new, cand, pos)
+            if approx == 0:
+                break
+            start = 0
+            run = 0
+            for i in range(approx):
+                if old[cand + i] == new[pos + i]:
+                    run += 1
+                    continue
+                if run >= MIN_COPY:
+                    if i - run > start:
+                        put_add(cand + start, pos + start, i - run - start)
+                    put_copy(cand + i - run, run)
+                    start = i
+                run = 0
+            if run >= MIN_COPY:
+                if approx - run > start:
+                    put_add(cand + start, pos + start, approx - run - start)
+                put_copy(cand + approx - run, run)
+            else:
+                put_add(cand + start, pos + start, approx - start)
+            pos += approx
+            cand += approx
+    put_insert()
+    return bytes(out)
+
+
+def apply_patch(old, patch):
+    magic, version, old_size, old_crc, new_size = struct.unpack_from(HEADER_FORMAT, patch)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a delta patch")
+    if old_size != len(old) or old_crc != zlib.crc32(old):
+        raise ValueError("patch is for another old image")
+    new = bytearray()
+    pos = struct.calcsize(HEADER_FORMAT)
+    while len(new) < new_size:
+        op = patch[pos]
+        pos += 1
+        if op == OP_INSERT:
+            (length,) = struct.unpack_from("<I", patch, pos)
+            pos += 4
+            new += patch[pos:pos + length]
+            pos += length
+        elif op in (OP_COPY, OP_ADD):
+            old_pos, length = struct.unpack_from("<II", patch, pos)
+            pos += 8
+            if op == OP_COPY:
+                new += old[old_pos:old_pos + length]
+            else:
+                new += bytes((old[old_pos + i] + patch[pos + i]) & 0xFF for i in range(length))
+                pos += length
+        else:
+            raise ValueError("bad opcode %d at %d" % (op, pos - 1))
+    return bytes(new)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Make a delta patch for CY_OTA_DELTA")
+    parser.add_argument("-a", "--apply", action="store_true", help="apply: <old image> <patch> <new image>")
+    parser.add_argument("-c", "--compress", action="store_true", help="LZSS compress the patch (CY_OTA_DECOMPRESS)")
+    parser.add_argument("-w", "--window-bits", type=int, default=10,
+                        help="window bits for -c, %d - %d (default 10)" % (ota_compress.MIN_WINDOW_BITS,
+                                                                          ota_compress.MAX_WINDOW_BITS))
+    parser.add_argument("old")
+    parser.add_argument("input")
+    parser.add_argument("output")
+    args = parser.parse_args()
+
+    if not ota_compress.MIN_WINDOW_BITS <= args.window_bits <= ota_compress.MAX_WINDOW_BITS:
+        parser.error("window bits must be %d - %d" % (ota_compress.MIN_WINDOW_BITS, ota_compress.MAX_WINDOW_BITS))
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    if args.apply:
+        if data[:len(ota_compress.MAGIC)] == ota_compress.MAGIC:
+            data = ota_compress.decompress(data)
+        result = apply_patch(old, data)
+    else:
+        result = make_patch(old, data)
+        if args.compress:
+            result = ota_compress.compress(result, args.window_bits)
+    with open(args.output, "wb") as f:
+        f.write(result)
+    print("%s: %d -> %d bytes (%.1f%%)" % (args.output, len(data), len(result),
+                                          100.0 * len(result) / max(1, len(data))), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
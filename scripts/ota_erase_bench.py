@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   Secondary Slot erase benchmark, full erase against CY_OTA_LAZY_ERASE.
+#
+#   Simulates the download of an image into a Secondary Slot on a FLASH with
+#   the given erase and program times (typical datasheet values by default):
+#       full - cy_ota_storage_open() erases the whole slot, then the download starts.
+#       lazy - cy_ota_storage_open() erases the end of the slot (trailer and
+#              journal), each other sector is erased before the first write
+#              into it, tracked in a bitmap as in cy_ota_storage_prepare_write().
+#       ahead - lazy with CY_OTA_ERASE_AHEAD_SECTORS ("-a"): after each write the
+#              erase-ahead thread erases the next sectors while the next chunk is
+#              received. FLASH is busy during an erase, a write that arrives during
+#              one waits for it to finish (one sector per lock, as the thread).
+#   Chunks are received and written in the receiving thread
+#   (CY_OTA_WRITER_NUM_BUFFERS 0). With "-p", chunks arrive from that many
+#   parallel range connections (CY_OTA_HTTP_CONNECTIONS), out of order.
+#
+#   Usage:
+#       python3 ota_erase_bench.py [-s <slot size>] [-i <image size list>]
+#                                  [-n <network bytes/s>] [-p <connections>]
+#                                  [-t <tail size>] [-f <profile list>] [-a <sectors>]
+#
+#   Output is CSV:  profile,image,mode,open_ms,first_write_ms,total_ms,sectors_erased,writer_waits,wait_ms,speedup
+#   open_ms is the time in cy_ota_storage_open(), first_write_ms the time until
+#   the first chunk is in FLASH; writer_waits and wait_ms count the writes that
+#   waited on an erase after the download started; speedup is total_ms of full
+#   over the mode.
+#
+
+import argparse
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+CHUNK_SIZE = 4096                   # matches CY_OTA_CHUNK_SIZE
+
+# name: (sector size, sector erase ms, program bytes/s)
+PROFILES = {
+    "smif_256k": (256 * 1024, 520.0, 1.5e6),     # S25FL512S, 256 KB sectors, 512 B page in 340 us
+    "smif_64k":  (64 * 1024, 150.0, 0.9e6),      # 64 KB block erase, 256 B page in 280 us
+    "smif_4k":   (4 * 1024, 45.0, 0.57e6),       # 4 KB sector erase, 256 B page in 450 us
+}
+
+
+def size_list(text):
+    result = []
+    for item in text.split(","):
+        item = item.strip().upper()
+        scale = 1
+        if item.endswith("K"):
+            scale, item = 1024, item[:-1]
+        elif item.endswith("M"):
+            scale, item = 1024 * 1024, item[:-1]
+        result.append(int(float(item) * scale))
+    return result
+
+
+def chunk_offsets(image_size, connections):
+    """ Chunk offsets in arrival order: each connection downloads one contiguous part """
+    chunks = list(range(0, image_size, CHUNK_SIZE))
+    if connections <= 1:
+        return chunks
+    per = (len(chunks) + connections - 1) // connections
+    parts = [chunks[i:i + per] for i in range(0, len(chunks), per)]
+    order = []
+    for i in range(per):
+        order.extend(part[i] for part in parts if i < len(part))
+    return order
+
+
+def simulate(profile, slot_size, image_size, net_rate, connections, tail_size, lazy, ahead=0):
+    sector, erase_ms, program_rate = profile
+    sectors = slot_size // sector
+    tail = (slot_size - tail_size) // sector
+    if lazy:
+        erased = [False] * tail + [True] * (sectors - tail)
+        now = (sectors - tail) * erase_ms
+    else:
+        erased = [True] * sectors
+        now = sectors * erase_ms
+    open_ms = now
+    erases = sectors - tail if lazy else sectors
+    first_write_ms = None
+    waits = 0
+    wait_ms = 0.0
+    image_sectors = (image_size + sector - 1) // sector      # the thread stops at total_image_size
+    ahead_first = 0
+    ahead_end = min(ahead, image_sectors)
+
+    for offset in chunk_offsets(image_size, connections):
+        size = min(CHUNK_SIZE, image_size - offset)
+        arrival = now + 1000.0 * size / net_rate
+        # the erase-ahead thread starts erases while the chunk is received
+        flash_free = now
+        for s in range(ahead_first, ahead_end):
+            if flash_free >= arrival:
+                break
+            if not erased[s]:
+                erased[s] = True
+                erases += 1
+                flash_free += erase_ms
+        now = max(arrival, flash_free)
+        end = (offset + size + sector - 1) // sector
+        for s in range(offset // sector, end):
+            if not erased[s]:
+                erased[s] = True
+                erases += 1
+                now += erase_ms
+        if now > arrival:
+            waits += 1
+            wait_ms += now - arrival
+        now += 1000.0 * size / program_rate
+        if ahead and end + ahead > ahead_end and end < image_sectors:
+            ahead_first, ahead_end = end, min(end + ahead, image_sectors)
+        if first_write_ms is None:
+            first_write_ms = now
+    return open_ms, first_write_ms, now, erases, waits, wait_ms
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulate full and lazy Secondary Slot erase")
+    parser.add_argument("-s", "--slot", default="2M", help="Secondary Slot size (default 2M)")
+    parser.add_argument("-i", "--images", default="128K,512K,1M,1.75M", help="image sizes")
+    parser.add_argument("-n", "--network", type=float, default=500e3, help="network bytes/s (default 500e3)")
+    parser.add_argument("-p", "--connections", type=int, default=1, help="parallel range connections (default 1)")
+    parser.add_argument("-t", "--tail", default="4K", help="end of slot erased at open (default 4K, CY_OTA_LAZY_ERASE_TRAILER_SIZE)")
+    parser.add_argument("-f", "--profiles", default=",".join(PROFILES), help="FLASH profiles: " + ",".join(PROFILES))
+    parser.add_argument("-a", "--ahead", type=int, default=2,
+                        help="sectors erased ahead, CY_OTA_ERASE_AHEAD_SECTORS (default 2, 0 = no ahead mode)")
+    args = parser.parse_args()
+
+    slot_size = size_list(args.slot)[0]
+    tail_size = size_list(args.tail)[0]
+    print("profile,image,mode,open_ms,first_write_ms,total_ms,sectors_erased,writer_waits,wait_ms,speedup")
+    for name in args.profiles.split(","):
+        profile = PROFILES[name]
+        for image_size in size_list(args.images):
+            if image_size > slot_size - tail_size:
+                continue
+            full = simulate(profile, slot_size, image_size, args.network, args.connections, tail_size, False)
+            lazy = simulate(profile, slot_size, image_size, args.network, args.connections, tail_size, True)
+            modes = [("full", full), ("lazy", lazy)]
+            if args.ahead > 0:
+                modes.append(("ahead", simulate(profile, slot_size, image_size, args.network, args.connections,
+                                                tail_size, True, args.ahead)))
+            for mode, result in modes:
+                print("%s,%d,%s,%.0f,%.0f,%.0f,%d,%d,%.0f,%.2f" % (name, image_size, mode, result[0], result[1],
+                                                                   result[2], result[3], result[4], result[5],
+                                                                   full[2] / result[2]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   BT FW Patch load benchmark for a FW Data Block (FWDB), peak heap and call time.
+#
+#   Builds host/ota_host with FW_DATBLOCK_SEPARATE_FROM_APPLICATION, programs
+#   the FWDB into the Primary Slot of the FLASH emulator behind an imgtool
+#   header and runs "ota_host -B", which loads the BT FW Patch the way the
+#   application does at boot and hashes every byte (standing in for the HCI
+#   writes to the BT module). Modes:
+#       copy    - cy_ota_fwdb_get_bt_fw(): heap for the whole patch, read from FLASH
+#       pieces  - cy_ota_fwdb_get_bt_fw_data() into one buffer of "-c" bytes
+#       mapped  - cy_ota_fwdb_get_bt_fw_mapped(): the patch in memory mapped FLASH
+#   The FWDB is the file given, or one made by build_fw_data_block.py with a
+#   random patch of "-S" bytes.
+#
+#   The Primary Slot is internal FLASH in the emulator, so FLASH reads cost
+#   memcpy() time on the host. "-M <timing>" adds the modelled device read
+#   time (read_us, see ota_host -M) without sleeping.
+#
+#   Usage:
+#       python3 ota_fwdb_bt_bench.py [-S <patch size> | <fw_data_block.bin>] [-c <piece size list>]
+#                                    [-M <timing>] [-n <runs>]
+#
+#   Output is CSV:  mode,piece,patch_bytes,peak_heap,call_us,read_calls,read_us,verify_ok
+#   peak_heap is the OTA heap peak during the load, call_us the median over the runs,
+#   verify_ok that the bytes loaded match the patch in the FWDB.
+#
+
+import argparse
+import json
+import os
+import statistics
+import struct
+import subprocess
+import sys
+import tempfile
+
+from ota_host_bench import build_host, int_list
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+CHUNK_SIZE = 4096                           # CY_OTA_CHUNK_SIZE, not used by the load
+FWDB_MAGIC = b"InfineonFWData  "
+FWDB_HEADER_FORMAT = "<16s2I4H4I128s2I"      # cy_ota_fw_data_block_header_t
+IMGTOOL_HEADER_SIZE = 0x100                 # CY_OTA_IMGTOOL_HEADER_SIZE
+BT_PATCH_VERSION = "BCM_BENCH_PATCH"
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def fnv1a(data):
+    """ ota_host_fnv1a() """
+    value = 0x811C9DC5
+    for byte in data:
+        value = ((value ^ byte) * 0x01000193) & 0xFFFFFFFF
+    return value
+
+
+def make_fwdb(directory, size):
+    """ FWDB with a random BT FW Patch of "size" bytes, made by build_fw_data_block.py """
+    with open(os.path.join(directory, "bt_patch.c"), "w") as f:
+        f.write('const char brcm_patch_version[] = "%s";\n' % BT_PATCH_VERSION)
+    with open(os.path.join(directory, BT_PATCH_VERSION + ".hcd"), "wb") as f:
+        f.write(os.urandom(size))
+    name = os.path.join(directory, "fw_data_block.bin")
+    subprocess.run([sys.executable, os.path.join(SCRIPT_DIR, "build_fw_data_block.py"),
+                    "-bt_src", os.path.join(directory, "bt_patch.c"), "-out_file", name],
+                   check=True, stdout=subprocess.DEVNULL)
+    return name
+
+
+def read_patch(name):
+    """ The BT FW Patch bytes of a FWDB file, which may start with the imgtool header """
+    with open(name, "rb") as f:
+        data = f.read()
+    for base in (0, IMGTOOL_HEADER_SIZE):
+        fields = struct.unpack_from(FWDB_HEADER_FORMAT, data, base)
+        if fields[0] == FWDB_MAGIC:
+            offset, size = fields[-2], fields[-1]
+            return data[base:], data[base + offset:base + offset + size]
+    raise SystemExit("%s: no FW Data Block header" % name)
+
+
+def run_load(host, directory, mode, args):
+    """ One "ota_host -B" run, returns the ota_host JSON result or None """
+    result_file = os.path.join(directory, "result.json")
+    if os.path.exists(result_file):
+        os.remove(result_file)
+    cmd = [host, "-F", os.path.join(directory, "flash.bin"), "-E", "-P", os.path.join(directory, "primary.bin"),
+           "-B", mode, "-j", result_file]
+    if args.timing:
+        cmd += ["-M", args.timing]
+    subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.STDOUT)
+    if not os.path.exists(result_file):
+        return None
+    with open(result_file) as f:
+        return json.load(f)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="BT FW Patch load from the FW Data Block on the host built OTA Agent")
+    parser.add_argument("fwdb", nargs="?", help="FW Data Block made by build_fw_data_block.py")
+    parser.add_argument("-S", "--size", type=int, default=40 * 1024, help="patch size when no FWDB (default 40 KB)")
+    parser.add_argument("-c", "--pieces", type=int_list, default=[256, 1024, 4096], help="piece sizes for pieces")
+    parser.add_argument("-M", "--timing", default=None, help="FLASH timing model for read_us (see ota_host -M)")
+    parser.add_argument("-n", "--runs", type=int, default=5, help="runs of each mode")
+    args = parser.parse_args()
+
+    host = build_host(CHUNK_SIZE, None, ["FW_DATBLOCK_SEPARATE_FROM_APPLICATION"], tag="_fwdb")
+    failed = 0
+
+    print("mode,piece,patch_bytes,peak_heap,call_us,read_calls,read_us,verify_ok")
+    with tempfile.TemporaryDirectory() as directory:
+        fwdb, patch = read_patch(args.fwdb or make_fwdb(directory, args.size))
+        with open(os.path.join(directory, "primary.bin"), "wb") as f:
+            f.write(bytes(IMGTOOL_HEADER_SIZE) + fwdb)
+        expected = fnv1a(patch)
+
+        for mode in ["copy"] + ["pieces:%d" % piece for piece in args.pieces] + ["mapped"]:
+            results = [run_load(host, directory, mode, args) for _ in range(args.runs)]
+            ok = all((r is not None) and (r["result"] == "success") and (r["hash"] == expected) and
+                     (r["patch_bytes"] == len(patch)) and (r["heap_in_use"] == 0) for r in results)
+            failed += 0 if ok else 1
+            if results[0] is None:
+                print("%s,,,,,,,0" % mode)
+                continue
+            first = results[0]
+            call_us = statistics.median(r["call_us"] for r in results if r is not None)
+            print("%s,%d,%d,%d,%d,%d,%d,%d" % (first["mode"], first["piece"], first["patch_bytes"], first["heap_peak"],
+                                               call_us, first["flash"]["reads"], first["flash"]["read_us"], int(ok)))
+            sys.stdout.flush()
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   End to end HTTP OTA benchmark.
+#
+#   Runs the OTA Agent built for the host (host/ota_host) against a local
+#   ota_http_server.py that serves the Job document (CY_OTA_HTTP_JOB_FILE)
+#   and a test OTA Image (CY_OTA_HTTP_DATA_FILE). Each run goes from
+#   cy_ota_agent_start() to CY_OTA_STATE_OTA_COMPLETE on a freshly erased
+#   FLASH emulator.
+#
+#   ota_host is built once per chunk size with
+#       make EXTRA_DEFINES=-DCY_OTA_CHUNK_SIZE=<chunk> in host/
+#   into host/build/bench_c<chunk>/, the rest of the configuration comes
+#   from configs/cy_ota_config.h (or "--config <dir>").
+#
+#   The host build has no TLS, so the runs are plain HTTP. The numbers
+#   cover the Agent, the transport code and the storage writes, not the
+#   cost of TLS on the Device.
+#
+#   Usage:
+#       python3 ota_host_bench.py [-s <image sizes>] [-c <chunk sizes>] [-f job|direct]
+#                                 [-x] [-M <timing>] [-r <rtt ms>] [-k <kbytes/s>]
+#                                 [--config <dir>] [--csv] [-o <file>]
+#
+#   Output is one JSON object per run (JSON lines), or CSV with "--csv":
+#       size,chunk,flow,result,seconds,bytes_per_sec,requests,connections,
+#       flash_ops_per_mb,reads,writes,erases,context_size,heap_peak,<ms in the main states>
+#   Keep the output of each release to compare them.
+#
+
+import argparse
+import hashlib
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+import ota_http_server
+from ota_image_hash_bench import make_image
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+SCHEMA = 1                          # bump when the record layout changes
+JOB_FILE = "ota_update.json"        # matches CY_OTA_HTTP_JOB_FILE
+IMAGE_NAME = "anycloud-ota.bin"     # matches CY_OTA_HTTP_DATA_FILE
+JOURNAL_COMMIT_SIZE = 16 * 1024     # matches CY_OTA_JOURNAL_COMMIT_SIZE, must be >= the chunk size
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+HOST_DIR = os.path.join(SCRIPT_DIR, "host")
+
+# cy_ota_get_state_string() of the states reported in CSV output, with the column names
+STATES = [("OTA STATE Storage Open", "storage_open"), ("OTA STATE Connecting for Job", "connect_job"),
+          ("OTA STATE Download Job", "download_job"), ("OTA STATE parse Job", "parse_job"),
+          ("OTA STATE Connecting for Data", "connect_data"), ("OTA STATE Downloading Data", "download_data"),
+          ("OTA STATE Storage Write", "storage_write"), ("OTA STATE Storage Close", "storage_close"),
+          ("OTA STATE Verifying", "verify")]
+
+
+def int_list(text):
+    """ Comma separated numbers, "K" and "M" suffixes multiply by 1024 and 1024 * 1024 """
+    values = []
+    for item in text.split(","):
+        item = item.strip()
+        if item == "":
+            continue
+        scale = {"K": 1024, "M": 1024 * 1024}.get(item[-1].upper(), 1)
+        values.append(int(item[:-1] if scale > 1 else item, 0) * scale)
+    return values
+
+
+def build_host(chunk, config_dir, extra_defines=(), tag=""):
+    """ Build ota_host for one chunk size (and extra -D defines), returns the path
+
+    Each config directory and set of defines gets its own build directory, the Makefile
+    rebuilds when a source or header in it changes.
+    """
+    defines = "-DCY_OTA_CHUNK_SIZE=%d" % chunk
+    if chunk > JOURNAL_COMMIT_SIZE:
+        defines += " -DCY_OTA_JOURNAL_COMMIT_SIZE=%d" % chunk
+    defines += "".join(" -D" + define for define in extra_defines)
+    key = "%s %s" % (os.path.abspath(config_dir) if config_dir is not None else "", defines)
+    build_dir = os.path.join("build", "bench_c%d%s_%s" % (chunk, tag, hashlib.sha1(key.encode()).hexdigest()[:8]))
+    target = os.path.join(build_dir, "ota_host")
+    cmd = ["make", "-s", "-j%d" % (os.cpu_count() or 1), "BUILD_DIR=" + build_dir, "TARGET=" + target,
+           "EXTRA_DEFINES=" + defines]
+    if config_dir is not None:
+        cmd.append("OTA_CONFIG=" + os.path.abspath(config_dir))
+    subprocess.run(cmd, cwd=HOST_DIR, check=True, stdout=subprocess.DEVNULL)
+    return os.path.join(HOST_DIR, target)
+
+
+def write_job(directory, port):
+    with open(os.path.join(SCRIPT_DIR, "http_update.json")) as f:
+        job = json.load(f)
+    job["Server"] = "127.0.0.1"
+    job["Port"] = str(port)
+    job["File"] = "/" + IMAGE_NAME
+    with open(os.path.join(directory, JOB_FILE), "w") as f:
+        json.dump(job, f)
+
+
+def run_one(host, server, directory, size, chunk, args, port=None):
+    """ One update session, returns the result record. "port" is where ota_host connects, default the server """
+    image, _ = make_image(size, seed=size)
+    with open(os.path.join(directory, IMAGE_NAME), "wb") as f:
+        f.write(image)
+    result_file = os.path.join(directory, "result.json")
+    if os.path.exists(result_file):
+        os.remove(result_file)
+
+    cmd = [host, "-p", str(port or server.server_address[1]), "-F", os.path.join(directory, "flash.bin"), "-E",
+           "-j", result_file, "-t", str(args.timeout)]
+    if args.flow == "direct":
+        cmd.append("-d")
+    if args.external:
+        cmd.append("-x")
+    if args.timing:
+        cmd += ["-M", args.timing, "-R", str(args.scale)]
+
+    server.stats.reset()
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    record = {"schema": SCHEMA, "size": len(image), "chunk": chunk, "flow": args.flow,
+              "external": args.external, "timing": args.timing or "", "rtt_ms": args.rtt,
+              "rate_kbps": args.rate, "exit": proc.returncode}
+    if not os.path.exists(result_file):
+        record["result"] = "no result"
+        sys.stderr.write(proc.stdout.decode("utf-8", "replace"))
+        return record
+
+    with open(result_file) as f:
+        host_result = json.load(f)
+    seconds = host_result["elapsed_ms"] / 1000.0
+    flash = host_result["flash"]
+    mbytes = len(image) / (1024.0 * 1024.0)
+    record.update({
+        "result": host_result["result"],
+        "seconds": seconds,
+        "failures": host_result["failures"],
+        "bytes_per_sec": round(host_result["bytes"] / seconds) if seconds > 0 else 0,
+        "requests": server.stats.requests,
+        "range_requests": server.stats.range_requests,
+        "connections": server.stats.connections,
+        "bytes_sent": server.stats.bytes_sent,
+        "flash_ops_per_mb": round((flash["reads"] + flash["writes"] + flash["erases"]) / mbytes, 1),
+        "flash": flash,
+        "context_size": host_result["context_size"],
+        "heap_peak": host_result["heap_peak"],
+        "states": host_result["states"],
+        "agent_stats": host_result["agent_stats"],
+        "range_stats": host_result["range_stats"],
+    })
+    return record
+
+
+def csv_line(record):
+    fields = [record["size"], record["chunk"], record["flow"], record["result"], record.get("seconds", ""),
+              record.get("bytes_per_sec", ""), record.get("requests", ""), record.get("connections", ""),
+              record.get("flash_ops_per_mb", "")]
+    flash = record.get("flash", {})
+    fields += [flash.get("reads", ""), flash.get("writes", ""), flash.get("erases", ""),
+               record.get("context_size", ""), record.get("heap_peak", "")]
+    states = record.get("states", {})
+    fields += [states.get(name, {}).get("ms", 0) for name, _ in STATES]
+    return ",".join(str(x) for x in fields)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="End to end HTTP OTA benchmark of the host built OTA Agent")
+    parser.add_argument("-s", "--sizes", type=int_list, default=[64 * 1024, 256 * 1024, 1024 * 1024],
+                        help="comma separated image sizes (default 64K,256K,1M)")
+    parser.add_argument("-c", "--chunks", type=int_list, default=[1024, 4096, 16384],
+                        help="comma separated CY_OTA_CHUNK_SIZE values (default 1024,4096,16384)")
+    parser.add_argument("-f", "--flow", choices=["job", "direct"], default="job", help="Job flow or Direct flow")
+    parser.add_argument("-x", "--external", action="store_true", help="Secondary Slot in external FLASH")
+    parser.add_argument("-M", "--timing", default=None, help="FLASH timing model (see ota_host -M)")
+    parser.add_argument("-R", "--scale", type=float, default=0.0, help="sleep for the modelled FLASH time * scale")
+    parser.add_argument("-r", "--rtt", type=int, default=0, help="server round trip time in milliseconds")
+    parser.add_argument("-k", "--rate", type=int, default=0, help="server bandwidth limit in kbytes/s")
+    parser.add_argument("-t", "--timeout", type=int, default=300, help="timeout of one run in seconds")
+    parser.add_argument("--config", default=None, help="directory with the cy_ota_config.h to build with")
+    parser.add_argument("--csv", action="store_true", help="CSV instead of JSON lines")
+    parser.add_argument("-o", "--output", default=None, help="output file (default stdout)")
+    args = parser.parse_args()
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    if args.csv:
+        out.write("size,chunk,flow,result,seconds,bytes_per_sec,requests,connections,flash_ops_per_mb,"
+                  "reads,writes,erases,context_size,heap_peak," +
+                  ",".join(column + "_ms" for _, column in STATES) + "\n")
+
+    failed = 0
+    with tempfile.TemporaryDirectory() as directory:
+        server = ota_http_server.start_server(directory, 0, args.rtt, False, args.rate)
+        write_job(directory, server.server_address[1])
+        for chunk in args.chunks:
+            host = build_host(chunk, args.config)
+            for size in args.sizes:
+                record = run_one(host, server, directory, size, chunk, args)
+                failed += 0 if record["result"] == "success" else 1
+                out.write((csv_line(record) if args.csv else json.dumps(record)) + "\n")
+                out.flush()
+        server.shutdown()
+
+    if out is not sys.stdout:
+        out.close()
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
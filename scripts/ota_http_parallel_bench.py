@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   HTTP parallel range download benchmark.
+#
+#   Downloads a test image from local ota_http_server.py instances (the Server
+#   and its mirrors) the same way cy_ota_http_fetch_parallel() does:
+#       CY_OTA_HTTP_CONNECTIONS fetch threads, slot i on server i % servers
+#       each thread claims the lowest range not yet claimed, ranges given up
+#       are claimed first
+#       a range that fails is given back, the thread stops
+#       a thread more than CY_OTA_HTTP_SLOW_FACTOR times slower than the
+#       fastest other thread stops after its range is written
+#       the ranges are written in order, one buffer per thread
+#
+#   Each connection is limited to the server bandwidth. With "-x" the last
+#   mirror is ten times slower, to show the slow mirror being dropped.
+#
+#   Usage:
+#       python3 ota_http_parallel_bench.py [-s <image size>] [-c <chunk size>] [-w <window>]
+#                                          [-n <connections list>] [-m <mirrors>]
+#                                          [-r <rtt ms>] [-k <kbytes/s>] [-x]
+#
+#   Output is CSV:  connections,servers,slow_mirror,seconds,bytes_per_sec,speedup,parked,requeued,verify_ok
+#   speedup is against 1 connection.
+#
+
+import argparse
+import http.client
+import os
+import tempfile
+import threading
+import time
+
+import ota_http_server
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+IMAGE_NAME = "anycloud-ota.bin"     # matches CY_OTA_HTTP_DATA_FILE
+CHUNK_SIZE = 4096                   # matches CY_OTA_CHUNK_SIZE
+WINDOW = 4                          # matches CY_OTA_HTTP_RANGE_WINDOW
+SLOW_FACTOR = 4                     # matches CY_OTA_HTTP_SLOW_FACTOR
+AVG_WEIGHT = 7                      # matches CY_OTA_HTTP_RANGE_AVG_WEIGHT
+
+
+def int_list(text):
+    return [int(x) for x in text.split(",") if x != ""]
+
+
+class Fetch:
+    """cy_ota_http_fetch_t"""
+    def __init__(self, image_size, span):
+        self.image_size = image_size
+        self.span = span
+        self.lock = threading.Lock()
+        self.ready = threading.Condition(self.lock)
+        self.next_offset = 0
+        self.requeue = []
+        self.stop = False
+        self.requeued = 0
+        self.parked = 0
+        self.slots = []
+
+    def claim(self, slot):
+        """cy_ota_http_fetch_claim(), call with the lock held"""
+        if self.stop:
+            return False
+        if self.requeue:
+            self.requeue.sort()
+            slot.offset = self.requeue.pop(0)
+        elif self.next_offset < self.image_size:
+            slot.offset = self.next_offset
+            self.next_offset += self.span
+        else:
+            return False
+        slot.size = min(self.span, self.image_size - slot.offset)
+        slot.state = "BUSY"
+        return True
+
+    def too_slow(self, slot):
+        """cy_ota_http_fetch_too_slow(), call with the lock held"""
+        if slot.requests == 0:
+            return False
+        others = [s.avg_ms for s in self.slots if s is not slot and s.state != "STOPPED" and s.requests > 0]
+        return bool(others) and slot.avg_ms > min(others) * SLOW_FACTOR
+
+
+class Slot:
+    """cy_ota_http_fetch_slot_t"""
+    def __init__(self, fetch, index, port):
+        self.fetch = fetch
+        self.index = index
+        self.port = port
+        self.state = "IDLE"
+        self.offset = 0
+        self.size = 0
+        self.body = None
+        self.requests = 0
+        self.avg_ms = 0
+        self.free = threading.Semaphore(0)
+        self.thread = threading.Thread(target=self.run, daemon=True)
+
+    def get(self, conn):
+        end = self.offset + self.size - 1
+        conn.request("GET", "/" + IMAGE_NAME, headers={"Range": "bytes=%d-%d" % (self.offset, end)})
+        response = conn.getresponse()
+        body = response.read()
+        if response.status // 100 != 2 or len(body) != self.size:
+            raise RuntimeError("bad response %d len %d" % (response.status, len(body)))
+        return body
+
+    def run(self):
+        """cy_ota_http_fetch_thread()"""
+        fetch = self.fetch
+        conn = http.client.HTTPConnection("127.0.0.1", self.port)
+        while True:
+            with fetch.lock:
+                if not fetch.claim(self):
+                    break
+            start = time.monotonic()
+            try:
+                body = self.get(conn)
+            except (OSError, RuntimeError, http.client.HTTPException):
+                with fetch.lock:
+                    fetch.requeue.append(self.offset)
+                    fetch.requeued += 1
+                break
+            request_ms = (time.monotonic() - start) * 1000.0
+            self.avg_ms = request_ms if self.requests == 0 else (self.avg_ms * AVG_WEIGHT + request_ms) / 8
+            self.requests += 1
+            with fetch.lock:
+                self.body = body
+                self.state = "READY"
+                fetch.ready.notify()
+            self.free.acquire()
+            with fetch.lock:
+                if fetch.stop:
+                    break
+                if fetch.too_slow(self):
+                    fetch.parked += 1
+                    break
+        conn.close()
+        with fetch.lock:
+            self.state = "STOPPED"
+            fetch.ready.notify()
+
+
+def download(ports, image_size, span, connections):
+    """cy_ota_http_fetch_parallel(), returns (image, seconds, parked, requeued)"""
+    fetch = Fetch(image_size, span)
+    fetch.slots = [Slot(fetch, i, ports[i % len(ports)]) for i in range(connections)]
+    image = bytearray()
+    start = time.monotonic()
+    for slot in fetch.slots:
+        slot.thread.start()
+    with fetch.lock:
+        while len(image) < image_size:
+            ready = [s for s in fetch.slots if s.state == "READY" and s.offset == len(image)]
+            if ready:
+                slot = ready[0]
+                body = slot.body
+                slot.state = "IDLE"
+                fetch.lock.release()
+                image += body           # written in order
+                slot.free.release()
+                fetch.lock.acquire()
+                continue
+            alive = [s for s in fetch.slots if s.state != "STOPPED"]
+            if not alive:
+                break
+            if not [s for s in alive if s.state in ("IDLE", "BUSY")]:
+                victim = max([s for s in alive if s.state == "READY"], key=lambda s: s.offset)
+                fetch.requeue.append(victim.offset)
+                fetch.requeued += 1
+                victim.state = "IDLE"
+                victim.free.release()
+            fetch.ready.wait(1.0)
+        fetch.stop = True
+    for slot in fetch.slots:
+        slot.free.release()
+        slot.thread.join()
+    return bytes(image), time.monotonic() - start, fetch.parked, fetch.requeued
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP parallel range download benchmark")
+    parser.add_argument("-s", "--size", type=int, default=1024 * 1024, help="test image size in bytes")
+    parser.add_argument("-c", "--chunk", type=int, default=CHUNK_SIZE, help="CY_OTA_CHUNK_SIZE")
+    parser.add_argument("-w", "--window", type=int, default=WINDOW, help="CY_OTA_HTTP_RANGE_WINDOW")
+    parser.add_argument("-n", "--connections", type=int_list, default=[1, 2, 4], help="comma separated CY_OTA_HTTP_CONNECTIONS list")
+    parser.add_argument("-m", "--mirrors", type=int, default=1, help="number of mirrors in the Job document")
+    parser.add_argument("-r", "--rtt", type=int, default=50, help="simulated round trip time in milliseconds")
+    parser.add_argument("-k", "--rate", type=int, default=256, help="bandwidth per connection in kbytes/s")
+    parser.add_argument("-x", "--slow", action="store_true", help="last mirror is ten times slower")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        expected = os.urandom(args.size)
+        with open(os.path.join(directory, IMAGE_NAME), "wb") as f:
+            f.write(expected)
+
+        servers = []
+        for i in range(args.mirrors + 1):
+            rate = args.rate
+            if args.slow and args.mirrors > 0 and i == args.mirrors:
+                rate = max(1, rate // 10)
+            servers.append(ota_http_server.start_server(directory, rtt_ms=args.rtt, rate_kbps=rate))
+        ports = [server.server_address[1] for server in servers]
+
+        print("connections,servers,slow_mirror,seconds,bytes_per_sec,speedup,parked,requeued,verify_ok")
+        baseline = None
+        for connections in sorted(set([1] + args.connections)):
+            image, elapsed, parked, requeued = download(ports, args.size, args.chunk * args.window, connections)
+            if baseline is None:
+                baseline = elapsed
+            if connections not in args.connections:
+                continue
+            print("%d,%d,%d,%.3f,%.0f,%.2f,%d,%d,%d" % (connections, min(connections, len(ports)), int(args.slow),
+                                                      elapsed, args.size / elapsed, baseline / elapsed,
+                                                      parked, requeued, int(image == expected)))
+
+        for server in servers:
+            server.shutdown()
+
+
+if __name__ == "__main__":
+    main()
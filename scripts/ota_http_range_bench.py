@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   HTTP range request window benchmark.
+#
+#   Builds host/ota_host for each CY_OTA_HTTP_RANGE_WINDOW and
+#   CY_OTA_WRITER_NUM_BUFFERS, and runs HTTP updates from ota_http_server.py
+#   through ota_net_shaper.py, which delays every segment by half the round
+#   trip time in each direction. With a window above 1 the Agent keeps that
+#   many range requests in flight on one connection (cy_ota_http_pipeline_data()),
+#   so the round trip is paid once per window instead of once per chunk.
+#
+#   With "-m", the single GET streaming download (CY_OTA_HTTP_STREAMING) is
+#   added as window 0.
+#   With "-M <timing>" the FLASH emulator sleeps for the modelled program and
+#   erase times (see ota_host -M), to show CY_OTA_WRITER_NUM_BUFFERS at work.
+#
+#   Usage:
+#       python3 ota_http_range_bench.py [-s <image size>] [-c <chunk size>]
+#                                       [-r <rtt ms list>] [-w <window list>]
+#                                       [-b <buffers list>] [-k <kbytes/s>] [-M <timing>] [-m]
+#
+#   Output is CSV:  rtt_ms,window,buffers,requests,pipelined_bytes,seconds,bytes_per_sec,speedup,verify_ok
+#   seconds is the whole update session, job download included, speedup is
+#   against window 1 for the same rtt and buffers.
+#
+
+import argparse
+import os
+import re
+import sys
+import tempfile
+
+import ota_http_server
+import ota_host_bench
+import ota_net_shaper
+from ota_host_bench import build_host, int_list, write_job
+from ota_image_hash_bench import make_image
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+CHUNK_SIZE = 4096                   # matches CY_OTA_CHUNK_SIZE
+SLOT_SIZE = 0x1C0000                # CY_FLASH_EMU_SLOT_SIZE, the Secondary Slot follows the Primary Slot
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+CONFIG_FILE = "cy_ota_config.h"
+
+
+def write_config(dst_dir, values):
+    """ Copy configs/cy_ota_config.h with the "values" {define: value} set """
+    with open(os.path.join(SCRIPT_DIR, "..", "configs", CONFIG_FILE)) as f:
+        text = f.read()
+    for define, value in values.items():
+        text, count = re.subn(r"^(#define\s+%s\s+).*$" % define, r"\g<1>(%d)" % value, text, flags=re.MULTILINE)
+        if count == 0:
+            text += "\n#define %s (%d)\n" % (define, value)
+    os.makedirs(dst_dir, exist_ok=True)
+    with open(os.path.join(dst_dir, CONFIG_FILE), "w") as f:
+        f.write(text)
+
+
+def build_window(chunk, window, buffers):
+    """ ota_host for one window (0 = single GET streaming) and writer buffer count """
+    tag = "_range_w%d_b%d" % (window, buffers)
+    config_dir = os.path.join(ota_host_bench.HOST_DIR, "build", "range_config" + tag)
+    write_config(config_dir, {"CY_OTA_HTTP_RANGE_WINDOW": max(window, 1),
+                              "CY_OTA_HTTP_RANGE_MIN_SIZE": chunk * max(window, 1),
+                              "CY_OTA_HTTP_STREAMING": 1 if window == 0 else 0,
+                              "CY_OTA_WRITER_NUM_BUFFERS": buffers})
+    return build_host(chunk, config_dir, tag=tag)
+
+
+def run_one(host, server, directory, image, rtt, args):
+    """ One update through a shaper with "rtt", returns (ota_host_bench record, slot holds the image) """
+    shaper = ota_net_shaper.start_shaper(server.server_address[1],
+                                         ota_net_shaper.ShaperProfile(rtt_ms=rtt, rate_kbps=args.rate))
+    write_job(directory, shaper.port)
+    bench_args = argparse.Namespace(flow="job", external=False, timing=args.timing, scale=args.scale,
+                                    rtt=rtt, rate=args.rate, timeout=args.timeout)
+    record = ota_host_bench.run_one(host, server, directory, args.size, args.chunk, bench_args, shaper.port)
+    shaper.shutdown()
+    with open(os.path.join(directory, "flash.bin"), "rb") as f:
+        f.seek(SLOT_SIZE)
+        slot = f.read(len(image))
+    return record, slot == image
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP range request window benchmark of the host built OTA Agent")
+    parser.add_argument("-s", "--size", type=int, default=1024 * 1024, help="test image size in bytes")
+    parser.add_argument("-c", "--chunk", type=int, default=CHUNK_SIZE, help="CY_OTA_CHUNK_SIZE")
+    parser.add_argument("-r", "--rtt", type=int_list, default=[0, 20, 50, 100], help="comma separated RTT list (ms)")
+    parser.add_argument("-w", "--window", type=int_list, default=[1, 2, 4, 8], help="comma separated CY_OTA_HTTP_RANGE_WINDOW list")
+    parser.add_argument("-b", "--buffers", type=int_list, default=[0], help="comma separated CY_OTA_WRITER_NUM_BUFFERS list")
+    parser.add_argument("-k", "--rate", type=int, default=0, help="bandwidth limit in kbytes/s")
+    parser.add_argument("-M", "--timing", default=None, help="FLASH timing model (see ota_host -M)")
+    parser.add_argument("-R", "--scale", type=float, default=1.0, help="sleep for the modelled FLASH time * scale")
+    parser.add_argument("-m", "--stream", action="store_true", help="add single GET streaming (reported as window 0)")
+    parser.add_argument("-t", "--timeout", type=int, default=300, help="timeout of one run in seconds")
+    args = parser.parse_args()
+
+    image, _ = make_image(args.size, seed=args.size)         # ota_host_bench.run_one() serves the same image
+    windows = sorted(set([1] + args.window)) + ([0] if args.stream else [])
+    failed = 0
+
+    print("rtt_ms,window,buffers,requests,pipelined_bytes,seconds,bytes_per_sec,speedup,verify_ok")
+    with tempfile.TemporaryDirectory() as directory:
+        server = ota_http_server.start_server(directory, 0)
+        try:
+            hosts = {(window, buffers): build_window(args.chunk, window, buffers)
+                     for window in windows for buffers in args.buffers}
+            for rtt in args.rtt:
+                for buffers in args.buffers:
+                    baseline = None
+                    for window in windows:
+                        record, verify_ok = run_one(hosts[(window, buffers)], server, directory, image, rtt, args)
+                        ok = (record["result"] == "success") and verify_ok
+                        failed += 0 if ok else 1
+                        if record["result"] != "success":
+                            print("%d,%d,%d,,,,,,%s" % (rtt, window, buffers, record["result"]))
+                            continue
+                        seconds = record["seconds"]
+                        if window == 1:
+                            baseline = seconds
+                        if window not in args.window and not (window == 0 and args.stream):
+                            continue
+                        ranges = record["range_stats"]
+                        print("%d,%d,%d,%d,%d,%.3f,%.0f,%s,%d" % (
+                            rtt, window, buffers, ranges["requests"], ranges["pipelined_bytes"], seconds,
+                            (len(image) / seconds) if seconds > 0 else 0,
+                            ("%.2f" % (baseline / seconds)) if baseline and seconds > 0 else "",
+                            int(ok)))
+                        sys.stdout.flush()
+        finally:
+            server.shutdown()
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
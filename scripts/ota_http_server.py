@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   This is a local HTTP server stand-in for AnyCloud OTA testing.
+#
+#   It serves the Job document (CY_OTA_HTTP_JOB_FILE, "/ota_update.json") and
+#   the OTA Image (CY_OTA_HTTP_DATA_FILE, "/anycloud-ota.bin") out of one
+#   directory, the same way the Device expects:
+#
+#   - HTTP/1.1 keep-alive, so one connection is used for the whole download.
+#   - "Range: bytes=<start>-<end>" requests are answered with 206 and a
+#     "Content-Range: bytes <start>-<end>/<total>" header.
+#   - Responses carry "ETag" and "Last-Modified". A GET with a matching
+#     "If-None-Match" (or "If-Modified-Since" no older than the file) is
+#     answered with 304 and no body (CY_OTA_HTTP_JOB_CACHE).
+#   - POST of the result JSON is answered with 200.
+#
+#   The round trip time of the link can be simulated with "-r <ms>", each
+#   response is held back by that many milliseconds. The bandwidth of each
+#   connection can be limited with "-k <kbytes per sec>".
+#
+#   Usage:
+#       python3 ota_http_server.py [-d <directory>] [-p <port>] [-r <rtt ms>] [-k <kbytes/s>] [-l]
+#
+#   The server is also used as a module by the benchmark scripts.
+#
+
+import argparse
+import email.utils
+import os
+import re
+import threading
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+DEFAULT_PORT = 8080
+DEFAULT_DIR = "."
+
+RANGE_RE = re.compile(r"bytes\s*=\s*(\d*)\s*-\s*(\d*)")
+
+
+class OTAServerStats:
+    """Counters kept across all connections of one server instance."""
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        self.requests = 0
+        self.range_requests = 0
+        self.bytes_sent = 0
+        self.connections = 0
+        self.not_modified = 0
+
+    def add(self, name, value=1):
+        with self.lock:
+            setattr(self, name, getattr(self, name) + value)
+
+
+class OTARequestHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"       # keep-alive
+    disable_nagle_algorithm = True      # do not let small responses sit in the send queue
+
+    def log_message(self, fmt, *args):
+        if self.server.debug_log:
+            BaseHTTPRequestHandler.log_message(self, fmt, *args)
+
+    def setup(self):
+        BaseHTTPRequestHandler.setup(self)
+        self.server.stats.add("connections")
+
+    def simulate_rtt(self):
+        if self.server.rtt_ms > 0:
+            time.sleep(self.server.rtt_ms / 1000.0)
+
+    def send_body(self, status, body, headers):
+        self.send_response(status)
+        for name, value in headers:
+            self.send_header(name, value)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        if self.command != "HEAD":
+            if self.server.rate_kbps > 0:
+                time.sleep(len(body) / (self.server.rate_kbps * 1024.0))
+            self.wfile.write(body)
+        self.server.stats.add("bytes_sent", len(body))
+
+    def do_GET(self):
+        self.server.stats.add("requests")
+        self.simulate_rtt()
+
+        path = os.path.join(self.server.directory, os.path.basename(self.path.split("?")[0]))
+        if not os.path.isfile(path):
+            self.send_body(404, b"", [])
+            return
+
+        with open(path, "rb") as f:
+            data = f.read()
+        total = len(data)
+        content_type = "application/json" if path.endswith(".json") else "application/octet-stream"
+
+        mtime = int(os.path.getmtime(path))
+        etag = '"%08x-%x"' % (zlib.crc32(data), total)
+        last_modified = email.utils.formatdate(mtime, usegmt=True)
+        if self.not_modified(etag, mtime):
+            self.server.stats.add("not_modified")
+            self.send_body(304, b"", [("ETag", etag), ("Last-Modified", last_modified)])
+            return
+
+        range_header = self.headers.get("Range")
+        match = RANGE_RE.search(range_header) if range_header else None
+        if match is None:
+            self.send_body(200, data, [("Content-Type", content_type), ("Accept-Ranges", "bytes"),
+                                       ("ETag", etag), ("Last-Modified", last_modified)])
+            return
+
+        self.server.stats.add("range_requests")
+        start = int(match.group(1)) if match.group(1) else 0
+        end = int(match.group(2)) if match.group(2) else total - 1
+        if end >= total:
+            end = total - 1
+        if start >= total or start > end:
+            self.send_body(416, b"", [("Content-Range", "bytes */%d" % total)])
+            return
+
+        self.send_body(206, data[start:end + 1],
+                       [("Content-Type", content_type),
+                        ("Accept-Ranges", "bytes"),
+                        ("Content-Range", "bytes %d-%d/%d" % (start, end, total))])
+
+    do_HEAD = do_GET
+
+    def not_modified(self, etag, mtime):
+        """ If-None-Match wins over If-Modified-Since (RFC 7232) """
+        if_none_match = self.headers.get("If-None-Match")
+        if if_none_match is not None:
+            return etag in [tag.strip() for tag in if_none_match.split(",")] or if_none_match.strip() == "*"
+        if_modified_since = self.headers.get("If-Modified-Since")
+        if if_modified_since is not None:
+            try:
+                since = email.utils.parsedate_to_datetime(if_modified_since).timestamp()
+            except (TypeError, ValueError):
+                return False
+            return mtime <= since
+        return False
+
+    def do_POST(self):
+        self.server.stats.add("requests")
+        length = int(self.headers.get("Content-Length", "0"))
+        result = self.rfile.read(length) if length > 0 else b""
+        if self.server.debug_log:
+            print("OTA result: " + result.decode("utf-8", "replace"))
+        self.simulate_rtt()
+        self.send_body(200, b"", [("Content-Type", "application/json")])
+
+
+class OTAHTTPServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address, directory=DEFAULT_DIR, rtt_ms=0, debug_log=False, rate_kbps=0):
+        ThreadingHTTPServer.__init__(self, address, OTARequestHandler)
+        self.directory = directory
+        self.rtt_ms = rtt_ms
+        self.rate_kbps = rate_kbps
+        self.debug_log = debug_log
+        self.stats = OTAServerStats()
+
+
+def start_server(directory=DEFAULT_DIR, port=0, rtt_ms=0, debug_log=False, rate_kbps=0):
+    """Start a server on a background thread, returns the server (use server.server_address for the port)."""
+    server = OTAHTTPServer(("127.0.0.1", port), directory, rtt_ms, debug_log, rate_kbps)
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+    return server
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local HTTP server stand-in for OTA testing")
+    parser.add_argument("-d", "--directory", default=DEFAULT_DIR, help="directory holding the Job document and OTA Image")
+    parser.add_argument("-p", "--port", type=int, default=DEFAULT_PORT, help="port to listen on")
+    parser.add_argument("-r", "--rtt", type=int, default=0, help="simulated round trip time in milliseconds")
+    parser.add_argument("-k", "--rate", type=int, default=0, help="bandwidth limit per connection in kbytes/s, 0 = no limit")
+    parser.add_argument("-l", "--log", action="store_true", help="turn on logging")
+    args = parser.parse_args()
+
+    server = OTAHTTPServer(("", args.port), args.directory, args.rtt, args.log, args.rate)
+    print("OTA HTTP server on port " + str(args.port) + " serving " + os.path.abspath(args.directory))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    server.server_close()
+
+
+if __name__ == "__main__":
+    main()
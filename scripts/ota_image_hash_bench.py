@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   Image hash benchmark, read back against CY_OTA_IMAGE_HASH.
+#
+#   Builds an MCUboot image (header, image, SHA256 TLV) and feeds it to a model
+#   of cy_ota_storage_image_hash() in the pieces each transport hands over:
+#   data that continues the hashed data is hashed as it is written, the rest is
+#   read back by cy_ota_image_hash_check() before the TLV area is compared.
+#   The digest is checked against hashlib over the whole image.
+#
+#   Verify time is estimated from the bytes read back and hashed at verify:
+#       readback - the whole image is read from the Secondary Slot and hashed
+#       stream   - CY_OTA_IMAGE_HASH, only the bytes not hashed while writing
+#
+#   Patterns:
+#       http_range  - CY_OTA_CHUNK_SIZE pieces in order
+#       http_par2   - two halves of the image interleaved (second half read back)
+#       resume      - download resumed from the journal at half the image
+#       ble         - GATT writes of 244 bytes
+#
+#   Usage:
+#       python3 ota_image_hash_bench.py [-s <image size>] [-r <FLASH read bytes/s>] [-H <SHA-256 bytes/s>]
+#                                       [-p <pattern list>] [--seed <n>]
+#
+#   Output is CSV:  pattern,mode,hashed_at_verify,verify_ms,digest_ok
+#
+
+import argparse
+import hashlib
+import random
+import struct
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+CHUNK_SIZE = 4096                   # matches CY_OTA_CHUNK_SIZE
+BLE_WRITE_SIZE = 244
+HEADER_SIZE = 32                    # CY_OTA_IMAGE_HEADER_SIZE
+IMAGE_MAGIC = 0x96f3b83d
+TLV_INFO_MAGIC = 0x6907
+TLV_SHA256 = 0x10
+
+
+def make_image(size, seed):
+    rng = random.Random(seed)
+    hdr_size = 0x400
+    body = bytes(rng.getrandbits(8) for _ in range(size))
+    header = struct.pack("<IIHHII", IMAGE_MAGIC, 0, hdr_size, 0, size, 0) + bytes(8)
+    signed = header + bytes(hdr_size - len(header)) + body
+    digest = hashlib.sha256(signed).digest()
+    tlv = struct.pack("<HH", TLV_INFO_MAGIC, 4 + 4 + len(digest)) + struct.pack("<HH", TLV_SHA256, len(digest)) + digest
+    return signed + tlv, digest
+
+
+class ImageHash:
+    """ cy_ota_image_hash_context_t with cy_ota_image_hash_add() """
+
+    def __init__(self):
+        self.sha = hashlib.sha256()
+        self.hashed = 0
+        self.hash_end = None
+        self.header = b""
+
+    def add(self, data):
+        pos = 0
+        while pos < len(data) and (self.hash_end is None or self.hashed < self.hash_end):
+            if self.hashed < HEADER_SIZE:
+                part = min(len(data) - pos, HEADER_SIZE - self.hashed)
+                self.header += data[pos:pos + part]
+            else:
+                part = min(len(data) - pos, self.hash_end - self.hashed)
+            self.sha.update(data[pos:pos + part])
+            self.hashed += part
+            pos += part
+            if self.hashed == HEADER_SIZE and self.hash_end is None:
+                _, _, hdr_size, ptlv, img_size = struct.unpack("<IIHHI", self.header[:16])
+                self.hash_end = hdr_size + img_size + ptlv
+
+    def write(self, offset, data):
+        """ cy_ota_storage_image_hash() """
+        if offset > self.hashed or offset + len(data) <= self.hashed:
+            return
+        self.add(data[self.hashed - offset:])
+
+
+def pieces(pattern, size):
+    def split(start, end, piece):
+        return [(o, min(piece, end - o)) for o in range(start, end, piece)]
+
+    if pattern == "http_range":
+        return split(0, size, CHUNK_SIZE)
+    if pattern == "ble":
+        return split(0, size, BLE_WRITE_SIZE)
+    half = ((size // 2) // CHUNK_SIZE) * CHUNK_SIZE
+    if pattern == "resume":
+        return split(half, size, CHUNK_SIZE)
+    if pattern == "http_par2":
+        parts = [split(0, half, CHUNK_SIZE), split(half, size, CHUNK_SIZE)]
+        order = []
+        for i in range(max(len(p) for p in parts)):
+            order.extend(p[i] for p in parts if i < len(p))
+        return order
+    raise ValueError("unknown pattern " + pattern)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare image hash read back with CY_OTA_IMAGE_HASH")
+    parser.add_argument("-s", "--size", type=int, default=1536 * 1024, help="image size (default 1.5 MB)")
+    parser.add_argument("-r", "--read", type=float, default=4.0e6, help="Secondary Slot read bytes/s (default 4e6, SMIF single SPI)")
+    parser.add_argument("-H", "--hash", type=float, default=3.0e6, help="mbedtls SHA-256 bytes/s (default 3e6, CM4 150 MHz)")
+    parser.add_argument("-p", "--patterns", default="http_range,http_par2,resume,ble", help="patterns to run")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the image")
+    args = parser.parse_args()
+
+    image, digest = make_image(args.size, args.seed)
+    per_byte_ms = 1000.0 / args.read + 1000.0 / args.hash
+
+    print("pattern,mode,hashed_at_verify,verify_ms,digest_ok")
+    for pattern in args.patterns.split(","):
+        ih = ImageHash()
+        for offset, length in pieces(pattern, len(image)):
+            ih.write(offset, image[offset:offset + length])
+        # cy_ota_image_hash_check(): read back what was not hashed while writing
+        readback = 0
+        while ih.hash_end is None or ih.hashed < ih.hash_end:
+            size = min(128, (ih.hash_end or len(image)) - ih.hashed)
+            readback += size
+            ih.add(image[ih.hashed:ih.hashed + size])
+        ok = ih.sha.digest() == digest
+        print("%s,readback,%d,%.0f,1" % (pattern, ih.hash_end, ih.hash_end * per_byte_ms))
+        print("%s,stream,%d,%.0f,%d" % (pattern, readback, readback * per_byte_ms, int(ok)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   HTTP Job document polling benchmark.
+#
+#   A fleet of Devices polls ota_http_server.py for the Job document
+#   (CY_OTA_HTTP_JOB_FILE) the same way cy_ota_http_get_job() does, once per
+#   CY_OTA_NEXT_CHECK_INTERVAL_SECS:
+#       CY_OTA_HTTP_JOB_CACHE 0 - GET and parse the Job document, and send the
+#                                 result, every poll
+#       CY_OTA_HTTP_JOB_CACHE 1 - after a Job document that did not lead to an
+#                                 update, send If-None-Match / If-Modified-Since;
+#                                 on 304 (or the same Job document) end the session
+#
+#   The Job document is replaced every "-j" polls, with a version that is not
+#   newer than the Devices' version, so no poll leads to an update.
+#
+#   Usage:
+#       python3 ota_job_poll_bench.py [-d <devices>] [-p <polls>] [-j <polls between Job changes>]
+#
+#   Output is CSV:  job_cache,devices,polls,bytes_received,bytes_per_poll,parses,results_sent,not_modified
+#   bytes_received counts status line, headers and body of the Job and result responses.
+#
+
+import argparse
+import http.client
+import json
+import os
+import tempfile
+import time
+
+import ota_http_server
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+JOB_NAME = "ota_update.json"        # matches CY_OTA_HTTP_JOB_FILE
+RESULT_NAME = "ota_update.json"     # result is POSTed to the Job document
+DEVICE_VERSION = (1, 6, 0)          # APP_VERSION_MAJOR / MINOR / BUILD
+
+
+def write_job(directory, serial, mtime):
+    job = {
+        "Message": "Update Available",
+        "Manufacturer": "Express Widgits Corporation",
+        "ManufacturerId": "EWCO",
+        "Product": "Easy Widgit",
+        "SerialNumber": "ABC2134500%02d" % serial,
+        "Board": "CY8CPROTO_062_4343W",
+        "Version": "%d.%d.%d" % DEVICE_VERSION,
+        "Connection": "HTTP",
+        "Server": "127.0.0.1",
+        "Port": "80",
+        "File": "/anycloud-ota.bin",
+    }
+    path = os.path.join(directory, JOB_NAME)
+    with open(path, "w") as f:
+        json.dump(job, f, indent=2)
+    os.utime(path, (mtime, mtime))
+
+
+def response_size(response, body):
+    return len("HTTP/1.1 %d %s\r\n" % (response.status, response.reason)) + len(str(response.msg)) + 2 + len(body)
+
+
+class Device:
+    """ cy_ota_http_job_cache_t and the Job flow of one Device """
+    def __init__(self, job_cache):
+        self.job_cache = job_cache
+        self.valid = False
+        self.etag = None
+        self.last_modified = None
+        self.job = None
+        self.bytes = 0
+        self.parses = 0
+        self.results = 0
+        self.not_modified = 0
+
+    def poll(self, port):
+        conn = http.client.HTTPConnection("127.0.0.1", port)
+        headers = {}
+        if self.job_cache and self.valid:
+            if self.etag:
+                headers["If-None-Match"] = self.etag
+            if self.last_modified:
+                headers["If-Modified-Since"] = self.last_modified
+        conn.request("GET", "/" + JOB_NAME, headers=headers)
+        response = conn.getresponse()
+        body = response.read()
+        self.bytes += response_size(response, body)
+
+        if self.job_cache and self.valid and (response.status == 304 or body == self.job):
+            self.not_modified += 1
+            conn.close()
+            return
+
+        self.valid = False
+        self.job = body
+        self.etag = response.getheader("ETag")
+        self.last_modified = response.getheader("Last-Modified")
+
+        # cy_ota_parse_job_info(): version not newer -> CY_RSLT_OTA_ERROR_INVALID_VERSION
+        self.parses += 1
+        job = json.loads(body)
+        version = tuple(int(v) for v in job["Version"].split("."))
+        if version <= DEVICE_VERSION:
+            self.valid = True       # cy_ota_http_job_parsed()
+
+        # the failed parse is reported to the Server
+        conn.request("POST", "/" + RESULT_NAME, body=b'{"Message":"Failure"}',
+                     headers={"Content-Type": "application/json"})
+        response = conn.getresponse()
+        self.bytes += response_size(response, response.read())
+        self.results += 1
+        conn.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP Job document polling benchmark")
+    parser.add_argument("-d", "--devices", type=int, default=20, help="number of Devices")
+    parser.add_argument("-p", "--polls", type=int, default=30, help="polls per Device")
+    parser.add_argument("-j", "--job-change", type=int, default=10, help="polls between Job document changes")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        server = ota_http_server.start_server(directory)
+        port = server.server_address[1]
+
+        print("job_cache,devices,polls,bytes_received,bytes_per_poll,parses,results_sent,not_modified")
+        for job_cache in (False, True):
+            devices = [Device(job_cache) for _ in range(args.devices)]
+            mtime = int(time.time()) - 100000
+            for poll in range(args.polls):
+                if poll % args.job_change == 0:
+                    mtime += 3600
+                    write_job(directory, poll // args.job_change, mtime)
+                for device in devices:
+                    device.poll(port)
+            total_polls = args.devices * args.polls
+            total_bytes = sum(d.bytes for d in devices)
+            print("%d,%d,%d,%d,%.0f,%d,%d,%d" % (int(job_cache), args.devices, total_polls, total_bytes,
+                                                 total_bytes / total_polls, sum(d.parses for d in devices),
+                                                 sum(d.results for d in devices),
+                                                 sum(d.not_modified for d in devices)))
+
+        server.shutdown()
+
+
+if __name__ == "__main__":
+    main()
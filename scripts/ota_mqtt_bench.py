@@ -0,0 +1,284 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   End to end MQTT OTA benchmark.
+#
+#   Runs the OTA Agent built for the host (host/ota_host -m) against an
+#   in-process ota_mqtt_broker.py and a publisher stand-in. The publisher
+#   answers the Device messages the same way publisher.py does:
+#
+#       "Update Availability"   the Job document (mqtt_update.json) on the
+#                               UniqueTopicName
+#       "Request Update"        the whole OTA Image in chunks, each with the
+#                               cy_ota_mqtt_chunk_payload_header_t header
+#                               (this_payload_index, total_num_payloads, ...)
+#       "Request Data Chunk"    the one chunk at "Offset"
+#
+#   Two request modes, each its own ota_host build:
+#       one     one "Request Update" for all chunks (CY_MQTT_GET_ALL_DATA_WITH_ONE_CALL,
+#               the default)
+#       each    one "Request Data Chunk" per chunk (CY_OTA_MQTT_REQUEST_EACH_CHUNK)
+#
+#   Faults the publisher can inject:
+#       --dup <fraction>        send this fraction of the chunks twice
+#       --reorder <window>      shuffle the chunks within windows of this many
+#                               ("one" mode, "each" mode has one chunk in flight)
+#
+#   For each run the Device CPU time (user + system of ota_host) is divided
+#   by the number of chunks the Device received, duplicates included. The
+#   CPU time includes the process start and the Slot erase, so compare runs
+#   of the same image size.
+#
+#   Usage:
+#       python3 ota_mqtt_bench.py [-s <image sizes>] [-c <chunk sizes>] [-m one,each]
+#                                 [--dup <fraction>] [--reorder <window>] [--seed <n>]
+#                                 [--csv] [-o <file>]
+#
+#   Output is one JSON object per run (JSON lines), or CSV with "--csv":
+#       size,chunk,mode,dup,reorder,result,seconds,chunks_sent,duplicates,out_of_order,
+#       requests,cpu_ms,cpu_us_per_chunk,us_per_chunk,heap_peak
+#
+
+import argparse
+import json
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+import ota_mqtt_broker
+from ota_host_bench import build_host, int_list
+from ota_image_hash_bench import make_image
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+SCHEMA = 1                              # bump when the record layout changes
+BOARD = "CY8CPROTO_062_4343W"           # host Makefile BOARD
+COMPANY_TOPIC_PREPEND = "anycloud"      # matches COMPANY_TOPIC_PREPEND
+PUBLISHER_LISTEN_TOPIC = "publish_notify"
+REQUEST_TOPIC = COMPANY_TOPIC_PREPEND + "/" + BOARD + "/" + PUBLISHER_LISTEN_TOPIC
+
+UPDATE_AVAILABLE_REQUEST = "Update Availability"
+SEND_UPDATE_REQUEST = "Request Update"
+SEND_CHUNK = "Request Data Chunk"
+AVAILABLE_REPONSE = "Update Available"
+
+# cy_ota_mqtt_chunk_payload_header_t in source/cy_ota_mqtt.c, as in publisher.py
+HEADER_FORMAT = "<8s5H2I3H"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+HEADER_MAGIC = b"OTAImage"
+IMAGE_TYPE = 0
+
+MODE_DEFINES = {"one": (), "each": ("CY_OTA_MQTT_REQUEST_EACH_CHUNK",)}
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+class Publisher:
+    """publisher.py stand-in, talks to the broker from this process"""
+
+    def __init__(self, broker, image, chunk, dup, reorder, seed, port=None):
+        self.broker = broker
+        self.image = image
+        self.chunk = chunk
+        self.dup = dup
+        self.reorder = reorder
+        self.rng = random.Random(seed)
+        self.total_payloads = (len(image) + chunk - 1) // chunk
+        self.lock = threading.Lock()
+        self.chunks_sent = 0
+        self.duplicates = 0
+        self.out_of_order = 0
+        self.highest_index = -1
+        self.requests = {}
+
+        with open(os.path.join(SCRIPT_DIR, "mqtt_update.json")) as f:
+            self.job = json.load(f)
+        self.job["Broker"] = "127.0.0.1"
+        self.job["Port"] = str(port or broker.server_address[1])
+        self.version = [int(x) for x in self.job["Version"].split(".")]
+        broker.subscribe(REQUEST_TOPIC, self.on_request)
+
+    def payload(self, index, offset, size):
+        header = struct.pack(HEADER_FORMAT, HEADER_MAGIC, HEADER_SIZE, IMAGE_TYPE,
+                             self.version[0], self.version[1], self.version[2],
+                             len(self.image), offset, size, self.total_payloads, index)
+        return header + self.image[offset:offset + size]
+
+    def send(self, topic, index, offset, size):
+        with self.lock:
+            self.chunks_sent += 1
+            if index < self.highest_index:
+                self.out_of_order += 1
+            self.highest_index = max(self.highest_index, index)
+        self.broker.publish(topic, self.payload(index, offset, size), 1)
+
+    def send_all(self, topic):
+        """ "Request Update": all chunks, with duplicates and reordering """
+        order = []
+        for index in range(self.total_payloads):
+            order.append(index)
+            if self.rng.random() < self.dup:
+                order.insert(len(order) - self.rng.randint(0, min(4, len(order) - 1)), index)
+                self.duplicates += 1
+        if self.reorder > 1:
+            for start in range(0, len(order), self.reorder):
+                window = order[start:start + self.reorder]
+                self.rng.shuffle(window)
+                order[start:start + self.reorder] = window
+        for index in order:
+            offset = index * self.chunk
+            self.send(topic, index, offset, min(self.chunk, len(self.image) - offset))
+
+    def send_chunk(self, topic, request):
+        """ "Request Data Chunk": one chunk, sent twice for a duplicate """
+        offset = int(request.get("Offset", "0"))
+        size = int(request.get("Size", "-1"))
+        if size <= 0 or size > self.chunk:
+            size = self.chunk                   # "-1" (or a 64 bit "%ld" of it) is the rest of the image
+        size = min(size, len(self.image) - offset)
+        if size <= 0:
+            return
+        index = offset // self.chunk
+        self.send(topic, index, offset, size)
+        if self.rng.random() < self.dup:
+            self.duplicates += 1
+            self.send(topic, index, offset, size)
+
+    def on_request(self, topic, payload):
+        request = json.loads(payload.decode("utf-8", "replace"))
+        message = request.get("Message", "")
+        unique_topic = request.get("UniqueTopicName", "")
+        with self.lock:
+            self.requests[message] = self.requests.get(message, 0) + 1
+        if message == UPDATE_AVAILABLE_REQUEST:
+            job = dict(self.job)
+            job["Message"] = AVAILABLE_REPONSE
+            job["UniqueTopicName"] = unique_topic
+            self.broker.publish(unique_topic, json.dumps(job), 1)
+        elif message == SEND_UPDATE_REQUEST:
+            threading.Thread(target=self.send_all, args=(unique_topic,), daemon=True).start()
+        elif message == SEND_CHUNK:
+            threading.Thread(target=self.send_chunk, args=(unique_topic, request), daemon=True).start()
+
+
+def run_one(host, broker, directory, size, chunk, mode, args, port=None):
+    """ One update session, returns the result record. "port" is where ota_host connects, default the broker """
+    image, _ = make_image(size, seed=size)
+    publisher = Publisher(broker, image, chunk, args.dup, args.reorder if mode == "one" else 0, args.seed, port)
+    result_file = os.path.join(directory, "result.json")
+    if os.path.exists(result_file):
+        os.remove(result_file)
+
+    cmd = [host, "-m", "-p", str(port or broker.server_address[1]), "-F", os.path.join(directory, "flash.bin"), "-E",
+           "-j", result_file, "-t", str(args.timeout)]
+    start = time.monotonic()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    output = proc.stdout.read()
+    _, status, usage = os.wait4(proc.pid, 0)
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    seconds = time.monotonic() - start
+    broker.local = []                           # drop this run's publisher
+
+    cpu_ms = (usage.ru_utime + usage.ru_stime) * 1000.0
+    record = {"schema": SCHEMA, "size": len(image), "chunk": chunk, "mode": mode, "dup": args.dup,
+              "reorder": args.reorder if mode == "one" else 0, "exit": proc.returncode,
+              "chunks_sent": publisher.chunks_sent, "duplicates": publisher.duplicates,
+              "out_of_order": publisher.out_of_order, "requests": sum(publisher.requests.values()),
+              "cpu_ms": round(cpu_ms, 1),
+              "cpu_us_per_chunk": round(cpu_ms * 1000.0 / publisher.chunks_sent, 1) if publisher.chunks_sent else 0}
+    if not os.path.exists(result_file):
+        record["result"] = "no result"
+        sys.stderr.write(output.decode("utf-8", "replace"))
+        return record
+
+    with open(result_file) as f:
+        host_result = json.load(f)
+    seconds = host_result["elapsed_ms"] / 1000.0
+    record.update({
+        "result": host_result["result"],
+        "seconds": seconds,
+        "failures": host_result["failures"],
+        "us_per_chunk": round(seconds * 1e6 / publisher.chunks_sent, 1) if publisher.chunks_sent else 0,
+        "bytes": host_result["bytes"],
+        "flash": host_result["flash"],
+        "heap_peak": host_result["heap_peak"],
+        "states": host_result["states"],
+        "agent_stats": host_result["agent_stats"],
+    })
+    return record
+
+
+def csv_line(record):
+    fields = [record["size"], record["chunk"], record["mode"], record["dup"], record["reorder"], record["result"],
+              record.get("seconds", ""), record["chunks_sent"], record["duplicates"], record["out_of_order"],
+              record["requests"], record["cpu_ms"], record["cpu_us_per_chunk"], record.get("us_per_chunk", ""),
+              record.get("heap_peak", "")]
+    return ",".join(str(x) for x in fields)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="End to end MQTT OTA benchmark of the host built OTA Agent")
+    parser.add_argument("-s", "--sizes", type=int_list, default=[64 * 1024, 256 * 1024],
+                        help="comma separated image sizes (default 64K,256K)")
+    parser.add_argument("-c", "--chunks", type=int_list, default=[1024, 4096],
+                        help="comma separated chunk sizes, CY_OTA_CHUNK_SIZE and the publisher chunk (default 1024,4096)")
+    parser.add_argument("-m", "--modes", default="one,each", help="request modes: one, each (default both)")
+    parser.add_argument("--dup", type=float, default=0.0, help="fraction of chunks sent twice")
+    parser.add_argument("--reorder", type=int, default=0, help="shuffle chunks within windows of this many")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the injected faults")
+    parser.add_argument("-t", "--timeout", type=int, default=120, help="timeout of one run in seconds")
+    parser.add_argument("--config", default=None, help="directory with the cy_ota_config.h to build with")
+    parser.add_argument("--csv", action="store_true", help="CSV instead of JSON lines")
+    parser.add_argument("-o", "--output", default=None, help="output file (default stdout)")
+    args = parser.parse_args()
+    modes = [m for m in args.modes.split(",") if m != ""]
+    for mode in modes:
+        if mode not in MODE_DEFINES:
+            parser.error("unknown mode " + mode)
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    if args.csv:
+        out.write("size,chunk,mode,dup,reorder,result,seconds,chunks_sent,duplicates,out_of_order,"
+                  "requests,cpu_ms,cpu_us_per_chunk,us_per_chunk,heap_peak\n")
+
+    failed = 0
+    with tempfile.TemporaryDirectory() as directory:
+        broker = ota_mqtt_broker.start_broker(0)
+        for mode in modes:
+            for chunk in args.chunks:
+                host = build_host(chunk, args.config, MODE_DEFINES[mode], "_" + mode)
+                for size in args.sizes:
+                    record = run_one(host, broker, directory, size, chunk, mode, args)
+                    failed += 0 if record["result"] == "success" else 1
+                    out.write((csv_line(record) if args.csv else json.dumps(record)) + "\n")
+                    out.flush()
+        broker.shutdown()
+
+    if out is not sys.stdout:
+        out.close()
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
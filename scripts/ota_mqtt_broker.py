@@ -0,0 +1,323 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   This is a local MQTT Broker stand-in for AnyCloud OTA testing.
+#
+#   It is the part of MQTT 3.1.1 the Device and publisher.py use:
+#
+#   - CONNECT / CONNACK, PINGREQ / PINGRESP, DISCONNECT
+#   - SUBSCRIBE / SUBACK and UNSUBSCRIBE / UNSUBACK, topic filters with
+#     "+" and "#"
+#   - PUBLISH at QoS 0 and 1, answered with PUBACK. Messages are sent on to
+#     each subscriber at the lower of the two QoS values, PUBACKs from the
+#     subscribers are not waited for.
+#
+#   No TLS, no authentication, no retained messages and no persistent
+#   sessions.
+#
+#   Code in the same process can subscribe and publish without a socket
+#   (broker.subscribe() / broker.publish()), the benchmark scripts use this
+#   for their publisher stand-in.
+#
+#   Usage:
+#       python3 ota_mqtt_broker.py [-p <port>] [-l]
+#
+#   The broker is also used as a module by the benchmark scripts.
+#
+
+import argparse
+import socket
+import socketserver
+import struct
+import threading
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+DEFAULT_PORT = 1883
+
+CONNECT = 1
+CONNACK = 2
+PUBLISH = 3
+PUBACK = 4
+SUBSCRIBE = 8
+SUBACK = 9
+UNSUBSCRIBE = 10
+UNSUBACK = 11
+PINGREQ = 12
+PINGRESP = 13
+DISCONNECT = 14
+
+
+class OTABrokerStats:
+    """Counters kept across all clients of one broker instance."""
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        self.connections = 0
+        self.publish_in = 0
+        self.publish_out = 0
+        self.bytes_out = 0
+
+    def add(self, name, value=1):
+        with self.lock:
+            setattr(self, name, getattr(self, name) + value)
+
+
+def topic_matches(topic_filter, topic):
+    """ MQTT 3.1.1 section 4.7 """
+    filter_levels = topic_filter.split("/")
+    topic_levels = topic.split("/")
+    for i, level in enumerate(filter_levels):
+        if level == "#":
+            return True
+        if i >= len(topic_levels):
+            return False
+        if level != "+" and level != topic_levels[i]:
+            return False
+    return len(filter_levels) == len(topic_levels)
+
+
+def encode_length(length):
+    out = bytearray()
+    while True:
+        byte = length % 128
+        length //= 128
+        out.append(byte | 0x80 if length > 0 else byte)
+        if length == 0:
+            return bytes(out)
+
+
+def encode_string(text):
+    data = text.encode("utf-8")
+    return struct.pack(">H", len(data)) + data
+
+
+def packet(packet_type, flags, body):
+    return bytes([(packet_type << 4) | flags]) + encode_length(len(body)) + body
+
+
+class LocalSubscriber:
+    """A subscriber in the broker process, callback(topic, payload) runs on the publishing thread."""
+    def __init__(self, topic_filter, callback):
+        self.topic_filter = topic_filter
+        self.callback = callback
+
+
+class OTAClientHandler(socketserver.BaseRequestHandler):
+    """One connected MQTT client."""
+
+    def setup(self):
+        self.request.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.send_lock = threading.Lock()
+        self.subscriptions = {}             # topic filter : granted QoS
+        self.next_packet_id = 1
+        self.client_id = ""
+        self.server.stats.add("connections")
+
+    def log(self, text):
+        if self.server.debug_log:
+            print("broker %s: %s" % (self.client_id or self.client_address[1], text))
+
+    def send(self, data):
+        """ All bytes to the client go through here """
+        with self.send_lock:
+            self.request.sendall(data)
+        self.server.stats.add("bytes_out", len(data))
+
+    def recv_exact(self, length):
+        data = bytearray()
+        while len(data) < length:
+            part = self.request.recv(length - len(data))
+            if not part:
+                raise ConnectionError("closed")
+            data += part
+        return bytes(data)
+
+    def read_packet(self):
+        first = self.recv_exact(1)[0]
+        length = 0
+        shift = 0
+        while True:
+            byte = self.recv_exact(1)[0]
+            length |= (byte & 0x7F) << shift
+            shift += 7
+            if (byte & 0x80) == 0:
+                break
+        return first >> 4, first & 0x0F, self.recv_exact(length) if length > 0 else b""
+
+    def deliver(self, topic, payload, qos):
+        """ Send a PUBLISH for a matching subscription """
+        body = encode_string(topic)
+        if qos > 0:
+            with self.send_lock:
+                packet_id = self.next_packet_id
+                self.next_packet_id = (self.next_packet_id % 0xFFFF) + 1
+            body += struct.pack(">H", packet_id)
+        self.send(packet(PUBLISH, qos << 1, body + payload))
+        self.server.stats.add("publish_out")
+
+    def handle(self):
+        self.server.add_client(self)
+        try:
+            while True:
+                packet_type, flags, body = self.read_packet()
+                if packet_type == CONNECT:
+                    self.on_connect(body)
+                elif packet_type == PUBLISH:
+                    self.on_publish(flags, body)
+                elif packet_type == SUBSCRIBE:
+                    self.on_subscribe(body)
+                elif packet_type == UNSUBSCRIBE:
+                    self.on_unsubscribe(body)
+                elif packet_type == PINGREQ:
+                    self.send(packet(PINGRESP, 0, b""))
+                elif packet_type == DISCONNECT:
+                    break
+                # PUBACK from the client is not tracked
+        except (ConnectionError, OSError):
+            pass
+        finally:
+            self.server.remove_client(self)
+            self.log("disconnected")
+
+    def on_connect(self, body):
+        pos = 2 + struct.unpack(">H", body[0:2])[0] + 1 + 1 + 2     # protocol name, level, flags, keep alive
+        id_len = struct.unpack(">H", body[pos:pos + 2])[0]
+        self.client_id = body[pos + 2:pos + 2 + id_len].decode("utf-8", "replace")
+        self.log("connected")
+        self.send(packet(CONNACK, 0, b"\x00\x00"))
+
+    def on_publish(self, flags, body):
+        qos = (flags >> 1) & 0x03
+        topic_len = struct.unpack(">H", body[0:2])[0]
+        topic = body[2:2 + topic_len].decode("utf-8", "replace")
+        pos = 2 + topic_len
+        if qos > 0:
+            packet_id = body[pos:pos + 2]
+            pos += 2
+            self.send(packet(PUBACK, 0, packet_id))
+        self.server.stats.add("publish_in")
+        self.log("PUBLISH %s %d bytes" % (topic, len(body) - pos))
+        self.server.route(topic, body[pos:], qos)
+
+    def on_subscribe(self, body):
+        packet_id = body[0:2]
+        pos = 2
+        granted = bytearray()
+        while pos < len(body):
+            length = struct.unpack(">H", body[pos:pos + 2])[0]
+            topic_filter = body[pos + 2:pos + 2 + length].decode("utf-8", "replace")
+            qos = min(body[pos + 2 + length] & 0x03, 1)
+            pos += 2 + length + 1
+            self.subscriptions[topic_filter] = qos
+            granted.append(qos)
+            self.log("SUBSCRIBE %s" % topic_filter)
+        self.send(packet(SUBACK, 0, packet_id + bytes(granted)))
+        self.server.subscribed(self)
+
+    def on_unsubscribe(self, body):
+        packet_id = body[0:2]
+        pos = 2
+        while pos < len(body):
+            length = struct.unpack(">H", body[pos:pos + 2])[0]
+            self.subscriptions.pop(body[pos + 2:pos + 2 + length].decode("utf-8", "replace"), None)
+            pos += 2 + length
+        self.send(packet(UNSUBACK, 0, packet_id))
+
+
+class OTABroker(socketserver.ThreadingTCPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+    def __init__(self, address, debug_log=False, handler=OTAClientHandler):
+        socketserver.ThreadingTCPServer.__init__(self, address, handler)
+        self.debug_log = debug_log
+        self.stats = OTABrokerStats()
+        self.lock = threading.Lock()
+        self.clients = []
+        self.local = []
+        self.on_subscribe = None            # called with the client after each SUBSCRIBE
+
+    def add_client(self, client):
+        with self.lock:
+            self.clients.append(client)
+
+    def remove_client(self, client):
+        with self.lock:
+            if client in self.clients:
+                self.clients.remove(client)
+
+    def subscribed(self, client):
+        if self.on_subscribe is not None:
+            self.on_subscribe(client)
+
+    def route(self, topic, payload, qos):
+        with self.lock:
+            clients = list(self.clients)
+            local = list(self.local)
+        for client in clients:
+            granted = [q for f, q in list(client.subscriptions.items()) if topic_matches(f, topic)]
+            if granted:
+                try:
+                    client.deliver(topic, payload, min(qos, max(granted)))
+                except OSError:
+                    pass
+        for subscriber in local:
+            if topic_matches(subscriber.topic_filter, topic):
+                subscriber.callback(topic, payload)
+
+    def subscribe(self, topic_filter, callback):
+        """ Subscribe from this process """
+        with self.lock:
+            self.local.append(LocalSubscriber(topic_filter, callback))
+
+    def publish(self, topic, payload, qos=1):
+        """ Publish from this process """
+        if isinstance(payload, str):
+            payload = payload.encode("utf-8")
+        self.stats.add("publish_in")
+        self.route(topic, bytes(payload), qos)
+
+
+def start_broker(port=0, debug_log=False, handler=OTAClientHandler):
+    """Start a broker on a background thread, returns the broker (use broker.server_address for the port)."""
+    broker = OTABroker(("127.0.0.1", port), debug_log, handler)
+    thread = threading.Thread(target=broker.serve_forever, daemon=True)
+    thread.start()
+    return broker
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local MQTT Broker stand-in for OTA testing")
+    parser.add_argument("-p", "--port", type=int, default=DEFAULT_PORT, help="port to listen on")
+    parser.add_argument("-l", "--log", action="store_true", help="turn on logging")
+    args = parser.parse_args()
+
+    broker = OTABroker(("", args.port), args.log)
+    print("OTA MQTT Broker on port %d" % args.port)
+    try:
+        broker.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
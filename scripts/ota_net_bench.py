@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   OTA time-to-complete over an impaired network.
+#
+#   Runs the host built OTA Agent (host/ota_host) through ota_net_shaper.py
+#   to the local server (ota_http_server.py) or broker (ota_mqtt_broker.py
+#   with the ota_mqtt_bench.py publisher), for each network profile and
+#   each combination of the retry settings:
+#
+#       --packet-interval   CY_OTA_PACKET_INTERVAL_SECS
+#       --retry-interval    CY_OTA_RETRY_INTERVAL_SECS (at least CY_OTA_INTERVAL_SECS_MIN, 5)
+#       --connect-retries   CY_OTA_CONNECT_RETRIES
+#       --download-tries    CY_OTA_MAX_DOWNLOAD_TRIES
+#       --http-timeout      CY_OTA_HTTP_TIMEOUT_RECEIVE (ms), what notices a stalled HTTP download
+#
+#   Each combination is its own ota_host build, with a copy of
+#   configs/cy_ota_config.h (or "--config <dir>") that has these values.
+#   CY_OTA_RETRIES is not used by the Agent, so it is not swept.
+#
+#   Network profiles (see PROFILES), "disconnect" is where in the OTA Image
+#   the data connection is dropped:
+#       lan         1 ms RTT
+#       wifi        20 ms RTT, 10 ms jitter, 0.5% loss
+#       cellular    120 ms RTT, 40 ms jitter, 1% loss, 64 KB/s
+#       drop        wifi, the connection is closed a third of the way in
+#       stall       wifi, the connection goes silent a third of the way in
+#       outage      wifi, closed a third of the way in and refused for 8 seconds
+#   The shaper options (-r, -j, -L, -k, -D, -S, -O) change all the profiles.
+#
+#   Usage:
+#       python3 ota_net_bench.py [-P http,mqtt] [-p <profiles>] [-s <image size>] [-c <chunk size>]
+#                                [--packet-interval <secs,...>] [--retry-interval <secs,...>]
+#                                [--connect-retries <n,...>] [--download-tries <n,...>]
+#                                [--http-timeout <ms,...>] [-n <repeat>] [--csv] [-o <file>]
+#
+#   Output is one JSON object per run (JSON lines), or CSV with "--csv":
+#       protocol,profile,packet_interval,retry_interval,connect_retries,download_tries,http_timeout,
+#       seed,result,seconds,failures,connections,disconnects,outages,segments_lost,
+#       job_connects,data_connects,downloads,waiting_ms
+#
+
+import argparse
+import itertools
+import json
+import os
+import re
+import sys
+import tempfile
+
+import ota_http_server
+import ota_host_bench
+import ota_mqtt_bench
+import ota_mqtt_broker
+import ota_net_shaper
+from ota_host_bench import build_host, int_list
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+SCHEMA = 1                          # bump when the record layout changes
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+CONFIG_FILE = "cy_ota_config.h"
+
+# option : config define, swept values change the copy of cy_ota_config.h
+SETTINGS = [("packet_interval", "CY_OTA_PACKET_INTERVAL_SECS"),
+            ("retry_interval", "CY_OTA_RETRY_INTERVAL_SECS"),
+            ("connect_retries", "CY_OTA_CONNECT_RETRIES"),
+            ("download_tries", "CY_OTA_MAX_DOWNLOAD_TRIES")]
+HTTP_TIMEOUT_DEFINE = "CY_OTA_HTTP_TIMEOUT_RECEIVE"    # in cy_ota_defaults.h, set with -D
+HTTP_TIMEOUT_DEFAULT = 3000
+
+PROFILES = {
+    "lan":      {"rtt_ms": 1},
+    "wifi":     {"rtt_ms": 20, "jitter_ms": 10, "loss": 0.005},
+    "cellular": {"rtt_ms": 120, "jitter_ms": 40, "loss": 0.01, "rate_kbps": 64},
+    "drop":     {"rtt_ms": 20, "jitter_ms": 10, "loss": 0.005, "disconnect": 1.0 / 3},
+    "stall":    {"rtt_ms": 20, "jitter_ms": 10, "loss": 0.005, "disconnect": 1.0 / 3, "stall": True},
+    "outage":   {"rtt_ms": 20, "jitter_ms": 10, "loss": 0.005, "disconnect": 1.0 / 3, "outage_secs": 8},
+}
+
+# cy_ota_get_state_string() of the states counted in the record
+JOB_CONNECT = "OTA STATE Connecting for Job"
+DATA_CONNECT = "OTA STATE Connecting for Data"
+DOWNLOAD = "OTA STATE Downloading Data"
+WAITING = "OTA STATE Agent waiting"
+
+CSV_HEADER = ("protocol,profile,packet_interval,retry_interval,connect_retries,download_tries,http_timeout,"
+              "seed,result,seconds,failures,connections,disconnects,outages,segments_lost,"
+              "job_connects,data_connects,downloads,waiting_ms")
+
+
+def config_defaults(config_dir):
+    """ The SETTINGS values in cy_ota_config.h """
+    with open(os.path.join(config_dir, CONFIG_FILE)) as f:
+        text = f.read()
+    values = {}
+    for name, define in SETTINGS:
+        match = re.search(r"^#define\s+%s\s+\(?\s*(\d+)" % define, text, re.MULTILINE)
+        values[name] = int(match.group(1)) if match else None
+    return values
+
+
+def write_config(src_dir, dst_dir, values):
+    """ Copy cy_ota_config.h with the SETTINGS values replaced """
+    with open(os.path.join(src_dir, CONFIG_FILE)) as f:
+        text = f.read()
+    for name, define in SETTINGS:
+        text, count = re.subn(r"^(#define\s+%s\s+).*$" % define, r"\g<1>(%d)" % values[name], text, flags=re.MULTILINE)
+        if count == 0:
+            text += "\n#define %s (%d)\n" % (define, values[name])
+    os.makedirs(dst_dir, exist_ok=True)
+    with open(os.path.join(dst_dir, CONFIG_FILE), "w") as f:
+        f.write(text)
+
+
+def make_profile(name, args, size):
+    """ ShaperProfile for a named profile with the command line overrides """
+    settings = dict(PROFILES[name])
+    for key, value in (("rtt_ms", args.rtt), ("jitter_ms", args.jitter), ("loss", args.loss),
+                       ("rate_kbps", args.rate), ("outage_secs", args.outage)):
+        if value is not None:
+            settings[key] = value
+    if args.stall:
+        settings["stall"] = True
+    disconnect_after = int(size * settings.pop("disconnect", 0))
+    if args.disconnect_after is not None:
+        disconnect_after = args.disconnect_after
+    return ota_net_shaper.ShaperProfile(disconnect_after=disconnect_after, disconnects=args.disconnects, **settings)
+
+
+def run_one(protocol, host, stand_in, shaper, directory, values, seed, args):
+    """ One update session through the shaper, returns the result record """
+    if protocol == "http":
+        ota_host_bench.write_job(directory, shaper.port)
+        bench_args = argparse.Namespace(flow="job", external=False, timing=None, scale=0.0, rtt=0, rate=0,
+                                        timeout=args.timeout)
+        record = ota_host_bench.run_one(host, stand_in, directory, args.size, args.chunk, bench_args, shaper.port)
+    else:
+        bench_args = argparse.Namespace(dup=0.0, reorder=0, seed=seed, timeout=args.timeout)
+        record = ota_mqtt_bench.run_one(host, stand_in, directory, args.size, args.chunk, "one", bench_args,
+                                        shaper.port)
+
+    states = record.get("states", {})
+    profile = shaper.profile
+    result = {"schema": SCHEMA, "protocol": protocol, "profile": args.profile_name, "seed": seed,
+              "rtt_ms": profile.rtt_ms, "jitter_ms": profile.jitter_ms, "loss": profile.loss,
+              "rate_kbps": profile.rate_kbps, "disconnect_after": profile.disconnect_after,
+              "stall": profile.stall, "outage_secs": profile.outage_secs, "size": args.size, "chunk": args.chunk}
+    result.update(values)
+    result.update({
+        "result": record["result"],
+        "seconds": record.get("seconds", ""),
+        "failures": record.get("failures", ""),
+        "connections": shaper.stats.connections,
+        "disconnects": shaper.stats.disconnects,
+        "outages": shaper.stats.outages,
+        "segments_lost": shaper.stats.segments_lost,
+        "job_connects": states.get(JOB_CONNECT, {}).get("count", 0),
+        "data_connects": states.get(DATA_CONNECT, {}).get("count", 0),
+        "downloads": states.get(DOWNLOAD, {}).get("count", 0),
+        "waiting_ms": states.get(WAITING, {}).get("ms", 0),
+        "states": states,
+    })
+    return result
+
+
+def csv_line(record):
+    fields = [record["protocol"], record["profile"], record["packet_interval"], record["retry_interval"],
+              record["connect_retries"], record["download_tries"], record["http_timeout"], record["seed"],
+              record["result"], record["seconds"], record["failures"], record["connections"],
+              record["disconnects"], record["outages"], record["segments_lost"], record["job_connects"],
+              record["data_connects"], record["downloads"], record["waiting_ms"]]
+    return ",".join(str(x) for x in fields)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="OTA time-to-complete over an impaired network")
+    parser.add_argument("-P", "--protocols", default="http", help="http, mqtt or both (default http)")
+    parser.add_argument("-p", "--profiles", default="lan,wifi,drop,stall,outage",
+                        help="comma separated network profiles: " + ", ".join(PROFILES))
+    parser.add_argument("-s", "--size", type=int, default=256 * 1024, help="OTA Image size (default 256K)")
+    parser.add_argument("-c", "--chunk", type=int, default=4096, help="CY_OTA_CHUNK_SIZE (default 4096)")
+    parser.add_argument("--packet-interval", type=int_list, default=None, help="CY_OTA_PACKET_INTERVAL_SECS values")
+    parser.add_argument("--retry-interval", type=int_list, default=None, help="CY_OTA_RETRY_INTERVAL_SECS values")
+    parser.add_argument("--connect-retries", type=int_list, default=None, help="CY_OTA_CONNECT_RETRIES values")
+    parser.add_argument("--download-tries", type=int_list, default=None, help="CY_OTA_MAX_DOWNLOAD_TRIES values")
+    parser.add_argument("--http-timeout", type=int_list, default=[HTTP_TIMEOUT_DEFAULT],
+                        help="CY_OTA_HTTP_TIMEOUT_RECEIVE values in ms (default 3000)")
+    parser.add_argument("-r", "--rtt", type=int, default=None, help="round trip time in milliseconds")
+    parser.add_argument("-j", "--jitter", type=int, default=None, help="extra random delay up to this many milliseconds")
+    parser.add_argument("-L", "--loss", type=float, default=None, help="fraction of segments lost (and retransmitted)")
+    parser.add_argument("-k", "--rate", type=int, default=None, help="bandwidth limit in kbytes/s")
+    parser.add_argument("-D", "--disconnect-after", type=int, default=None, help="drop the connection after this many bytes")
+    parser.add_argument("-N", "--disconnects", type=int, default=1, help="number of connections to drop (default 1)")
+    parser.add_argument("-S", "--stall", action="store_true", help="stall the connection instead of closing it")
+    parser.add_argument("-O", "--outage", type=int, default=None, help="refuse connections for this many seconds after a drop")
+    parser.add_argument("-n", "--repeat", type=int, default=1, help="runs of each combination, with seeds 1..n")
+    parser.add_argument("-t", "--timeout", type=int, default=300, help="timeout of one run in seconds")
+    parser.add_argument("--config", default=None, help="directory with the cy_ota_config.h to start from")
+    parser.add_argument("--csv", action="store_true", help="CSV instead of JSON lines")
+    parser.add_argument("-o", "--output", default=None, help="output file (default stdout)")
+    args = parser.parse_args()
+
+    protocols = [p for p in args.protocols.split(",") if p != ""]
+    profiles = [p for p in args.profiles.split(",") if p != ""]
+    for protocol in protocols:
+        if protocol not in ("http", "mqtt"):
+            parser.error("unknown protocol " + protocol)
+    for profile in profiles:
+        if profile not in PROFILES:
+            parser.error("unknown profile " + profile)
+
+    config_dir = args.config or os.path.join(SCRIPT_DIR, "..", "configs")
+    defaults = config_defaults(config_dir)
+    sweeps = [getattr(args, name) or [defaults[name]] for name, _ in SETTINGS]
+    if min(sweeps[1]) < 5:
+        parser.error("CY_OTA_RETRY_INTERVAL_SECS must be at least CY_OTA_INTERVAL_SECS_MIN (5)")
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    if args.csv:
+        out.write(CSV_HEADER + "\n")
+
+    failed = 0
+    with tempfile.TemporaryDirectory() as directory:
+        server = ota_http_server.start_server(directory, 0, 0, False, 0)
+        broker = ota_mqtt_broker.start_broker(0)
+        for combination in itertools.product(*(sweeps + [args.http_timeout])):
+            values = dict(zip([name for name, _ in SETTINGS], combination))
+            values["http_timeout"] = combination[-1]
+            tag = "_net_p%d_r%d_c%d_d%d_h%d" % combination
+            build_config = os.path.join(ota_host_bench.HOST_DIR, "build", "net_config" + tag)
+            write_config(config_dir, build_config, values)
+            host = build_host(args.chunk, build_config, ("%s=%d" % (HTTP_TIMEOUT_DEFINE, values["http_timeout"]),), tag)
+            for protocol in protocols:
+                stand_in = server if protocol == "http" else broker
+                for args.profile_name in profiles:
+                    for seed in range(1, args.repeat + 1):
+                        shaper = ota_net_shaper.start_shaper(stand_in.server_address[1],
+                                                             make_profile(args.profile_name, args, args.size),
+                                                             seed=seed)
+                        record = run_one(protocol, host, stand_in, shaper, directory, values, seed, args)
+                        shaper.shutdown()
+                        failed += 0 if record["result"] == "success" else 1
+                        out.write((csv_line(record) if args.csv else json.dumps(record)) + "\n")
+                        out.flush()
+        broker.shutdown()
+        server.shutdown()
+
+    if out is not sys.stdout:
+        out.close()
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,343 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   Network impairment stand-in for AnyCloud OTA testing.
+#
+#   A TCP proxy between the Device (host/ota_host) and the local server or
+#   broker (ota_http_server.py, ota_mqtt_broker.py). Each direction of each
+#   connection is shaped on its own:
+#
+#   - RTT: every segment is held back for rtt / 2 in each direction.
+#   - Jitter: plus a uniform random 0 .. jitter ms. Segments never pass each
+#     other, like on a TCP stream.
+#   - Bandwidth: segments leave no faster than the rate, in kbytes/s.
+#   - Loss: TCP does not lose bytes, it delays them. A lost segment (of up
+#     to MSS bytes) is held back for one retransmit time, max(rto, rtt),
+#     and everything behind it waits too.
+#   - Disconnects: after "disconnect_after" bytes from the server on one
+#     connection the proxy either closes both sides ("reset"), or keeps both
+#     open and forwards nothing more ("stall", a dead link that only a
+#     timeout on the Device notices), "disconnects" times in all.
+#   - Outage: after each of those disconnects new connections are refused
+#     for "outage" seconds, so the Device has to retry its connect.
+#
+#   Usage:
+#       python3 ota_net_shaper.py -p <listen port> -u <server port> [-r <rtt ms>] [-j <jitter ms>]
+#                                 [-L <loss fraction>] [-k <kbytes/s>]
+#                                 [-D <disconnect after bytes>] [-n <disconnects>] [-S]
+#                                 [-O <outage secs>] [--seed <n>]
+#
+#   The shaper is also used as a module by the benchmark scripts.
+#
+
+import argparse
+import collections
+import random
+import socket
+import threading
+import time
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+MSS = 1460                  # bytes per segment
+RTO_MIN_MS = 200            # Linux TCP_RTO_MIN, lwIP uses a larger initial RTO
+
+SEND = 0
+DROP = 1                    # stalled connection, data goes nowhere
+CLOSE = 2
+
+
+class ShaperProfile:
+    """Impairment settings, shared by all connections of one shaper."""
+    def __init__(self, rtt_ms=0, jitter_ms=0, loss=0.0, rate_kbps=0, disconnect_after=0, disconnects=0,
+                 stall=False, outage_secs=0, rto_ms=RTO_MIN_MS):
+        self.rtt_ms = rtt_ms
+        self.jitter_ms = jitter_ms
+        self.loss = loss
+        self.rate_kbps = rate_kbps
+        self.disconnect_after = disconnect_after
+        self.disconnects = disconnects if disconnects > 0 or disconnect_after == 0 else 1
+        self.stall = stall
+        self.outage_secs = outage_secs
+        self.rto_ms = rto_ms
+
+    def __repr__(self):
+        return "rtt %d ms jitter %d ms loss %.3f rate %d KB/s %s after %d x%d outage %d s" % (
+            self.rtt_ms, self.jitter_ms, self.loss, self.rate_kbps, "stall" if self.stall else "disconnect",
+            self.disconnect_after, self.disconnects, self.outage_secs)
+
+
+class ShaperStats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        self.connections = 0
+        self.bytes_up = 0
+        self.bytes_down = 0
+        self.segments_lost = 0
+        self.disconnects = 0
+        self.outages = 0
+
+    def add(self, name, value=1):
+        with self.lock:
+            setattr(self, name, getattr(self, name) + value)
+
+
+class Direction:
+    """One direction of one connection: a reader thread queues segments with
+    their release time, a writer thread sends them when that time comes."""
+
+    def __init__(self, shaper, connection, src, dst, downstream):
+        self.shaper = shaper
+        self.connection = connection
+        self.src = src
+        self.dst = dst
+        self.downstream = downstream
+        self.queue = collections.deque()
+        self.cond = threading.Condition()
+        self.closed = False
+        self.link_free = 0.0        # when the bandwidth limited link has sent what is queued
+        self.last_release = 0.0
+
+    def release_time(self, length):
+        profile = self.shaper.profile
+        rng = self.shaper.rng
+        now = time.monotonic()
+        if profile.rate_kbps > 0:
+            self.link_free = max(now, self.link_free) + length / (profile.rate_kbps * 1024.0)
+            start = self.link_free
+        else:
+            start = now
+        delay = profile.rtt_ms / 2000.0
+        if profile.jitter_ms > 0:
+            delay += rng.uniform(0, profile.jitter_ms / 1000.0)
+        if profile.loss > 0 and rng.random() < profile.loss:
+            delay += max(profile.rto_ms, profile.rtt_ms) / 1000.0
+            self.shaper.stats.add("segments_lost")
+        self.last_release = max(self.last_release, start + delay)
+        return self.last_release
+
+    def reader(self):
+        try:
+            while True:
+                data = self.src.recv(MSS)
+                if not data:
+                    break
+                with self.cond:
+                    self.queue.append((self.release_time(len(data)), data))
+                    self.cond.notify()
+        except OSError:
+            pass
+        with self.cond:
+            self.closed = True
+            self.cond.notify()
+
+    def writer(self):
+        try:
+            while True:
+                with self.cond:
+                    while not self.queue and not self.closed:
+                        self.cond.wait()
+                    if not self.queue:
+                        break
+                    release, data = self.queue.popleft()
+                wait = release - time.monotonic()
+                if wait > 0:
+                    time.sleep(wait)
+                action = self.connection.action(len(data)) if self.downstream else self.connection.state
+                if action == CLOSE:
+                    break
+                if action == DROP:
+                    continue
+                self.dst.sendall(data)
+                self.shaper.stats.add("bytes_down" if self.downstream else "bytes_up", len(data))
+        except OSError:
+            pass
+        self.connection.close()
+
+    def start(self):
+        for target in (self.reader, self.writer):
+            threading.Thread(target=target, daemon=True).start()
+
+
+class Connection:
+    def __init__(self, shaper, client, server):
+        self.shaper = shaper
+        self.client = client
+        self.server = server
+        self.lock = threading.Lock()
+        self.closed = False
+        self.bytes_down = 0
+        self.state = SEND
+
+    def action(self, length):
+        """ SEND, DROP or CLOSE for the next segment from the server """
+        profile = self.shaper.profile
+        with self.lock:
+            self.bytes_down += length
+            if (self.state != SEND or profile.disconnect_after == 0 or
+                    self.bytes_down < profile.disconnect_after):
+                return self.state
+        if not self.shaper.take_disconnect():
+            return SEND
+        self.state = DROP if profile.stall else CLOSE
+        if self.state == CLOSE:
+            self.close()
+        return self.state
+
+    def close(self):
+        with self.lock:
+            if self.closed:
+                return
+            self.closed = True
+        for sock in (self.client, self.server):
+            try:
+                sock.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+            sock.close()
+
+
+class NetShaper:
+    def __init__(self, upstream_port, profile, port=0, upstream_host="127.0.0.1", seed=1):
+        self.upstream = (upstream_host, upstream_port)
+        self.profile = profile
+        self.rng = random.Random(seed)
+        self.stats = ShaperStats()
+        self.disconnects_left = profile.disconnects
+        self.down_until = 0.0
+        self.lock = threading.Lock()
+        self.listener = None
+        self.port = port
+        self.listen()
+        self.running = True
+
+    def listen(self):
+        self.listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.listener.bind(("127.0.0.1", self.port))
+        self.listener.listen(8)
+        self.listener.settimeout(0.1)
+        self.port = self.listener.getsockname()[1]
+
+    def close_listener(self):
+        """ Stop listening now, the shutdown also ends an accept() in progress """
+        try:
+            self.listener.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
+        self.listener.close()
+        self.listener = None
+
+    def set_profile(self, profile, seed=1):
+        """ New settings for the next connections, resets the disconnect count and the stats """
+        with self.lock:
+            self.profile = profile
+            self.disconnects_left = profile.disconnects
+            self.down_until = 0.0
+            self.rng = random.Random(seed)
+        self.stats.reset()
+
+    def take_disconnect(self):
+        with self.lock:
+            if self.disconnects_left <= 0:
+                return False
+            self.disconnects_left -= 1
+            if self.profile.outage_secs > 0:
+                # stop listening before the Device can reconnect
+                self.down_until = time.monotonic() + self.profile.outage_secs
+                if self.listener is not None:
+                    self.close_listener()
+                    self.stats.add("outages")
+        self.stats.add("disconnects")
+        return True
+
+    def serve_forever(self):
+        while self.running:
+            with self.lock:
+                if time.monotonic() >= self.down_until and self.listener is None:
+                    self.listen()
+                listener = self.listener
+            if listener is None:
+                # nothing listens on the port, a connect is refused
+                time.sleep(0.05)
+                continue
+            try:
+                client, _ = listener.accept()
+            except socket.timeout:
+                continue
+            except OSError:
+                continue                    # closed for an outage or a shutdown
+            client.settimeout(None)
+            try:
+                server = socket.create_connection(self.upstream)
+            except OSError:
+                client.close()
+                continue
+            for sock in (client, server):
+                sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            self.stats.add("connections")
+            connection = Connection(self, client, server)
+            Direction(self, connection, client, server, False).start()
+            Direction(self, connection, server, client, True).start()
+
+    def shutdown(self):
+        with self.lock:
+            self.running = False
+            self.down_until = float("inf")
+            if self.listener is not None:
+                self.close_listener()
+
+
+def start_shaper(upstream_port, profile, port=0, seed=1):
+    """Start a shaper on a background thread, returns the shaper (use shaper.port)."""
+    shaper = NetShaper(upstream_port, profile, port, seed=seed)
+    threading.Thread(target=shaper.serve_forever, daemon=True).start()
+    return shaper
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Network impairment proxy for OTA testing")
+    parser.add_argument("-p", "--port", type=int, required=True, help="port to listen on")
+    parser.add_argument("-u", "--upstream", type=int, required=True, help="server / broker port on 127.0.0.1")
+    parser.add_argument("-r", "--rtt", type=int, default=0, help="round trip time in milliseconds")
+    parser.add_argument("-j", "--jitter", type=int, default=0, help="extra random delay up to this many milliseconds")
+    parser.add_argument("-L", "--loss", type=float, default=0.0, help="fraction of segments lost (and retransmitted)")
+    parser.add_argument("-k", "--rate", type=int, default=0, help="bandwidth limit in kbytes/s, 0 = no limit")
+    parser.add_argument("-D", "--disconnect-after", type=int, default=0, help="drop a connection after this many bytes down")
+    parser.add_argument("-n", "--disconnects", type=int, default=0, help="number of connections to drop (default 1 with -D)")
+    parser.add_argument("-S", "--stall", action="store_true", help="stall the connection instead of closing it")
+    parser.add_argument("-O", "--outage", type=int, default=0, help="refuse connections for this many seconds after a disconnect")
+    parser.add_argument("--seed", type=int, default=1, help="seed for jitter and loss")
+    args = parser.parse_args()
+
+    profile = ShaperProfile(args.rtt, args.jitter, args.loss, args.rate, args.disconnect_after, args.disconnects,
+                            args.stall, args.outage)
+    shaper = NetShaper(args.upstream, profile, args.port, seed=args.seed)
+    print("Shaping port %d -> %d: %s" % (shaper.port, args.upstream, profile))
+    try:
+        shaper.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   Download progress journal power loss test.
+#
+#   Builds host/ota_host with CY_OTA_JOURNAL 1 and runs HTTP updates from
+#   ota_http_server.py. The FLASH emulator cuts power ("ota_host -C") during
+#   a random program or erase operation - data rows, journal records, slot
+#   and journal erases - and leaves that row, page or sector half done.
+#   ota_host is started again on the same backing file until the update
+#   completes. The Secondary Slot must then hold the OTA Image.
+#
+#   With "-p N" each run is cut within the first 1/N of the FLASH operations
+#   of a whole update, so a resumed download still gets cut N times. The same
+#   cut points are replayed with CY_OTA_JOURNAL 0, where every download starts
+#   over, to report the bytes the journal saves.
+#
+#   Usage:
+#       python3 ota_power_loss_test.py [-s <image size>] [-c <commit size list>]
+#                                      [-p <power losses list>] [-t <trials>] [-x]
+#
+#   Output is CSV:  commit_size,power_losses,trials,restart_bytes,journal_bytes,saved_pct,cuts,verify_ok
+#   restart_bytes and journal_bytes are the average bytes the server sent per trial,
+#   cuts the power cuts per trial that hit a FLASH operation.
+#   Exit status is 0 when every trial ends with the OTA Image in the Secondary Slot.
+#
+
+import argparse
+import json
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+import ota_http_server
+from ota_host_bench import build_host, int_list, write_job, IMAGE_NAME
+from ota_image_hash_bench import make_image
+from ota_truncate_test import write_config
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+CHUNK_SIZE = 4096                   # CY_OTA_CHUNK_SIZE
+SLOT_SIZE = 0x1C0000                # CY_FLASH_EMU_SLOT_SIZE, the Secondary Slot follows the Primary Slot
+POWER_CUT_EXIT = 3                  # CY_FLASH_EMU_POWER_CUT_EXIT
+MAX_RESTARTS = 3                    # runs without a power cut before a trial fails
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def run_host(host, server, directory, erase, cut, args):
+    """ One ota_host run, returns (exit status, ota_host JSON result or None) """
+    result_file = os.path.join(directory, "result.json")
+    if os.path.exists(result_file):
+        os.remove(result_file)
+    cmd = [host, "-p", str(server.server_address[1]), "-F", os.path.join(directory, "flash.bin"),
+           "-j", result_file, "-t", str(args.timeout)]
+    if erase:
+        cmd.append("-E")
+    if args.external:
+        cmd.append("-x")
+    if cut is not None:
+        cmd += ["-C", "%d:%d" % cut]
+    proc = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.STDOUT)
+    if not os.path.exists(result_file):
+        return proc.returncode, None
+    with open(result_file) as f:
+        return proc.returncode, json.load(f)
+
+
+def run_trial(host, server, directory, image, full_ops, cuts, args):
+    """ Update until complete, cutting power at each (fraction of full_ops, seed) of "cuts".
+        Returns (bytes the server sent, power cuts that happened, image ok) """
+    server.stats.reset()
+    erase = True
+    done = 0
+    result = None
+    for fraction, seed in cuts:
+        status, result = run_host(host, server, directory, erase, (int(fraction * full_ops) + 1, seed), args)
+        erase = False
+        if status != POWER_CUT_EXIT:
+            break
+        done += 1
+        result = None
+    for _ in range(MAX_RESTARTS):
+        if result is not None:
+            break
+        _, result = run_host(host, server, directory, erase, None, args)
+        erase = False
+
+    with open(os.path.join(directory, "flash.bin"), "rb") as f:
+        f.seek(SLOT_SIZE)
+        slot = f.read(len(image))
+    ok = (result is not None) and (result["result"] == "success") and (slot == image) and \
+         (result["flash"]["program_violations"] == 0)
+    return server.stats.bytes_sent, done, ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Download progress journal power loss test of the host built OTA Agent")
+    parser.add_argument("-s", "--size", type=int, default=512 * 1024, help="OTA Image size")
+    parser.add_argument("-c", "--commit", type=int_list, default=[4096, 16384, 65536],
+                        help="comma separated CY_OTA_JOURNAL_COMMIT_SIZE list")
+    parser.add_argument("-p", "--losses", type=int_list, default=[1, 3, 10],
+                        help="comma separated power losses per update list")
+    parser.add_argument("-t", "--trials", type=int, default=5, help="trials per setting")
+    parser.add_argument("-x", "--external", action="store_true", help="Secondary Slot in external (SMIF) FLASH")
+    parser.add_argument("--seed", type=int, default=1, help="random seed")
+    parser.add_argument("--timeout", type=int, default=60, help="timeout of one run in seconds")
+    args = parser.parse_args()
+
+    image, _ = make_image(args.size, seed=args.size)
+    rng = random.Random(args.seed)
+    failed = 0
+
+    print("commit_size,power_losses,trials,restart_bytes,journal_bytes,saved_pct,cuts,verify_ok")
+    with tempfile.TemporaryDirectory() as directory:
+        with open(os.path.join(directory, IMAGE_NAME), "wb") as f:
+            f.write(image)
+        server = ota_http_server.start_server(directory, 0)
+        write_job(directory, server.server_address[1])
+        try:
+            for commit in args.commit:
+                hosts = []
+                for journal in (0, 1):
+                    config_dir = os.path.join(SCRIPT_DIR, "host", "build", "power_loss_config%d" % journal)
+                    write_config(config_dir, ["CY_OTA_JOURNAL"] if journal else [])
+                    host = build_host(CHUNK_SIZE, config_dir, ["CY_OTA_JOURNAL_COMMIT_SIZE=%d" % commit],
+                                      tag="_power_loss")
+                    # FLASH operations of an update without a power cut
+                    _, result = run_host(host, server, directory, True, None, args)
+                    if (result is None) or (result["result"] != "success"):
+                        print("ota_host without a power cut failed")
+                        return 1
+                    hosts.append((host, result["flash"]["ops"]))
+
+                for losses in args.losses:
+                    totals = [0, 0]
+                    cut_total = 0
+                    ok_count = 0
+                    for _ in range(args.trials):
+                        cuts = [(rng.random() / losses, rng.randrange(1 << 16)) for _ in range(losses)]
+                        trial_ok = True
+                        for journal, (host, full_ops) in enumerate(hosts):
+                            sent, done, ok = run_trial(host, server, directory, image, full_ops, cuts, args)
+                            totals[journal] += sent
+                            cut_total += done if journal else 0
+                            trial_ok = trial_ok and ok
+                        ok_count += 1 if trial_ok else 0
+                        failed += 0 if trial_ok else 1
+                    saved = 100.0 * (totals[0] - totals[1]) / totals[0]
+                    print("%d,%d,%d,%d,%d,%.1f,%.1f,%d" % (commit, losses, args.trials,
+                                                           totals[0] // args.trials, totals[1] // args.trials,
+                                                           saved, cut_total / args.trials, ok_count))
+                    sys.stdout.flush()
+        finally:
+            server.shutdown()
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   Truncated stream test for CY_OTA_DECOMPRESS and CY_OTA_DELTA.
+#
+#   Builds host/ota_host with CY_OTA_DECOMPRESS 1 and CY_OTA_DELTA 1 and runs
+#   HTTP updates from ota_http_server.py with an LZSS compressed OTA Image
+#   (ota_compress.py) and a delta patch (ota_delta.py) from the image loaded
+#   into the Primary Slot: the whole stream, and the stream with its last
+#   bytes cut off. A complete stream must succeed, a cut off stream must fail
+#   at storage close, so the boot magic is never written.
+#
+#   Usage:
+#       python3 ota_truncate_test.py [-s <image size>] [-c <cut bytes list>]
+#
+#   Output is CSV:  case,cut,result,expected,ok
+#   Exit status is 0 when every case has the expected result.
+#
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+import ota_http_server
+from ota_compress import compress
+from ota_delta import make_patch
+from ota_host_bench import build_host, int_list, write_job, IMAGE_NAME
+from ota_image_hash_bench import make_image
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+CHUNK_SIZE = 4096                   # CY_OTA_CHUNK_SIZE
+WINDOW_BITS = 10                    # ota_compress.py default
+CONFIG_FILE = "cy_ota_config.h"
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def write_config(dst_dir, defines):
+    """ Copy configs/cy_ota_config.h with "defines" set to 1 """
+    with open(os.path.join(SCRIPT_DIR, "..", "configs", CONFIG_FILE)) as f:
+        text = f.read()
+    for define in defines:
+        text, count = re.subn(r"^(#define\s+%s\s+).*$" % define, r"\g<1>(1)", text, flags=re.MULTILINE)
+        if count == 0:
+            text += "\n#define %s (1)\n" % define
+    os.makedirs(dst_dir, exist_ok=True)
+    with open(os.path.join(dst_dir, CONFIG_FILE), "w") as f:
+        f.write(text)
+
+
+def run_case(host, server, directory, data, primary, timeout):
+    """ One update session serving "data", returns the ota_host result string """
+    with open(os.path.join(directory, IMAGE_NAME), "wb") as f:
+        f.write(data)
+    result_file = os.path.join(directory, "result.json")
+    if os.path.exists(result_file):
+        os.remove(result_file)
+    cmd = [host, "-p", str(server.server_address[1]), "-F", os.path.join(directory, "flash.bin"), "-E",
+           "-j", result_file, "-t", str(timeout)]
+    if primary is not None:
+        cmd += ["-P", primary]
+    subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.STDOUT)
+    if not os.path.exists(result_file):
+        return "no result"
+    with open(result_file) as f:
+        return json.load(f)["result"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Truncated compressed stream test of the host built OTA Agent")
+    parser.add_argument("-s", "--size", type=int, default=200 * 1024, help="OTA Image size")
+    parser.add_argument("-c", "--cuts", type=int_list, default=[1, 3000, 20000],
+                        help="comma separated bytes cut off the end of the stream")
+    parser.add_argument("-t", "--timeout", type=int, default=60, help="timeout of one run in seconds")
+    args = parser.parse_args()
+
+    image, _ = make_image(args.size, seed=args.size)
+    stream = compress(image, WINDOW_BITS)
+
+    # the new image: the old one with a few changed and inserted bytes
+    old_image = image
+    new_image = bytearray(old_image)
+    new_image[len(new_image) // 3:len(new_image) // 3 + 64] = bytes(range(64)) * 2
+    new_image[len(new_image) // 2] ^= 0xFF
+    patch = make_patch(old_image, bytes(new_image))
+
+    config_dir = os.path.join(SCRIPT_DIR, "host", "build", "truncate_config")
+    write_config(config_dir, ["CY_OTA_DECOMPRESS", "CY_OTA_DELTA"])
+    host = build_host(CHUNK_SIZE, config_dir, tag="_truncate")
+
+    cases = [("lzss", 0, stream, False)] + [("lzss", cut, stream[:-cut], False) for cut in args.cuts]
+    delta_cuts = [cut for cut in args.cuts if cut < len(patch)] + [len(patch) // 2]
+    cases += [("delta", 0, patch, True)] + [("delta", cut, patch[:-cut], True) for cut in delta_cuts]
+
+    failed = 0
+    print("case,cut,result,expected,ok")
+    with tempfile.TemporaryDirectory() as directory:
+        primary = os.path.join(directory, "primary.bin")
+        with open(primary, "wb") as f:
+            f.write(old_image)
+        server = ota_http_server.start_server(directory, 0)
+        write_job(directory, server.server_address[1])
+        try:
+            for name, cut, data, delta in cases:
+                result = run_case(host, server, directory, data, primary if delta else None, args.timeout)
+                expected = "success" if cut == 0 else "failure"
+                ok = (result == "success") == (cut == 0)
+                failed += 0 if ok else 1
+                print("%s,%d,\"%s\",%s,%d" % (name, cut, result, expected, ok))
+                sys.stdout.flush()
+        finally:
+            server.shutdown()
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
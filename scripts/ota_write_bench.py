@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#   Secondary Slot write benchmark, FLASH operations of write_data_to_flash().
+#
+#   Feeds an image to a model of write_data_to_flash() in cy_ota_untar.c in
+#   the pieces each transport hands over, and counts the FLASH operations:
+#       rmw      - the previous code: each piece is written in CY_FLASH_SIZEOF_ROW
+#                  blocks, a block smaller than a row reads the row, patches it
+#                  and writes the whole row back.
+#       coalesce - the row buffer: whole rows are written straight through, the
+#                  rest is collected until the row is complete, cy_ota_write_flush()
+#                  writes the last row.
+#       skip     - coalesce, rows of the erased value are not written (row_can_skip()).
+#   The FLASH is modelled as NOR (erased 0xFF, a write clears bits), the result is
+#   compared with the image. misaligned counts writes not on a row boundary,
+#   which PSoC internal FLASH refuses. In the previous code a block that crosses
+#   a row boundary overruns block_buffer; the model drops the bytes past the row,
+#   so verify_ok is 0 for those patterns.
+#
+#   Patterns:
+#       http_range   - CY_OTA_CHUNK_SIZE range requests (and CY_OTA_HTTP_STREAMING)
+#       http_par2    - two halves of the image in CY_OTA_CHUNK_SIZE pieces, interleaved
+#                      (out of order data, checks the row reads)
+#       mqtt         - publisher.py payloads
+#       ble          - GATT writes of 244 bytes (247 byte MTU)
+#       lzss         - CY_OTA_DECOMPRESS output, one piece per compressed chunk
+#                      (1.3 to 2.2 times CY_OTA_CHUNK_SIZE)
+#       random       - 1 to CY_OTA_CHUNK_SIZE byte pieces
+#
+#   With "--padding", that fraction of the image is runs of 0x00 and erased
+#   value bytes of 4 to 64 KB, as the padding between linker sections.
+#
+#   Usage:
+#       python3 ota_write_bench.py [-s <image size>] [-r <row size>] [-p <pattern list>] [--seed <n>]
+#                                  [--padding <fraction>] [-e <erased value>]
+#
+#   Output is CSV:  pattern,mode,pieces,reads_per_mb,writes_per_mb,programmed_kb_per_mb,skipped_kb_per_mb,misaligned,verify_ok
+#
+
+import argparse
+import random
+
+#==============================================================================
+# Defines
+#==============================================================================
+
+CHUNK_SIZE = 4096                   # matches CY_OTA_CHUNK_SIZE
+BLE_WRITE_SIZE = 244
+
+
+class Flash:
+    """ NOR FLASH, counting flash_area_read() / flash_area_write() """
+
+    def __init__(self, size, row, erased):
+        self.data = bytearray(bytes([erased]) * size)
+        self.row = row
+        self.erased = erased
+        self.reads = 0
+        self.writes = 0
+        self.programmed = 0
+        self.skipped = 0
+        self.misaligned = 0
+
+    def read(self, offset, size):
+        self.reads += 1
+        return bytes(self.data[offset:offset + size])
+
+    def write(self, offset, data):
+        self.writes += 1
+        self.programmed += len(data)
+        if offset % self.row or len(data) % self.row:
+            self.misaligned += 1
+        for i, b in enumerate(data):
+            if self.erased == 0xff:
+                self.data[offset + i] &= b
+            else:
+                self.data[offset + i] = b
+
+
+def write_rmw(flash, offset, data):
+    """ write_data_to_flash() before the row buffer """
+    row = flash.row
+    pos = 0
+    while pos < len(data):
+        size = min(row, len(data) - pos)
+        if size % row:
+            base = ((offset + pos) // row) * row
+            block = bytearray(flash.read(base, row))
+            start = offset + pos - base
+            block[start:start + size] = data[pos:pos + size]
+            flash.write(base, bytes(block[:row]))
+        else:
+            flash.write(offset + pos, data[pos:pos + size])
+        pos += size
+
+
+class RowBuffer:
+    """ write_data_to_flash() with the row buffer """
+
+    def __init__(self, flash, skip):
+        self.flash = flash
+        self.skip = skip
+        self.valid = False
+        self.base = 0
+        self.end = 0
+        self.high = 0
+        self.data = bytearray(flash.row)
+
+    def can_skip(self, data):
+        return self.skip and data == bytes([self.flash.erased]) * self.flash.row
+
+    def flush(self):
+        if self.valid:
+            self.valid = False
+            if self.can_skip(bytes(self.data)):
+                self.flash.skipped += self.flash.row
+            else:
+                self.flash.write(self.base, bytes(self.data))
+
+    def write(self, offset, data):
+        row = self.flash.row
+        pos = 0
+        while pos < len(data):
+            curr = offset + pos
+            base = (curr // row) * row
+            row_off = curr - base
+            left = len(data) - pos
+            if row_off == 0 and left >= row and (not self.valid or self.base != base):
+                size = (left // row) * row
+                if self.valid and base < self.base < base + size:
+                    size = self.base - base
+                if self.can_skip(data[pos:pos + row]):
+                    size = row
+                    self.flash.skipped += row
+                else:
+                    for rows in range(row, size, row):
+                        if self.can_skip(data[pos + rows:pos + rows + row]):
+                            size = rows
+                            break
+                    self.flash.write(curr, data[pos:pos + size])
+            else:
+                size = min(row - row_off, left)
+                if self.valid and self.base != base:
+                    self.flush()
+                if not self.valid:
+                    if base >= self.high:
+                        self.data = bytearray(bytes([self.flash.erased]) * row)
+                    else:
+                        self.data = bytearray(self.flash.read(base, row))
+                    self.base, self.end, self.valid = base, 0, True
+                self.data[row_off:row_off + size] = data[pos:pos + size]
+                self.end = max(self.end, row_off + size)
+                if self.end == row:
+                    self.flush()
+            pos += size
+            self.high = max(self.high, offset + pos)
+
+
+def pieces(pattern, size, seed):
+    """ (offset, length) in arrival order """
+    def split(start, end, piece):
+        return [(o, min(piece, end - o)) for o in range(start, end, piece)]
+
+    if pattern in ("http_range", "mqtt"):
+        return split(0, size, CHUNK_SIZE)
+    if pattern == "ble":
+        return split(0, size, BLE_WRITE_SIZE)
+    if pattern == "http_par2":
+        half = ((size // 2) // CHUNK_SIZE) * CHUNK_SIZE
+        parts = [split(0, half, CHUNK_SIZE), split(half, size, CHUNK_SIZE)]
+        order = []
+        for i in range(max(len(p) for p in parts)):
+            order.extend(p[i] for p in parts if i < len(p))
+        return order
+    if pattern in ("lzss", "random"):
+        rng = random.Random(seed)
+        result = []
+        offset = 0
+        while offset < size:
+            if pattern == "lzss":
+                length = rng.randint(CHUNK_SIZE * 13 // 10, CHUNK_SIZE * 22 // 10)
+            else:
+                length = rng.randint(1, CHUNK_SIZE)
+            length = min(length, size - offset)
+            result.append((offset, length))
+            offset += length
+        return result
+    raise ValueError("unknown pattern " + pattern)
+
+
+def make_image(size, padding, seed):
+    """ random data with runs of 0x00 / 0xFF padding """
+    rng = random.Random(seed)
+    image = bytearray(rng.getrandbits(8) for _ in range(size))
+    pad = int(size * padding)
+    while pad > 0:
+        length = min(rng.randint(4096, 65536), pad)
+        start = rng.randrange(0, size - length)
+        image[start:start + length] = bytes([rng.choice((0x00, 0xff))]) * length
+        pad -= length
+    return bytes(image)
+
+
+def run(image, row, mode, order, erased):
+    flash = Flash(len(image) + row, row, erased)
+    buffer = RowBuffer(flash, mode == "skip")
+    for offset, length in order:
+        data = image[offset:offset + length]
+        if mode == "rmw":
+            write_rmw(flash, offset, data)
+        else:
+            buffer.write(offset, data)
+    buffer.flush()
+    return flash, bytes(flash.data[:len(image)]) == image
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Count FLASH operations of write_data_to_flash()")
+    parser.add_argument("-s", "--size", type=int, default=1024 * 1024, help="image size (default 1 MB)")
+    parser.add_argument("-r", "--row", type=int, default=512, help="CY_FLASH_SIZEOF_ROW (default 512)")
+    parser.add_argument("-p", "--patterns", default="http_range,http_par2,mqtt,ble,lzss,random",
+                        help="patterns to run")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the image and random pieces")
+    parser.add_argument("--padding", type=float, default=0.2, help="fraction of the image that is padding (default 0.2)")
+    parser.add_argument("-e", "--erased", type=lambda x: int(x, 0), default=0xff,
+                        help="erased value, flash_area_erased_val() (default 0xff, SMIF)")
+    args = parser.parse_args()
+
+    image = make_image(args.size, args.padding, args.seed)
+    mb = args.size / (1024.0 * 1024.0)
+
+    print("pattern,mode,pieces,reads_per_mb,writes_per_mb,programmed_kb_per_mb,skipped_kb_per_mb,misaligned,verify_ok")
+    for pattern in args.patterns.split(","):
+        order = pieces(pattern, args.size, args.seed)
+        for mode in ("rmw", "coalesce", "skip"):
+            flash, ok = run(image, args.row, mode, order, args.erased)
+            print("%s,%s,%d,%.0f,%.0f,%.0f,%.0f,%d,%d" % (pattern, mode, len(order), flash.reads / mb, flash.writes / mb,
+                                                        flash.programmed / 1024.0 / mb, flash.skipped / 1024.0 / mb,
+                                                        flash.misaligned, int(ok)))
+
+
+if __name__ == "__main__":
+    main()
@@ -337,6 +337,7 @@ static cy_ota_error_string_lookup_t cy_ota_error_strings[] =
     { CY_RSLT_OTA_USE_DIRECT_FLOW, "OTA Agent use Direct data download flow" },
 
     { CY_RSLT_OTA_NO_UPDATE_AVAILABLE, "OTA ERROR No Update Available" },
+    { CY_RSLT_OTA_JOB_NOT_MODIFIED, "OTA Job document not modified" },
 
 };
 #define CY_OTA_NUM_ERROR_STRINGS    (sizeof(cy_ota_error_strings)/sizeof(cy_ota_error_strings[0]) )
@@ -615,8 +616,90 @@ cy_ota_callback_results_t cy_ota_internal_call_cb( cy_ota_context_t *ctx,
  * Miscellaneous Functions
  *
  **********************************************************************/
+/**
+ * @brief Timing category of a state
+ *
+ * @param[in]   state   - OTA Agent state
+ *
+ * @return  @ref cy_ota_stats_category_t, CY_OTA_NUM_STATS when the state is not timed
+ */
+static cy_ota_stats_category_t cy_ota_stats_category(cy_ota_agent_state_t state)
+{
+    switch (state)
+    {
+        case CY_OTA_STATE_JOB_CONNECT:
+        case CY_OTA_STATE_DATA_CONNECT:
+        case CY_OTA_STATE_RESULT_CONNECT:
+            return CY_OTA_STATS_CONNECT;
+        case CY_OTA_STATE_JOB_DOWNLOAD:
+            return CY_OTA_STATS_JOB_DOWNLOAD;
+        case CY_OTA_STATE_DATA_DOWNLOAD:
+            return CY_OTA_STATS_DATA_DOWNLOAD;
+        case CY_OTA_STATE_STORAGE_OPEN:
+            return CY_OTA_STATS_STORAGE_OPEN;
+        case CY_OTA_STATE_STORAGE_CLOSE:
+            return CY_OTA_STATS_STORAGE_CLOSE;
+        case CY_OTA_STATE_VERIFY:
+            return CY_OTA_STATS_VERIFY;
+        default:
+            break;
+    }
+    return CY_OTA_NUM_STATS;
+}
+
+/**
+ * @brief Add the time spent in the current state to the statistics
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   now     - time the current state is left
+ */
+static void cy_ota_stats_add_state_time(cy_ota_context_t *ctx, cy_time_t now)
+{
+    cy_ota_stats_histogram_t    *histogram;
+    cy_ota_stats_category_t     category;
+    uint32_t                    elapsed_ms;
+    uint32_t                    bucket;
+
+    elapsed_ms = (uint32_t)(now - ctx->state_start_ms);
+    ctx->state_start_ms = now;
+
+    ctx->stats.transitions++;
+    ctx->stats.state_count[ctx->curr_state]++;
+    ctx->stats.state_ms[ctx->curr_state] += elapsed_ms;
+
+    category = cy_ota_stats_category(ctx->curr_state);
+    if (category >= CY_OTA_NUM_STATS)
+    {
+        return;
+    }
+
+    histogram = &ctx->stats.histogram[category];
+    if ( (histogram->count == 0) || (elapsed_ms < histogram->min_ms) )
+    {
+        histogram->min_ms = elapsed_ms;
+    }
+    if (elapsed_ms > histogram->max_ms)
+    {
+        histogram->max_ms = elapsed_ms;
+    }
+    histogram->count++;
+    histogram->total_ms += elapsed_ms;
+    histogram->last_ms = elapsed_ms;
+
+    for (bucket = 0; bucket < (CY_OTA_STATS_BUCKETS - 1); bucket++)
+    {
+        if (elapsed_ms < ( (uint32_t)CY_OTA_STATS_BUCKET_MS << bucket) )
+        {
+            break;
+        }
+    }
+    histogram->buckets[bucket]++;
+}
+
 void cy_ota_set_state(cy_ota_context_t *ctx, cy_ota_agent_state_t state)
 {
+    cy_time_t   now;
+
     CY_OTA_CONTEXT_ASSERT(ctx);
 
     /* sanity check */
@@ -627,6 +710,15 @@ void cy_ota_set_state(cy_ota_context_t *ctx, cy_ota_agent_state_t state)
     else
     {
         cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() state: %d\n", __func__, state);
+        if (state != ctx->curr_state)
+        {
+            cy_rtos_get_time(&now);
+            cy_ota_stats_add_state_time(ctx, now);
+            if (state == CY_OTA_STATE_START_UPDATE)
+            {
+                ctx->stats.sessions++;
+            }
+        }
         ctx->curr_state = state;
     }
 }
@@ -960,6 +1052,28 @@ cy_rslt_t cy_OTA_JSON_callback(cy_JSON_object_t* json_object, void *arg)
                 }
                 memcpy(ctx->parsed_job.file, val, val_len);
             }
+            else if ( (obj_len == strlen(CY_OTA_MIRRORS_FIELD) ) &&
+                      (strncasecmp(obj, CY_OTA_MIRRORS_FIELD, obj_len) == 0) )
+            {
+                if (val_len >= sizeof(ctx->parsed_job.mirrors) )
+                {
+                    cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "Job parse: Mirrors text too long. Increase CY_OTA_JOB_MIRRORS_LEN!\n");
+                    val_len = sizeof(ctx->parsed_job.mirrors) - 1;
+                }
+                memcpy(ctx->parsed_job.mirrors, val, val_len);
+            }
+#if (CY_OTA_BLOCK_REUSE == 1)
+            else if ( (obj_len == strlen(CY_OTA_MANIFEST_FIELD) ) &&
+                      (strncasecmp(obj, CY_OTA_MANIFEST_FIELD, obj_len) == 0) )
+            {
+                if (val_len >= sizeof(ctx->parsed_job.manifest) )
+                {
+                    cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "Job parse: Manifest name too long!\n");
+                    val_len = sizeof(ctx->parsed_job.manifest) - 1;
+                }
+                memcpy(ctx->parsed_job.manifest, val, val_len);
+            }
+#endif
             else if ( (obj_len == strlen(CY_OTA_UNIQUE_TOPIC_FIELD) ) &&
                       (strncasecmp(obj, CY_OTA_UNIQUE_TOPIC_FIELD, obj_len) == 0) )
             {
@@ -1021,6 +1135,10 @@ static void cy_ota_print_parsed_doc_info(cy_ota_context_t *ctx)
         cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "   Server   : %s\n", ctx->parsed_job.broker_server.host_name);
         cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "   Port     : %d\n", ctx->parsed_job.broker_server.port);
         cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "   FILE     : %s\n", ctx->parsed_job.file);
+        if (ctx->parsed_job.mirrors[0] != 0)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "   MIRRORS  : %s\n", ctx->parsed_job.mirrors);
+        }
     }
     else
     {
@@ -1267,8 +1385,8 @@ static cy_rslt_t cy_ota_wait_for_start(cy_ota_context_t *ctx)
             COMPANY_TOPIC_PREPEND, CY_TARGET_BOARD_STRING, CY_OTA_MQTT_MAGIC, (uint16_t)(tval & 0x0000FFFF) );
 #endif
 
-    /* clear any old events */
-    waitfor = CY_OTA_EVENT_THREAD_EVENTS;
+    /* clear any old start events, keep a shutdown from cy_ota_agent_stop() */
+    waitfor = CY_OTA_EVENT_START_UPDATE;
     cy_rtos_waitbits_event(&ctx->ota_event, &waitfor, 1, 0, 1);
 
     while (true)
@@ -1348,7 +1466,10 @@ static cy_rslt_t cy_ota_determine_flow(cy_ota_context_t *ctx)
      * - If Direct flow, App set to the name of the OTA Image file
      * */
     memset(ctx->http.file, 0x00, sizeof(ctx->http.file));
-    strncpy(ctx->http.file, ctx->network_params.http.file, (sizeof(ctx->http.file) - 1) );
+    if (ctx->network_params.http.file != NULL)      /* not set by an MQTT only application */
+    {
+        strncpy(ctx->http.file, ctx->network_params.http.file, (sizeof(ctx->http.file) - 1) );
+    }
     if (strlen(ctx->http.file) < 1)
     {
         strncpy(ctx->http.file, CY_OTA_HTTP_JOB_FILE, (sizeof(ctx->http.file) - 1) );
@@ -1569,6 +1690,14 @@ static cy_rslt_t cy_ota_job_parse(cy_ota_context_t *ctx)
     ctx->parsed_job.parse_result = cy_ota_parse_job_info(ctx, ctx->job_doc, strlen(ctx->job_doc));
     cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() cy_ota_parse_job_info result: 0x%lx\n", __func__, ctx->parsed_job.parse_result);
 
+#ifdef COMPONENT_OTA_HTTP
+    if ( (ctx->curr_connect_type == CY_OTA_CONNECTION_HTTP) ||
+         (ctx->curr_connect_type == CY_OTA_CONNECTION_HTTPS) )
+    {
+        cy_ota_http_job_parsed(ctx, ctx->parsed_job.parse_result);
+    }
+#endif
+
     if ( (ctx->parsed_job.parse_result != CY_RSLT_SUCCESS) &&
          (ctx->parsed_job.parse_result != CY_RSLT_OTA_CHANGING_SERVER) )
     {
@@ -1646,6 +1775,15 @@ static cy_rslt_t cy_ota_data_download(cy_ota_context_t *ctx)
     /* clear received / written info before we start */
     cy_ota_clear_received_stats(ctx);
 
+    /* continue an interrupted download, cy_ota_storage_open() found the data before resume_offset in FLASH */
+    if (ctx->journal.resume_offset > 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Data Download resume at %ld of %ld\n",
+                   ctx->journal.resume_offset, ctx->journal.resume_image_size);
+        ctx->total_bytes_written = ctx->journal.resume_offset;
+        ctx->total_image_size    = ctx->journal.resume_image_size;
+    }
+
     /* get_data functions */
 #ifdef COMPONENT_OTA_MQTT
     if (ctx->curr_connect_type == CY_OTA_CONNECTION_MQTT)
@@ -1935,6 +2073,16 @@ static void cy_ota_agent( cy_thread_arg_t arg )
                             result = CY_RSLT_SUCCESS;
                             cy_ota_set_last_error(ctx, CY_RSLT_SUCCESS);
                         }
+                        else if ( (ctx->curr_state == CY_OTA_STATE_JOB_DOWNLOAD) &&
+                                  (result == CY_RSLT_OTA_JOB_NOT_MODIFIED) )
+                        {
+                            /* Same Job document as the last poll, which did not lead to an update.
+                             * Skip parsing, the Data server and the Result - cy_ota_complete() disconnects.
+                             */
+                            new_state = CY_OTA_STATE_OTA_COMPLETE;
+                            result = CY_RSLT_SUCCESS;
+                            cy_ota_set_last_error(ctx, CY_RSLT_OTA_NO_UPDATE_AVAILABLE);
+                        }
                         else if (result == CY_RSLT_OTA_ERROR_APP_RETURNED_STOP)
                         {
                             cy_ota_set_last_error(ctx, CY_RSLT_OTA_ERROR_APP_RETURNED_STOP);
@@ -2008,9 +2156,11 @@ static void cy_ota_agent( cy_thread_arg_t arg )
                         {
                             cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%d : %s() state:%s retry_count:%d\n", __LINE__, __func__,
                                         cy_ota_get_state_string(ctx->curr_state), ctx->download_retry_count);
-                            /* We are still connected, just try to download again
+                            /* The download may have failed because the connection was lost,
+                             * disconnect so that CY_OTA_STATE_DATA_CONNECT makes a new one.
                              * Always check if we need to erase the storage
                              */
+                            cy_ota_disconnect(ctx);
                             new_state = CY_OTA_STATE_STORAGE_OPEN;
                             cy_ota_set_last_error(ctx, CY_RSLT_SUCCESS);
                             result = CY_RSLT_SUCCESS;
@@ -2169,6 +2319,7 @@ cy_rslt_t cy_ota_agent_start(cy_ota_network_params_t *network_params, cy_ota_age
     memset(ctx, 0x00, sizeof(cy_ota_context_t) );
 
     ctx->curr_state = CY_OTA_STATE_INITIALIZING;
+    cy_rtos_get_time(&ctx->state_start_ms);
 
     /* copy over the initial parameters */
     memcpy(&ctx->network_params, network_params, sizeof(cy_ota_network_params_t) );
@@ -2361,6 +2512,10 @@ cy_rslt_t cy_ota_agent_stop(cy_ota_context_ptr *ota_ptr)
     cy_rtos_join_thread(&ctx->ota_agent_thread);
 #endif
 
+    /* stop the storage writer thread and the erase-ahead thread if still running */
+    cy_ota_writer_stop(ctx);
+    cy_ota_storage_erase_ahead_stop(ctx);
+
     /* clear timer */
     cy_rtos_deinit_timer(&ctx->ota_timer);
 
@@ -2394,6 +2549,42 @@ cy_rslt_t cy_ota_get_state(cy_ota_context_ptr ota_ptr, cy_ota_agent_state_t *sta
     return CY_RSLT_SUCCESS;
 }
 
+/* --------------------------------------------------------------- */
+cy_rslt_t cy_ota_get_http_range_stats(cy_ota_context_ptr ota_ptr, cy_ota_http_range_stats_t *stats)
+{
+    const cy_ota_context_t *ctx = (cy_ota_context_t *)ota_ptr;
+    CY_OTA_CONTEXT_ASSERT(ctx);
+
+    /* sanity check */
+    if ( (ctx == NULL) || (stats == NULL) )
+    {
+        return CY_RSLT_OTA_ERROR_BADARG;
+    }
+
+#ifdef COMPONENT_OTA_HTTP
+    memcpy(stats, &ctx->http.range_stats, sizeof(cy_ota_http_range_stats_t));
+    return CY_RSLT_SUCCESS;
+#else
+    return CY_RSLT_OTA_ERROR_TRANSPORT_UNSUPPORTED;
+#endif
+}
+
+/* --------------------------------------------------------------- */
+cy_rslt_t cy_ota_get_stats(cy_ota_context_ptr ota_ptr, cy_ota_stats_t *stats)
+{
+    const cy_ota_context_t *ctx = (cy_ota_context_t *)ota_ptr;
+    CY_OTA_CONTEXT_ASSERT(ctx);
+
+    /* sanity check */
+    if ( (ctx == NULL) || (stats == NULL) )
+    {
+        return CY_RSLT_OTA_ERROR_BADARG;
+    }
+
+    memcpy(stats, &ctx->stats, sizeof(cy_ota_stats_t));
+    return CY_RSLT_SUCCESS;
+}
+
 /* --------------------------------------------------------------- */
 void cy_ota_set_log_level(CY_LOG_LEVEL_T level)
 {
@@ -420,7 +420,7 @@ cy_rslt_t cy_ota_ble_download_write(cy_ota_context_ptr ota_ptr, wiced_bt_gatt_ev
     }
 #endif
 
-    result = cy_ota_write_incoming_data_block(ota_ptr, &chunk_info);
+    result = cy_ota_writer_write(ota_ctx, &chunk_info);
     if (result != CY_RSLT_SUCCESS)
     {
         cy_rtos_setbits_event(&ota_ctx->ota_event, (uint32_t)CY_OTA_EVENT_DATA_FAIL, 0);
@@ -522,6 +522,18 @@ cy_rslt_t cy_ota_ble_download_verify(cy_ota_context_ptr ota_ptr, wiced_bt_gatt_e
     }
 #endif
 
+    /* Bluetooth(r) does not close storage, make sure everything received is in FLASH and stop the writer */
+    if ( (cy_ota_writer_stop(ota_ctx) != CY_RSLT_SUCCESS) && (result == CY_RSLT_SUCCESS) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "          cy_ota_writer_stop() failed\n");
+        result = CY_RSLT_OTA_ERROR_BLE_VERIFY;
+    }
+    if ( (cy_ota_write_flush(ota_ctx) != CY_RSLT_SUCCESS) && (result == CY_RSLT_SUCCESS) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "          cy_ota_write_flush() failed\n");
+        result = CY_RSLT_OTA_ERROR_BLE_VERIFY;
+    }
+
     if (result == CY_RSLT_SUCCESS)
     {
         /* set OTA library status to verified */
@@ -569,6 +581,7 @@ cy_rslt_t cy_ota_ble_download_abort(cy_ota_context_ptr ota_ptr)
 
     CY_OTA_CONTEXT_ASSERT(ota_ctx);
     cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s(): Set state\n", __func__);
+    cy_ota_writer_stop(ota_ctx);
     cy_ota_set_state(ota_ctx, CY_OTA_STATE_AGENT_WAITING);
 
     return CY_RSLT_SUCCESS;
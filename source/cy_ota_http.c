@@ -20,6 +20,7 @@
  */
 
 #include <stdio.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
@@ -37,10 +38,13 @@
 #include "cy_ota_internal.h"
 #include "ip4_addr.h"
 #include "cy_http_client_api.h"
+#include "cy_secure_sockets.h"
 
 #include "cyabs_rtos.h"
 #include "cy_log.h"
 
+#include "http_header.h"
+
 
 /***********************************************************************
  *
@@ -105,6 +109,10 @@ typedef enum
  *
  **********************************************************************/
 
+#define OTA_HTTP_FETCH_THREAD_NAME      "CY OTA Fetch"
+
+#define OTA_HTTP_HASH_INIT              (2166136261UL)      /* FNV-1a offset basis */
+
 /***********************************************************************
  *
  * Structures
@@ -117,15 +125,17 @@ typedef enum
  *
  **********************************************************************/
 
-#define HTTP_HEADER_STR                 "HTTP/"
-#define HTTP_HEADERS_BODY_SEPARATOR     "\r\n\r\n"
-
 #define HTTP_HEADER_CONTENT_TYPE        "Content-Type"      /* for JOB, it is HTTP_HEADER_CONTENT_TYPE_JOB_VALUE */
 #define HTTP_HEADER_CONTENT_LENGTH      "Content-Length"    /* This is different for each Job, don't enforce size */
 
 #define HTTP_HEADER_ACCEPT_RANGE        "Accept-Ranges"     /* We are only looking for bytes of data */
 #define HTTP_HEADER_CONTENT_RANGE       "Content-Range"     /* The range will change - look for response values */
 
+#define HTTP_HEADER_ETAG                "ETag"              /* Saved from the Job response, see CY_OTA_HTTP_JOB_CACHE */
+#define HTTP_HEADER_LAST_MODIFIED       "Last-Modified"
+#define HTTP_HEADER_IF_NONE_MATCH       "If-None-Match"     /* Sent when polling for the Job */
+#define HTTP_HEADER_IF_MODIFIED_SINCE   "If-Modified-Since"
+
 /* For the Job Document, we want to see these values */
 #define HTTP_HEADER_CONTENT_ACCEPT_RANGE_VALUE      "bytes"
 #define HTTP_HEADER_CONTENT_TYPE_JOB_VALUE          "application/json"
@@ -181,6 +191,9 @@ static cy_http_client_header_t cy_ota_http_read_headers[] =
 };
 #define CY_NUM_READ_HEADERS ( sizeof(cy_ota_http_read_headers) / sizeof(cy_http_client_header_t) )
 
+/* chunk handed to storage during the data download */
+static cy_ota_storage_write_info_t     http_chunk_info;
+
 static cy_http_client_header_t cy_ota_http_result_headers[] =
 {
     { HTTP_HEADER_CONTENT_TYPE, sizeof(HTTP_HEADER_CONTENT_TYPE) - 1,
@@ -201,29 +214,6 @@ static cy_http_client_header_t cy_ota_http_result_headers[] =
  *
  **********************************************************************/
 
-/**
- * Length limited version of strstr. Ported from wiced_lib.c
- *
- * @param s[in]             : The string to be searched.
- * @param s_len[in]         : The length of the string to be searched.
- * @param substr[in]        : The string to be found.
- * @param substr_len[in]    : The length of the string to be found.
- *
- * @return    pointer to the found string if search successful, otherwise NULL
- */
-char* strnstrn(const char *s, uint16_t s_len, const char *substr, uint16_t substr_len)
-{
-    for (; s_len >= substr_len; s++, s_len--)
-    {
-        if (strncmp(s, substr, substr_len) == 0)
-        {
-            return (char*)s;
-        }
-    }
-
-    return NULL;
-}
-
 void cy_ota_http_timer_callback(cy_timer_callback_arg_t arg)
 {
     cy_ota_context_t *ctx = (cy_ota_context_t *)arg;
@@ -258,6 +248,8 @@ static cy_rslt_t cy_ota_http_init_headers(cy_ota_context_t *ctx,
                                             cy_http_client_header_t **send_headers, uint16_t *num_send_headers,
                                             cy_http_client_header_t **read_headers, uint16_t *num_read_headers)
 {
+    uint32_t    i;
+
     CY_OTA_CONTEXT_ASSERT(ctx);
 
     if ( (send_headers == NULL) || (num_send_headers == NULL) ||
@@ -290,77 +282,17 @@ static cy_rslt_t cy_ota_http_init_headers(cy_ota_context_t *ctx,
         return CY_RSLT_OTA_ERROR_GENERAL;
     }
 
-    *read_headers = cy_ota_http_read_headers;
-    *num_read_headers = CY_NUM_READ_HEADERS;
-
-
-    return CY_RSLT_SUCCESS;
-}
-
-/****************************************************************/
-cy_rslt_t cy_ota_http_parse_header(uint8_t **ptr, uint16_t *data_len, uint32_t *file_len, http_status_code_t *response_code)
-{
-    char    *response_status;
-    uint8_t *header_end;
-
-    if ( (ptr == NULL) || (*ptr == NULL) ||
-         (data_len == NULL) || (*data_len == 0) ||
-         (file_len == NULL) ||
-         (response_code == NULL) )
-    {
-        return CY_RSLT_OTA_ERROR_BADARG;
-    }
-    *response_code = HTTP_FORBIDDEN;
-
-    /* example:
-        "HTTP/1.1 200 Ok\r\n"
-        "Server: mini_httpd/1.23 28Dec2015\r\n"
-        "Date: Tue, 03 Mar 2020 18:49:23 GMT\r\n"
-        "Content-Type: application/octet-stream\r\n"
-        "Content-Length: 830544\r\n"
-        "\r\n\r\n"
+    /* cy_http_client_read_header() sets value_len to the length read,
+     * give each value its whole buffer again for this download (or retry)
      */
-
-    /* sanity check */
-    if (*data_len < 12)
-    {
-        return CY_RSLT_OTA_ERROR_NOT_A_HEADER;
-    }
-
-    /* Find the HTTP/x.x part*/
-    response_status = strnstrn( (char *)*ptr, *data_len, HTTP_HEADER_STR, sizeof(HTTP_HEADER_STR) - 1);
-    if (response_status == NULL)
-    {
-        return CY_RSLT_OTA_ERROR_NOT_A_HEADER;
-    }
-    /* skip to next ' ' space character */
-    response_status = strchr(response_status, ' ');
-    if (response_status == NULL)
-    {
-        return CY_RSLT_OTA_ERROR_NOT_A_HEADER;
-    }
-    *response_code = (http_status_code_t)atoi(response_status + 1);
-
-    /* Find Content-Length part*/
-    response_status = strnstrn( (char *)*ptr, *data_len, HTTP_HEADER_CONTENT_LENGTH, sizeof(HTTP_HEADER_CONTENT_LENGTH) - 1);
-    if (response_status == NULL)
+    for (i = 0; i < CY_NUM_READ_HEADERS; i++)
     {
-        return CY_RSLT_OTA_ERROR_NOT_A_HEADER;
+        cy_ota_http_read_headers[i].value_len = CY_HTTP_HEADER_VALUE_LEN;
     }
-    response_status += sizeof(HTTP_HEADER_CONTENT_LENGTH);
-    *file_len = atoi(response_status);
+    *read_headers = cy_ota_http_read_headers;
+    *num_read_headers = CY_NUM_READ_HEADERS;
 
-    /* find end of header */
-    header_end = (uint8_t *)strnstrn( (char *)*ptr, *data_len, HTTP_HEADERS_BODY_SEPARATOR, sizeof(HTTP_HEADERS_BODY_SEPARATOR) - 1);
-    if (header_end == NULL)
-    {
-        return CY_RSLT_OTA_ERROR_NOT_A_HEADER;
-    }
-    header_end += sizeof(HTTP_HEADERS_BODY_SEPARATOR) - 1;
-    *data_len -= (header_end - *ptr);
-    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG3, "Move ptr from %p to %p skipping %d new_len:%d first_byte:0x%x\n", *ptr, header_end, (header_end - *ptr), *data_len, *header_end);
 
-    *ptr = header_end;
     return CY_RSLT_SUCCESS;
 }
 
@@ -429,7 +361,7 @@ static cy_rslt_t cy_ota_http_write_chunk_to_flash(cy_ota_context_t *ctx, cy_ota_
     {
     default:
     case CY_OTA_CB_RSLT_OTA_CONTINUE:
-        if (cy_ota_write_incoming_data_block(ctx, chunk_info) != CY_RSLT_SUCCESS)
+        if (cy_ota_writer_write(ctx, chunk_info) != CY_RSLT_SUCCESS)
         {
             cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Write failed\n", __func__);
             cy_rtos_setbits_event(&ctx->ota_event, (uint32_t)CY_OTA_EVENT_DATA_FAIL, 0);
@@ -590,12 +522,16 @@ cy_rslt_t cy_ota_http_connect(cy_ota_context_t *ctx)
     if (result != CY_RSLT_SUCCESS)
     {
         cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_http_client_connect() failed %d.\n", __func__, result);
-        cy_http_client_delete(&ctx->http.connection);
+        cy_http_client_delete(ctx->http.connection);
+        ctx->http.connection = NULL;            /* or the connect retry finds it "Already connected" */
         cy_http_client_deinit();
         return CY_RSLT_OTA_ERROR_CONNECT;
     }
 
     ctx->http.connection_established = true;
+    ctx->http.connection_tls = (security != NULL);
+    ctx->http.server_info = server_info;
+    ctx->http.security = security;
 
     cy_log_msg(CYLF_OTA, CY_LOG_INFO, "HTTP Connection Successful, server:%s:%d  TLS:%s\n",
                (server_info->host_name == NULL) ? "None" : server_info->host_name, server_info->port,
@@ -714,6 +650,14 @@ static cy_rslt_t cy_ota_http_send_get_response(cy_ota_context_t *ctx,
                 }
                 result = CY_RSLT_SUCCESS;
             }
+#if (CY_OTA_HTTP_JOB_CACHE == 1)
+            else if ( (response->status_code == HTTP_NOT_MODIFIED) && (ctx->curr_state == CY_OTA_STATE_JOB_DOWNLOAD) )
+            {
+                /* Answer to a conditional GET for the Job document */
+                cy_log_msg(CYLF_OTA, CY_LOG_INFO, "HTTP response code: %d, Job document not modified\n", response->status_code);
+                result = CY_RSLT_OTA_JOB_NOT_MODIFIED;
+            }
+#endif
             else if (response->status_code < 400 )
             {
                 /* 3xx (Redirection): Further action needs to be taken in order to complete the request */
@@ -733,6 +677,129 @@ static cy_rslt_t cy_ota_http_send_get_response(cy_ota_context_t *ctx,
     return result;
 }
 
+#if (CY_OTA_HTTP_JOB_CACHE == 1)
+/**
+ * @brief FNV-1a hash
+ *
+ * @param[in]   hash    - hash so far, start with OTA_HTTP_HASH_INIT
+ * @param[in]   data    - data to add
+ * @param[in]   len     - length of data
+ *
+ * @return  new hash
+ */
+static uint32_t cy_ota_http_hash(uint32_t hash, const void *data, uint32_t len)
+{
+    const uint8_t *ptr = (const uint8_t *)data;
+
+    while (len-- > 0)
+    {
+        hash ^= *ptr++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Hash of the Server, port and file the Job document is polled from
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  identity for @ref cy_ota_http_job_cache_t
+ */
+static uint32_t cy_ota_http_job_identity(cy_ota_context_t *ctx)
+{
+    uint32_t hash = OTA_HTTP_HASH_INIT;
+
+    if (ctx->curr_server->host_name != NULL)
+    {
+        hash = cy_ota_http_hash(hash, ctx->curr_server->host_name, strlen(ctx->curr_server->host_name));
+    }
+    hash = cy_ota_http_hash(hash, &ctx->curr_server->port, sizeof(ctx->curr_server->port));
+    hash = cy_ota_http_hash(hash, ctx->http.file, strlen(ctx->http.file));
+    return hash;
+}
+
+/**
+ * @brief Add the conditional headers to the Job request headers
+ *
+ * @param[in]   ctx             - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   headers         - Job request headers
+ * @param[in]   num_headers     - number of Job request headers
+ * @param[out]  out             - headers to send, room for num_headers + 2
+ *
+ * @return  number of headers in out
+ */
+static uint16_t cy_ota_http_job_cache_headers(cy_ota_context_t *ctx, cy_http_client_header_t *headers,
+                                              uint16_t num_headers, cy_http_client_header_t *out)
+{
+    cy_ota_http_job_cache_t *cache = &ctx->http.job_cache;
+
+    memcpy(out, headers, (num_headers * sizeof(cy_http_client_header_t)) );
+    if (cache->valid == false)
+    {
+        return num_headers;
+    }
+    if (cache->etag[0] != 0)
+    {
+        out[num_headers].field     = HTTP_HEADER_IF_NONE_MATCH;
+        out[num_headers].field_len = sizeof(HTTP_HEADER_IF_NONE_MATCH) - 1;
+        out[num_headers].value     = cache->etag;
+        out[num_headers].value_len = strlen(cache->etag);
+        num_headers++;
+    }
+    if (cache->last_modified[0] != 0)
+    {
+        out[num_headers].field     = HTTP_HEADER_IF_MODIFIED_SINCE;
+        out[num_headers].field_len = sizeof(HTTP_HEADER_IF_MODIFIED_SINCE) - 1;
+        out[num_headers].value     = cache->last_modified;
+        out[num_headers].value_len = strlen(cache->last_modified);
+        num_headers++;
+    }
+    return num_headers;
+}
+
+/**
+ * @brief Save a response header value if it fits
+ *
+ * @param[out]  dest    - saved value, CY_OTA_HTTP_JOB_VALIDATOR_LEN bytes
+ * @param[in]   header  - response header read with value CY_OTA_HTTP_JOB_VALIDATOR_LEN bytes, 0 filled
+ */
+static void cy_ota_http_job_cache_save(char *dest, cy_http_client_header_t *header)
+{
+    uint32_t len = strlen(header->value);
+
+    memset(dest, 0x00, CY_OTA_HTTP_JOB_VALIDATOR_LEN);
+    if (len < (CY_OTA_HTTP_JOB_VALIDATOR_LEN - 1) )
+    {
+        memcpy(dest, header->value, len);
+    }
+}
+#endif  /* CY_OTA_HTTP_JOB_CACHE */
+
+/**
+ * @brief Save the outcome of parsing the HTTP Job document
+ *
+ * A Job document for another board or with a version that is not newer will not
+ * lead to an update until it changes, so the next poll is conditional.
+ *
+ * @param[in]   ctx             - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   parse_result    - result of parsing the Job document
+ */
+void cy_ota_http_job_parsed(cy_ota_context_t *ctx, cy_rslt_t parse_result)
+{
+#if (CY_OTA_HTTP_JOB_CACHE == 1)
+    CY_OTA_CONTEXT_ASSERT(ctx);
+
+    ctx->http.job_cache.valid = ( (parse_result == CY_RSLT_OTA_ERROR_INVALID_VERSION) ||
+                                  (parse_result == CY_RSLT_OTA_ERROR_WRONG_BOARD) );
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() parse_result:0x%lx conditional poll:%d\n", __func__,
+               parse_result, ctx->http.job_cache.valid);
+#else
+    (void)ctx;
+    (void)parse_result;
+#endif
+}
+
 /**
  * @brief get the OTA job
  *
@@ -743,6 +810,7 @@ static cy_rslt_t cy_ota_http_send_get_response(cy_ota_context_t *ctx,
  * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
  *
  * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_JOB_NOT_MODIFIED - same Job document as the last poll, see CY_OTA_HTTP_JOB_CACHE
  *          CY_RSLT_OTA_ERROR_GENERAL
  */
 cy_rslt_t cy_ota_http_get_job(cy_ota_context_t *ctx)
@@ -804,6 +872,20 @@ cy_rslt_t cy_ota_http_get_job(cy_ota_context_t *ctx)
                 cy_http_client_response_t       response;               // move into ctx structure ?
                 cy_http_client_header_t         *read_headers = NULL;
                 uint16_t                        num_read_headers=0;     /* Number of headers in the list */
+#if (CY_OTA_HTTP_JOB_CACHE == 1)
+                cy_ota_http_job_cache_t         *cache = &ctx->http.job_cache;
+                cy_http_client_header_t         job_send_headers[CY_NUM_JOB_HEADERS + 2];
+                char                            validators[2][CY_OTA_HTTP_JOB_VALIDATOR_LEN];
+                cy_http_client_header_t         job_read_headers[] =
+                {
+                    { HTTP_HEADER_ETAG, sizeof(HTTP_HEADER_ETAG) - 1,
+                      validators[0], (CY_OTA_HTTP_JOB_VALIDATOR_LEN - 1) },
+                    { HTTP_HEADER_LAST_MODIFIED, sizeof(HTTP_HEADER_LAST_MODIFIED) - 1,
+                      validators[1], (CY_OTA_HTTP_JOB_VALIDATOR_LEN - 1) },
+                };
+                uint32_t                        identity;
+                uint32_t                        job_hash;
+#endif
 
                 request.method        = CY_HTTP_CLIENT_METHOD_GET;
                 request.resource_path = ctx->http.file;                 /* File to load */
@@ -819,6 +901,21 @@ cy_rslt_t cy_ota_http_get_job(cy_ota_context_t *ctx)
                     cy_log_msg(CYLF_OTA, CY_LOG_ERR, "cy_ota_http_init_headers() failed for state: %s\n", cy_ota_get_state_string(ctx->curr_state));
                 }
 
+#if (CY_OTA_HTTP_JOB_CACHE == 1)
+                /* Poll conditionally if the last Job document from here did not lead to an update */
+                identity = cy_ota_http_job_identity(ctx);
+                if (identity != cache->identity)
+                {
+                    cache->valid = false;
+                }
+                num_send_headers = cy_ota_http_job_cache_headers(ctx, send_headers, num_send_headers, job_send_headers);
+                send_headers = job_send_headers;
+                memset(validators, 0x00, sizeof(validators));
+                read_headers = job_read_headers;
+                num_read_headers = (uint16_t)(sizeof(job_read_headers) / sizeof(job_read_headers[0]));
+                cache->polls++;
+#endif
+
                 memset(&response, 0x00, sizeof(response));
 
                 result = cy_ota_http_send_get_response(ctx, &request,
@@ -827,6 +924,40 @@ cy_rslt_t cy_ota_http_get_job(cy_ota_context_t *ctx)
                                                         &response);
                 cy_log_msg(CYLF_OTA, CY_LOG_DEBUG2, "cy_ota_http_send_get_response() returned: 0x%lx status:%d\n", result, response.status_code);
                 cy_log_msg(CYLF_OTA, CY_LOG_DEBUG2, "  Buffer:%p   len:%d\n", response.body, response.body_len);
+
+#if (CY_OTA_HTTP_JOB_CACHE == 1)
+                job_hash = 0;
+                if (result == CY_RSLT_SUCCESS)
+                {
+                    /* A server without validators sends the whole Job document - compare it */
+                    job_hash = cy_ota_http_hash(OTA_HTTP_HASH_INIT, response.body, response.body_len);
+                    if ( (cache->valid == true) && (job_hash == cache->job_hash) )
+                    {
+                        result = CY_RSLT_OTA_JOB_NOT_MODIFIED;
+                    }
+                }
+                if (result == CY_RSLT_OTA_JOB_NOT_MODIFIED)
+                {
+                    if (cache->valid == true)
+                    {
+                        cache->not_modified++;
+                        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Job document not modified (%ld of %ld polls), no update\n",
+                                   cache->not_modified, cache->polls);
+                        break;
+                    }
+                    /* 304 to a GET that was not conditional */
+                    result = CY_RSLT_OTA_ERROR_GENERAL;
+                }
+                if (result == CY_RSLT_SUCCESS)
+                {
+                    /* New Job document - cy_ota_http_job_parsed() decides if the next poll is conditional */
+                    cache->valid    = false;
+                    cache->identity = identity;
+                    cache->job_hash = job_hash;
+                    cy_ota_http_job_cache_save(cache->etag, &job_read_headers[0]);
+                    cy_ota_http_job_cache_save(cache->last_modified, &job_read_headers[1]);
+                }
+#endif
                 if (result != CY_RSLT_SUCCESS)
                 {
                     cy_log_msg(CYLF_OTA, CY_LOG_ERR, "cy_ota_http_send_get_response() returned: 0x%lx\n", result);
@@ -874,118 +1005,1404 @@ cy_rslt_t cy_ota_http_get_job(cy_ota_context_t *ctx)
 
 
 /**
- * @brief get the OTA download
- *
- * NOTE: Individual Network Connection type will do whatever is necessary
- *      ex: MQTT
- *          - subscribe to start data transfer
- *          HTTP
- *          - pull the data from the server
+ * @brief Clear the range request statistics and set the first range size
  *
  * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
- *
- * @return  CY_RSLT_SUCCESS
- *          CY_RSLT_OTA_ERROR_GENERAL
  */
-static cy_ota_storage_write_info_t     http_chunk_info;
-cy_rslt_t cy_ota_http_get_data(cy_ota_context_t *ctx)
+static void cy_ota_http_range_init(cy_ota_context_t *ctx)
 {
-    cy_rslt_t       result;
-    uint32_t        waitfor_clear;
-    uint32_t        range_start;
-    uint32_t        range_end;
-
-    cy_ota_callback_results_t   cb_result;
-
-    CY_OTA_CONTEXT_ASSERT(ctx);
+    cy_ota_http_range_stats_t *stats = &ctx->http.range_stats;
+
+    memset(stats, 0x00, sizeof(cy_ota_http_range_stats_t));
+    stats->min_size      = CY_OTA_HTTP_RANGE_MIN_SIZE;
+    stats->max_size      = CY_OTA_HTTP_RANGE_SPAN;
+    stats->adaptive      = (stats->min_size < stats->max_size);
+    stats->current_size  = stats->min_size;    /* adaptive sizing starts small and grows */
+    stats->smallest_size = stats->current_size;
+    stats->largest_size  = stats->current_size;
+}
 
-    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG2, "%s()\n", __func__);
+/**
+ * @brief Adjust the range size after a request
+ *
+ * Double the size after a fast request, halve it after a slow or failed request,
+ * staying between min_size and max_size.
+ *
+ * @param[in]   ctx         - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   request_ms  - time for the request
+ * @param[in]   failed      - true if the request failed
+ */
+static void cy_ota_http_range_update(cy_ota_context_t *ctx, uint32_t request_ms, bool failed)
+{
+    cy_ota_http_range_stats_t *stats = &ctx->http.range_stats;
+    uint32_t                  new_size = stats->current_size;
 
-    if (cy_rtos_init_mutex(&ctx->sub_callback_mutex) != CY_RSLT_SUCCESS)
+    stats->requests++;
+    if (failed)
     {
-        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() sub_callback_mutex init failed\n", __func__);
-        return CY_RSLT_OTA_ERROR_GET_DATA;
+        stats->failures++;
     }
-    ctx->sub_callback_mutex_inited = 1;
-
-    /* clear any lingering events */
-    waitfor_clear = CY_OTA_EVENT_HTTP_EVENTS;
-    result = cy_rtos_waitbits_event(&ctx->ota_event, &waitfor_clear, 1, 0, 1);
-    if (waitfor_clear != 0)
+    else
     {
-        cy_log_msg(CYLF_OTA, CY_LOG_DEBUG2, "%s() Clearing waitfor: 0x%lx\n", __func__, waitfor_clear);
+        stats->last_request_ms = request_ms;
+        if (stats->avg_request_ms == 0)
+        {
+            stats->avg_request_ms = request_ms;
+        }
+        else
+        {
+            stats->avg_request_ms = ( (stats->avg_request_ms * CY_OTA_HTTP_RANGE_AVG_WEIGHT) + request_ms) / (CY_OTA_HTTP_RANGE_AVG_WEIGHT + 1);
+        }
     }
 
-    result = cy_rtos_init_timer(&ctx->http.http_timer, CY_TIMER_TYPE_ONCE,
-                        cy_ota_http_timer_callback, (cy_timer_callback_arg_t)ctx);
-    if (result != CY_RSLT_SUCCESS)
+    if (!stats->adaptive)
     {
-        /* Timer init failed */
-        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Timer Create Failed!\n", __func__);
-        ctx->sub_callback_mutex_inited = 0;
-        cy_rtos_deinit_mutex(&ctx->sub_callback_mutex);
-        return CY_RSLT_OTA_ERROR_GET_DATA;
+        return;
     }
 
-    /* start with first chunk of data */
-    range_start = 0;
-    range_end = CY_OTA_CHUNK_SIZE - 1;      /* end byte, not length ! */
+    if (failed || (request_ms > CY_OTA_HTTP_RANGE_TARGET_MS))
+    {
+        new_size = stats->current_size / 2;
+        if (new_size < stats->min_size)
+        {
+            new_size = stats->min_size;
+        }
+    }
+    else if (request_ms < (CY_OTA_HTTP_RANGE_TARGET_MS / 2))
+    {
+        new_size = stats->current_size * 2;
+        if (new_size > stats->max_size)
+        {
+            new_size = stats->max_size;
+        }
+    }
 
-    /* Form GET request - re-use data buffer to save some RAM */
-    memset(ctx->http.file, 0x00, sizeof(ctx->http.file));
-    memset(ctx->http.json_doc, 0x00, sizeof(ctx->http.json_doc));
-    if (ctx->network_params.use_get_job_flow == CY_OTA_DIRECT_FLOW)
+    if (new_size > stats->current_size)
     {
-        /* Caller gave us the file name directly - use what is params */
-        strncpy(ctx->http.file, ctx->network_params.http.file, (sizeof(ctx->http.file) - 1) );
-        snprintf(ctx->http.json_doc, sizeof(ctx->http.json_doc), CY_OTA_HTTP_GET_RANGE_TEMPLATE,
-                ctx->http.file, ctx->curr_server->host_name, ctx->curr_server->port,
-                (long)range_start, (long)range_end);
+        stats->grow_count++;
+    }
+    else if (new_size < stats->current_size)
+    {
+        stats->shrink_count++;
     }
     else
     {
-        /* We got the file name from the Job file.
-         * The Job redirect will have already changed the current server */
-        strncpy(ctx->http.file, ctx->parsed_job.file, (sizeof(ctx->http.file) - 1) );
-        snprintf(ctx->http.json_doc, sizeof(ctx->http.json_doc), CY_OTA_HTTP_GET_RANGE_TEMPLATE,
-                ctx->parsed_job.file, ctx->curr_server->host_name, ctx->curr_server->port,
-                (long)range_start, (long)range_end);
+        return;
     }
-    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%d : %s() CALLING CB STATE_CHANGE %s stop_OTA_session:%d\n", __LINE__, __func__,
-            cy_ota_get_state_string(ctx->curr_state), ctx->stop_OTA_session);
 
-    cb_result = cy_ota_internal_call_cb(ctx, CY_OTA_REASON_STATE_CHANGE, ctx->curr_state);
-    switch( cb_result )
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() range size %ld -> %ld (%ld ms%s)\n", __func__,
+               stats->current_size, new_size, request_ms, (failed) ? " failed" : "");
+    stats->current_size = new_size;
+    if (new_size < stats->smallest_size)
     {
-    case CY_OTA_CB_RSLT_OTA_CONTINUE:
-        /* Processing continues after switch() */
-        break;
+        stats->smallest_size = new_size;
+    }
+    if (new_size > stats->largest_size)
+    {
+        stats->largest_size = new_size;
+    }
+}
 
-    default:
-    case CY_OTA_CB_RSLT_OTA_STOP:
-        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() App returned OTA Stop for STATE_CHANGE for DATA_DOWNLOAD\n", __func__);
-        result = CY_RSLT_OTA_ERROR_APP_RETURNED_STOP;
-        goto cleanup_and_exit;
+/**
+ * @brief Re-open the HTTP connection to the server after a failed request
+ *
+ * A failed request can leave part of a response on the socket.
+ * The connection is not touched if the Application passed it in.
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_CONNECT
+ */
+static cy_rslt_t cy_ota_http_reconnect(cy_ota_context_t *ctx)
+{
+    cy_rslt_t result;
 
-    case CY_OTA_CB_RSLT_APP_SUCCESS:
-        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%s() App returned APP_SUCCESS for STATE_CHANGE for DATA_DOWNLOAD\n", __func__);
-        result = CY_RSLT_SUCCESS;
-        goto cleanup_and_exit;
+    if ( (ctx->http.connection_from_app == true) || (ctx->http.connection == NULL) )
+    {
+        return CY_RSLT_SUCCESS;
+    }
 
-    case CY_OTA_CB_RSLT_APP_FAILED:
-        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() App returned APP_FAILED for STATE_CHANGE for DATA_DOWNLOAD\n", __func__);
-        result = CY_RSLT_OTA_ERROR_GET_DATA;
-        goto cleanup_and_exit;
+    cy_http_client_disconnect(ctx->http.connection);
+    result = cy_http_client_connect(ctx->http.connection, CY_OTA_HTTP_TIMEOUT_SEND, CY_OTA_HTTP_TIMEOUT_RECEIVE);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_http_client_connect() failed 0x%lx\n", __func__, result);
+        return CY_RSLT_OTA_ERROR_CONNECT;
+    }
+    return CY_RSLT_SUCCESS;
+}
 
+#if (CY_OTA_BLOCK_REUSE == 1)
+/**
+ * @brief Get the block manifest named in the Job and compare it with the Primary Slot
+ *
+ * Called once the image size is known. Any failure leaves block reuse off,
+ * the image is then downloaded in full.
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ */
+static void cy_ota_http_get_manifest(cy_ota_context_t *ctx)
+{
+    cy_http_client_request_header_t request;
+    cy_http_client_response_t       response;
+    cy_http_client_header_t         *send_headers = NULL;
+    uint16_t                        num_send_headers = 0;
+    cy_http_client_header_t         *read_headers = NULL;
+    uint16_t                        num_read_headers = 0;
+    uint32_t                        offset = 0;
+
+    memset(&ctx->block_reuse, 0x00, sizeof(ctx->block_reuse));
+    if ( (ctx->network_params.use_get_job_flow == CY_OTA_DIRECT_FLOW) || (ctx->parsed_job.manifest[0] == 0x00) )
+    {
+        return;
+    }
+    if (cy_ota_storage_block_reuse_start(ctx) != CY_RSLT_SUCCESS)
+    {
+        return;
     }
 
-    /* we only get here when there are no errors in our setup above. */
-    /* If we bail without doing anything here, then we need to look at getting the file size before
-     * getting here.
-     */
-    while ( ( (ctx->total_bytes_written == 0) ||
-              (ctx->total_bytes_written < ctx->total_image_size) ) &&
-            (range_end > range_start) )
+    do
+    {
+        request.method        = CY_HTTP_CLIENT_METHOD_GET;
+        request.resource_path = ctx->parsed_job.manifest;
+        request.buffer        = ctx->chunk_buffer;
+        request.buffer_len    = sizeof(ctx->chunk_buffer);
+        request.headers_len   = 0;
+        request.range_start   = offset;
+        request.range_end     = offset + CY_OTA_CHUNK_SIZE - 1;
+
+        if (cy_ota_http_init_headers(ctx, &send_headers, &num_send_headers, &read_headers, &num_read_headers) != CY_RSLT_SUCCESS)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "cy_ota_http_init_headers() failed for state: %s\n", cy_ota_get_state_string(ctx->curr_state));
+        }
+        memset(&response, 0x00, sizeof(response));
+        if ( (cy_ota_http_send_get_response(ctx, &request, send_headers, num_send_headers,
+                                            read_headers, num_read_headers, &response) != CY_RSLT_SUCCESS) ||
+             (response.body_len == 0) )
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() no manifest %s, download all blocks\n", __func__, ctx->parsed_job.manifest);
+            cy_ota_http_reconnect(ctx);
+            ctx->block_reuse.active = 0;
+            return;
+        }
+        if (cy_ota_storage_block_reuse_manifest(ctx, (const uint8_t *)response.body, response.body_len) != CY_RSLT_SUCCESS)
+        {
+            return;
+        }
+        offset += response.body_len;
+    } while ( (ctx->block_reuse.manifest_size == 0) || (offset < ctx->block_reuse.manifest_size) );
+}
+
+/**
+ * @brief Copy the blocks at range_start that are the same in the Primary Slot
+ *
+ * The copies go through the same write path as downloaded data. The next range
+ * request is shortened to end before the next block that is copied.
+ *
+ * @param[in]       ctx         - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in,out]   range_start - first byte of the next range request
+ * @param[in,out]   range_end   - last byte of the next range request
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ *          CY_RSLT_OTA_ERROR_APP_RETURNED_STOP
+ */
+static cy_rslt_t cy_ota_http_reuse_blocks(cy_ota_context_t *ctx, uint32_t *range_start, uint32_t *range_end)
+{
+    cy_rslt_t   result;
+    uint32_t    next;
+
+    if (ctx->block_reuse.active == 0)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    while ( (*range_start < ctx->total_image_size) &&
+            (cy_ota_storage_block_reuse_next(ctx, *range_start) == *range_start) )
+    {
+        http_chunk_info.offset     = ctx->total_bytes_written;
+        http_chunk_info.buffer     = ctx->chunk_buffer;
+        http_chunk_info.size       = ctx->total_image_size - *range_start;
+        http_chunk_info.size       = (http_chunk_info.size > CY_OTA_CHUNK_SIZE) ? CY_OTA_CHUNK_SIZE : http_chunk_info.size;
+        http_chunk_info.total_size = ctx->total_image_size;
+        if (cy_ota_storage_primary_read(ctx, *range_start, ctx->chunk_buffer, http_chunk_info.size) != 0)
+        {
+            /* download the rest */
+            ctx->block_reuse.active = 0;
+            break;
+        }
+        result = cy_ota_http_write_chunk_to_flash(ctx, &http_chunk_info);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            return result;
+        }
+        ctx->block_reuse.reused_bytes += http_chunk_info.size;
+        *range_start += http_chunk_info.size;
+    }
+
+    *range_end = *range_start + ctx->http.range_stats.current_size - 1;
+    next = cy_ota_storage_block_reuse_next(ctx, *range_start + 1);
+    if (*range_end >= next)
+    {
+        *range_end = next - 1;
+    }
+    if (*range_end >= ctx->total_image_size)
+    {
+        *range_end = ctx->total_image_size - 1;
+    }
+    return CY_RSLT_SUCCESS;
+}
+#endif  /* CY_OTA_BLOCK_REUSE == 1 */
+
+#if (CY_OTA_HTTP_STREAMING == 1) || ( (CY_OTA_HTTP_RANGE_WINDOW > 1) && (CY_OTA_HTTP_CONNECTIONS == 1) )
+/**
+ * @brief Open a plain TCP socket to the current server
+ *
+ * Used by streaming and pipelined range requests, which read the responses
+ * themselves instead of going through the HTTP client.
+ *
+ * @param[in]   ctx  - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[out]  sock - connected socket, close with cy_ota_http_socket_close()
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GET_DATA
+ */
+static cy_rslt_t cy_ota_http_socket_open(cy_ota_context_t *ctx, cy_socket_t *sock)
+{
+    cy_rslt_t               result;
+    cy_socket_sockaddr_t    address;
+    uint32_t                timeout_ms = CY_OTA_HTTP_TIMEOUT_RECEIVE;
+
+    memset(&address, 0x00, sizeof(address));
+    if (cy_socket_gethostbyname(ctx->curr_server->host_name, CY_SOCKET_IP_VER_V4, &address.ip_address) != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_socket_gethostbyname(%s) failed\n", __func__, ctx->curr_server->host_name);
+        return CY_RSLT_OTA_ERROR_GET_DATA;
+    }
+    address.port = ctx->curr_server->port;
+
+    if (cy_socket_init() != CY_RSLT_SUCCESS)
+    {
+        return CY_RSLT_OTA_ERROR_GET_DATA;
+    }
+    result = cy_socket_create(CY_SOCKET_DOMAIN_AF_INET, CY_SOCKET_TYPE_STREAM, CY_SOCKET_IPPROTO_TCP, sock);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_socket_create() failed 0x%lx\n", __func__, result);
+        cy_socket_deinit();
+        return CY_RSLT_OTA_ERROR_GET_DATA;
+    }
+    cy_socket_setsockopt(*sock, CY_SOCKET_SOL_SOCKET, CY_SOCKET_SO_RCVTIMEO, &timeout_ms, sizeof(timeout_ms));
+
+    result = cy_socket_connect(*sock, &address, sizeof(cy_socket_sockaddr_t));
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_socket_connect() failed 0x%lx\n", __func__, result);
+        cy_socket_delete(*sock);
+        cy_socket_deinit();
+        return CY_RSLT_OTA_ERROR_GET_DATA;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Close a socket from cy_ota_http_socket_open()
+ *
+ * @param[in]   sock - socket to close
+ */
+static void cy_ota_http_socket_close(cy_socket_t sock)
+{
+    cy_socket_disconnect(sock, 0);
+    cy_socket_delete(sock);
+    cy_socket_deinit();
+}
+#endif  /* CY_OTA_HTTP_STREAMING || pipelined range requests */
+
+#if (CY_OTA_HTTP_STREAMING == 1)
+/**
+ * @brief Get the whole OTA Image with one GET request
+ *
+ * Opens a separate TCP socket to the server, sends one GET without a range,
+ * parses the response header once and hands the body to storage in
+ * CY_OTA_CHUNK_SIZE pieces as it arrives.
+ *
+ * If the connection breaks, the data written so far is kept and the caller
+ * gets the rest with range requests starting at ctx->total_bytes_written.
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GET_DATA              - no data or connection broken, use range requests
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ *          CY_RSLT_OTA_ERROR_APP_RETURNED_STOP
+ */
+static cy_rslt_t cy_ota_http_stream_data(cy_ota_context_t *ctx)
+{
+    cy_rslt_t               result;
+    cy_socket_t             sock = NULL;
+    uint32_t                bytes_sent;
+    uint32_t                bytes_received;
+    uint32_t                fill = 0;
+    cy_http_header_parser_t header;
+    cy_http_header_result_t header_result = CY_HTTP_HEADER_NEED_MORE;
+
+    if (cy_ota_http_socket_open(ctx, &sock) != CY_RSLT_SUCCESS)
+    {
+        return CY_RSLT_OTA_ERROR_GET_DATA;
+    }
+
+    /* one GET for the whole file */
+    memset(ctx->http.json_doc, 0x00, sizeof(ctx->http.json_doc));
+    snprintf(ctx->http.json_doc, sizeof(ctx->http.json_doc), CY_OTA_HTTP_GET_TEMPLATE,
+             ctx->http.file, ctx->curr_server->host_name, ctx->curr_server->port);
+    result = cy_socket_send(sock, ctx->http.json_doc, strlen(ctx->http.json_doc), CY_SOCKET_FLAGS_NONE, &bytes_sent);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_socket_send() failed 0x%lx\n", __func__, result);
+        result = CY_RSLT_OTA_ERROR_GET_DATA;
+        goto _stream_exit;
+    }
+
+    /* parse the response header as it arrives, the body follows it in chunk_buffer */
+    cy_http_header_init(&header);
+    while (header_result == CY_HTTP_HEADER_NEED_MORE)
+    {
+        if (fill >= CY_OTA_CHUNK_SIZE)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() response header too large\n", __func__);
+            result = CY_RSLT_OTA_ERROR_GET_DATA;
+            goto _stream_exit;
+        }
+        result = cy_socket_recv(sock, &ctx->chunk_buffer[fill], (CY_OTA_CHUNK_SIZE - fill), CY_SOCKET_FLAGS_NONE, &bytes_received);
+        if ( (result != CY_RSLT_SUCCESS) || (bytes_received == 0) )
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_socket_recv() header failed 0x%lx\n", __func__, result);
+            result = CY_RSLT_OTA_ERROR_GET_DATA;
+            goto _stream_exit;
+        }
+        header_result = cy_http_header_parse(&header, &ctx->chunk_buffer[fill], bytes_received, NULL);
+        fill += bytes_received;
+    }
+
+    if ( (header_result != CY_HTTP_HEADER_DONE) || (header.status_code != HTTP_RESPONSE_OK) ||
+         !header.has_content_length || (header.content_length == 0) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() no stream, response code:%d file_len:%ld\n", __func__,
+                   header.status_code, header.content_length);
+        result = CY_RSLT_OTA_ERROR_GET_DATA;
+        goto _stream_exit;
+    }
+    ctx->total_image_size = header.content_length;
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() streaming %ld bytes\n", __func__, header.content_length);
+
+    /* move the start of the body to the front of the buffer */
+    fill -= header.header_len;
+    memmove(ctx->chunk_buffer, &ctx->chunk_buffer[header.header_len], fill);
+    ctx->http.range_stats.stream_bytes += fill;
+
+    while ( (ctx->total_bytes_written + fill) < ctx->total_image_size)
+    {
+        if (fill < CY_OTA_CHUNK_SIZE)
+        {
+            uint32_t want = CY_OTA_CHUNK_SIZE - fill;
+            if (want > (ctx->total_image_size - ctx->total_bytes_written - fill) )
+            {
+                want = ctx->total_image_size - ctx->total_bytes_written - fill;
+            }
+            result = cy_socket_recv(sock, &ctx->chunk_buffer[fill], want, CY_SOCKET_FLAGS_NONE, &bytes_received);
+            if ( (result != CY_RSLT_SUCCESS) || (bytes_received == 0) )
+            {
+                cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() connection broken at %ld of %ld\n", __func__,
+                           (ctx->total_bytes_written + fill), ctx->total_image_size);
+                result = CY_RSLT_OTA_ERROR_GET_DATA;
+                break;
+            }
+            fill += bytes_received;
+            ctx->http.range_stats.stream_bytes += bytes_received;
+            if (fill < CY_OTA_CHUNK_SIZE)
+            {
+                continue;
+            }
+        }
+
+        /* full chunk */
+        http_chunk_info.offset     = ctx->total_bytes_written;
+        http_chunk_info.buffer     = ctx->chunk_buffer;
+        http_chunk_info.size       = CY_OTA_CHUNK_SIZE;
+        http_chunk_info.total_size = ctx->total_image_size;
+        result = cy_ota_http_write_chunk_to_flash(ctx, &http_chunk_info);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            goto _stream_exit;
+        }
+        fill -= CY_OTA_CHUNK_SIZE;
+        memmove(ctx->chunk_buffer, &ctx->chunk_buffer[CY_OTA_CHUNK_SIZE], fill);
+
+        if (ctx->packet_timeout_sec > 0 )
+        {
+            cy_ota_start_http_timer(ctx, ctx->packet_timeout_sec, CY_OTA_EVENT_PACKET_TIMEOUT);
+        }
+    }
+
+    /* last (or only) partial chunk - for a broken connection, keep what we have */
+    if (fill > 0)
+    {
+        cy_rslt_t write_result;
+
+        http_chunk_info.offset     = ctx->total_bytes_written;
+        http_chunk_info.buffer     = ctx->chunk_buffer;
+        http_chunk_info.size       = fill;
+        http_chunk_info.total_size = ctx->total_image_size;
+        write_result = cy_ota_http_write_chunk_to_flash(ctx, &http_chunk_info);
+        if (write_result != CY_RSLT_SUCCESS)
+        {
+            result = write_result;
+        }
+    }
+
+_stream_exit:
+    cy_ota_http_socket_close(sock);
+
+    return result;
+}
+#endif  /* CY_OTA_HTTP_STREAMING */
+
+#if (CY_OTA_HTTP_RANGE_WINDOW > 1) && (CY_OTA_HTTP_CONNECTIONS == 1)
+/**
+ * @brief Send range requests until CY_OTA_HTTP_RANGE_WINDOW are in flight
+ *
+ * Until a response has given the OTA Image size, only one request is kept in flight.
+ *
+ * @param[in]       ctx         - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]       sock        - socket from cy_ota_http_socket_open()
+ * @param[in,out]   next_offset - offset of the next range to request
+ * @param[in,out]   in_flight   - requests sent and not answered yet
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GET_DATA
+ */
+static cy_rslt_t cy_ota_http_pipeline_send(cy_ota_context_t *ctx, cy_socket_t sock,
+                                           uint32_t *next_offset, uint32_t *in_flight)
+{
+    uint32_t    range_end;
+    uint32_t    bytes_sent;
+    int         len;
+
+    while ( (*in_flight < CY_OTA_HTTP_RANGE_WINDOW) &&
+            ( (ctx->total_image_size == 0) ? (*in_flight == 0) : (*next_offset < ctx->total_image_size) ) )
+    {
+        range_end = *next_offset + CY_OTA_CHUNK_SIZE - 1;
+        if ( (ctx->total_image_size > 0) && (range_end >= ctx->total_image_size) )
+        {
+            range_end = ctx->total_image_size - 1;
+        }
+
+        len = snprintf(ctx->http.json_doc, sizeof(ctx->http.json_doc), CY_OTA_HTTP_GET_RANGE_TEMPLATE,
+                       ctx->http.file, ctx->curr_server->host_name, ctx->curr_server->port,
+                       (long)*next_offset, (long)range_end);
+        if ( (len <= 0) || ((size_t)len >= sizeof(ctx->http.json_doc)) )
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() range request too large for buffer\n", __func__);
+            return CY_RSLT_OTA_ERROR_GET_DATA;
+        }
+        if ( (cy_socket_send(sock, ctx->http.json_doc, (uint32_t)len, CY_SOCKET_FLAGS_NONE, &bytes_sent) != CY_RSLT_SUCCESS) ||
+             (bytes_sent != (uint32_t)len) )
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_socket_send() failed at offset %ld\n", __func__, *next_offset);
+            return CY_RSLT_OTA_ERROR_GET_DATA;
+        }
+        cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() sent range %ld-%ld, %ld in flight\n", __func__,
+                   *next_offset, range_end, (*in_flight + 1));
+
+        *next_offset = range_end + 1;
+        (*in_flight)++;
+        ctx->http.range_stats.requests++;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Get the OTA Image with pipelined range requests
+ *
+ * Opens a separate TCP socket to the server and keeps CY_OTA_HTTP_RANGE_WINDOW
+ * range requests of CY_OTA_CHUNK_SIZE in flight, so the round trip time is paid
+ * once per window instead of once per chunk. The responses come back in order;
+ * each is checked against the range asked for and written to storage before the
+ * next request is sent.
+ *
+ * Starts at ctx->total_bytes_written. If the connection breaks, the data written
+ * so far is kept and the caller gets the rest with single range requests.
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GET_DATA              - bad response or connection broken, use single range requests
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ *          CY_RSLT_OTA_ERROR_APP_RETURNED_STOP
+ */
+static cy_rslt_t cy_ota_http_pipeline_data(cy_ota_context_t *ctx)
+{
+    cy_rslt_t               result = CY_RSLT_SUCCESS;
+    cy_socket_t             sock = NULL;
+    uint32_t                next_offset = ctx->total_bytes_written;
+    uint32_t                in_flight = 0;
+    uint32_t                fill = 0;
+    uint32_t                consumed;
+    uint32_t                expected;
+    uint32_t                bytes_received;
+    cy_http_header_parser_t header;
+    cy_http_header_result_t header_result;
+
+    if (cy_ota_http_socket_open(ctx, &sock) != CY_RSLT_SUCCESS)
+    {
+        return CY_RSLT_OTA_ERROR_GET_DATA;
+    }
+
+    while ( (ctx->total_image_size == 0) || (ctx->total_bytes_written < ctx->total_image_size) )
+    {
+        result = cy_ota_http_pipeline_send(ctx, sock, &next_offset, &in_flight);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            break;
+        }
+
+        /* Header of the oldest response. chunk_buffer may already hold the start
+         * of it, read past the end of the previous body.
+         */
+        cy_http_header_init(&header);
+        header_result = CY_HTTP_HEADER_NEED_MORE;
+        consumed = 0;
+        if (fill > 0)
+        {
+            header_result = cy_http_header_parse(&header, ctx->chunk_buffer, fill, &consumed);
+        }
+        while (header_result == CY_HTTP_HEADER_NEED_MORE)
+        {
+            result = cy_socket_recv(sock, ctx->chunk_buffer, sizeof(ctx->chunk_buffer), CY_SOCKET_FLAGS_NONE, &bytes_received);
+            if ( (result != CY_RSLT_SUCCESS) || (bytes_received == 0) )
+            {
+                cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() cy_socket_recv() header failed 0x%lx\n", __func__, result);
+                result = CY_RSLT_OTA_ERROR_GET_DATA;
+                goto _pipeline_exit;
+            }
+            fill = bytes_received;
+            header_result = cy_http_header_parse(&header, ctx->chunk_buffer, fill, &consumed);
+        }
+        fill -= consumed;
+        memmove(ctx->chunk_buffer, &ctx->chunk_buffer[consumed], fill);
+
+        if ( (header_result != CY_HTTP_HEADER_DONE) || (header.status_code != HTTP_PARTIAL_CONTENT) ||
+             !header.has_content_range || !header.has_content_length ||
+             (header.range_start != ctx->total_bytes_written) || (header.range_total == 0) ||
+             (header.content_length != (header.range_end - header.range_start + 1)) )
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() unexpected response code:%d range:%ld-%ld/%ld at %ld\n", __func__,
+                       header.status_code, header.range_start, header.range_end, header.range_total, ctx->total_bytes_written);
+            result = CY_RSLT_OTA_ERROR_GET_DATA;
+            break;
+        }
+        if (ctx->total_image_size == 0)
+        {
+            ctx->total_image_size = header.range_total;
+            cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() %ld bytes, %d ranges in flight\n", __func__,
+                       ctx->total_image_size, CY_OTA_HTTP_RANGE_WINDOW);
+        }
+        expected = ctx->total_image_size - ctx->total_bytes_written;
+        if (expected > CY_OTA_CHUNK_SIZE)
+        {
+            expected = CY_OTA_CHUNK_SIZE;
+        }
+        if (header.content_length != expected)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() got %ld bytes at %ld, asked for %ld\n", __func__,
+                       header.content_length, ctx->total_bytes_written, expected);
+            result = CY_RSLT_OTA_ERROR_GET_DATA;
+            break;
+        }
+
+        /* body - the next response may follow it in the same read */
+        while (fill < expected)
+        {
+            result = cy_socket_recv(sock, &ctx->chunk_buffer[fill], (sizeof(ctx->chunk_buffer) - fill),
+                                    CY_SOCKET_FLAGS_NONE, &bytes_received);
+            if ( (result != CY_RSLT_SUCCESS) || (bytes_received == 0) )
+            {
+                cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() connection broken at %ld of %ld\n", __func__,
+                           (ctx->total_bytes_written + fill), ctx->total_image_size);
+                result = CY_RSLT_OTA_ERROR_GET_DATA;
+                goto _pipeline_exit;
+            }
+            fill += bytes_received;
+        }
+
+        http_chunk_info.offset     = ctx->total_bytes_written;
+        http_chunk_info.buffer     = ctx->chunk_buffer;
+        http_chunk_info.size       = expected;
+        http_chunk_info.total_size = ctx->total_image_size;
+        result = cy_ota_http_write_chunk_to_flash(ctx, &http_chunk_info);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            break;
+        }
+        ctx->http.range_stats.pipelined_bytes += expected;
+        in_flight--;
+        fill -= expected;
+        memmove(ctx->chunk_buffer, &ctx->chunk_buffer[expected], fill);
+
+        if (ctx->packet_timeout_sec > 0 )
+        {
+            cy_ota_start_http_timer(ctx, ctx->packet_timeout_sec, CY_OTA_EVENT_PACKET_TIMEOUT);
+        }
+    }
+
+_pipeline_exit:
+    cy_ota_http_socket_close(sock);
+
+    return result;
+}
+#endif  /* CY_OTA_HTTP_RANGE_WINDOW > 1 && CY_OTA_HTTP_CONNECTIONS == 1 */
+
+#if (CY_OTA_HTTP_CONNECTIONS > 1)
+/**
+ * @brief Get one mirror from the Job document "Mirrors" list
+ *
+ * The list is "<host>[:<port>],<host>[:<port>],..."
+ *
+ * @param[in]   list        - mirrors from the Job document
+ * @param[in]   index       - 0 for the first mirror
+ * @param[out]  host        - host name
+ * @param[in]   host_len    - size of host buffer
+ * @param[out]  port        - port, unchanged if not in the list
+ *
+ * @return  true if the mirror is in the list
+ */
+static bool cy_ota_http_get_mirror(const char *list, uint32_t index, char *host, uint32_t host_len, uint16_t *port)
+{
+    const char  *start = list;
+    const char  *end;
+    const char  *colon;
+    uint32_t    len;
+
+    while (*start != 0)
+    {
+        while (*start == ' ')
+        {
+            start++;
+        }
+        end = strchr(start, ',');
+        if (end == NULL)
+        {
+            end = start + strlen(start);
+        }
+        if ( (end > start) && (index-- == 0) )
+        {
+            colon = memchr(start, ':', (end - start));
+            len = (colon != NULL) ? (colon - start) : (end - start);
+            if ( (len == 0) || (len >= host_len) )
+            {
+                return false;
+            }
+            memcpy(host, start, len);
+            host[len] = 0;
+            if (colon != NULL)
+            {
+                *port = (uint16_t)atoi(colon + 1);
+            }
+            return true;
+        }
+        start = (*end == ',') ? (end + 1) : end;
+    }
+    return false;
+}
+
+/**
+ * @brief Open the connection for one parallel download slot
+ *
+ * Slot 0 uses the main connection. The other slots go to the Server and the
+ * Job document mirrors in turn, with the credentials of the main connection.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   slot    - parallel download slot
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_CONNECT
+ */
+static cy_rslt_t cy_ota_http_fetch_connect(cy_ota_context_t *ctx, cy_ota_http_fetch_slot_t *slot)
+{
+    cy_rslt_t   result;
+    uint32_t    num_mirrors = 0;
+    uint32_t    mirror;
+    uint16_t    port;
+
+    if (slot->index == 0)
+    {
+        slot->connection = ctx->http.connection;
+        slot->own_connection = false;
+        return CY_RSLT_SUCCESS;
+    }
+
+    memcpy(&slot->server, ctx->http.server_info, sizeof(slot->server));
+    if (ctx->network_params.use_get_job_flow == CY_OTA_JOB_FLOW)
+    {
+        while ( (num_mirrors < CY_OTA_HTTP_CONNECTIONS) &&
+                (cy_ota_http_get_mirror(ctx->parsed_job.mirrors, num_mirrors, slot->host, sizeof(slot->host), &port) == true) )
+        {
+            num_mirrors++;
+        }
+
+        /* 0 is the Server from the Job document, then the mirrors in turn */
+        mirror = slot->index % (num_mirrors + 1);
+        if ( (mirror != 0) &&
+             (cy_ota_http_get_mirror(ctx->parsed_job.mirrors, mirror - 1, slot->host, sizeof(slot->host), &slot->server.port) == true) )
+        {
+            slot->server.host_name = slot->host;
+        }
+    }
+
+    result = cy_http_client_create(ctx->http.security, &slot->server, cy_ota_http_disconnect_callback, ctx, &slot->connection);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_http_client_create() %s failed 0x%lx\n", __func__, slot->server.host_name, result);
+        return CY_RSLT_OTA_ERROR_CONNECT;
+    }
+    result = cy_http_client_connect(slot->connection, CY_OTA_HTTP_TIMEOUT_SEND, CY_OTA_HTTP_TIMEOUT_RECEIVE);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_http_client_connect() %s failed 0x%lx\n", __func__, slot->server.host_name, result);
+        cy_http_client_delete(slot->connection);
+        return CY_RSLT_OTA_ERROR_CONNECT;
+    }
+    slot->own_connection = true;
+
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() slot %d server:%s:%d\n", __func__, slot->index, slot->server.host_name, slot->server.port);
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Give a range back, it is claimed again before any new range
+ *
+ * Call with the fetch mutex held.
+ *
+ * A range is given back only by the slot that holds it, and a slot holds at most
+ * one range, so requeue[] never has more than CY_OTA_HTTP_CONNECTIONS entries.
+ * Should that ever not hold, the ranges are not lost: the slots stop and the
+ * caller fetches the rest of the image on the main connection.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   offset  - offset of the range
+ */
+static void cy_ota_http_fetch_requeue(cy_ota_context_t *ctx, uint32_t offset)
+{
+    cy_ota_http_fetch_t *fetch = &ctx->http.fetch;
+
+    CY_ASSERT(fetch->num_requeue < CY_OTA_HTTP_CONNECTIONS);
+    if (fetch->num_requeue >= CY_OTA_HTTP_CONNECTIONS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() no room to give back 0x%lx, continue on one connection\n", __func__, offset);
+        fetch->stop = true;
+        return;
+    }
+    fetch->requeue[fetch->num_requeue++] = offset;
+    ctx->http.range_stats.requeued++;
+}
+
+/**
+ * @brief Claim the next range for a slot
+ *
+ * Ranges given back are claimed first, lowest offset first.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   slot    - parallel download slot
+ *
+ * @return  true if the slot has a range to fetch
+ */
+static bool cy_ota_http_fetch_claim(cy_ota_context_t *ctx, cy_ota_http_fetch_slot_t *slot)
+{
+    cy_ota_http_fetch_t *fetch = &ctx->http.fetch;
+    bool                claimed = false;
+    uint8_t             i;
+    uint8_t             lowest;
+
+    cy_rtos_get_mutex(&fetch->mutex, CY_RTOS_NEVER_TIMEOUT);
+    if (fetch->stop == false)
+    {
+        if (fetch->num_requeue > 0)
+        {
+            lowest = 0;
+            for (i = 1; i < fetch->num_requeue; i++)
+            {
+                if (fetch->requeue[i] < fetch->requeue[lowest])
+                {
+                    lowest = i;
+                }
+            }
+            slot->offset = fetch->requeue[lowest];
+            fetch->requeue[lowest] = fetch->requeue[--fetch->num_requeue];
+            claimed = true;
+        }
+        else if (fetch->next_offset < ctx->total_image_size)
+        {
+            slot->offset = fetch->next_offset;
+            fetch->next_offset += CY_OTA_HTTP_RANGE_SPAN;
+            claimed = true;
+        }
+    }
+    if (claimed)
+    {
+        slot->size = ctx->total_image_size - slot->offset;
+        if (slot->size > CY_OTA_HTTP_RANGE_SPAN)
+        {
+            slot->size = CY_OTA_HTTP_RANGE_SPAN;
+        }
+        slot->state = CY_OTA_HTTP_FETCH_BUSY;
+    }
+    cy_rtos_set_mutex(&fetch->mutex);
+
+    return claimed;
+}
+
+/**
+ * @brief Check if a slot is much slower than the fastest working slot
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   slot    - parallel download slot
+ *
+ * @return  true if the slot should stop
+ */
+static bool cy_ota_http_fetch_too_slow(cy_ota_context_t *ctx, cy_ota_http_fetch_slot_t *slot)
+{
+    cy_ota_http_fetch_t *fetch = &ctx->http.fetch;
+    uint32_t            fastest = 0;
+    uint8_t             i;
+
+    if (slot->requests == 0)
+    {
+        return false;
+    }
+    for (i = 0; i < CY_OTA_HTTP_CONNECTIONS; i++)
+    {
+        if ( (&fetch->slots[i] != slot) && (fetch->slots[i].state != CY_OTA_HTTP_FETCH_STOPPED) &&
+             (fetch->slots[i].requests > 0) && ( (fastest == 0) || (fetch->slots[i].avg_ms < fastest) ) )
+        {
+            fastest = fetch->slots[i].avg_ms;
+        }
+    }
+    return ( (fastest > 0) && (slot->avg_ms > (fastest * CY_OTA_HTTP_SLOW_FACTOR)) );
+}
+
+/**
+ * @brief Send one range request on a slot connection
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   slot    - parallel download slot, slot->body is set on success
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GET_DATA
+ */
+static cy_rslt_t cy_ota_http_fetch_range(cy_ota_context_t *ctx, cy_ota_http_fetch_slot_t *slot)
+{
+    cy_rslt_t                       result;
+    cy_http_client_request_header_t request;
+    cy_http_client_response_t       response;
+    char                            range_value[CY_HTTP_HEADER_VALUE_LEN];
+    cy_http_client_header_t         read_header =
+    {
+        HTTP_HEADER_CONTENT_RANGE, sizeof(HTTP_HEADER_CONTENT_RANGE) - 1, range_value, sizeof(range_value)
+    };
+
+    memset(&request, 0x00, sizeof(request));
+    memset(&response, 0x00, sizeof(response));
+    request.method        = CY_HTTP_CLIENT_METHOD_GET;
+    request.resource_path = ctx->http.file;
+    request.buffer        = slot->buffer;
+    request.buffer_len    = CY_OTA_CHUNK_BUFFER_SIZE;
+    request.range_start   = slot->offset;
+    request.range_end     = slot->offset + slot->size - 1;
+
+    result = cy_http_client_write_header(slot->connection, &request, cy_ota_http_data_headers, CY_NUM_DATA_HEADERS);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = cy_http_client_send(slot->connection, &request, NULL, 0, &response);
+    }
+    if (result == CY_RSLT_SUCCESS)
+    {
+        result = cy_http_client_read_header(slot->connection, &response, &read_header, 1);
+    }
+    if ( (result != CY_RSLT_SUCCESS) || (response.status_code < 200) || (response.status_code >= 300) ||
+         (response.body_len != slot->size) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() slot %d range 0x%lx failed 0x%lx status:%d len:%ld\n", __func__,
+                   slot->index, slot->offset, result, response.status_code, response.body_len);
+        return CY_RSLT_OTA_ERROR_GET_DATA;
+    }
+
+    slot->body = (uint8_t *)response.body;
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Parallel download thread, one per slot
+ *
+ * Claims ranges and fetches them into the slot buffer, then waits for the OTA Agent
+ * thread to write the buffer. A range that still fails after CY_OTA_HTTP_RANGE_RETRIES
+ * reconnects is given back and the slot stops.
+ *
+ * @param[in]   arg - pointer to slot @ref cy_ota_http_fetch_slot_t
+ */
+static void cy_ota_http_fetch_thread(cy_thread_arg_t arg)
+{
+    cy_ota_http_fetch_slot_t    *slot = (cy_ota_http_fetch_slot_t *)arg;
+    cy_ota_context_t            *ctx = slot->ctx;
+    cy_ota_http_fetch_t         *fetch = &ctx->http.fetch;
+    cy_rslt_t                   result = CY_RSLT_SUCCESS;
+    cy_time_t                   request_start;
+    cy_time_t                   request_end;
+    uint32_t                    request_ms;
+    uint32_t                    retries;
+
+    while (cy_ota_http_fetch_claim(ctx, slot))
+    {
+        for (retries = 0; ; retries++)
+        {
+            cy_rtos_get_time(&request_start);
+            result = cy_ota_http_fetch_range(ctx, slot);
+            cy_rtos_get_time(&request_end);
+            if ( (result == CY_RSLT_SUCCESS) || (fetch->stop) || (retries >= CY_OTA_HTTP_RANGE_RETRIES) )
+            {
+                break;
+            }
+            cy_http_client_disconnect(slot->connection);
+            if (cy_http_client_connect(slot->connection, CY_OTA_HTTP_TIMEOUT_SEND, CY_OTA_HTTP_TIMEOUT_RECEIVE) != CY_RSLT_SUCCESS)
+            {
+                break;
+            }
+        }
+
+        if (result != CY_RSLT_SUCCESS)
+        {
+            cy_rtos_get_mutex(&fetch->mutex, CY_RTOS_NEVER_TIMEOUT);
+            cy_ota_http_fetch_requeue(ctx, slot->offset);
+            cy_rtos_set_mutex(&fetch->mutex);
+            break;
+        }
+
+        request_ms = (uint32_t)(request_end - request_start);
+        slot->avg_ms = (slot->requests == 0) ? request_ms :
+                       ( (slot->avg_ms * CY_OTA_HTTP_RANGE_AVG_WEIGHT) + request_ms) / (CY_OTA_HTTP_RANGE_AVG_WEIGHT + 1);
+        slot->requests++;
+
+        slot->state = CY_OTA_HTTP_FETCH_READY;
+        cy_rtos_set_semaphore(&fetch->ready_sem, false);
+
+        /* wait for the buffer to be written (or given back) */
+        cy_rtos_get_semaphore(&slot->free_sem, CY_RTOS_NEVER_TIMEOUT, false);
+        if (fetch->stop)
+        {
+            break;
+        }
+
+        if (cy_ota_http_fetch_too_slow(ctx, slot))
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() slot %d %s too slow (%ld ms), stop using it\n", __func__,
+                       slot->index, slot->server.host_name, slot->avg_ms);
+            ctx->http.range_stats.parked++;
+            break;
+        }
+    }
+
+    slot->state = CY_OTA_HTTP_FETCH_STOPPED;
+    cy_rtos_set_semaphore(&fetch->ready_sem, false);
+
+    cy_rtos_exit_thread();
+}
+
+/**
+ * @brief Fetch the rest of the image on CY_OTA_HTTP_CONNECTIONS connections
+ *
+ * Starts at ctx->total_bytes_written, ctx->total_image_size must be known.
+ * The ranges are written in order from this (the OTA Agent) thread.
+ * Returns when the image is complete, when no connection is left, or when the slots
+ * were stopped. The caller then continues on the main connection from
+ * ctx->total_bytes_written.
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_APP_RETURNED_STOP
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+static cy_rslt_t cy_ota_http_fetch_parallel(cy_ota_context_t *ctx)
+{
+    cy_ota_http_fetch_t         *fetch = &ctx->http.fetch;
+    cy_ota_http_fetch_slot_t    *slot;
+    cy_ota_http_fetch_slot_t    *victim;
+    cy_rslt_t                   result = CY_RSLT_SUCCESS;
+    uint8_t                     *body;
+    uint32_t                    body_len;
+    bool                        working;
+    bool                        alive;
+    uint8_t                     i;
+
+    memset(fetch, 0x00, offsetof(cy_ota_http_fetch_t, buffers));
+    fetch->next_offset = ctx->total_bytes_written;
+
+    if (cy_rtos_init_mutex(&fetch->mutex) != CY_RSLT_SUCCESS)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+    if (cy_rtos_init_semaphore(&fetch->ready_sem, (CY_OTA_HTTP_CONNECTIONS * 2), 0) != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&fetch->mutex);
+        return CY_RSLT_SUCCESS;
+    }
+
+    for (i = 0; i < CY_OTA_HTTP_CONNECTIONS; i++)
+    {
+        slot = &fetch->slots[i];
+        slot->ctx    = ctx;
+        slot->index  = i;
+        slot->buffer = (i == 0) ? ctx->chunk_buffer : fetch->buffers[i - 1];
+        slot->state  = CY_OTA_HTTP_FETCH_STOPPED;
+        if (cy_rtos_init_semaphore(&slot->free_sem, 1, 0) != CY_RSLT_SUCCESS)
+        {
+            continue;
+        }
+        if (cy_ota_http_fetch_connect(ctx, slot) != CY_RSLT_SUCCESS)
+        {
+            continue;
+        }
+        slot->state = CY_OTA_HTTP_FETCH_IDLE;
+        if (cy_rtos_create_thread(&slot->thread, cy_ota_http_fetch_thread, OTA_HTTP_FETCH_THREAD_NAME, NULL,
+                                  CY_OTA_HTTP_FETCH_THREAD_STACK_SIZE, CY_RTOS_PRIORITY_NORMAL, slot) != CY_RSLT_SUCCESS)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_rtos_create_thread() slot %d failed\n", __func__, i);
+            slot->state = CY_OTA_HTTP_FETCH_STOPPED;
+            continue;
+        }
+        slot->thread_running = true;
+        ctx->http.range_stats.connections++;
+    }
+    cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Parallel download from %ld on %ld connections\n",
+               ctx->total_bytes_written, ctx->http.range_stats.connections);
+
+    while ( (ctx->total_bytes_written < ctx->total_image_size) && (fetch->stop == false) )
+    {
+        /* write the range that comes next, if a slot has it */
+        slot = NULL;
+        for (i = 0; i < CY_OTA_HTTP_CONNECTIONS; i++)
+        {
+            if ( (fetch->slots[i].state == CY_OTA_HTTP_FETCH_READY) &&
+                 (fetch->slots[i].offset == ctx->total_bytes_written) )
+            {
+                slot = &fetch->slots[i];
+                break;
+            }
+        }
+
+        if (slot != NULL)
+        {
+            body     = slot->body;
+            body_len = slot->size;
+            while (body_len > 0)
+            {
+                http_chunk_info.offset     = ctx->total_bytes_written;
+                http_chunk_info.buffer     = body;
+                http_chunk_info.size       = (body_len > CY_OTA_CHUNK_SIZE) ? CY_OTA_CHUNK_SIZE : body_len;
+                http_chunk_info.total_size = ctx->total_image_size;
+                result = cy_ota_http_write_chunk_to_flash(ctx, &http_chunk_info);
+                if (result != CY_RSLT_SUCCESS)
+                {
+                    break;
+                }
+                body     += http_chunk_info.size;
+                body_len -= http_chunk_info.size;
+            }
+            ctx->http.range_stats.parallel_bytes += (slot->size - body_len);
+
+            slot->state = CY_OTA_HTTP_FETCH_IDLE;
+            cy_rtos_set_semaphore(&slot->free_sem, false);
+            if (result != CY_RSLT_SUCCESS)
+            {
+                break;
+            }
+
+            if (ctx->packet_timeout_sec > 0 )
+            {
+                cy_ota_start_http_timer(ctx, ctx->packet_timeout_sec, CY_OTA_EVENT_PACKET_TIMEOUT);
+            }
+            continue;
+        }
+
+        cy_rtos_get_mutex(&fetch->mutex, CY_RTOS_NEVER_TIMEOUT);
+        working = false;
+        alive   = false;
+        victim  = NULL;
+        for (i = 0; i < CY_OTA_HTTP_CONNECTIONS; i++)
+        {
+            if (fetch->slots[i].state != CY_OTA_HTTP_FETCH_STOPPED)
+            {
+                alive = true;
+            }
+            if ( (fetch->slots[i].state == CY_OTA_HTTP_FETCH_IDLE) || (fetch->slots[i].state == CY_OTA_HTTP_FETCH_BUSY) )
+            {
+                working = true;
+            }
+            if ( (fetch->slots[i].state == CY_OTA_HTTP_FETCH_READY) &&
+                 ( (victim == NULL) || (fetch->slots[i].offset > victim->offset) ) )
+            {
+                victim = &fetch->slots[i];
+            }
+        }
+        if ( (alive == true) && (working == false) && (victim != NULL) )
+        {
+            /* Every slot holds a later range while the next one was given up - free the latest */
+            cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() slot %d gives back 0x%lx\n", __func__, victim->index, victim->offset);
+            cy_ota_http_fetch_requeue(ctx, victim->offset);
+            victim->state = CY_OTA_HTTP_FETCH_IDLE;
+            cy_rtos_set_semaphore(&victim->free_sem, false);
+        }
+        cy_rtos_set_mutex(&fetch->mutex);
+
+        if (alive == false)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() no connection left at %ld\n", __func__, ctx->total_bytes_written);
+            break;
+        }
+        cy_rtos_get_semaphore(&fetch->ready_sem, CY_OTA_HTTP_TIMEOUT_RECEIVE, false);
+    }
+
+    /* stop the slots */
+    cy_rtos_get_mutex(&fetch->mutex, CY_RTOS_NEVER_TIMEOUT);
+    fetch->stop = true;
+    cy_rtos_set_mutex(&fetch->mutex);
+    for (i = 0; i < CY_OTA_HTTP_CONNECTIONS; i++)
+    {
+        slot = &fetch->slots[i];
+        if (slot->thread_running)
+        {
+            cy_rtos_set_semaphore(&slot->free_sem, false);
+            cy_rtos_join_thread(&slot->thread);
+            slot->thread_running = false;
+        }
+        if (slot->own_connection)
+        {
+            cy_http_client_disconnect(slot->connection);
+            cy_http_client_delete(slot->connection);
+            slot->own_connection = false;
+        }
+        cy_rtos_deinit_semaphore(&slot->free_sem);
+    }
+    cy_rtos_deinit_semaphore(&fetch->ready_sem);
+    cy_rtos_deinit_mutex(&fetch->mutex);
+
+    return result;
+}
+#endif  /* CY_OTA_HTTP_CONNECTIONS > 1 */
+
+/**
+ * @brief get the OTA download
+ *
+ * NOTE: Individual Network Connection type will do whatever is necessary
+ *      ex: MQTT
+ *          - subscribe to start data transfer
+ *          HTTP
+ *          - pull the data from the server
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GENERAL
+ */
+cy_rslt_t cy_ota_http_get_data(cy_ota_context_t *ctx)
+{
+    cy_rslt_t       result;
+    uint32_t        waitfor_clear;
+    uint32_t        range_start;
+    uint32_t        range_end;
+    uint32_t        retries;
+    cy_time_t       request_start;
+    cy_time_t       request_end;
+#if (CY_OTA_HTTP_CONNECTIONS > 1)
+    bool            parallel_done = false;
+#endif
+#if (CY_OTA_BLOCK_REUSE == 1)
+    bool            manifest_done = false;
+#endif
+
+    cy_ota_callback_results_t   cb_result;
+
+    CY_OTA_CONTEXT_ASSERT(ctx);
+
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG2, "%s()\n", __func__);
+
+    if (cy_rtos_init_mutex(&ctx->sub_callback_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() sub_callback_mutex init failed\n", __func__);
+        return CY_RSLT_OTA_ERROR_GET_DATA;
+    }
+    ctx->sub_callback_mutex_inited = 1;
+
+    /* clear any lingering events */
+    waitfor_clear = CY_OTA_EVENT_HTTP_EVENTS;
+    result = cy_rtos_waitbits_event(&ctx->ota_event, &waitfor_clear, 1, 0, 1);
+    if (waitfor_clear != 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_DEBUG2, "%s() Clearing waitfor: 0x%lx\n", __func__, waitfor_clear);
+    }
+
+    result = cy_rtos_init_timer(&ctx->http.http_timer, CY_TIMER_TYPE_ONCE,
+                        cy_ota_http_timer_callback, (cy_timer_callback_arg_t)ctx);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        /* Timer init failed */
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Timer Create Failed!\n", __func__);
+        ctx->sub_callback_mutex_inited = 0;
+        cy_rtos_deinit_mutex(&ctx->sub_callback_mutex);
+        return CY_RSLT_OTA_ERROR_GET_DATA;
+    }
+
+    /* start with first window of data, or where an interrupted download left off */
+    cy_ota_http_range_init(ctx);
+    retries = 0;
+    range_start = ctx->total_bytes_written;
+    range_end = range_start + ctx->http.range_stats.current_size - 1; /* end byte, not length ! */
+    if ( (ctx->total_image_size > 0) && (range_end >= ctx->total_image_size) )
+    {
+        range_end = ctx->total_image_size - 1;
+    }
+
+    /* Form GET request - re-use data buffer to save some RAM */
+    memset(ctx->http.file, 0x00, sizeof(ctx->http.file));
+    memset(ctx->http.json_doc, 0x00, sizeof(ctx->http.json_doc));
+    if (ctx->network_params.use_get_job_flow == CY_OTA_DIRECT_FLOW)
+    {
+        /* Caller gave us the file name directly - use what is params */
+        strncpy(ctx->http.file, ctx->network_params.http.file, (sizeof(ctx->http.file) - 1) );
+        snprintf(ctx->http.json_doc, sizeof(ctx->http.json_doc), CY_OTA_HTTP_GET_RANGE_TEMPLATE,
+                ctx->http.file, ctx->curr_server->host_name, ctx->curr_server->port,
+                (long)range_start, (long)range_end);
+    }
+    else
+    {
+        /* We got the file name from the Job file.
+         * The Job redirect will have already changed the current server */
+        strncpy(ctx->http.file, ctx->parsed_job.file, (sizeof(ctx->http.file) - 1) );
+        snprintf(ctx->http.json_doc, sizeof(ctx->http.json_doc), CY_OTA_HTTP_GET_RANGE_TEMPLATE,
+                ctx->parsed_job.file, ctx->curr_server->host_name, ctx->curr_server->port,
+                (long)range_start, (long)range_end);
+    }
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%d : %s() CALLING CB STATE_CHANGE %s stop_OTA_session:%d\n", __LINE__, __func__,
+            cy_ota_get_state_string(ctx->curr_state), ctx->stop_OTA_session);
+
+    cb_result = cy_ota_internal_call_cb(ctx, CY_OTA_REASON_STATE_CHANGE, ctx->curr_state);
+    switch( cb_result )
+    {
+    case CY_OTA_CB_RSLT_OTA_CONTINUE:
+        /* Processing continues after switch() */
+        break;
+
+    default:
+    case CY_OTA_CB_RSLT_OTA_STOP:
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() App returned OTA Stop for STATE_CHANGE for DATA_DOWNLOAD\n", __func__);
+        result = CY_RSLT_OTA_ERROR_APP_RETURNED_STOP;
+        goto cleanup_and_exit;
+
+    case CY_OTA_CB_RSLT_APP_SUCCESS:
+        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%s() App returned APP_SUCCESS for STATE_CHANGE for DATA_DOWNLOAD\n", __func__);
+        result = CY_RSLT_SUCCESS;
+        goto cleanup_and_exit;
+
+    case CY_OTA_CB_RSLT_APP_FAILED:
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() App returned APP_FAILED for STATE_CHANGE for DATA_DOWNLOAD\n", __func__);
+        result = CY_RSLT_OTA_ERROR_GET_DATA;
+        goto cleanup_and_exit;
+
+    }
+
+#if (CY_OTA_HTTP_STREAMING == 1)
+    /* Streaming uses its own plain TCP socket, TLS and Application connections use range requests.
+     * A resumed download continues with range requests, as does one with a block manifest.
+     */
+    if ( (ctx->http.connection_from_app == false) && (ctx->http.connection_tls == false) &&
+         (ctx->total_bytes_written == 0)
+#if (CY_OTA_BLOCK_REUSE == 1)
+         && ( (ctx->network_params.use_get_job_flow == CY_OTA_DIRECT_FLOW) || (ctx->parsed_job.manifest[0] == 0x00) )
+#endif
+       )
+    {
+        result = cy_ota_http_stream_data(ctx);
+        if ( (result == CY_RSLT_OTA_ERROR_APP_RETURNED_STOP) || (result == CY_RSLT_OTA_ERROR_WRITE_STORAGE) )
+        {
+            goto cleanup_and_exit;
+        }
+        if ( (result == CY_RSLT_SUCCESS) && (ctx->total_bytes_written >= ctx->total_image_size) )
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_INFO, "Done streaming all data! %ld of %ld\n", ctx->total_bytes_written, ctx->total_image_size);
+            cy_rtos_setbits_event(&ctx->ota_event, (uint32_t)CY_OTA_EVENT_DATA_DONE, 0);
+            cy_ota_stop_http_timer(ctx);
+            goto cleanup_and_exit;
+        }
+
+        /* broken connection or server will not stream - get the rest with range requests */
+        cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() stream stopped at %ld, continue with range requests\n", __func__, ctx->total_bytes_written);
+        ctx->http.range_stats.stream_fallbacks++;
+        cy_ota_http_reconnect(ctx);
+        range_start = ctx->total_bytes_written;
+        range_end = range_start + ctx->http.range_stats.current_size - 1;
+        if ( (ctx->total_image_size > 0) && (range_end >= ctx->total_image_size) )
+        {
+            range_end = ctx->total_image_size - 1;
+        }
+        result = CY_RSLT_SUCCESS;
+    }
+#endif
+
+#if (CY_OTA_HTTP_RANGE_WINDOW > 1) && (CY_OTA_HTTP_CONNECTIONS == 1)
+    /* Pipelined range requests use their own plain TCP socket, TLS and Application
+     * connections get the window with one range request. So does a download with a block manifest.
+     */
+    if ( (ctx->http.connection_from_app == false) && (ctx->http.connection_tls == false) &&
+         ( (ctx->total_image_size == 0) || (ctx->total_bytes_written < ctx->total_image_size) )
+#if (CY_OTA_BLOCK_REUSE == 1)
+         && ( (ctx->network_params.use_get_job_flow == CY_OTA_DIRECT_FLOW) || (ctx->parsed_job.manifest[0] == 0x00) )
+#endif
+       )
+    {
+        result = cy_ota_http_pipeline_data(ctx);
+        if ( (result == CY_RSLT_OTA_ERROR_APP_RETURNED_STOP) || (result == CY_RSLT_OTA_ERROR_WRITE_STORAGE) )
+        {
+            goto cleanup_and_exit;
+        }
+        if ( (result == CY_RSLT_SUCCESS) && (ctx->total_bytes_written >= ctx->total_image_size) )
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_INFO, "Done pipelining all data! %ld of %ld\n", ctx->total_bytes_written, ctx->total_image_size);
+            cy_rtos_setbits_event(&ctx->ota_event, (uint32_t)CY_OTA_EVENT_DATA_DONE, 0);
+            cy_ota_stop_http_timer(ctx);
+            goto cleanup_and_exit;
+        }
+
+        /* broken connection or unexpected response - get the rest with single range requests */
+        cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() pipeline stopped at %ld, continue with range requests\n", __func__, ctx->total_bytes_written);
+        ctx->http.range_stats.pipeline_fallbacks++;
+        cy_ota_http_reconnect(ctx);
+        range_start = ctx->total_bytes_written;
+        range_end = range_start + ctx->http.range_stats.current_size - 1;
+        if ( (ctx->total_image_size > 0) && (range_end >= ctx->total_image_size) )
+        {
+            range_end = ctx->total_image_size - 1;
+        }
+        result = CY_RSLT_SUCCESS;
+    }
+#endif
+
+    /* we only get here when there are no errors in our setup above. */
+    /* If we bail without doing anything here, then we need to look at getting the file size before
+     * getting here.
+     */
+    while ( ( (ctx->total_bytes_written == 0) ||
+              (ctx->total_bytes_written < ctx->total_image_size) ) &&
+            (range_end >= range_start) )
     {
         cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "while(ctx->total_bytes_written (%ld) < (%ld) ctx->total_image_size)\n", ctx->total_bytes_written, ctx->total_image_size);
         /* Send a request and wait for a response
@@ -1015,21 +2432,58 @@ cy_rslt_t cy_ota_http_get_data(cy_ota_context_t *ctx)
 
         memset(&response, 0x00, sizeof(response));
 
+        cy_rtos_get_time(&request_start);
         result = cy_ota_http_send_get_response(ctx, &request,
                                                 send_headers, num_send_headers,
                                                 read_headers, num_read_headers,
                                                 &response);
+        cy_rtos_get_time(&request_end);
+        cy_ota_http_range_update(ctx, (uint32_t)(request_end - request_start), (result != CY_RSLT_SUCCESS));
+
+        if ( (result != CY_RSLT_SUCCESS) && ctx->http.range_stats.adaptive && (retries < CY_OTA_HTTP_RANGE_RETRIES) )
+        {
+            /* retry the same offset with the (now smaller) range size */
+            cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() range request failed, retry %ld at 0x%lx size:%ld\n", __func__,
+                       retries + 1, range_start, ctx->http.range_stats.current_size);
+            retries++;
+            if (cy_ota_http_reconnect(ctx) == CY_RSLT_SUCCESS)
+            {
+                ctx->http.range_stats.retries++;
+                range_end = range_start + ctx->http.range_stats.current_size - 1;
+                if ( (ctx->total_image_size > 0) && (range_end >= ctx->total_image_size) )
+                {
+                    range_end = ctx->total_image_size - 1;
+                }
+                continue;
+            }
+        }
 
         if (result == CY_RSLT_SUCCESS)
         {
-            /* set parameters for writing */
-            http_chunk_info.offset     = ctx->total_bytes_written;
-            http_chunk_info.buffer     = (uint8_t *)response.body;
-            http_chunk_info.size       = response.body_len;
-            http_chunk_info.total_size = ctx->total_image_size;  // is this correct? Is it set?
+            uint8_t     *body = (uint8_t *)response.body;
+            uint32_t    body_len = response.body_len;
+
+            retries = 0;
+
+            /* The response may hold a window of chunks, pass them to storage one chunk at a time, in order */
+            while (body_len > 0)
+            {
+                /* set parameters for writing */
+                http_chunk_info.offset     = ctx->total_bytes_written;
+                http_chunk_info.buffer     = body;
+                http_chunk_info.size       = (body_len > CY_OTA_CHUNK_SIZE) ? CY_OTA_CHUNK_SIZE : body_len;
+                http_chunk_info.total_size = ctx->total_image_size;  // is this correct? Is it set?
+
+                cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "call cy_ota_http_write_chunk_to_flash(%p %d)\n", http_chunk_info.buffer, http_chunk_info.size);
+                result = cy_ota_http_write_chunk_to_flash(ctx, &http_chunk_info);
+                if (result != CY_RSLT_SUCCESS)
+                {
+                    break;
+                }
+                body     += http_chunk_info.size;
+                body_len -= http_chunk_info.size;
+            }
 
-            cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "call cy_ota_http_write_chunk_to_flash(%p %d)\n", http_chunk_info.buffer, http_chunk_info.size);
-            result = cy_ota_http_write_chunk_to_flash(ctx, &http_chunk_info);
             if (result == CY_RSLT_OTA_ERROR_APP_RETURNED_STOP)
             {
                 cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() cy_ota_storage_write() returned OTA_STOP 0x%lx\n", __func__, result);
@@ -1050,7 +2504,7 @@ cy_rslt_t cy_ota_http_get_data(cy_ota_context_t *ctx)
 
 
         range_start = range_end + 1;
-        range_end += CY_OTA_CHUNK_SIZE;     /* end, not length */
+        range_end += ctx->http.range_stats.current_size;    /* end, not length */
         if (range_end > ctx->total_image_size)
         {
             range_end = ctx->total_image_size - 1;
@@ -1065,6 +2519,65 @@ cy_rslt_t cy_ota_http_get_data(cy_ota_context_t *ctx)
             cy_ota_start_http_timer(ctx, ctx->packet_timeout_sec, CY_OTA_EVENT_PACKET_TIMEOUT);
         }
 
+#if (CY_OTA_BLOCK_REUSE == 1)
+        /* Now that the image size is known, copy the blocks that did not change instead of downloading them */
+        if ( (manifest_done == false) && (result == CY_RSLT_SUCCESS) )
+        {
+            manifest_done = true;
+            cy_ota_http_get_manifest(ctx);
+        }
+        if (result == CY_RSLT_SUCCESS)
+        {
+            result = cy_ota_http_reuse_blocks(ctx, &range_start, &range_end);
+            if (result == CY_RSLT_OTA_ERROR_APP_RETURNED_STOP)
+            {
+                break;
+            }
+            if (result != CY_RSLT_SUCCESS)
+            {
+                result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+                break;
+            }
+        }
+#endif
+
+#if (CY_OTA_HTTP_CONNECTIONS > 1)
+        /* Now that the image size is known, fetch the rest on parallel connections (each range is downloaded in full) */
+        if ( (parallel_done == false) && (ctx->http.connection_from_app == false) && (result == CY_RSLT_SUCCESS) &&
+#if (CY_OTA_BLOCK_REUSE == 1)
+             (ctx->block_reuse.active == 0) &&
+#endif
+             ( (ctx->total_image_size - ctx->total_bytes_written) > CY_OTA_HTTP_RANGE_SPAN) )
+        {
+            parallel_done = true;
+            result = cy_ota_http_fetch_parallel(ctx);
+            if (result == CY_RSLT_OTA_ERROR_APP_RETURNED_STOP)
+            {
+                break;
+            }
+            if (result != CY_RSLT_SUCCESS)
+            {
+                result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+                break;
+            }
+            if (ctx->total_bytes_written < ctx->total_image_size)
+            {
+                /* no parallel connection left - finish on a fresh main connection */
+                if (cy_ota_http_reconnect(ctx) != CY_RSLT_SUCCESS)
+                {
+                    result = CY_RSLT_OTA_ERROR_GET_DATA;
+                    break;
+                }
+            }
+            range_start = ctx->total_bytes_written;
+            range_end   = range_start + ctx->http.range_stats.current_size - 1;
+            if (range_end >= ctx->total_image_size)
+            {
+                range_end = ctx->total_image_size - 1;
+            }
+        }
+#endif
+
         /* Check for finished getting data */
         if (ctx->total_bytes_written > 0 && ctx->total_bytes_written >= ctx->total_image_size)
         {
@@ -1076,6 +2589,20 @@ cy_rslt_t cy_ota_http_get_data(cy_ota_context_t *ctx)
 
     }   /* While not done loading */
 
+    /* make sure everything received is in FLASH before we verify */
+    if ( (cy_ota_writer_flush(ctx) != CY_RSLT_SUCCESS) && (result == CY_RSLT_SUCCESS) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_ota_writer_flush() failed\n", __func__);
+        result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+
+#if (CY_OTA_BLOCK_REUSE == 1)
+    if (ctx->block_reuse.reused_bytes > 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Block reuse: %ld of %ld bytes copied from the Primary Slot\n",
+                   ctx->block_reuse.reused_bytes, ctx->total_image_size);
+    }
+#endif
     cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() HTTP GET DATA DONE result: 0x%lx\n", __func__, result);
 
 cleanup_and_exit:
@@ -26,6 +26,8 @@ extern "C" {
 #include "cyabs_rtos.h"
 #include "cy_log.h"
 #include "untar.h"
+#include "lzss.h"
+#include "delta.h"
 
 /* This is so that Eclipse doesn't complain about the Logging messages */
 #ifndef NULL
@@ -49,6 +51,14 @@ extern "C" {
  */
 #define CY_OTA_SIZE_OF_RECV_BUFFER              (4 * 1024)
 
+/**
+ * @brief Size of the chunk buffer
+ *
+ * Holds CY_OTA_HTTP_RANGE_WINDOW chunks plus room for a response header - one range response
+ * covering the window, or pipelined responses read ahead of the one being written.
+ */
+#define CY_OTA_CHUNK_BUFFER_SIZE                ( (CY_OTA_CHUNK_SIZE * CY_OTA_HTTP_RANGE_WINDOW) + 512)
+
 /**
  * @brief Maximum size of signature scheme descriptive string
  *
@@ -106,6 +116,11 @@ typedef enum
  */
 #define CY_OTA_MAX_PACKETS     (2048)  /* Handle checking for 2M OTA code using 1k packets */
 
+/**
+ * @brief Secondary Slots written by a download (image 0 and image 1 of a tar archive)
+ */
+#define CY_OTA_SECONDARY_SLOTS  (2)
+
 /******************************************************************************
  *
  * Include the transport header files
@@ -130,6 +145,16 @@ typedef enum
  */
 #define CY_OTA_HTTP_TYPICAL_HEADER_SIZE         (256)
 
+/*
+ * @brief Number of bytes asked for in each HTTP range request
+ */
+#define CY_OTA_HTTP_RANGE_SPAN                  (CY_OTA_CHUNK_SIZE * CY_OTA_HTTP_RANGE_WINDOW)
+
+/*
+ * @brief Weight of previous average when smoothing the range request time (out of 8)
+ */
+#define CY_OTA_HTTP_RANGE_AVG_WEIGHT            (7)
+
 /* OTA MQTT main loop events to wait look for */
 #define CY_OTA_EVENT_HTTP_EVENTS  (CY_OTA_EVENT_SHUTDOWN_NOW | \
                                 CY_OTA_EVENT_PACKET_TIMEOUT | \
@@ -155,12 +180,86 @@ typedef enum
  *
  **********************************************************************/
 
+#if (CY_OTA_HTTP_JOB_CACHE == 1)
+/**
+ * @brief Last Job document poll, kept across OTA sessions
+ *
+ * valid is set when the Job document did not lead to an update, and cleared when a
+ * different Job document is received.
+ */
+typedef struct cy_ota_http_job_cache_s {
+    bool        valid;                                          /**< true = send a conditional GET          */
+    uint32_t    identity;                                       /**< Hash of Server, port and Job file      */
+    uint32_t    job_hash;                                       /**< Hash of the Job document               */
+    char        etag[CY_OTA_HTTP_JOB_VALIDATOR_LEN];            /**< ETag of the Job document               */
+    char        last_modified[CY_OTA_HTTP_JOB_VALIDATOR_LEN];   /**< Last-Modified of the Job document      */
+    uint32_t    polls;                                          /**< Job document polls                     */
+    uint32_t    not_modified;                                   /**< Polls ended as not modified            */
+} cy_ota_http_job_cache_t;
+#endif  /* CY_OTA_HTTP_JOB_CACHE */
+
+#if (CY_OTA_HTTP_CONNECTIONS > 1)
+
+struct cy_ota_context_s;
+
+/**
+ * @brief States of one parallel download connection
+ */
+typedef enum
+{
+    CY_OTA_HTTP_FETCH_IDLE = 0,         /**< buffer free, claim the next range                  */
+    CY_OTA_HTTP_FETCH_BUSY,             /**< range request in progress                          */
+    CY_OTA_HTTP_FETCH_READY,            /**< range in buffer, waiting to be written in order    */
+    CY_OTA_HTTP_FETCH_STOPPED,          /**< connection failed, too slow, or download finished  */
+} cy_ota_http_fetch_state_t;
+
+/**
+ * @brief One connection of the parallel download
+ */
+typedef struct cy_ota_http_fetch_slot_s {
+    struct cy_ota_context_s     *ctx;                       /**< OTA context                                        */
+    uint8_t                     index;                      /**< Slot number, 0 uses the main connection            */
+    cy_thread_t                 thread;                     /**< Fetch thread                                       */
+    bool                        thread_running;             /**< true = thread created                              */
+    cy_semaphore_t              free_sem;                   /**< Given when the buffer has been written             */
+    cy_http_client_t            connection;                 /**< HTTP connection for this slot                      */
+    bool                        own_connection;             /**< true = created for this slot                       */
+    cy_awsport_server_info_t    server;                     /**< Server or mirror for this slot                     */
+    char                        host[CY_OTA_JOB_URL_BROKER_LEN];    /**< Host name storage for a mirror             */
+    volatile cy_ota_http_fetch_state_t  state;              /**< See cy_ota_http_fetch_state_t                      */
+    uint32_t                    offset;                     /**< Offset of the range in the image                   */
+    uint32_t                    size;                       /**< Size of the range                                  */
+    uint8_t                     *body;                      /**< Range data in buffer                               */
+    uint8_t                     *buffer;                    /**< Receive buffer                                     */
+    uint32_t                    requests;                   /**< Successful range requests                          */
+    uint32_t                    avg_ms;                     /**< Smoothed time for a range request                  */
+} cy_ota_http_fetch_slot_t;
+
+/**
+ * @brief Parallel download data
+ *
+ * Each slot claims the lowest range not yet claimed, ranges given up by a failed or slow
+ * connection are claimed first. The OTA Agent thread writes the ranges in order.
+ */
+typedef struct cy_ota_http_fetch_s {
+    cy_mutex_t                  mutex;                      /**< Protects the range bookkeeping                     */
+    cy_semaphore_t              ready_sem;                  /**< Given when a slot has a range or stopped           */
+    uint32_t                    next_offset;                /**< Next range never claimed                           */
+    uint32_t                    requeue[CY_OTA_HTTP_CONNECTIONS];   /**< Offsets of ranges given up                 */
+    uint8_t                     num_requeue;                /**< Number of entries in requeue[]                     */
+    volatile bool               stop;                       /**< true = slots must stop                             */
+    cy_ota_http_fetch_slot_t    slots[CY_OTA_HTTP_CONNECTIONS];     /**< One per connection                         */
+    uint8_t                     buffers[CY_OTA_HTTP_CONNECTIONS - 1][CY_OTA_CHUNK_BUFFER_SIZE]; /**< Buffers for slots 1 and up */
+} cy_ota_http_fetch_t;
+#endif  /* CY_OTA_HTTP_CONNECTIONS > 1 */
+
 /**
  * @brief HTTP context data
  */
 typedef struct cy_ota_http_context_s {
     bool                connection_from_app;                        /**< true if HTTP connection passed in from App */
     bool                connection_established;                     /**< true if HTTP connection established        */
+    bool                connection_tls;                             /**< true if HTTP connection uses TLS           */
 
     cy_http_client_t    connection;                             /**< HTTP connection instance                   */
 
@@ -171,6 +270,17 @@ typedef struct cy_ota_http_context_s {
     char                json_doc[CY_OTA_JSON_DOC_BUFF_SIZE];    /**< Message to request OTA data            */
     char                file[CY_OTA_HTTP_FILENAME_SIZE];        /**< Filename for OTA data                  */
 
+    cy_ota_http_range_stats_t   range_stats;                    /**< Range request sizes and timing         */
+
+    cy_awsport_server_info_t        *server_info;               /**< Server used for the connection         */
+    cy_awsport_ssl_credentials_t    *security;                  /**< Credentials used, NULL = non-TLS       */
+#if (CY_OTA_HTTP_CONNECTIONS > 1)
+    cy_ota_http_fetch_t         fetch;                          /**< Parallel download                      */
+#endif
+#if (CY_OTA_HTTP_JOB_CACHE == 1)
+    cy_ota_http_job_cache_t     job_cache;                      /**< Conditional Job document polling       */
+#endif
+
 } cy_ota_http_context_t;
 #endif /* COMPONENT_OTA_HTTP    */
 
@@ -275,6 +385,210 @@ typedef struct cy_ota_ble_context_s {
 
 #endif  /* COMPONENT_OTA_BLUETOOTH */
 
+/***********************************************************************
+ *
+ * Storage writer
+ *
+ **********************************************************************/
+
+#if (CY_OTA_WRITER_NUM_BUFFERS > 0)
+
+/**
+ * @brief One chunk queued for the storage writer thread
+ */
+typedef struct cy_ota_writer_buffer_s {
+    cy_ota_storage_write_info_t info;                       /**< chunk info, info.buffer points to data[]                   */
+    uint8_t                     data[CY_OTA_CHUNK_SIZE];    /**< copy of the received data                                  */
+} cy_ota_writer_buffer_t;
+
+/**
+ * @brief Storage writer context data
+ *
+ * The receiving thread fills buffers[head], the writer thread empties buffers[tail].
+ */
+typedef struct cy_ota_writer_context_s {
+    cy_thread_t                 thread;                     /**< Writer thread                                              */
+    cy_semaphore_t              free_sem;                   /**< Count of empty buffers                                     */
+    cy_semaphore_t              full_sem;                   /**< Count of buffers waiting to be written                     */
+    uint8_t                     running;                    /**< 1 = thread and semaphores are created                      */
+    volatile uint8_t            stop;                       /**< 1 = thread should exit                                     */
+    uint16_t                    head;                       /**< Next buffer to fill                                        */
+    uint16_t                    tail;                       /**< Next buffer to write                                       */
+    volatile cy_rslt_t          result;                     /**< First write failure, reported back to the transport        */
+    uint32_t                    writes;                     /**< Number of chunks written by the thread                     */
+    uint32_t                    wait_ms;                    /**< Time the receiving thread waited for a free buffer         */
+    cy_ota_writer_buffer_t      buffers[CY_OTA_WRITER_NUM_BUFFERS]; /**< Chunk buffers                                      */
+} cy_ota_writer_context_t;
+
+#endif  /* CY_OTA_WRITER_NUM_BUFFERS > 0 */
+
+#if (CY_OTA_DECOMPRESS == 1)
+
+/**
+ * @brief Decompression stage context data
+ *
+ * Set up by the first chunk (offset 0) of each download, see cy_ota_writer_write().
+ */
+typedef struct cy_ota_decompress_context_s {
+    uint8_t                     active;                     /**< 1 = this download is compressed                            */
+    uint32_t                    next_offset;                /**< Offset of the next compressed byte expected                */
+    cy_ota_storage_write_info_t *chunk_info;                /**< Compressed chunk being decoded                             */
+    cy_lzss_decoder_t           decoder;                    /**< Decoder state                                              */
+    uint8_t                     window[1UL << CY_OTA_DECOMPRESS_WINDOW_BITS];  /**< Decoder output window              */
+} cy_ota_decompress_context_t;
+
+#endif  /* CY_OTA_DECOMPRESS == 1 */
+
+#if (CY_OTA_DELTA == 1)
+
+/**
+ * @brief Delta patch stage context data
+ *
+ * Set up by the first chunk (offset 0) of each download, see cy_ota_writer_write().
+ */
+typedef struct cy_ota_delta_context_s {
+    uint8_t                     active;                     /**< 1 = this download is a patch                               */
+    uint32_t                    next_offset;                /**< Offset of the next patch byte expected                     */
+    cy_ota_storage_write_info_t *chunk_info;                /**< Patch chunk being applied                                  */
+    cy_delta_decoder_t          decoder;                    /**< Decoder state                                              */
+    uint8_t                     buffer[CY_OTA_DELTA_BUFFER_SIZE];  /**< New image output buffer                        */
+} cy_ota_delta_context_t;
+
+#endif  /* CY_OTA_DELTA == 1 */
+
+#if (CY_OTA_BLOCK_REUSE == 1)
+
+/***********************************************************************
+ *
+ * Block reuse from the Primary Slot
+ *
+ **********************************************************************/
+
+#include "sha256.h"
+
+/**
+ * @brief Block manifest made by scripts/ota_blocks.py, little endian
+ *
+ *  0   "CYBM"
+ *  4   block size (CY_OTA_CHUNK_SIZE)
+ *  8   image size
+ *  12  number of blocks
+ *  16  first CY_OTA_MANIFEST_HASH_SIZE bytes of the SHA-256 of each block
+ */
+#define CY_OTA_MANIFEST_MAGIC           "CYBM"
+#define CY_OTA_MANIFEST_HEADER_SIZE     (16)
+#define CY_OTA_MANIFEST_HASH_SIZE       (8)
+
+/**
+ * @brief Block reuse context data
+ *
+ * Set up from the manifest by cy_ota_storage_block_reuse_manifest().
+ */
+typedef struct cy_ota_block_reuse_context_s {
+    uint8_t                     active;                     /**< 1 = manifest accepted, matching blocks are copied          */
+    uint8_t                     failed;                     /**< 1 = manifest is not for this image, download all blocks    */
+    uint32_t                    blocks;                     /**< Blocks in the manifest                                     */
+    uint32_t                    manifest_size;              /**< Size of the manifest, 0 until the header is parsed         */
+    uint32_t                    next_block;                 /**< Next manifest entry to compare                             */
+    uint8_t                     pending[CY_OTA_MANIFEST_HEADER_SIZE];   /**< Header or entry split over responses           */
+    uint32_t                    pending_len;                /**< Bytes in pending                                           */
+    uint32_t                    matches;                    /**< Blocks that are the same in the Primary Slot               */
+    uint32_t                    reused_bytes;               /**< Bytes copied from the Primary Slot for this download       */
+    uint8_t                     match[(CY_OTA_BLOCK_REUSE_MAX_BLOCKS + 7) / 8];    /**< Bit set = block is in the Primary Slot */
+} cy_ota_block_reuse_context_t;
+
+#endif  /* CY_OTA_BLOCK_REUSE == 1 */
+
+/***********************************************************************
+ *
+ * Download progress journal
+ *
+ **********************************************************************/
+
+/**
+ * @brief Download progress journal context data
+ *
+ * The journal area is at the end of the Secondary Slot, see CY_OTA_JOURNAL_OFFSET_FROM_END.
+ * Only resume_offset and resume_image_size are used with CY_OTA_JOURNAL == 0 (always 0).
+ */
+typedef struct cy_ota_journal_context_s {
+    uint8_t                     active;                     /**< 1 = record progress for this download                      */
+    uint32_t                    identity;                   /**< CRC of server, file and version of this download           */
+    uint32_t                    resume_offset;              /**< Data before this offset was in FLASH at storage open       */
+    uint32_t                    resume_image_size;          /**< Image size recorded with resume_offset                     */
+    uint32_t                    contiguous;                 /**< End of the data written without gaps from offset 0         */
+    uint32_t                    committed;                  /**< Offset in the last journal record                          */
+    uint32_t                    sequence;                   /**< Sequence number of the last journal record                 */
+    uint32_t                    next_record;                /**< Index of the next free record in the journal area          */
+    uint32_t                    commits;                    /**< Journal records written for this download                  */
+} cy_ota_journal_context_t;
+
+#if (CY_OTA_LAZY_ERASE == 1)
+
+/***********************************************************************
+ *
+ * Secondary Slot lazy erase
+ *
+ **********************************************************************/
+
+/**
+ * @brief Lazy erase context data
+ *
+ * Set up by cy_ota_storage_open(), see cy_ota_storage_prepare_write().
+ */
+typedef struct cy_ota_lazy_erase_context_s {
+    uint8_t                     active;                     /**< 1 = erase sectors on first write                           */
+    uint32_t                    sector_size;                /**< Erase size, CY_OTA_ERASE_SECTOR_SIZE or larger             */
+    uint32_t                    sectors;                    /**< sector_size sectors in the Secondary Slot                  */
+    uint32_t                    erases;                     /**< Sectors erased by the writer for this download             */
+    uint32_t                    waits;                      /**< Writes that waited on an erase                             */
+    uint32_t                    wait_ms;                    /**< Time writes waited on erases                               */
+    uint8_t                     erased[(CY_OTA_LAZY_ERASE_MAX_SECTORS + 7) / 8];   /**< Bit set = sector ready to write */
+#if (CY_OTA_ERASE_AHEAD_SECTORS > 0)
+    cy_thread_t                 thread;                     /**< Erase-ahead thread                                         */
+    cy_mutex_t                  lock;                       /**< Held for each erase, write and read of the Secondary Slot  */
+    cy_semaphore_t              wake_sem;                   /**< Signalled when the erase-ahead range moves                 */
+    uint8_t                     running;                    /**< 1 = thread, lock and wake_sem are created                  */
+    volatile uint8_t            stop;                       /**< 1 = erase-ahead thread exits                               */
+    volatile uint8_t            failed;                     /**< 1 = an erase-ahead erase failed, thread stopped erasing    */
+    volatile uint32_t           ahead_first;                /**< First sector to erase ahead of the writer                  */
+    volatile uint32_t           ahead_end;                  /**< Sector after the last one to erase ahead                   */
+    uint32_t                    ahead_erases;               /**< Sectors erased by the erase-ahead thread                   */
+#endif
+} cy_ota_lazy_erase_context_t;
+
+#endif  /* CY_OTA_LAZY_ERASE == 1 */
+
+#if (CY_OTA_IMAGE_HASH == 1)
+
+/***********************************************************************
+ *
+ * MCUboot image hash
+ *
+ **********************************************************************/
+
+#include "sha256.h"
+
+/**
+ * @brief Size of the MCUboot image header at the start of the image
+ */
+#define CY_OTA_IMAGE_HEADER_SIZE    (32)
+
+/**
+ * @brief Streaming image hash context data
+ *
+ * Reset by cy_ota_storage_open(), see cy_ota_storage_image_hash() and cy_ota_storage_verify().
+ */
+typedef struct cy_ota_image_hash_context_s {
+    uint8_t                     active;                     /**< 1 = hash is started                                        */
+    uint32_t                    hashed;                     /**< Image bytes hashed so far (next offset to hash)            */
+    uint32_t                    hash_end;                   /**< Header + image + protected TLVs, UINT32_MAX until header   */
+    uint8_t                     header[CY_OTA_IMAGE_HEADER_SIZE];   /**< MCUboot image header                               */
+    mbedtls_sha256_context      sha;                        /**< SHA-256 of [0, hashed)                                     */
+} cy_ota_image_hash_context_t;
+
+#endif  /* CY_OTA_IMAGE_HASH == 1 */
+
 /******************************************************************************
  *
  * OTA Defines
@@ -336,6 +650,10 @@ typedef struct cy_ota_job_parsed_info_s {
         cy_awsport_server_info_t    broker_server;                          /**< Broker or Server holding OTA Image */
 #endif
         char                    file[CY_OTA_HTTP_FILENAME_SIZE];            /**< File on Server (HTTP)              */
+        char                    mirrors[CY_OTA_JOB_MIRRORS_LEN];            /**< Other servers for File (HTTP)      */
+#if (CY_OTA_BLOCK_REUSE == 1)
+        char                    manifest[CY_OTA_HTTP_FILENAME_SIZE];        /**< Block manifest of File (HTTP)      */
+#endif
         uint32_t                file_size;                                  /**< size of file to download           */
         char                    topic[CY_OTA_MQTT_UNIQUE_TOPIC_BUFF_SIZE];  /**< Unique Topic                       */
 } cy_ota_job_parsed_info_t;
@@ -354,6 +672,8 @@ typedef struct cy_ota_context_s {
     cy_thread_t                 ota_agent_thread;           /**< OTA Agent Thread                                           */
 
     cy_ota_agent_state_t        curr_state;                 /**< current OTA system state                                   */
+    cy_time_t                   state_start_ms;             /**< time curr_state was entered                                */
+    cy_ota_stats_t              stats;                      /**< state timing statistics                                    */
 
     uint8_t                     stop_OTA_session;           /**< App callback returned CY_RSLT_OTA_ERROR_APP_RETURNED_STOP */
     uint32_t                    initial_timer_sec;          /**< Seconds before connecting after cy_ota_agent_start()       */
@@ -370,6 +690,7 @@ typedef struct cy_ota_context_s {
 
     /* Storage and progress info */
     void                        *storage_loc;               /**< can be cast as flash_area or FILE as needed                    */
+    void                        *slot_loc[CY_OTA_SECONDARY_SLOTS];  /**< Secondary Slots of other images, open until storage close */
     uint32_t                    total_image_size;           /**< Total size of OTA Image                                        */
     uint32_t                    total_bytes_written;        /**< Number of bytes written to FLASH                               */
     uint32_t                    last_offset;                /**< Last offset written to from cy_ota_storage_write()             */
@@ -407,7 +728,30 @@ typedef struct cy_ota_context_s {
     char                        job_doc[CY_OTA_JSON_DOC_BUFF_SIZE];         /**< Message to parse                                */
     cy_ota_job_parsed_info_t    parsed_job;                                 /**< Parsed Job JSON info                                           */
 
-    uint8_t                     chunk_buffer[CY_OTA_CHUNK_SIZE + 512];    /**< Store Chunked data here */
+    uint8_t                     chunk_buffer[CY_OTA_CHUNK_BUFFER_SIZE];   /**< Store Chunked data here */
+
+#if (CY_OTA_WRITER_NUM_BUFFERS > 0)
+    cy_ota_writer_context_t     writer;                     /**< Storage writer thread and buffers                              */
+#endif
+#if (CY_OTA_DECOMPRESS == 1)
+    cy_ota_decompress_context_t decompress;                 /**< Decompression stage for compressed OTA Images                  */
+#endif
+#if (CY_OTA_DELTA == 1)
+    cy_ota_delta_context_t      delta;                      /**< Delta patch stage                                              */
+#endif
+#if (CY_OTA_BLOCK_REUSE == 1)
+    cy_ota_block_reuse_context_t block_reuse;               /**< Blocks copied from the Primary Slot                            */
+#endif
+#if (CY_OTA_DELTA == 1) || (CY_OTA_BLOCK_REUSE == 1)
+    void                        *primary_loc;               /**< Primary Slot flash area, open while the old image is read      */
+#endif
+    cy_ota_journal_context_t    journal;                    /**< Download progress journal                                      */
+#if (CY_OTA_LAZY_ERASE == 1)
+    cy_ota_lazy_erase_context_t lazy_erase;                 /**< Secondary Slot sectors erased so far                           */
+#endif
+#if (CY_OTA_IMAGE_HASH == 1)
+    cy_ota_image_hash_context_t image_hash;                 /**< SHA-256 of the image written so far                            */
+#endif
 
     cy_ota_cb_struct_t          callback_data;              /**< For passing data to callback function                          */
 
@@ -498,6 +842,16 @@ cy_rslt_t cy_ota_mqtt_connect(cy_ota_context_t *ctx);
 cy_rslt_t cy_ota_http_get_job(cy_ota_context_t *ctx);
 cy_rslt_t cy_ota_mqtt_get_job(cy_ota_context_t *ctx);
 
+/**
+ * @brief Save the outcome of parsing the HTTP Job document
+ *
+ * A Job document that did not lead to an update is polled for with a conditional GET.
+ *
+ * @param[in]   ctx             - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   parse_result    - result of parsing the Job document
+ */
+void cy_ota_http_job_parsed(cy_ota_context_t *ctx, cy_rslt_t parse_result);
+
 /**
  * @brief get the OTA download
  *
@@ -542,6 +896,238 @@ cy_rslt_t cy_ota_mqtt_report_result(cy_ota_context_t *ctx, cy_rslt_t last_error)
  */
 void cy_ota_mqtt_create_unique_topic(cy_ota_context_t *ctx);
 
+/***********************************************************************
+ *
+ * Storage writer
+ *
+ **********************************************************************/
+
+/**
+ * @brief Hand a chunk of received data to storage
+ *
+ * With CY_OTA_WRITER_NUM_BUFFERS == 0 this calls cy_ota_write_incoming_data_block().
+ * Otherwise the data is copied to a writer buffer and written by the writer thread.
+ * With CY_OTA_DECOMPRESS == 1, a compressed download is decompressed first.
+ * With CY_OTA_DELTA == 1, a patch is applied to the Primary Slot image next.
+ *
+ * @param[in]   ctx         - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   chunk_info  - pointer to chunk information
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+cy_rslt_t cy_ota_writer_write(cy_ota_context_t *ctx, cy_ota_storage_write_info_t *chunk_info);
+
+/**
+ * @brief Wait for all queued chunks to be written to storage
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+cy_rslt_t cy_ota_writer_flush(cy_ota_context_t *ctx);
+
+/**
+ * @brief Flush and stop the storage writer thread
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+cy_rslt_t cy_ota_writer_stop(cy_ota_context_t *ctx);
+
+/**
+ * @brief Check that a compressed download or a delta patch was decoded to the end
+ *
+ * Call after cy_ota_writer_stop(). A stream that ended early leaves the end of the
+ * new image unwritten, it must not be marked for the update.
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+cy_rslt_t cy_ota_writer_check_complete(cy_ota_context_t *ctx);
+
+/***********************************************************************
+ *
+ * Download progress journal
+ *
+ **********************************************************************/
+
+/**
+ * @brief Write the FLASH rows still being collected to the Secondary Slots
+ *
+ * Data that does not fill a FLASH row waits for the rest of the row in
+ * cy_ota_write_incoming_data_block(). Call when all data is written, before
+ * the image is verified. Logs the FLASH operations of the download.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+cy_rslt_t cy_ota_write_flush(cy_ota_context_t *ctx);
+
+/**
+ * @brief Drop the FLASH rows being collected, for a new download
+ */
+void cy_ota_write_discard(void);
+
+/**
+ * @brief Note data written to the Secondary Slot, record progress when due
+ *
+ * Called after the data is in FLASH. A journal record is written each time the data
+ * written without gaps from offset 0 grows by CY_OTA_JOURNAL_COMMIT_SIZE.
+ * Does nothing with CY_OTA_JOURNAL == 0.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   offset  - offset of the data in the Secondary Slot
+ * @param[in]   size    - size of the data
+ */
+void cy_ota_storage_journal_update(cy_ota_context_t *ctx, uint32_t offset, uint32_t size);
+
+/**
+ * @brief Erase the Secondary Slot sectors of a write that are not erased yet
+ *
+ * Call before writing (or read-modify-writing) data in the Secondary Slot of image 0.
+ * Does nothing with CY_OTA_LAZY_ERASE == 0, the slot was erased by cy_ota_storage_open().
+ * With CY_OTA_ERASE_AHEAD_SECTORS, moves the erase-ahead range past the write and returns
+ * holding the FLASH lock; call cy_ota_storage_write_done() after the write. A size of 0
+ * only takes the lock (for writes to another slot on the same FLASH).
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   offset  - offset of the data in the Secondary Slot
+ * @param[in]   size    - size of the data
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE (the lock is not held)
+ */
+cy_rslt_t cy_ota_storage_prepare_write(cy_ota_context_t *ctx, uint32_t offset, uint32_t size);
+
+/**
+ * @brief Release the FLASH lock taken by cy_ota_storage_prepare_write()
+ *
+ * Does nothing without the erase-ahead thread (CY_OTA_ERASE_AHEAD_SECTORS == 0).
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ */
+void cy_ota_storage_write_done(cy_ota_context_t *ctx);
+
+/**
+ * @brief Get the open Secondary Slot flash area of an image
+ *
+ * Image 0 is storage_loc, opened by cy_ota_storage_open(). Other images are opened
+ * on first use and stay open until cy_ota_storage_close().
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   image   - image (0 = application)
+ *
+ * @return  pointer to the flash area (const struct flash_area *)
+ *          NULL if the slot could not be opened
+ */
+void *cy_ota_storage_get_slot(cy_ota_context_t *ctx, uint16_t image);
+
+/**
+ * @brief Add data written to the Secondary Slot of image 0 to the image hash
+ *
+ * Data is hashed when it continues the data hashed so far, data that arrives
+ * out of order is read back from FLASH by cy_ota_storage_verify().
+ * Does nothing with CY_OTA_IMAGE_HASH == 0.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   offset  - offset of the data in the Secondary Slot
+ * @param[in]   buffer  - data
+ * @param[in]   size    - size of the data
+ */
+void cy_ota_storage_image_hash(cy_ota_context_t *ctx, uint32_t offset, const uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Stop the erase-ahead thread and free its lock and semaphore
+ *
+ * Safe to call when the thread is not running.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ */
+void cy_ota_storage_erase_ahead_stop(cy_ota_context_t *ctx);
+
+#if (CY_OTA_DELTA == 1) || (CY_OTA_BLOCK_REUSE == 1)
+/***********************************************************************
+ *
+ * Old image in the Primary Slot (delta patch, block reuse)
+ *
+ **********************************************************************/
+
+/**
+ * @brief Open the Primary Slot to read the old image
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_OPEN_STORAGE
+ */
+cy_rslt_t cy_ota_storage_primary_open(cy_ota_context_t *ctx);
+
+/**
+ * @brief Read the old image from the Primary Slot, a @ref cy_delta_read_callback_t
+ *
+ * @param[in]   cb_arg  - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   offset  - offset in the Primary Slot
+ * @param[out]  buffer  - buffer for the data
+ * @param[in]   size    - bytes to read
+ *
+ * @return  0 - OK, -1 - read failed
+ */
+int cy_ota_storage_primary_read(void *cb_arg, uint32_t offset, uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Close the Primary Slot if open
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ */
+void cy_ota_storage_primary_close(cy_ota_context_t *ctx);
+#endif  /* CY_OTA_DELTA == 1 || CY_OTA_BLOCK_REUSE == 1 */
+
+#if (CY_OTA_BLOCK_REUSE == 1)
+/**
+ * @brief Start block reuse for the download, before the manifest arrives
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_OPEN_STORAGE
+ */
+cy_rslt_t cy_ota_storage_block_reuse_start(cy_ota_context_t *ctx);
+
+/**
+ * @brief Compare the next part of the block manifest with the Primary Slot
+ *
+ * The manifest may arrive in any number of pieces, in order. Each block hash is
+ * compared with the same block of the Primary Slot as it arrives. Block reuse is
+ * active when the whole manifest is compared.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   data    - next manifest data
+ * @param[in]   size    - size of the data
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GENERAL - not a manifest for this image, download all blocks
+ */
+cy_rslt_t cy_ota_storage_block_reuse_manifest(cy_ota_context_t *ctx, const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Find the next block that is the same in the Primary Slot
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   offset  - offset in the image to start looking (block aligned)
+ *
+ * @return  offset of the block, ctx->total_image_size if none
+ */
+uint32_t cy_ota_storage_block_reuse_next(cy_ota_context_t *ctx, uint32_t offset);
+#endif  /* CY_OTA_BLOCK_REUSE == 1 */
+
 
 /**********************************************************************
  *
@@ -43,9 +43,12 @@
 /* Publish 1 MQTT request, publisher chunks and sends all data
  * Enabled is current version.
  *
- * Comment out to have Device request each chunk separately.
+ * Comment out, or define CY_OTA_MQTT_REQUEST_EACH_CHUNK in the build,
+ * to have Device request each chunk separately.
  * */
+#ifndef CY_OTA_MQTT_REQUEST_EACH_CHUNK
 #define CY_MQTT_GET_ALL_DATA_WITH_ONE_CALL
+#endif
 
 /***********************************************************************
  *
@@ -260,6 +263,7 @@ static cy_rslt_t cy_ota_mqtt_create_json_request(cy_ota_context_t *ctx,
 #ifdef CY_MQTT_GET_ALL_DATA_WITH_ONE_CALL
     /* Current default. Send one request for the entire file,
      * Publisher.py will chunk and send separate chunks.
+     * When resuming, chunks before the resume offset are dropped without writing.
      */
     needed_size = snprintf(NULL, 0, message_doc, APP_VERSION_MAJOR, APP_VERSION_MINOR, APP_VERSION_BUILD, ctx->mqtt.unique_topic);
     if (needed_size > (sizeof(ctx->mqtt.json_doc)-1) )
@@ -456,6 +460,26 @@ cy_rslt_t cy_ota_mqtt_write_chunk_to_flash(cy_ota_context_t *ctx, cy_ota_storage
 
     cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() num_packets_received: %d\n", __func__, ctx->num_packets_received);
 
+    /* A resumed download already has the data before resume_offset in FLASH,
+     * and total_bytes_written already counts it.
+     */
+    if (chunk_info->offset < ctx->journal.resume_offset)
+    {
+        uint32_t skip = ctx->journal.resume_offset - chunk_info->offset;
+        if (skip >= chunk_info->size)
+        {
+            if (chunk_info->packet_number < CY_OTA_MAX_PACKETS)
+            {
+                ctx->mqtt.received_packets[chunk_info->packet_number]++;
+            }
+            cy_log_msg(CYLF_OTA, CY_LOG_DEBUG2, "PACKET index %d already in FLASH - not written\n", chunk_info->packet_number);
+            return CY_RSLT_SUCCESS;
+        }
+        chunk_info->buffer += skip;
+        chunk_info->offset += skip;
+        chunk_info->size   -= skip;
+    }
+
     /* check for receipt of duplicate packets - do not write twice */
     if (chunk_info->packet_number >= CY_OTA_MAX_PACKETS)
     {
@@ -477,7 +501,7 @@ cy_rslt_t cy_ota_mqtt_write_chunk_to_flash(cy_ota_context_t *ctx, cy_ota_storage
     switch( cb_result )
     {
     case CY_OTA_CB_RSLT_OTA_CONTINUE:
-        result = cy_ota_write_incoming_data_block(ctx, chunk_info);
+        result = cy_ota_writer_write(ctx, chunk_info);
         if (result != CY_RSLT_SUCCESS)
         {
             cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Write failed\n", __func__);
@@ -1239,6 +1263,11 @@ cy_rslt_t cy_ota_mqtt_get_data(cy_ota_context_t *ctx)
         goto cleanup_and_exit;
     }
 
+    /* clear out tally of received / written packets before the request,
+     * the first chunks can arrive before cy_ota_mqtt_publish_request() returns
+     */
+    memset(&ctx->mqtt.received_packets, 0, sizeof(ctx->mqtt.received_packets) );
+
     /* Create json doc for the request */
     memset(ctx->mqtt.json_doc, 0x00, sizeof(ctx->mqtt.json_doc));
 #ifdef CY_MQTT_GET_ALL_DATA_WITH_ONE_CALL
@@ -1250,7 +1279,7 @@ cy_rslt_t cy_ota_mqtt_get_data(cy_ota_context_t *ctx)
     /* This code is for requesting each chunk separately. */
     cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "MQTT Subscribe for CHUNK download DATA Messages..............\n");
     result = cy_ota_mqtt_create_json_request(ctx, CY_OTA_DOWNLOAD_CHUNK_REQUEST,
-                                                        ctx->parsed_job.file, 0, CY_OTA_CHUNK_SIZE);
+                                                        ctx->parsed_job.file, ctx->total_bytes_written, CY_OTA_CHUNK_SIZE);
 #endif
 
     if (result != CY_RSLT_SUCCESS)
@@ -1312,9 +1341,6 @@ cy_rslt_t cy_ota_mqtt_get_data(cy_ota_context_t *ctx)
        cy_ota_start_mqtt_timer(ctx, ctx->packet_timeout_sec, CY_OTA_EVENT_PACKET_TIMEOUT);
    }
 
-   /* clear out tally of received / written packets */
-    memset(&ctx->mqtt.received_packets, 0, sizeof(ctx->mqtt.received_packets) );
-
     while (1)
     {
         uint32_t waitfor;
@@ -1458,6 +1484,13 @@ cy_rslt_t cy_ota_mqtt_get_data(cy_ota_context_t *ctx)
         }
     }   /* While 1 */
 
+    /* make sure everything received is in FLASH before we verify */
+    if ( (cy_ota_writer_flush(ctx) != CY_RSLT_SUCCESS) && (result == CY_RSLT_SUCCESS) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_ota_writer_flush() failed\n", __func__);
+        result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+
     cy_log_msg(CYLF_OTA, CY_LOG_DEBUG2, "%s() MQTT DONE result: 0x%lx\n", __func__, result);
 
     for (i = 0;i < ctx->total_packets; i++)
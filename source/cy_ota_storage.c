@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <ctype.h>
 #include <string.h>
 
@@ -30,9 +31,14 @@
 
 #include "flash_map_backend.h"
 #include "sysflash.h"
+#include "ota_serial_flash.h"
 
 #include "cy_log.h"
 
+#if (CY_OTA_IMAGE_SIGNATURE == 1)
+#include "pk.h"
+#endif
+
 /***********************************************************************
  *
  * defines & enums
@@ -86,6 +92,34 @@ static const uint32_t boot_img_magic[] = {
 
 #define BOOT_IMAGE_OK_OFFSET(fap)   (BOOT_MAGIC_OFFSET(fap) - BOOT_MAX_ALIGN)
 
+#if (CY_OTA_JOURNAL == 1)
+/*
+ * Download progress journal
+ *
+ * Each record is written to its own FLASH row, so a write interrupted by a reset
+ * can only damage that one record. The last valid record wins.
+ */
+#define CY_OTA_JOURNAL_MAGIC            (0x4C4E524AUL)      /* "JRNL" */
+#define CY_OTA_JOURNAL_VERSION          (1)
+#define CY_OTA_JOURNAL_RECORD_SPACING   (CY_FLASH_SIZEOF_ROW)
+#define CY_OTA_JOURNAL_NUM_RECORDS      (CY_OTA_JOURNAL_SIZE / CY_OTA_JOURNAL_RECORD_SPACING)
+#define CY_OTA_JOURNAL_AREA_OFFSET(fap) ((fap)->fa_size - CY_OTA_JOURNAL_OFFSET_FROM_END)
+#define CY_OTA_JOURNAL_CRC_INIT         (0UL)
+#endif
+
+#if (CY_OTA_LAZY_ERASE == 1)
+/*
+ * Secondary Slot lazy erase
+ *
+ * The end of the slot (MCUboot trailer and journal area) is erased at storage open,
+ * each other sector just before the first write into it.
+ */
+#if (CY_OTA_JOURNAL == 1) && (CY_OTA_JOURNAL_OFFSET_FROM_END > CY_OTA_LAZY_ERASE_TRAILER_SIZE)
+#define CY_OTA_LAZY_ERASE_TAIL_SIZE     (CY_OTA_JOURNAL_OFFSET_FROM_END)
+#else
+#define CY_OTA_LAZY_ERASE_TAIL_SIZE     (CY_OTA_LAZY_ERASE_TRAILER_SIZE)
+#endif
+#endif
 
 /***********************************************************************
  *
@@ -105,6 +139,22 @@ static const uint32_t boot_img_magic[] = {
  *
  **********************************************************************/
 
+#if (CY_OTA_JOURNAL == 1)
+/**
+ * @brief Download progress journal record, as stored in FLASH
+ */
+typedef struct cy_ota_journal_record_s {
+    uint32_t    magic;          /**< CY_OTA_JOURNAL_MAGIC                                   */
+    uint32_t    version;        /**< CY_OTA_JOURNAL_VERSION                                 */
+    uint32_t    identity;       /**< CRC of server, file and version of the download        */
+    uint32_t    image_size;     /**< Total size of the OTA Image                            */
+    uint32_t    committed;      /**< Data before this offset is in FLASH                    */
+    uint32_t    sequence;       /**< Incremented for each record                            */
+    uint32_t    reserved;       /**< Keep the record a multiple of BOOT_MAX_ALIGN           */
+    uint32_t    crc;            /**< CRC of the fields above                                */
+} cy_ota_journal_record_t;
+#endif
+
 /***********************************************************************
  *
  * Variables
@@ -113,172 +163,1487 @@ static const uint32_t boot_img_magic[] = {
 
 /***********************************************************************
  *
- * functions
+ * Download progress journal
  *
  **********************************************************************/
+#if (CY_OTA_JOURNAL == 1)
+
+static uint32_t cy_ota_journal_crc32(uint32_t prev_crc32, const uint8_t *buffer, uint32_t buffer_length)
+{
+    uint32_t crc32 = ~prev_crc32;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < buffer_length; i++)
+    {
+        crc32 ^= buffer[i];
+        for (j = 0; j < 8; j++)
+        {
+            if (crc32 & 0x1)
+            {
+                crc32 = (crc32 >> 1) ^ 0xEDB88320;
+            }
+            else
+            {
+                crc32 = (crc32 >> 1);
+            }
+        }
+    }
+    return ~crc32;
+}
+
 /**
- * @brief Open Storage area for download
+ * @brief Identify the image being downloaded
  *
- * NOTE: Typically, this erases Secondary Slot
+ * A journal record is only used for a download from the same server, of the same file and version.
  *
- * @param[in]   ota_ptr - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
  *
- * @return  CY_RSLT_SUCCESS
- *          CY_RSLT_OTA_ERROR_OPEN_STORAGE
+ * @return  CRC of the download identity
  */
-cy_rslt_t cy_ota_storage_open(cy_ota_context_ptr ota_ptr)
+static uint32_t cy_ota_journal_identity(cy_ota_context_t *ctx)
 {
-    const struct flash_area *fap;
-    cy_ota_context_t *ctx = (cy_ota_context_t *)ota_ptr;
-    CY_OTA_CONTEXT_ASSERT(ctx);
-    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s()\n", __func__);
+    uint32_t    crc = CY_OTA_JOURNAL_CRC_INIT;
 
-    /* clear out the stats */
-    ctx->total_image_size    = 0;
-    ctx->total_bytes_written = 0;
-    ctx->last_offset         = 0;
-    ctx->last_size           = 0;
-    ctx->storage_loc         = NULL;
+    crc = cy_ota_journal_crc32(crc, (const uint8_t *)&ctx->curr_connect_type, sizeof(ctx->curr_connect_type));
+#if defined(COMPONENT_OTA_HTTP) || defined(COMPONENT_OTA_MQTT)
+    if ( (ctx->curr_server != NULL) && (ctx->curr_server->host_name != NULL) )
+    {
+        crc = cy_ota_journal_crc32(crc, (const uint8_t *)ctx->curr_server->host_name, strlen(ctx->curr_server->host_name));
+        crc = cy_ota_journal_crc32(crc, (const uint8_t *)&ctx->curr_server->port, sizeof(ctx->curr_server->port));
+    }
+#endif
+    if (ctx->network_params.use_get_job_flow == CY_OTA_JOB_FLOW)
+    {
+        crc = cy_ota_journal_crc32(crc, (const uint8_t *)ctx->parsed_job.file, strlen(ctx->parsed_job.file));
+        crc = cy_ota_journal_crc32(crc, (const uint8_t *)ctx->parsed_job.version, strlen(ctx->parsed_job.version));
+        crc = cy_ota_journal_crc32(crc, (const uint8_t *)&ctx->parsed_job.file_size, sizeof(ctx->parsed_job.file_size));
+    }
+#ifdef COMPONENT_OTA_HTTP
+    else if (ctx->network_params.http.file != NULL)
+    {
+        crc = cy_ota_journal_crc32(crc, (const uint8_t *)ctx->network_params.http.file, strlen(ctx->network_params.http.file));
+    }
+#endif
 
-    if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(0), &fap) != 0)
+    return crc;
+}
+
+/**
+ * @brief Find the last valid record in the journal area
+ *
+ * Sets ctx->journal.next_record to the first erased record.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   fap     - Secondary Slot flash area
+ * @param[out]  record  - last valid record
+ *
+ * @return  true if a valid record was found
+ */
+static bool cy_ota_journal_read(cy_ota_context_t *ctx, const struct flash_area *fap, cy_ota_journal_record_t *record)
+{
+    cy_ota_journal_record_t entry;
+    uint32_t                base;
+    uint32_t                erased_magic;
+    uint32_t                i;
+    bool                    found = false;
+
+    base = CY_OTA_JOURNAL_AREA_OFFSET(fap);
+    ctx->journal.next_record = CY_OTA_JOURNAL_NUM_RECORDS;
+    memset(&erased_magic, flash_area_erased_val(fap), sizeof(erased_magic));  /* 0x00 internal, 0xFF external */
+
+    for (i = 0; i < CY_OTA_JOURNAL_NUM_RECORDS; i++)
     {
-        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_open(FLASH_AREA_IMAGE_SECONDARY(0) ) failed\n", __func__);
-        return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+        if (flash_area_read(fap, base + (i * CY_OTA_JOURNAL_RECORD_SPACING), &entry, sizeof(entry)) != 0)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_read() failed\n", __func__);
+            break;
+        }
+        if (entry.magic == erased_magic)
+        {
+            /* erased - no more records */
+            ctx->journal.next_record = i;
+            break;
+        }
+        if ( (entry.magic == CY_OTA_JOURNAL_MAGIC) && (entry.version == CY_OTA_JOURNAL_VERSION) &&
+             (entry.crc == cy_ota_journal_crc32(CY_OTA_JOURNAL_CRC_INIT, (const uint8_t *)&entry, offsetof(cy_ota_journal_record_t, crc))) )
+        {
+            memcpy(record, &entry, sizeof(entry));
+            found = true;
+        }
     }
 
-    cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Erase secondary image slot fap->fa_off: 0x%08lx, size: 0x%08lx\n", fap->fa_off, fap->fa_size);
-    if (flash_area_erase(fap, 0, fap->fa_size) != 0)
+    return found;
+}
+
+/**
+ * @brief Write a record with the current progress
+ *
+ * When the journal area is full it is erased first. A reset between the erase and the
+ * write loses the progress, the next download then starts from the beginning.
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   fap - Secondary Slot flash area
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+static cy_rslt_t cy_ota_journal_write(cy_ota_context_t *ctx, const struct flash_area *fap)
+{
+    cy_ota_journal_record_t record;
+    uint32_t                base;
+
+    base = CY_OTA_JOURNAL_AREA_OFFSET(fap);
+    if (ctx->journal.next_record >= CY_OTA_JOURNAL_NUM_RECORDS)
     {
-        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_erase(fap, 0) failed\r\n", __func__);
-        return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+        if (flash_area_erase(fap, base, CY_OTA_JOURNAL_SIZE) != 0)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_erase() failed\n", __func__);
+            return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+        }
+        ctx->journal.next_record = 0;
     }
 
-    ctx->storage_loc = (void *)fap;
+    memset(&record, 0x00, sizeof(record));
+    record.magic      = CY_OTA_JOURNAL_MAGIC;
+    record.version    = CY_OTA_JOURNAL_VERSION;
+    record.identity   = ctx->journal.identity;
+    record.image_size = ctx->total_image_size;
+    record.committed  = ctx->journal.contiguous;
+    record.sequence   = ctx->journal.sequence + 1;
+    record.crc        = cy_ota_journal_crc32(CY_OTA_JOURNAL_CRC_INIT, (const uint8_t *)&record, offsetof(cy_ota_journal_record_t, crc));
 
+    if (flash_area_write(fap, base + (ctx->journal.next_record * CY_OTA_JOURNAL_RECORD_SPACING), &record, sizeof(record)) != 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_write() failed\n", __func__);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+
+    ctx->journal.next_record++;
+    ctx->journal.sequence  = record.sequence;
+    ctx->journal.committed = record.committed;
+    ctx->journal.commits++;
+
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() committed %ld of %ld seq:%ld\n", __func__,
+               record.committed, record.image_size, record.sequence);
     return CY_RSLT_SUCCESS;
 }
 
 /**
- * @brief Read from storage area
+ * @brief Check for an interrupted download of the same image
  *
- * @param[in]       ota_ptr     - pointer to OTA agent context @ref cy_ota_context_t
- * @param[in][out]  chunk_info  - pointer to chunk information, buffer pointer used for the read
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   fap - Secondary Slot flash area
+ *
+ * @return  true if the download can continue without erasing the Secondary Slot
+ */
+static bool cy_ota_journal_resume(cy_ota_context_t *ctx, const struct flash_area *fap)
+{
+    cy_ota_journal_record_t record;
+
+    /* Bluetooth® downloads are driven by the peer and always start over */
+    if (ctx->curr_connect_type == CY_OTA_CONNECTION_BLE)
+    {
+        return false;
+    }
+
+    ctx->journal.active   = 1;
+    ctx->journal.identity = cy_ota_journal_identity(ctx);
+
+    if (cy_ota_journal_read(ctx, fap, &record) == false)
+    {
+        return false;
+    }
+
+    ctx->journal.sequence = record.sequence;
+    if ( (record.identity != ctx->journal.identity) || (record.committed == 0) ||
+         (record.committed >= record.image_size) || (record.image_size > CY_OTA_JOURNAL_AREA_OFFSET(fap)) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Journal is for a different download, start over\n");
+        return false;
+    }
+
+    ctx->journal.resume_offset     = record.committed;
+    ctx->journal.resume_image_size = record.image_size;
+    ctx->journal.contiguous        = record.committed;
+    ctx->journal.committed         = record.committed;
+
+    /* only single file images are recorded in the journal */
+    ctx->ota_is_tar_archive = 0;
+
+    cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Resume download at %ld of %ld, keep Secondary Slot\n",
+               record.committed, record.image_size);
+    return true;
+}
+
+#endif  /* CY_OTA_JOURNAL == 1 */
+
+/***********************************************************************
+ *
+ * Secondary Slot lazy erase
+ *
+ **********************************************************************/
+#if (CY_OTA_LAZY_ERASE == 1)
+
+/**
+ * @brief Check if a sector is ready to write
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   sector  - sector in the Secondary Slot
+ *
+ * @return  true if the sector is erased (or holds data kept for this download)
+ */
+static bool cy_ota_lazy_erase_is_erased(cy_ota_context_t *ctx, uint32_t sector)
+{
+    return ( (ctx->lazy_erase.erased[sector / 8] & (1 << (sector % 8))) != 0);
+}
+
+/**
+ * @brief Mark sectors as ready to write
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   first   - first sector
+ * @param[in]   end     - sector after the last one
+ */
+static void cy_ota_lazy_erase_mark(cy_ota_context_t *ctx, uint32_t first, uint32_t end)
+{
+    uint32_t    sector;
+
+    for (sector = first; sector < end; sector++)
+    {
+        ctx->lazy_erase.erased[sector / 8] |= (uint8_t)(1 << (sector % 8));
+    }
+}
+
+/**
+ * @brief Erase one sector of the Secondary Slot and mark it
+ *
+ * With the erase-ahead thread running, call with the FLASH lock held.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   fap     - Secondary Slot flash area
+ * @param[in]   sector  - sector to erase
  *
  * @return  CY_RSLT_SUCCESS
- *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
  */
-cy_rslt_t cy_ota_storage_read(cy_ota_context_ptr ctx_ptr, cy_ota_storage_write_info_t *chunk_info)
+static cy_rslt_t cy_ota_lazy_erase_sector(cy_ota_context_t *ctx, const struct flash_area *fap, uint32_t sector)
 {
-    const struct flash_area     *fap;
-    cy_ota_context_t *ctx = (cy_ota_context_t *)ctx_ptr;
+    uint32_t    offset = sector * ctx->lazy_erase.sector_size;
+
+    if (flash_area_erase(fap, offset, ctx->lazy_erase.sector_size) != 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_erase(0x%lx) failed\n", __func__, offset);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+    cy_ota_lazy_erase_mark(ctx, sector, sector + 1);
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Erase size to use for the Secondary Slot
+ *
+ * The larger of CY_OTA_ERASE_SECTOR_SIZE and, for external FLASH, the erase sector
+ * size at both ends of the slot (ota_smif_get_erase_size()). ota_smif_erase()
+ * erases whole FLASH sectors, a smaller size would erase data already written.
+ *
+ * @param[in]   fap - Secondary Slot flash area
+ *
+ * @return  erase size in bytes
+ */
+static uint32_t cy_ota_lazy_erase_sector_size(const struct flash_area *fap)
+{
+    uint32_t    size = CY_OTA_ERASE_SECTOR_SIZE;
+#ifdef CY_IP_MXSMIF
+    uint32_t    smif_size;
+    uint32_t    addr = fap->fa_off;
+
+    if ((fap->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
+    {
+#ifdef COMPONENT_OTA_MCUBOOT_PSOC
+        addr -= CY_SMIF_BASE_MEM_OFFSET;    /* external slot offsets are XIP addresses */
+#endif
+        smif_size = ota_smif_get_erase_size(addr);
+        if (smif_size > size)
+        {
+            size = smif_size;
+        }
+        smif_size = ota_smif_get_erase_size(addr + fap->fa_size - 1);
+        if (smif_size > size)
+        {
+            size = smif_size;
+        }
+    }
+#else
+    (void)fap;
+#endif
+    return size;
+}
+
+#if (CY_OTA_ERASE_AHEAD_SECTORS > 0)
+
+#define OTA_ERASE_THREAD_NAME       "CY OTA Erase"
+
+/**
+ * @brief Erase-ahead thread
+ *
+ * Erases the sectors from ahead_first up to ahead_end that are not erased yet, one at a
+ * time with the FLASH lock held, then waits for cy_ota_storage_prepare_write() to move
+ * the range. After an erase failure it stops erasing, the writer erases and reports.
+ *
+ * @param[in]   arg - pointer to OTA agent context @ref cy_ota_context_t
+ */
+static void cy_ota_erase_ahead_thread(cy_thread_arg_t arg)
+{
+    cy_ota_context_t        *ctx = (cy_ota_context_t *)arg;
+    const struct flash_area *fap;
+    uint32_t                sector;
+    bool                    erased;
     CY_OTA_CONTEXT_ASSERT(ctx);
 
-    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() buf:%p len:%ld off: 0x%lx (%ld)\n", __func__,
-                             chunk_info->buffer, chunk_info->size,
-                             chunk_info->offset, chunk_info->offset);
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() Entered OTA Erase Thread\n", __func__);
 
-    /* Always read from secondary slot */
-    fap = (const struct flash_area *)ctx->storage_loc;
-    if (fap != NULL)
+    while (1)
     {
-        /* read into the chunk_info buffer */
-        if (flash_area_read(fap, chunk_info->offset, chunk_info->buffer, chunk_info->size) != CY_RSLT_SUCCESS)
+        if (cy_rtos_get_semaphore(&ctx->lazy_erase.wake_sem, CY_RTOS_NEVER_TIMEOUT, false) != CY_RSLT_SUCCESS)
         {
-            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "flash_area_read() failed \n");
-            return CY_RSLT_OTA_ERROR_READ_STORAGE;
+            continue;
         }
-        return CY_RSLT_SUCCESS;
+
+        while (ctx->lazy_erase.stop == 0)
+        {
+            erased = false;
+            cy_rtos_get_mutex(&ctx->lazy_erase.lock, CY_RTOS_NEVER_TIMEOUT);
+            fap = (const struct flash_area *)ctx->storage_loc;
+            for (sector = ctx->lazy_erase.ahead_first; (fap != NULL) && (sector < ctx->lazy_erase.ahead_end); sector++)
+            {
+                if (!cy_ota_lazy_erase_is_erased(ctx, sector))
+                {
+                    if (cy_ota_lazy_erase_sector(ctx, fap, sector) != CY_RSLT_SUCCESS)
+                    {
+                        ctx->lazy_erase.failed = 1;
+                        break;
+                    }
+                    ctx->lazy_erase.ahead_erases++;
+                    erased = true;
+                    break;
+                }
+            }
+            cy_rtos_set_mutex(&ctx->lazy_erase.lock);
+            if ( !erased || (ctx->lazy_erase.failed != 0) )
+            {
+                break;
+            }
+        }
+
+        if (ctx->lazy_erase.stop != 0)
+        {
+            break;
+        }
+    }
+
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() exiting, erased %ld sectors ahead\n", __func__, ctx->lazy_erase.ahead_erases);
+
+    cy_rtos_exit_thread();
+}
+
+/**
+ * @brief Create the lock and start the erase-ahead thread
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GENERAL
+ */
+static cy_rslt_t cy_ota_erase_ahead_start(cy_ota_context_t *ctx)
+{
+    cy_rslt_t result;
+
+    ctx->lazy_erase.stop = 0;
+    if (cy_rtos_init_mutex(&ctx->lazy_erase.lock) != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_rtos_init_mutex() failed\n", __func__);
+        return CY_RSLT_OTA_ERROR_GENERAL;
+    }
+    if (cy_rtos_init_semaphore(&ctx->lazy_erase.wake_sem, 1, 0) != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_rtos_init_semaphore() failed\n", __func__);
+        cy_rtos_deinit_mutex(&ctx->lazy_erase.lock);
+        return CY_RSLT_OTA_ERROR_GENERAL;
+    }
+
+    result = cy_rtos_create_thread(&ctx->lazy_erase.thread, cy_ota_erase_ahead_thread,
+                                   OTA_ERASE_THREAD_NAME, NULL, CY_OTA_ERASE_THREAD_STACK_SIZE,
+                                   CY_RTOS_PRIORITY_BELOWNORMAL, ctx);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_rtos_create_thread() failed 0x%lx\n", __func__, result);
+        cy_rtos_deinit_semaphore(&ctx->lazy_erase.wake_sem);
+        cy_rtos_deinit_mutex(&ctx->lazy_erase.lock);
+        return CY_RSLT_OTA_ERROR_GENERAL;
+    }
+
+    ctx->lazy_erase.running = 1;
+    return CY_RSLT_SUCCESS;
+}
+
+#endif  /* CY_OTA_ERASE_AHEAD_SECTORS > 0 */
+
+/**
+ * @brief Set up lazy erase for a download
+ *
+ * Erases the end of the Secondary Slot unless an interrupted download is resumed.
+ * When resumed, the sectors with data before the resume offset are kept.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   fap     - Secondary Slot flash area
+ * @param[in]   resumed - true if the download continues from ctx->journal.resume_offset
+ *
+ * @return  true  - sectors are erased on the first write
+ *          false - the whole slot must be erased now
+ */
+static bool cy_ota_lazy_erase_start(cy_ota_context_t *ctx, const struct flash_area *fap, bool resumed)
+{
+    uint32_t    sector_size = cy_ota_lazy_erase_sector_size(fap);
+    uint32_t    tail;
+
+    cy_ota_storage_erase_ahead_stop(ctx);
+    memset(&ctx->lazy_erase, 0x00, sizeof(ctx->lazy_erase));
+    if ( ((fap->fa_size % sector_size) != 0) ||
+         ((fap->fa_size / sector_size) > CY_OTA_LAZY_ERASE_MAX_SECTORS) ||
+         (fap->fa_size <= CY_OTA_LAZY_ERASE_TAIL_SIZE) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() slot size 0x%08lx does not fit erase size 0x%lx / CY_OTA_LAZY_ERASE_MAX_SECTORS\n",
+                   __func__, fap->fa_size, sector_size);
+        return false;
+    }
+    ctx->lazy_erase.sector_size = sector_size;
+    ctx->lazy_erase.sectors     = fap->fa_size / sector_size;
+    tail = (fap->fa_size - CY_OTA_LAZY_ERASE_TAIL_SIZE) / sector_size;
+
+    if (resumed)
+    {
+        cy_ota_lazy_erase_mark(ctx, 0, (ctx->journal.resume_offset + sector_size - 1) / sector_size);
+    }
+    else
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Erase secondary image slot trailer off: 0x%08lx, size: 0x%08lx\n",
+                   (tail * sector_size), (fap->fa_size - (tail * sector_size)));
+        if (flash_area_erase(fap, (tail * sector_size), (fap->fa_size - (tail * sector_size))) != 0)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_erase() failed\n", __func__);
+            return false;
+        }
+    }
+    cy_ota_lazy_erase_mark(ctx, tail, ctx->lazy_erase.sectors);
+    ctx->lazy_erase.active = 1;
+
+#if (CY_OTA_ERASE_AHEAD_SECTORS > 0)
+    /* start with the first sectors of the image, before the first write */
+    ctx->lazy_erase.ahead_end = CY_OTA_ERASE_AHEAD_SECTORS;
+    if (cy_ota_erase_ahead_start(ctx) == CY_RSLT_SUCCESS)
+    {
+        cy_rtos_set_semaphore(&ctx->lazy_erase.wake_sem, false);
+    }
+#endif
+    return true;
+}
+
+#endif  /* CY_OTA_LAZY_ERASE == 1 */
+
+/**
+ * @brief Take the FLASH lock shared with the erase-ahead thread
+ *
+ * Does nothing unless the erase-ahead thread is running.
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ */
+static void cy_ota_storage_lock(cy_ota_context_t *ctx)
+{
+#if (CY_OTA_LAZY_ERASE == 1) && (CY_OTA_ERASE_AHEAD_SECTORS > 0)
+    if ( (ctx != NULL) && (ctx->lazy_erase.running != 0) )
+    {
+        cy_rtos_get_mutex(&ctx->lazy_erase.lock, CY_RTOS_NEVER_TIMEOUT);
+    }
+#else
+    (void)ctx;
+#endif
+}
+
+/**
+ * @brief Release the FLASH lock taken by cy_ota_storage_lock()
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ */
+static void cy_ota_storage_unlock(cy_ota_context_t *ctx)
+{
+#if (CY_OTA_LAZY_ERASE == 1) && (CY_OTA_ERASE_AHEAD_SECTORS > 0)
+    if ( (ctx != NULL) && (ctx->lazy_erase.running != 0) )
+    {
+        cy_rtos_set_mutex(&ctx->lazy_erase.lock);
+    }
+#else
+    (void)ctx;
+#endif
+}
+
+/**
+ * @brief Close the Secondary Slots of other images opened by cy_ota_storage_get_slot()
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ */
+static void cy_ota_storage_close_slots(cy_ota_context_t *ctx)
+{
+    uint16_t    image;
+
+    for (image = 0; image < CY_OTA_SECONDARY_SLOTS; image++)
+    {
+        if (ctx->slot_loc[image] != NULL)
+        {
+            flash_area_close((const struct flash_area *)ctx->slot_loc[image]);
+            ctx->slot_loc[image] = NULL;
+        }
+    }
+}
+
+#if (CY_OTA_IMAGE_HASH == 1)
+
+/***********************************************************************
+ *
+ * MCUboot image hash
+ *
+ **********************************************************************/
+
+/**
+ * @brief MCUboot image header and TLV values
+ */
+#define CY_OTA_IMAGE_MAGIC              (0x96f3b83dUL)
+#define CY_OTA_IMAGE_TLV_INFO_MAGIC     (0x6907)        /* unprotected TLV area, follows the protected one */
+#define CY_OTA_IMAGE_TLV_SHA256         (0x10)
+#define CY_OTA_IMAGE_TLV_ECDSA256       (0x22)
+#define CY_OTA_IMAGE_HASH_SIZE          (32)
+
+/**
+ * @brief Size of the FLASH reads in cy_ota_image_hash_check() (also the largest signature TLV)
+ */
+#define CY_OTA_IMAGE_READ_SIZE          (128)
+
+#if (CY_OTA_IMAGE_SIGNATURE == 1)
+/* ECDSA P-256 public key provided by the application, imgtool keys.c names */
+extern const unsigned char ecdsa_pub_key[];
+extern const unsigned int ecdsa_pub_key_len;
+#endif
+
+static uint16_t cy_ota_image_get_u16(const uint8_t *ptr)
+{
+    return (uint16_t)(ptr[0] | (ptr[1] << 8));
+}
+
+static uint32_t cy_ota_image_get_u32(const uint8_t *ptr)
+{
+    return ((uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24));
+}
+
+/**
+ * @brief Start the image hash for a new download
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ */
+static void cy_ota_image_hash_start(cy_ota_context_t *ctx)
+{
+    cy_ota_image_hash_context_t *ih = &ctx->image_hash;
+
+    if (ih->active != 0)
+    {
+        mbedtls_sha256_free(&ih->sha);
+    }
+    memset(ih, 0x00, sizeof(cy_ota_image_hash_context_t));
+    mbedtls_sha256_init(&ih->sha);
+    mbedtls_sha256_starts_ret(&ih->sha, 0);
+    ih->hash_end = UINT32_MAX;
+    ih->active = 1;
+}
+
+/**
+ * @brief Hash the next image bytes
+ *
+ * Keeps the MCUboot header, and stops at the end of the protected TLVs once the
+ * header is known. Stops the hash if the data is not an MCUboot image.
+ *
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   buffer  - data at offset image_hash.hashed
+ * @param[in]   size    - size of the data
+ */
+static void cy_ota_image_hash_add(cy_ota_context_t *ctx, const uint8_t *buffer, uint32_t size)
+{
+    cy_ota_image_hash_context_t *ih = &ctx->image_hash;
+    uint32_t    part;
+
+    while ( (size > 0) && (ih->active != 0) && (ih->hashed < ih->hash_end) )
+    {
+        if (ih->hashed < CY_OTA_IMAGE_HEADER_SIZE)
+        {
+            part = CY_OTA_IMAGE_HEADER_SIZE - ih->hashed;
+            part = (size < part) ? size : part;
+            memcpy(&ih->header[ih->hashed], buffer, part);
+        }
+        else
+        {
+            part = ih->hash_end - ih->hashed;
+            part = (size < part) ? size : part;
+        }
+        mbedtls_sha256_update_ret(&ih->sha, buffer, part);
+        ih->hashed += part;
+        buffer     += part;
+        size       -= part;
+
+        if ( (ih->hashed == CY_OTA_IMAGE_HEADER_SIZE) && (ih->hash_end == UINT32_MAX) )
+        {
+            if (cy_ota_image_get_u32(&ih->header[0]) != CY_OTA_IMAGE_MAGIC)
+            {
+                cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() not an MCUboot image, magic 0x%08lx\n", __func__, cy_ota_image_get_u32(&ih->header[0]));
+                mbedtls_sha256_free(&ih->sha);
+                ih->active = 0;
+                break;
+            }
+            /* ih_hdr_size + ih_img_size + ih_protect_tlv_size */
+            ih->hash_end = (uint32_t)cy_ota_image_get_u16(&ih->header[8]) + cy_ota_image_get_u32(&ih->header[12]) +
+                           (uint32_t)cy_ota_image_get_u16(&ih->header[10]);
+        }
+    }
+}
+
+#if (CY_OTA_IMAGE_SIGNATURE == 1)
+/**
+ * @brief Check the ECDSA P-256 signature of the image hash
+ *
+ * @param[in]   digest  - SHA-256 of the image
+ * @param[in]   sig     - DER signature from the TLV
+ * @param[in]   sig_len - size of the signature
+ *
+ * @return  0 = signature is good
+ */
+static int cy_ota_image_signature_check(const uint8_t *digest, const uint8_t *sig, uint32_t sig_len)
+{
+    mbedtls_pk_context  pk;
+    int                 ret;
+
+    mbedtls_pk_init(&pk);
+    ret = mbedtls_pk_parse_public_key(&pk, ecdsa_pub_key, ecdsa_pub_key_len);
+    if (ret == 0)
+    {
+        ret = mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, digest, CY_OTA_IMAGE_HASH_SIZE, sig, sig_len);
+    }
+    mbedtls_pk_free(&pk);
+    return ret;
+}
+#endif
+
+/**
+ * @brief Compare the image hash with the SHA256 TLV of the image in the Secondary Slot
+ *
+ * Data that was not hashed while writing (out of order or resumed download) is read
+ * back first, then only the TLV area is read.
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   fap - Secondary Slot of image 0
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_VERIFY
+ */
+static cy_rslt_t cy_ota_image_hash_check(cy_ota_context_t *ctx, const struct flash_area *fap)
+{
+    cy_ota_image_hash_context_t *ih = &ctx->image_hash;
+    uint8_t     buffer[CY_OTA_IMAGE_READ_SIZE];
+    uint8_t     digest[CY_OTA_IMAGE_HASH_SIZE];
+    uint32_t    readback = 0;
+    uint32_t    size;
+    uint32_t    off;
+    uint32_t    end;
+    uint16_t    type;
+    uint16_t    len;
+    bool        hash_ok = false;
+    bool        sig_ok = (CY_OTA_IMAGE_SIGNATURE == 0);
+    cy_time_t   start_time;
+    cy_time_t   end_time;
+
+    cy_rtos_get_time(&start_time);
+
+    /* data that did not arrive in order */
+    while ( (ih->active != 0) && (ih->hashed < ih->hash_end) )
+    {
+        size = ih->hash_end - ih->hashed;
+        size = (size < sizeof(buffer)) ? size : sizeof(buffer);
+        if ( (ih->hashed + size > fap->fa_size) || (flash_area_read(fap, ih->hashed, buffer, size) != 0) )
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() image read failed at 0x%lx\n", __func__, ih->hashed);
+            return CY_RSLT_OTA_ERROR_VERIFY;
+        }
+        cy_ota_image_hash_add(ctx, buffer, size);
+        readback += size;
+    }
+    if (ih->active == 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() no MCUboot image in the Secondary Slot\n", __func__);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    mbedtls_sha256_finish_ret(&ih->sha, digest);
+    mbedtls_sha256_free(&ih->sha);
+    ih->active = 0;
+
+    /* unprotected TLV area: info { magic, tlv_tot } then { type, len } entries */
+    off = ih->hash_end;
+    if ( (off + 4 > fap->fa_size) || (flash_area_read(fap, off, buffer, 4) != 0) ||
+         (cy_ota_image_get_u16(&buffer[0]) != CY_OTA_IMAGE_TLV_INFO_MAGIC) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() no TLV area at 0x%lx\n", __func__, off);
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+    end = off + cy_ota_image_get_u16(&buffer[2]);
+    off += 4;
+    while ( (off + 4 <= end) && (end <= fap->fa_size) )
+    {
+        if (flash_area_read(fap, off, buffer, 4) != 0)
+        {
+            break;
+        }
+        type = cy_ota_image_get_u16(&buffer[0]);
+        len  = cy_ota_image_get_u16(&buffer[2]);
+        off += 4;
+        if ( (type == CY_OTA_IMAGE_TLV_SHA256) && (len == CY_OTA_IMAGE_HASH_SIZE) )
+        {
+            if (flash_area_read(fap, off, buffer, len) != 0)
+            {
+                break;
+            }
+            hash_ok = (memcmp(buffer, digest, CY_OTA_IMAGE_HASH_SIZE) == 0);
+        }
+#if (CY_OTA_IMAGE_SIGNATURE == 1)
+        else if ( (type == CY_OTA_IMAGE_TLV_ECDSA256) && (len <= sizeof(buffer)) )
+        {
+            if (flash_area_read(fap, off, buffer, len) != 0)
+            {
+                break;
+            }
+            sig_ok = (cy_ota_image_signature_check(digest, buffer, len) == 0);
+        }
+#endif
+        off += len;
+    }
+
+    cy_rtos_get_time(&end_time);
+    cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Image hash %s signature %s, read back %ld bytes, %ld ms\n",
+               (hash_ok ? "good" : "BAD"), (sig_ok ? ((CY_OTA_IMAGE_SIGNATURE == 1) ? "good" : "not checked") : "BAD"),
+               readback, (end_time - start_time));
+
+    return ( (hash_ok && sig_ok) ? CY_RSLT_SUCCESS : CY_RSLT_OTA_ERROR_VERIFY );
+}
+
+#endif  /* CY_OTA_IMAGE_HASH == 1 */
+
+/***********************************************************************
+ *
+ * functions
+ *
+ **********************************************************************/
+/**
+ * @brief Open Storage area for download
+ *
+ * NOTE: Typically, this erases Secondary Slot
+ *       With CY_OTA_LAZY_ERASE, only the end of the slot is erased here,
+ *       see cy_ota_storage_prepare_write().
+ *
+ * @param[in]   ota_ptr - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_OPEN_STORAGE
+ */
+cy_rslt_t cy_ota_storage_open(cy_ota_context_ptr ota_ptr)
+{
+    const struct flash_area *fap;
+    cy_ota_context_t *ctx = (cy_ota_context_t *)ota_ptr;
+    CY_OTA_CONTEXT_ASSERT(ctx);
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s()\n", __func__);
+
+    /* a writer left over from a previous download must not write into the erased slot */
+    cy_ota_writer_stop(ctx);
+    cy_ota_storage_erase_ahead_stop(ctx);
+    cy_ota_write_discard();
+    cy_ota_storage_close_slots(ctx);
+
+    /* clear out the stats */
+    ctx->total_image_size    = 0;
+    ctx->total_bytes_written = 0;
+    ctx->last_offset         = 0;
+    ctx->last_size           = 0;
+    ctx->storage_loc         = NULL;
+    memset(&ctx->journal, 0x00, sizeof(ctx->journal));
+#if (CY_OTA_DECOMPRESS == 1)
+    ctx->decompress.active   = 0;
+#endif
+#if (CY_OTA_DELTA == 1)
+    ctx->delta.active        = 0;
+#endif
+#if (CY_OTA_DELTA == 1) || (CY_OTA_BLOCK_REUSE == 1)
+    cy_ota_storage_primary_close(ctx);
+#endif
+#if (CY_OTA_IMAGE_HASH == 1)
+    cy_ota_image_hash_start(ctx);
+#endif
+
+    if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(0), &fap) != 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_open(FLASH_AREA_IMAGE_SECONDARY(0) ) failed\n", __func__);
+        return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+    }
+
+#if (CY_OTA_JOURNAL == 1)
+    if (cy_ota_journal_resume(ctx, fap) == true)
+    {
+        ctx->storage_loc = (void *)fap;
+#if (CY_OTA_LAZY_ERASE == 1)
+        cy_ota_lazy_erase_start(ctx, fap, true);
+#endif
+        return CY_RSLT_SUCCESS;
+    }
+    ctx->journal.next_record = 0;    /* the journal area is erased with the slot */
+#endif
+
+#if (CY_OTA_LAZY_ERASE == 1)
+    /* the erase-ahead thread erases through storage_loc */
+    ctx->storage_loc = (void *)fap;
+    if (cy_ota_lazy_erase_start(ctx, fap, false) == true)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+    ctx->storage_loc = NULL;
+#endif
+
+    cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Erase secondary image slot fap->fa_off: 0x%08lx, size: 0x%08lx\n", fap->fa_off, fap->fa_size);
+    if (flash_area_erase(fap, 0, fap->fa_size) != 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_erase(fap, 0) failed\r\n", __func__);
+        return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+    }
+
+    ctx->storage_loc = (void *)fap;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Read from storage area
+ *
+ * @param[in]       ota_ptr     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in][out]  chunk_info  - pointer to chunk information, buffer pointer used for the read
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ */
+cy_rslt_t cy_ota_storage_read(cy_ota_context_ptr ctx_ptr, cy_ota_storage_write_info_t *chunk_info)
+{
+    const struct flash_area     *fap;
+    cy_ota_context_t *ctx = (cy_ota_context_t *)ctx_ptr;
+    CY_OTA_CONTEXT_ASSERT(ctx);
+
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() buf:%p len:%ld off: 0x%lx (%ld)\n", __func__,
+                             chunk_info->buffer, chunk_info->size,
+                             chunk_info->offset, chunk_info->offset);
+
+    /* Always read from secondary slot */
+    fap = (const struct flash_area *)ctx->storage_loc;
+    if (fap != NULL)
+    {
+        /* read into the chunk_info buffer */
+        cy_ota_storage_lock(ctx);
+        if (flash_area_read(fap, chunk_info->offset, chunk_info->buffer, chunk_info->size) != CY_RSLT_SUCCESS)
+        {
+            cy_ota_storage_unlock(ctx);
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "flash_area_read() failed \n");
+            return CY_RSLT_OTA_ERROR_READ_STORAGE;
+        }
+        cy_ota_storage_unlock(ctx);
+        return CY_RSLT_SUCCESS;
+    }
+
+    cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area invalid\r\n", __func__);
+    return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+}
+
+/**
+ * @brief Write to storage area
+ *
+ * @param[in]   ctx         - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   chunk_info  - pointer to chunk information
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+cy_rslt_t cy_ota_storage_write(cy_ota_context_ptr ctx_ptr, cy_ota_storage_write_info_t *chunk_info)
+{
+    const struct flash_area *fap;
+    cy_ota_context_t *ctx = (cy_ota_context_t *)ctx_ptr;
+    CY_OTA_CONTEXT_ASSERT(ctx);
+
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() buf:%p len:%ld off: 0x%lx (%ld)\n", __func__,
+                             chunk_info->buffer, chunk_info->size,
+                             chunk_info->offset, chunk_info->offset);
+
+    /* write to secondary slot */
+    fap = (const struct flash_area *)ctx->storage_loc;
+    if (fap != NULL)
+    {
+        if (cy_ota_storage_prepare_write(ctx, chunk_info->offset, chunk_info->size) != CY_RSLT_SUCCESS)
+        {
+            return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+        }
+        if (flash_area_write(fap, chunk_info->offset, chunk_info->buffer, chunk_info->size) != CY_RSLT_SUCCESS)
+        {
+            cy_ota_storage_write_done(ctx);
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "flash_area_write() failed\n");
+            return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+        }
+        cy_ota_storage_write_done(ctx);
+        return CY_RSLT_SUCCESS;
+    }
+
+    cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() no fap!\n", __func__);
+    return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+}
+
+/**
+ * @brief Close Storage area for download
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_CLOSE_STORAGE
+ */
+cy_rslt_t cy_ota_storage_close(cy_ota_context_ptr ctx_ptr)
+{
+    const struct flash_area *fap;
+    cy_rslt_t result;
+    cy_ota_context_t *ctx = (cy_ota_context_t *)ctx_ptr;
+    CY_OTA_CONTEXT_ASSERT(ctx);
+
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s()\n", __func__);
+
+    /* finish any queued writes and the last FLASH rows */
+    cy_ota_writer_stop(ctx);
+    result = cy_ota_write_flush(ctx);
+    if (cy_ota_writer_check_complete(ctx) != CY_RSLT_SUCCESS)
+    {
+        result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+
+#if (CY_OTA_DELTA == 1) || (CY_OTA_BLOCK_REUSE == 1)
+    cy_ota_storage_primary_close(ctx);
+#endif
+
+#if (CY_OTA_LAZY_ERASE == 1)
+    cy_ota_storage_erase_ahead_stop(ctx);
+    if (ctx->lazy_erase.active != 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Erased %ld of %ld sectors while writing (%ld ahead), writer waited %ld times, %ld ms\n",
+                   (ctx->lazy_erase.erases + ctx->lazy_erase.ahead_erases), ctx->lazy_erase.sectors,
+                   ctx->lazy_erase.ahead_erases, ctx->lazy_erase.waits, ctx->lazy_erase.wait_ms);
+    }
+#endif
+
+    /* close secondary slots */
+    cy_ota_storage_close_slots(ctx);
+    fap = (const struct flash_area *)ctx->storage_loc;
+    if (fap == NULL)
+    {
+        return CY_RSLT_OTA_ERROR_CLOSE_STORAGE;
+    }
+    flash_area_close(fap);
+
+    return result;
+}
+
+cy_rslt_t cy_ota_storage_prepare_write(cy_ota_context_t *ctx, uint32_t offset, uint32_t size)
+{
+#if (CY_OTA_LAZY_ERASE == 1)
+    const struct flash_area *fap;
+    cy_time_t               start_time;
+    cy_time_t               end_time;
+    uint32_t                sector;
+    uint32_t                first;
+    uint32_t                end;
+#if (CY_OTA_ERASE_AHEAD_SECTORS > 0)
+    uint32_t                limit;
+#endif
+    bool                    waited = false;
+
+    if ( (ctx == NULL) || (ctx->lazy_erase.active == 0) )
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    if (size == 0)
+    {
+        cy_ota_storage_lock(ctx);
+        return CY_RSLT_SUCCESS;
+    }
+
+    fap   = (const struct flash_area *)ctx->storage_loc;
+    first = offset / ctx->lazy_erase.sector_size;
+    end   = (offset + size + ctx->lazy_erase.sector_size - 1) / ctx->lazy_erase.sector_size;
+    if ( (fap == NULL) || (end > ctx->lazy_erase.sectors) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() write off:0x%lx size:0x%lx outside of the slot\n", __func__, offset, size);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+
+    /* the erase-ahead thread may be in the middle of an erase */
+    cy_rtos_get_time(&start_time);
+    cy_ota_storage_lock(ctx);
+
+    for (sector = first; sector < end; sector++)
+    {
+        if (cy_ota_lazy_erase_is_erased(ctx, sector))
+        {
+            continue;
+        }
+        if (cy_ota_lazy_erase_sector(ctx, fap, sector) != CY_RSLT_SUCCESS)
+        {
+            cy_ota_storage_write_done(ctx);
+            return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+        }
+        ctx->lazy_erase.erases++;
+        waited = true;
+    }
+
+    cy_rtos_get_time(&end_time);
+#if (CY_OTA_ERASE_AHEAD_SECTORS > 0)
+    if (ctx->lazy_erase.running != 0)
+    {
+        /* any time spent here was an erase, by this thread or the erase-ahead thread */
+        if ( (end_time - start_time) > 0)
+        {
+            waited = true;
+        }
+        /* do not erase past the download, a compressed or delta image is larger, the writer erases the rest */
+        limit = ctx->lazy_erase.sectors;
+        if ( (ctx->total_image_size > 0) &&
+             (((ctx->total_image_size + ctx->lazy_erase.sector_size - 1) / ctx->lazy_erase.sector_size) < limit) )
+        {
+            limit = (ctx->total_image_size + ctx->lazy_erase.sector_size - 1) / ctx->lazy_erase.sector_size;
+        }
+        if ( ((end + CY_OTA_ERASE_AHEAD_SECTORS) > ctx->lazy_erase.ahead_end) && (end < limit) )
+        {
+            ctx->lazy_erase.ahead_first = end;
+            ctx->lazy_erase.ahead_end   = end + CY_OTA_ERASE_AHEAD_SECTORS;
+            if (ctx->lazy_erase.ahead_end > limit)
+            {
+                ctx->lazy_erase.ahead_end = limit;
+            }
+            cy_rtos_set_semaphore(&ctx->lazy_erase.wake_sem, false);
+        }
+    }
+#endif
+    if (waited)
+    {
+        ctx->lazy_erase.waits++;
+        ctx->lazy_erase.wait_ms += (end_time - start_time);
+        cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() writer waited %ld ms on erase at off:0x%lx\n", __func__,
+                   (end_time - start_time), offset);
+    }
+#else
+    (void)ctx;
+    (void)offset;
+    (void)size;
+#endif
+    return CY_RSLT_SUCCESS;
+}
+
+void *cy_ota_storage_get_slot(cy_ota_context_t *ctx, uint16_t image)
+{
+    const struct flash_area *fap;
+
+    if ( (image == 0) && (ctx->storage_loc != NULL) )
+    {
+        return ctx->storage_loc;
+    }
+    if (image >= CY_OTA_SECONDARY_SLOTS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() no Secondary Slot for image %d\n", __func__, image);
+        return NULL;
+    }
+    if (ctx->slot_loc[image] == NULL)
+    {
+        if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(image), &fap) != 0)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_open(FLASH_AREA_IMAGE_SECONDARY(%d)) failed\n", __func__, image);
+            return NULL;
+        }
+        ctx->slot_loc[image] = (void *)fap;
+    }
+    return ctx->slot_loc[image];
+}
+
+void cy_ota_storage_write_done(cy_ota_context_t *ctx)
+{
+    cy_ota_storage_unlock(ctx);
+}
+
+void cy_ota_storage_image_hash(cy_ota_context_t *ctx, uint32_t offset, const uint8_t *buffer, uint32_t size)
+{
+#if (CY_OTA_IMAGE_HASH == 1)
+    uint32_t    skip;
+
+    /* only data that continues the hashed data, gaps are read back at verify */
+    if ( (ctx->image_hash.active == 0) || (offset > ctx->image_hash.hashed) || ((offset + size) <= ctx->image_hash.hashed) )
+    {
+        return;
+    }
+    skip = ctx->image_hash.hashed - offset;
+    cy_ota_image_hash_add(ctx, &buffer[skip], (size - skip));
+#else
+    (void)ctx;
+    (void)offset;
+    (void)buffer;
+    (void)size;
+#endif
+}
+
+void cy_ota_storage_erase_ahead_stop(cy_ota_context_t *ctx)
+{
+#if (CY_OTA_LAZY_ERASE == 1) && (CY_OTA_ERASE_AHEAD_SECTORS > 0)
+    if ( (ctx == NULL) || (ctx->lazy_erase.running == 0) )
+    {
+        return;
+    }
+
+    ctx->lazy_erase.stop = 1;
+    cy_rtos_set_semaphore(&ctx->lazy_erase.wake_sem, false);
+    cy_rtos_join_thread(&ctx->lazy_erase.thread);
+
+    cy_rtos_deinit_semaphore(&ctx->lazy_erase.wake_sem);
+    cy_rtos_deinit_mutex(&ctx->lazy_erase.lock);
+    ctx->lazy_erase.running = 0;
+#else
+    (void)ctx;
+#endif
+}
+
+void cy_ota_storage_journal_update(cy_ota_context_t *ctx, uint32_t offset, uint32_t size)
+{
+#if (CY_OTA_JOURNAL == 1)
+    const struct flash_area *fap;
+
+    if ( (ctx == NULL) || (ctx->journal.active == 0) || (ctx->ota_is_tar_archive != 0) )
+    {
+        return;
+    }
+
+    fap = (const struct flash_area *)ctx->storage_loc;
+    if (fap == NULL)
+    {
+        return;
+    }
+
+    if ( (ctx->total_image_size == 0) || (ctx->total_image_size > CY_OTA_JOURNAL_AREA_OFFSET(fap)) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "%s() image size %ld overlaps the journal, no journal for this download\n",
+                   __func__, ctx->total_image_size);
+        ctx->journal.active = 0;
+        return;
+    }
+
+    /* out of order data does not move the durable offset */
+    if ( (offset <= ctx->journal.contiguous) && ((offset + size) > ctx->journal.contiguous) )
+    {
+        ctx->journal.contiguous = offset + size;
+    }
+
+    /* the download is complete, verify follows */
+    if (ctx->journal.contiguous >= ctx->total_image_size)
+    {
+        return;
+    }
+
+    if ( (ctx->journal.contiguous - ctx->journal.committed) >= CY_OTA_JOURNAL_COMMIT_SIZE)
+    {
+        if (cy_ota_journal_write(ctx, fap) != CY_RSLT_SUCCESS)
+        {
+            /* not fatal, the download goes on without a journal */
+            ctx->journal.active = 0;
+        }
+    }
+#else
+    (void)ctx;
+    (void)offset;
+    (void)size;
+#endif
+}
+
+#if (CY_OTA_DELTA == 1) || (CY_OTA_BLOCK_REUSE == 1)
+cy_rslt_t cy_ota_storage_primary_open(cy_ota_context_t *ctx)
+{
+    const struct flash_area *fap;
+
+    if (ctx->primary_loc != NULL)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+    if (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(0), &fap) != 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_open(FLASH_AREA_IMAGE_PRIMARY(0) ) failed\n", __func__);
+        return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+    }
+    ctx->primary_loc = (void *)fap;
+    return CY_RSLT_SUCCESS;
+}
+
+int cy_ota_storage_primary_read(void *cb_arg, uint32_t offset, uint8_t *buffer, uint32_t size)
+{
+    cy_ota_context_t        *ctx = (cy_ota_context_t *)cb_arg;
+    const struct flash_area *fap = (const struct flash_area *)ctx->primary_loc;
+
+    if ( (fap == NULL) || (offset > fap->fa_size) || (size > (fap->fa_size - offset)) )
+    {
+        return -1;
+    }
+    cy_ota_storage_lock(ctx);
+    if (flash_area_read(fap, offset, buffer, size) != 0)
+    {
+        cy_ota_storage_unlock(ctx);
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_read() failed\n", __func__);
+        return -1;
+    }
+    cy_ota_storage_unlock(ctx);
+    return 0;
+}
+
+void cy_ota_storage_primary_close(cy_ota_context_t *ctx)
+{
+    if (ctx->primary_loc != NULL)
+    {
+        flash_area_close((const struct flash_area *)ctx->primary_loc);
+        ctx->primary_loc = NULL;
     }
+}
+#endif  /* CY_OTA_DELTA == 1 || CY_OTA_BLOCK_REUSE == 1 */
 
-    cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area invalid\r\n", __func__);
-    return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+#if (CY_OTA_BLOCK_REUSE == 1)
+static uint32_t cy_ota_manifest_get_u32(const uint8_t *ptr)
+{
+    return ((uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24));
 }
 
 /**
- * @brief Write to storage area
+ * @brief Check the manifest header against the image being downloaded
  *
- * @param[in]   ctx         - pointer to OTA agent context @ref cy_ota_context_t
- * @param[in]   chunk_info  - pointer to chunk information
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
  *
- * @return  CY_RSLT_SUCCESS
- *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ * @return  true if the manifest is for this image
  */
-cy_rslt_t cy_ota_storage_write(cy_ota_context_ptr ctx_ptr, cy_ota_storage_write_info_t *chunk_info)
+static bool cy_ota_block_reuse_header(cy_ota_context_t *ctx)
 {
-    const struct flash_area *fap;
-    cy_ota_context_t *ctx = (cy_ota_context_t *)ctx_ptr;
-    CY_OTA_CONTEXT_ASSERT(ctx);
-
-    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() buf:%p len:%ld off: 0x%lx (%ld)\n", __func__,
-                             chunk_info->buffer, chunk_info->size,
-                             chunk_info->offset, chunk_info->offset);
+    cy_ota_block_reuse_context_t *br = &ctx->block_reuse;
+    uint32_t    block_size = cy_ota_manifest_get_u32(&br->pending[4]);
+    uint32_t    image_size = cy_ota_manifest_get_u32(&br->pending[8]);
+    uint32_t    blocks     = cy_ota_manifest_get_u32(&br->pending[12]);
 
-    /* write to secondary slot */
-    fap = (const struct flash_area *)ctx->storage_loc;
-    if (fap != NULL)
+    if ( (memcmp(br->pending, CY_OTA_MANIFEST_MAGIC, 4) != 0) || (block_size != CY_OTA_CHUNK_SIZE) ||
+         (image_size != ctx->total_image_size) || (blocks != ((image_size + CY_OTA_CHUNK_SIZE - 1) / CY_OTA_CHUNK_SIZE)) )
     {
-        if (flash_area_write(fap, chunk_info->offset, chunk_info->buffer, chunk_info->size) != CY_RSLT_SUCCESS)
-        {
-            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "flash_area_write() failed\n");
-            return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
-        }
-        return CY_RSLT_SUCCESS;
+        cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "Block manifest is not for this image (block %ld, image %ld of %ld), download all blocks\n",
+                   block_size, image_size, ctx->total_image_size);
+        return false;
     }
-
-    cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() no fap!\n", __func__);
-    return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+    if (blocks > CY_OTA_BLOCK_REUSE_MAX_BLOCKS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "Image has %ld blocks, more than CY_OTA_BLOCK_REUSE_MAX_BLOCKS, download all blocks\n", blocks);
+        return false;
+    }
+    br->blocks        = blocks;
+    br->manifest_size = CY_OTA_MANIFEST_HEADER_SIZE + (blocks * CY_OTA_MANIFEST_HASH_SIZE);
+    return true;
 }
 
 /**
- * @brief Close Storage area for download
+ * @brief Hash a block of the Primary Slot and compare with its manifest entry
  *
- * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   ctx     - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   block   - block number
+ * @param[in]   hash    - manifest entry, CY_OTA_MANIFEST_HASH_SIZE bytes
  *
- * @return  CY_RSLT_SUCCESS
- *          CY_RSLT_OTA_ERROR_CLOSE_STORAGE
+ * @return  true if the block is the same
  */
-cy_rslt_t cy_ota_storage_close(cy_ota_context_ptr ctx_ptr)
+static bool cy_ota_block_reuse_compare(cy_ota_context_t *ctx, uint32_t block, const uint8_t *hash)
 {
-    const struct flash_area *fap;
-    cy_ota_context_t *ctx = (cy_ota_context_t *)ctx_ptr;
-    CY_OTA_CONTEXT_ASSERT(ctx);
+    mbedtls_sha256_context  sha;
+    uint8_t                 buffer[256];
+    uint8_t                 digest[32];
+    uint32_t                offset = block * CY_OTA_CHUNK_SIZE;
+    uint32_t                end;
+    uint32_t                size;
+    bool                    same = true;
+
+    end = offset + CY_OTA_CHUNK_SIZE;
+    if (end > ctx->total_image_size)
+    {
+        end = ctx->total_image_size;
+    }
 
-    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s()\n", __func__);
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts_ret(&sha, 0);
+    while (offset < end)
+    {
+        size = ((end - offset) < sizeof(buffer)) ? (end - offset) : sizeof(buffer);
+        if (cy_ota_storage_primary_read(ctx, offset, buffer, size) != 0)
+        {
+            /* past the end of the Primary Slot */
+            same = false;
+            break;
+        }
+        mbedtls_sha256_update_ret(&sha, buffer, size);
+        offset += size;
+    }
+    if (same)
+    {
+        mbedtls_sha256_finish_ret(&sha, digest);
+        same = (memcmp(digest, hash, CY_OTA_MANIFEST_HASH_SIZE) == 0);
+    }
+    mbedtls_sha256_free(&sha);
+    return same;
+}
 
-    /* close secondary slot */
-    fap = (const struct flash_area *)ctx->storage_loc;
-    if (fap == NULL)
+cy_rslt_t cy_ota_storage_block_reuse_start(cy_ota_context_t *ctx)
+{
+    memset(&ctx->block_reuse, 0x00, sizeof(ctx->block_reuse));
+    return cy_ota_storage_primary_open(ctx);
+}
+
+cy_rslt_t cy_ota_storage_block_reuse_manifest(cy_ota_context_t *ctx, const uint8_t *data, uint32_t size)
+{
+    cy_ota_block_reuse_context_t *br = &ctx->block_reuse;
+    uint32_t    need;
+    uint32_t    part;
+
+    while ( (size > 0) && (br->failed == 0) && ( (br->manifest_size == 0) || (br->next_block < br->blocks) ) )
     {
-        return CY_RSLT_OTA_ERROR_CLOSE_STORAGE;
+        need = (br->manifest_size == 0) ? CY_OTA_MANIFEST_HEADER_SIZE : CY_OTA_MANIFEST_HASH_SIZE;
+        part = need - br->pending_len;
+        part = (size < part) ? size : part;
+        memcpy(&br->pending[br->pending_len], data, part);
+        br->pending_len += part;
+        data += part;
+        size -= part;
+        if (br->pending_len < need)
+        {
+            break;
+        }
+        br->pending_len = 0;
+
+        if (br->manifest_size == 0)
+        {
+            if (cy_ota_block_reuse_header(ctx) == false)
+            {
+                br->failed = 1;
+            }
+            continue;
+        }
+        if (cy_ota_block_reuse_compare(ctx, br->next_block, br->pending))
+        {
+            br->match[br->next_block / 8] |= (uint8_t)(1 << (br->next_block % 8));
+            br->matches++;
+        }
+        br->next_block++;
     }
-    flash_area_close(fap);
 
+    if (br->failed != 0)
+    {
+        return CY_RSLT_OTA_ERROR_GENERAL;
+    }
+    if ( (br->manifest_size != 0) && (br->next_block >= br->blocks) && (br->active == 0) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Block manifest: %ld of %ld blocks are in the Primary Slot\n", br->matches, br->blocks);
+        br->active = (br->matches > 0) ? 1 : 0;
+    }
     return CY_RSLT_SUCCESS;
 }
 
+uint32_t cy_ota_storage_block_reuse_next(cy_ota_context_t *ctx, uint32_t offset)
+{
+    cy_ota_block_reuse_context_t *br = &ctx->block_reuse;
+    uint32_t    block;
+
+    if (br->active != 0)
+    {
+        for (block = (offset + CY_OTA_CHUNK_SIZE - 1) / CY_OTA_CHUNK_SIZE; block < br->blocks; block++)
+        {
+            if ( (br->match[block / 8] & (1 << (block % 8))) != 0)
+            {
+                return block * CY_OTA_CHUNK_SIZE;
+            }
+        }
+    }
+    return ctx->total_image_size;
+}
+#endif  /* CY_OTA_BLOCK_REUSE == 1 */
+
 /**
  * @brief Verify download signature
  *
+ * With CY_OTA_IMAGE_HASH, the image hash (and signature) is checked before
+ * the boot magic is written.
+ *
  * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
  *
  * @return  CY_RSLT_SUCCESS
  *          CY_RSLT_OTA_ERROR_GENERAL
+ *          CY_RSLT_OTA_ERROR_VERIFY
  */
 cy_rslt_t cy_ota_storage_verify(cy_ota_context_ptr ctx_ptr)
 {
     const struct flash_area *fap;
     uint32_t                off;
     uint8_t                 buffer[BOOT_MAGIC_SZ];
+#if (CY_OTA_IMAGE_HASH == 1)
+    cy_rslt_t               result;
+#endif
     cy_ota_context_t *ctx = (cy_ota_context_t *)ctx_ptr;
     CY_OTA_CONTEXT_ASSERT(ctx);
     (void)ctx;
 
     cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%s()\n", __func__);
 
+    /* do not mark a partly decoded or patched image for the update */
+    if (cy_ota_writer_check_complete(ctx) != CY_RSLT_SUCCESS)
+    {
+        return CY_RSLT_OTA_ERROR_VERIFY;
+    }
+
     /* we copy this to a RAM buffer so that if we are running in XIP from external flash, the write routine won't fail */
     memcpy(buffer, boot_img_magic, BOOT_MAGIC_SZ);
     if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(0), &fap) == 0)
     {
+#if (CY_OTA_JOURNAL == 1)
+        /* the download is complete, do not resume it again */
+        if (ctx->journal.active != 0)
+        {
+            if (flash_area_erase(fap, CY_OTA_JOURNAL_AREA_OFFSET(fap), CY_OTA_JOURNAL_SIZE) != 0)
+            {
+                cy_log_msg(CYLF_OTA, CY_LOG_WARNING, "VERIFY journal erase failed\n");
+            }
+            ctx->journal.active = 0;
+        }
+#endif
+#if (CY_OTA_IMAGE_HASH == 1)
+        /* do not mark a bad image for the update */
+        cy_ota_storage_lock(ctx);
+        result = cy_ota_image_hash_check(ctx, fap);
+        cy_ota_storage_unlock(ctx);
+        if (result != CY_RSLT_SUCCESS)
+        {
+            flash_area_close(fap);
+            return result;
+        }
+#endif
         off = BOOT_MAGIC_OFFSET(fap);
         cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "VERIFY flash_area_write( fa_off: 0x%lx  sz: 0x%lx off: 0x%lx) 2\n", fap->fa_off, fap->fa_size, off);
         if (flash_area_write(fap, off, buffer, BOOT_MAGIC_SZ) != CY_RSLT_SUCCESS)
@@ -316,6 +1681,10 @@ cy_rslt_t cy_ota_storage_verify(cy_ota_context_ptr ctx_ptr)
 #endif
         flash_area_close(fap);
     }
+#ifdef FW_DATBLOCK_SEPARATE_FROM_APPLICATION
+    /* a new FW Data Block may be copied to the Primary Slot */
+    cy_ota_fwdb_invalidate();
+#endif
     return CY_RSLT_SUCCESS;
 }
 
@@ -360,6 +1729,9 @@ cy_rslt_t cy_ota_storage_validated(void)
         }
         flash_area_close(fap);
     }
+#ifdef FW_DATBLOCK_SEPARATE_FROM_APPLICATION
+    cy_ota_fwdb_invalidate();
+#endif
 
     return result;
 }
@@ -369,72 +1741,166 @@ cy_rslt_t cy_ota_storage_validated(void)
 #define CY_OTA_IMGTOOL_HEADER_SIZE              0x100
 #define CY_OTA_SEPARATE_INTERNAL_HEADER_SIZE    0x100
 
-static cy_ota_fw_data_block_header_t cy_ota_fwdb_info;
+/**
+ * @brief FW Data Block header read from the Primary Slot of image 1
+ *
+ * Read and checked once by cy_ota_fwdb_get_base_info(), then used by all
+ * cy_ota_fwdb_get_*() calls until cy_ota_fwdb_invalidate().
+ * The offsets in header are from the start of the slot.
+ */
+typedef struct cy_ota_fwdb_cache_s
+{
+    bool                            valid;      /**< true = header and slot_off hold the FW Data Block */
+    bool                            mapped;     /**< true = the slot can be read at slot_addr           */
+    uint32_t                        slot_off;   /**< fa_off of the Primary Slot of image 1              */
+    uint32_t                        slot_size;  /**< fa_size of the Primary Slot of image 1             */
+    uintptr_t                       slot_addr;  /**< CPU address of the slot when mapped                */
+    cy_ota_fw_data_block_header_t   header;     /**< header, offsets adjusted to the slot                */
+} cy_ota_fwdb_cache_t;
+
+static cy_ota_fwdb_cache_t cy_ota_fwdb_cache;
+
+/**
+ * @brief Check one item of the FW Data Block header lies in the slot
+ *
+ * @param[in]   offset      - offset of the item in the slot, 0 = no item
+ * @param[in]   size        - size of the item
+ * @param[in]   slot_size   - size of the slot
+ *
+ * @return  true if the item is absent or fits in the slot
+ */
+static bool cy_ota_fwdb_item_ok(uint32_t offset, uint32_t size, uint32_t slot_size)
+{
+    if (offset == 0)
+    {
+        return true;
+    }
+    return ( (offset < slot_size) && (size <= (slot_size - offset)) );
+}
 
-static cy_ota_fw_data_block_header_t *cy_ota_fwdb_get_base_info( void )
+/**
+ * @brief Read the FW Data Block header from FLASH and check it
+ *
+ * @param[out]  cache   - filled with the header, offsets adjusted to the slot
+ *
+ * @return  true if the header is good
+ */
+static bool cy_ota_fwdb_read_header(cy_ota_fwdb_cache_t *cache)
 {
     const struct flash_area         *fap;
-    cy_ota_fw_data_block_header_t   *info = &cy_ota_fwdb_info;
-    uint32_t                        read_offset;
+    cy_ota_fw_data_block_header_t   *info = &cache->header;
+    uint32_t                        slot_size;
 
-    cy_log_set_facility_level(CYLF_OTA, CY_LOG_INFO);
-
-    /* Always read from secondary slot */
+    /* Always read from secondary image of primary slot */
     if (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(1), &fap) != 0)
     {
         cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_open(FLASH_AREA_IMAGE_PRIMARY(1) ) failed\n", __func__);
-        return NULL;
+        return false;
     }
+    cache->slot_off = fap->fa_off;
+    cache->slot_size = fap->fa_size;
+    slot_size = fap->fa_size;
+#ifdef COMPONENT_OTA_MCUBOOT_20829
+    cache->slot_addr = CY_XIP_BASE + fap->fa_off;
+#else
+    cache->slot_addr = fap->fa_off;
+#endif
+    /* internal FLASH is always mapped, external FLASH only while SMIF is in XIP mode */
+    cache->mapped = ( (fap->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH) || (CY_OTA_FWDB_XIP == 1) );
 
-    read_offset = CY_OTA_IMGTOOL_HEADER_SIZE;
     /* read into the info buffer */
-    if (flash_area_read(fap, read_offset, (uint8_t *)info, sizeof(cy_ota_fw_data_block_header_t)) != CY_RSLT_SUCCESS)
+    if (flash_area_read(fap, CY_OTA_IMGTOOL_HEADER_SIZE, (uint8_t *)info, sizeof(cy_ota_fw_data_block_header_t)) != CY_RSLT_SUCCESS)
     {
         cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_read(info) failed \n", __func__);
         flash_area_close(fap);
-        info = NULL;
+        return false;
     }
-
     flash_area_close(fap);
 
-    if ( (info->WiFi_FW_offset == 0xFFFF) && (info->BT_FW_offset == 0xFFFF) )
+    if ( (memcmp(info->magic, FW_DATA_block_header_info_MAGIC, sizeof(info->magic)) != 0) ||
+         (info->FWDB_version != FW_DATA_block_header_info_VERSION) )
     {
-        info = NULL;
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() no FW Data Block header (version %ld)\n", __func__, info->FWDB_version);
+        return false;
     }
 
-    if (info != NULL)
+    /* Offsets in the header are from the end of the imgtool header */
+    if (info->WiFi_FW_offset != 0)
     {
-        /* Add base address */
-        if (info->WiFi_FW_offset != 0)
-        {
-            info->WiFi_FW_offset += CY_OTA_SEPARATE_INTERNAL_HEADER_SIZE;
-        }
-        if (info->CLM_blob_offset != 0)
-        {
-            info->CLM_blob_offset += CY_OTA_SEPARATE_INTERNAL_HEADER_SIZE;
-        }
-        if (info->BT_FW_offset != 0)
-        {
-            info->BT_FW_offset += CY_OTA_SEPARATE_INTERNAL_HEADER_SIZE;
-        }
+        info->WiFi_FW_offset += CY_OTA_SEPARATE_INTERNAL_HEADER_SIZE;
+    }
+    if (info->CLM_blob_offset != 0)
+    {
+        info->CLM_blob_offset += CY_OTA_SEPARATE_INTERNAL_HEADER_SIZE;
+    }
+    if (info->BT_FW_offset != 0)
+    {
+        info->BT_FW_offset += CY_OTA_SEPARATE_INTERNAL_HEADER_SIZE;
+    }
+
+    if ( !cy_ota_fwdb_item_ok(info->WiFi_FW_offset, info->WiFi_FW_size, slot_size) ||
+         !cy_ota_fwdb_item_ok(info->CLM_blob_offset, info->CLM_blob_size, slot_size) ||
+         !cy_ota_fwdb_item_ok(info->BT_FW_offset, info->BT_FW_size, slot_size) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() FW Data Block item outside slot (size 0x%lx)\n", __func__, slot_size);
+        return false;
+    }
+
+    /* BT FW version is used as a string */
+    info->BT_FW_version[sizeof(info->BT_FW_version) - 1] = 0;
+
+    return true;
+}
 
-        /* For debugging */
-        cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:WiFi_FW_version: %d %d %d %d\n", __func__,
-                                          info->WiFi_FW_version[0], info->WiFi_FW_version[1], info->WiFi_FW_version[2], info->WiFi_FW_version[3] );
-        cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:WiFi_FW_offset : 0x%x\n", __func__, info->WiFi_FW_offset);
-        cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:WiFi_FW_size   : 0x%x\n", __func__, info->WiFi_FW_size);
-        cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:CLM_blob_offset: 0x%x\n", __func__, info->CLM_blob_offset);
-        cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:CLM_blob_size  : 0x%x\n", __func__, info->CLM_blob_size);
+/**
+ * @brief Get the FW Data Block header
+ *
+ * The header is read from FLASH and checked on the first call after boot
+ * or cy_ota_fwdb_invalidate(), later calls use the cached copy.
+ *
+ * @return  ptr to the header, offsets adjusted to the slot
+ *          NULL if there is no good FW Data Block
+ */
+static const cy_ota_fw_data_block_header_t *cy_ota_fwdb_get_base_info( void )
+{
+    cy_ota_fw_data_block_header_t   *info;
 
-        cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:BT_FW_version  : >%s<\n", __func__, info->BT_FW_version);
-        cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:BT_FW_offset   : 0x%x\n", __func__, info->BT_FW_offset);
-        cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:BT_FW_size     : 0x%x\n", __func__, info->BT_FW_size);
+    if (cy_ota_fwdb_cache.valid)
+    {
+        return &cy_ota_fwdb_cache.header;
+    }
 
+    if (!cy_ota_fwdb_read_header(&cy_ota_fwdb_cache))
+    {
+        return NULL;
     }
+    cy_ota_fwdb_cache.valid = true;
+
+    info = &cy_ota_fwdb_cache.header;
+    /* For debugging */
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:WiFi_FW_version: %d %d %d %d\n", __func__,
+                                      info->WiFi_FW_version[0], info->WiFi_FW_version[1], info->WiFi_FW_version[2], info->WiFi_FW_version[3] );
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:WiFi_FW_offset : 0x%x\n", __func__, info->WiFi_FW_offset);
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:WiFi_FW_size   : 0x%x\n", __func__, info->WiFi_FW_size);
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:CLM_blob_offset: 0x%x\n", __func__, info->CLM_blob_offset);
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:CLM_blob_size  : 0x%x\n", __func__, info->CLM_blob_size);
+
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:BT_FW_version  : >%s<\n", __func__, info->BT_FW_version);
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:BT_FW_offset   : 0x%x\n", __func__, info->BT_FW_offset);
+    cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() info:BT_FW_size     : 0x%x\n", __func__, info->BT_FW_size);
 
     return info;
 }
 
+/**
+ * @brief Drop the cached FW Data Block header
+ *
+ * The next cy_ota_fwdb_get_*() call reads the header from FLASH again.
+ */
+void cy_ota_fwdb_invalidate(void)
+{
+    cy_ota_fwdb_cache.valid = false;
+}
 
 /**
  * @brief When FW is stored in a separate Data Block, get WiFi FW info
@@ -448,7 +1914,7 @@ static cy_ota_fw_data_block_header_t *cy_ota_fwdb_get_base_info( void )
  */
 cy_rslt_t cy_ota_fwdb_get_wifi_fw_info(cy_ota_fwdb_wifi_fw_info_t *wifi_fw_info)
 {
-    cy_ota_fw_data_block_header_t *fwdb_header;
+    const cy_ota_fw_data_block_header_t *fwdb_header;
 
     if (wifi_fw_info == NULL)
     {
@@ -458,17 +1924,9 @@ cy_rslt_t cy_ota_fwdb_get_wifi_fw_info(cy_ota_fwdb_wifi_fw_info_t *wifi_fw_info)
     fwdb_header = cy_ota_fwdb_get_base_info();
     if (fwdb_header != NULL)
     {
-        const struct flash_area *fap;
-        int rc;
-
         memcpy( &wifi_fw_info->WiFi_FW_version, &fwdb_header->WiFi_FW_version, sizeof(wifi_fw_info->WiFi_FW_version));
         wifi_fw_info->WiFi_FW_addr = fwdb_header->WiFi_FW_offset;
         wifi_fw_info->WiFi_FW_size = fwdb_header->WiFi_FW_size;
-        rc = flash_area_open(FLASH_AREA_IMAGE_PRIMARY(1), &fap);
-        if (rc == 0)
-        {
-            flash_area_close(fap);
-        }
 
         cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() wifi_fw_info:WIFI_FW_version: >%s<\n", __func__, wifi_fw_info->WiFi_FW_version);
         cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() wifi_fw_info:WIFI_FW_addr   : 0x%x\n", __func__, wifi_fw_info->WiFi_FW_addr);
@@ -528,7 +1986,7 @@ cy_rslt_t cy_ota_fwdb_get_wifi_fw_data(uint32_t offset, uint32_t size, uint8_t *
  */
 cy_rslt_t cy_ota_fwdb_get_clm_blob_info(cy_ota_fwdb_clm_blob_info_t *clm_blob_info)
 {
-    cy_ota_fw_data_block_header_t *fwdb_header;
+    const cy_ota_fw_data_block_header_t *fwdb_header;
 
     if (clm_blob_info == NULL)
     {
@@ -538,16 +1996,8 @@ cy_rslt_t cy_ota_fwdb_get_clm_blob_info(cy_ota_fwdb_clm_blob_info_t *clm_blob_in
     fwdb_header = cy_ota_fwdb_get_base_info();
     if (fwdb_header != NULL)
     {
-        const struct flash_area *fap;
-        int rc;
-
         clm_blob_info->CLM_blob_addr = fwdb_header->CLM_blob_offset;
         clm_blob_info->CLM_blob_size = fwdb_header->CLM_blob_size;
-        rc = flash_area_open(FLASH_AREA_IMAGE_PRIMARY(1), &fap);
-        if (rc == 0)
-        {
-            flash_area_close(fap);
-        }
 
         cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() clm_blob_info:CLM_blob_addr   : 0x%x\n", __func__, clm_blob_info->CLM_blob_addr);
         cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() clm_blob_info:CLM_blob_size   : 0x%x\n\n", __func__, clm_blob_info->CLM_blob_size);
@@ -570,7 +2020,7 @@ cy_rslt_t cy_ota_fwdb_get_clm_blob_info(cy_ota_fwdb_clm_blob_info_t *clm_blob_in
  */
 cy_rslt_t cy_ota_fwdb_get_bt_fw_info(cy_ota_fwdb_bt_fw_info_t *bt_fw_info)
 {
-    cy_ota_fw_data_block_header_t *fwdb_header;
+    const cy_ota_fw_data_block_header_t *fwdb_header;
 
     if (bt_fw_info == NULL)
     {
@@ -580,18 +2030,9 @@ cy_rslt_t cy_ota_fwdb_get_bt_fw_info(cy_ota_fwdb_bt_fw_info_t *bt_fw_info)
     fwdb_header = cy_ota_fwdb_get_base_info();
     if (fwdb_header != NULL)
     {
-        const struct flash_area *fap;
-        int rc;
-
-        bt_fw_info->BT_FW_version = fwdb_header->BT_FW_version;
-        bt_fw_info->BT_FW_addr = fwdb_header->BT_FW_offset;
+        bt_fw_info->BT_FW_version = (uint8_t *)fwdb_header->BT_FW_version;
+        bt_fw_info->BT_FW_addr = cy_ota_fwdb_cache.slot_off + fwdb_header->BT_FW_offset;
         bt_fw_info->BT_FW_size = fwdb_header->BT_FW_size;
-        rc = flash_area_open(FLASH_AREA_IMAGE_PRIMARY(1), &fap);
-        if (rc == 0)
-        {
-            bt_fw_info->BT_FW_addr += fap->fa_off;
-            flash_area_close(fap);
-        }
 
         cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() bt_fw_info:BT_FW_version: >%s<\n", __func__, bt_fw_info->BT_FW_version);
         cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() bt_fw_info:BT_FW_addr    : 0x%x\n", __func__, bt_fw_info->BT_FW_addr);
@@ -601,101 +2042,162 @@ cy_rslt_t cy_ota_fwdb_get_bt_fw_info(cy_ota_fwdb_bt_fw_info_t *bt_fw_info)
     return CY_RSLT_SUCCESS;
 }
 
+/**
+ * @brief Read part of the BT FW Patch from the FW Data Block
+ *
+ * Use this call to pass the BT FW Patch to the BT module in pieces,
+ * without a buffer for the whole patch. Get BT_FW_size with
+ * cy_ota_fwdb_get_bt_fw_info(), then read from offset 0 up to BT_FW_size.
+ *
+ * @param[in]   offset - offset into the BT FW Patch
+ * @param[in]   size   - amount to copy
+ * @param[in]   dest   - destination buffer for the read
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_BADARG
+ *          CY_RSLT_OTA_ERROR_OPEN_STORAGE
+ *          CY_RSLT_OTA_ERROR_READ_STORAGE
+ */
+cy_rslt_t cy_ota_fwdb_get_bt_fw_data(uint32_t offset, uint32_t size, uint8_t *dest)
+{
+    cy_rslt_t                           result = CY_RSLT_SUCCESS;
+    const cy_ota_fw_data_block_header_t *fwdb_header;
+    const struct flash_area             *fap;
+
+    fwdb_header = cy_ota_fwdb_get_base_info();
+    if ( (dest == NULL) || (fwdb_header == NULL) || (fwdb_header->BT_FW_offset == 0) ||
+         (offset > fwdb_header->BT_FW_size) || (size > (fwdb_header->BT_FW_size - offset)) )
+    {
+        return CY_RSLT_OTA_ERROR_BADARG;
+    }
+
+    if (cy_ota_fwdb_cache.mapped)
+    {
+        memcpy(dest, (const uint8_t *)(cy_ota_fwdb_cache.slot_addr + fwdb_header->BT_FW_offset + offset), size);
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* Always read from secondary image of primary slot */
+    if (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(1), &fap) != 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_open(FLASH_AREA_IMAGE_PRIMARY(1) failed\r\n", __func__);
+        return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+    }
+    if (flash_area_read(fap, fwdb_header->BT_FW_offset + offset, dest, size) != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_read() failed \n", __func__);
+        result = CY_RSLT_OTA_ERROR_READ_STORAGE;
+    }
+    flash_area_close(fap);
+
+    return result;
+}
+
 /**
  * @brief Get BT FW for transfer to BT module
  *
  * Use this call to get the external flash BT FW Patch info
- * NOTES: This allocates RAM, Expected to be < 48k
+ * NOTES: This allocates RAM for the whole patch, Expected to be < 48k
+ *        and copies the patch into it. cy_ota_fwdb_get_bt_fw_data() reads it in
+ *        pieces instead, cy_ota_fwdb_get_bt_fw_mapped() uses it in place.
  *        The User must call cy_ota_fwdb_free_bt_fw() after use.
  *
  * @param   bt_fw   - ptr to cy_ota_fwdb_bt_fw_t
  *
  * @return  CY_RSLT_SUCCESS
  *          CY_RSLT_OTA_ERROR_GENERAL
+ *          CY_RSLT_OTA_ERROR_OUT_OF_MEMORY
  */
 cy_rslt_t cy_ota_fwdb_get_bt_fw(cy_ota_fwdb_bt_fw_t *bt_fw)
 {
-    cy_rslt_t result = CY_RSLT_OTA_ERROR_GENERAL;
-    uint32_t  fw_buffer = 0x00;
+    uint8_t                             *fw_buffer;
+    const cy_ota_fw_data_block_header_t *fwdb_header;
 
     cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() bt_fw:%p\n", __func__, bt_fw);
 
-    if (bt_fw == 0x00)
+    if (bt_fw == NULL)
     {
         return CY_RSLT_OTA_ERROR_GENERAL;
     }
     memset(bt_fw, 0x00, sizeof(cy_ota_fwdb_bt_fw_t));
 
-    cy_ota_fw_data_block_header_t *fwdb_header;
     fwdb_header = cy_ota_fwdb_get_base_info();
-    if ( (fwdb_header != 0x00) && (fwdb_header->BT_FW_offset != 0x00) && (fwdb_header->BT_FW_size > 0) &&
-         (fwdb_header->BT_FW_offset != 0xFF) && (fwdb_header->BT_FW_size != 0xffffffff) )
+    if ( (fwdb_header == NULL) || (fwdb_header->BT_FW_offset == 0x00) || (fwdb_header->BT_FW_size == 0) )
     {
-        uint32_t                    malloc_size;
-        const struct flash_area     *fap;
-        uint32_t                    read_offset;
+        return CY_RSLT_OTA_ERROR_GENERAL;
+    }
 
-        cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() fwdb_header:BT_FW_offset : 0x%x\n", __func__, fwdb_header->BT_FW_offset);
-        cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() fwdb_header:BT_FW_size   : 0x%x\n", __func__, fwdb_header->BT_FW_size);
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() fwdb_header:BT_FW_offset : 0x%x\n", __func__, fwdb_header->BT_FW_offset);
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() fwdb_header:BT_FW_size   : 0x%x\n", __func__, fwdb_header->BT_FW_size);
 
-        /* Round up size a bit */
-        malloc_size = fwdb_header->BT_FW_size + (4 - (fwdb_header->BT_FW_size & 3));
-        fw_buffer  =(uint32_t)mlloc(malloc_size);
-        if (fw_buffer == 0x00)
-        {
-            return CY_RSLT_OTA_ERROR_OUT_OF_MEMORY;
-        }
-        cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%d:%s() buf:%p\n", __LINE__, __func__, fw_buffer);
-        cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "        off:0x%x malloc:0x%x sz:0x%lx\n", fwdb_header->BT_FW_offset, malloc_size, fwdb_header->BT_FW_size);
+    fw_buffer = (uint8_t *)pvPortMalloc(fwdb_header->BT_FW_size);
+    if (fw_buffer == NULL)
+    {
+        return CY_RSLT_OTA_ERROR_OUT_OF_MEMORY;
+    }
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%d:%s() buf:%p sz:0x%lx\n", __LINE__, __func__, fw_buffer, fwdb_header->BT_FW_size);
 
-        memset( (char *)fw_buffer, 0xDE, malloc_size);
+    if (cy_ota_fwdb_get_bt_fw_data(0, fwdb_header->BT_FW_size, fw_buffer) != CY_RSLT_SUCCESS)
+    {
+        vPortFree(fw_buffer);
+        return CY_RSLT_OTA_ERROR_GENERAL;
+    }
 
-        read_offset = fwdb_header->BT_FW_offset;
+    bt_fw->BT_FW_version = (uint8_t *)fwdb_header->BT_FW_version;
+    bt_fw->BT_FW_buffer  = fw_buffer;
+    bt_fw->BT_FW_size    = fwdb_header->BT_FW_size;
 
-        /* Always read from secondary slot */
-        if (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(1), &fap) != 0)
-        {
-            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_open(FLASH_AREA_IMAGE_PRIMARY(1) ) failed\r\n", __func__);
-            result = CY_RSLT_OTA_ERROR_GENERAL;
-        }
-        else
-        {
-            /* read the bt fw patch into the buffer */
-            if (flash_areaf_read(fap, read_offset, (uint8_t *)fw_buffer, fwdb_header->BT_FW_size) != CY_RSLT_SUCCESS)
-            {
-                cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_read() failed \n", __func__);
-                result = CY_RSLT_OTA_ERROR_GENERAL;
-            }
-            else
-            {
-                cy_log_msg(CYLF_OTA, CY_LOG_DEBUG4, "%s() flash_area_read() success\n", __func__);
-                result = CY_RSLT_SUCCESS;
-            }
-            flash_area_close(fap);
-        }
+    return CY_RSLT_SUCCESS;
+}
+
+/**
+ * @brief Get BT FW in place for transfer to BT module
+ *
+ * Use this call when the FW Data Block is memory mapped - in internal FLASH,
+ * or in external FLASH with CY_OTA_FWDB_XIP and SMIF in XIP mode.
+ * BT_FW_buffer points at the patch in FLASH, no RAM is used. The pointer is
+ * only good until the Primary Slot is written or SMIF leaves XIP mode.
+ * cy_ota_fwdb_free_bt_fw() may be called, it frees nothing.
+ *
+ * @param   bt_fw   - ptr to cy_ota_fwdb_bt_fw_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GENERAL
+ *          CY_RSLT_OTA_ERROR_UNSUPPORTED   - not memory mapped, use cy_ota_fwdb_get_bt_fw()
+ */
+cy_rslt_t cy_ota_fwdb_get_bt_fw_mapped(cy_ota_fwdb_bt_fw_t *bt_fw)
+{
+    const cy_ota_fw_data_block_header_t *fwdb_header;
+
+    if (bt_fw == NULL)
+    {
+        return CY_RSLT_OTA_ERROR_GENERAL;
     }
+    memset(bt_fw, 0x00, sizeof(cy_ota_fwdb_bt_fw_t));
 
-    if (result == CY_RSLT_SUCCESS)
+    fwdb_header = cy_ota_fwdb_get_base_info();
+    if ( (fwdb_header == NULL) || (fwdb_header->BT_FW_offset == 0x00) || (fwdb_header->BT_FW_size == 0) )
     {
-        bt_fw->BT_FW_version = fwdb_header->BT_FW_version;
-        bt_fw->BT_FW_buffer  = (uint8_t *)fw_buffer;
-        bt_fw->BT_FW_size    = fwdb_header->BT_FW_size;
+        return CY_RSLT_OTA_ERROR_GENERAL;
     }
-    else
+    if (!cy_ota_fwdb_cache.mapped)
     {
-        if (fw_buffer != 0x00)
-        {
-            vPortFree((uint8_t *)fw_buffer);
-        }
+        return CY_RSLT_OTA_ERROR_UNSUPPORTED;
     }
-    return result;
+
+    bt_fw->BT_FW_version = (uint8_t *)fwdb_header->BT_FW_version;
+    bt_fw->BT_FW_buffer  = (uint8_t *)(cy_ota_fwdb_cache.slot_addr + fwdb_header->BT_FW_offset);
+    bt_fw->BT_FW_size    = fwdb_header->BT_FW_size;
+
+    return CY_RSLT_SUCCESS;
 }
 
 /**
  * @brief Free BT FW for transfer to BT module
  *
  * Use this call to free the external flash BT FW Patch info
- * NOTES: This frees RAM, Expected to be < 48k
+ * NOTES: This frees the RAM copy from cy_ota_fwdb_get_bt_fw().
+ *        For cy_ota_fwdb_get_bt_fw_mapped() it only clears BT_FW_buffer.
  *
  * @param   bt_fw   - ptr to cy_ota_fwdb_bt_fw_t
  *
@@ -704,14 +2206,22 @@ cy_rslt_t cy_ota_fwdb_get_bt_fw(cy_ota_fwdb_bt_fw_t *bt_fw)
  */
 cy_rslt_t cy_ota_fwdb_free_bt_fw(cy_ota_fwdb_bt_fw_t *bt_fw)
 {
+    uintptr_t   addr;
+
     if (bt_fw == NULL)
     {
         return CY_RSLT_OTA_ERROR_GENERAL;
     }
     if (bt_fw->BT_FW_buffer != 0x00)
     {
-        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%d:%s() free :%p\n", __LINE__, __func__, bt_fw->BT_FW_buffer);
-        vPortFree(bt_fw->BT_FW_buffer);
+        /* nothing to free when the buffer is the patch in memory mapped FLASH */
+        addr = (uintptr_t)bt_fw->BT_FW_buffer;
+        if ( !cy_ota_fwdb_cache.mapped || (addr < cy_ota_fwdb_cache.slot_addr) ||
+             (addr >= (cy_ota_fwdb_cache.slot_addr + cy_ota_fwdb_cache.slot_size)) )
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%d:%s() free :%p\n", __LINE__, __func__, bt_fw->BT_FW_buffer);
+            vPortFree(bt_fw->BT_FW_buffer);
+        }
         bt_fw->BT_FW_buffer = 0x00;
     }
 
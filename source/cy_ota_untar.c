@@ -21,6 +21,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <ctype.h>
 #include <string.h>
 
@@ -89,6 +90,20 @@
  *
  **********************************************************************/
 
+/**
+ * @brief FLASH row being collected for one Secondary Slot
+ *
+ * data holds the whole row: bytes received so far, the rest read from FLASH,
+ * or 0xFF (erased) for a row past all data written so far.
+ */
+typedef struct cy_ota_row_buffer_s {
+    uint8_t     valid;                          /**< 1 = data holds the row at row_base, not written yet   */
+    uint32_t    high;                           /**< End of the data written for the image, erased after    */
+    uint32_t    row_base;                       /**< Offset of the row in the Secondary Slot                */
+    uint32_t    end;                            /**< End of the data received in the row                    */
+    uint8_t     data[CY_FLASH_SIZEOF_ROW];      /**< Row contents                                           */
+} cy_ota_row_buffer_t;
+
 /***********************************************************************
  *
  * Data & Variables
@@ -101,11 +116,19 @@
 cy_untar_context_t  ota_untar_context;
 
 /**
- * @brief FLASH write block
- * This is used if a block is < Block size to satisfy requirements
- * of flash_area_write()
+ * @brief FLASH rows being collected, one per Secondary Slot (image)
+ * flash_area_write() needs whole rows, data that does not fill a row waits
+ * here for the rest so that each row is written once.
  */
-static uint8_t block_buffer[CY_FLASH_SIZEOF_ROW];
+static cy_ota_row_buffer_t row_buffer[CY_OTA_SECONDARY_SLOTS];
+
+/**
+ * @brief FLASH operations for this download, logged by cy_ota_write_flush()
+ */
+static uint32_t flash_row_reads;
+static uint32_t flash_writes;
+static uint32_t flash_bytes;
+static uint32_t flash_skipped;
 
 /***********************************************************************
  *
@@ -120,9 +143,106 @@ static uint8_t block_buffer[CY_FLASH_SIZEOF_ROW];
  **********************************************************************/
 
 /**
- * @brief Write different sized chunks in 512 byte blocks
+ * @brief Check if a FLASH row of data is all the erased value
+ *
+ * Compares 32 bits at a time, the data may start at any address.
+ *
+ * @param data          data for the row
+ * @param erased_val    erased value of the FLASH, flash_area_erased_val()
+ *
+ * @return  true if writing the row to an erased row changes nothing
+ */
+static bool row_is_erased(const uint8_t *data, uint8_t erased_val)
+{
+    const uint8_t   *end = data + CY_FLASH_SIZEOF_ROW;
+    uint32_t        erased_word = erased_val * 0x01010101UL;
+
+    while ( (data < end) && (((uintptr_t)data & (sizeof(uint32_t) - 1)) != 0) )
+    {
+        if (*data++ != erased_val)
+        {
+            return false;
+        }
+    }
+    while ((end - data) >= (ptrdiff_t)sizeof(uint32_t))
+    {
+        if (*(const uint32_t *)data != erased_word)
+        {
+            return false;
+        }
+        data += sizeof(uint32_t);
+    }
+    while (data < end)
+    {
+        if (*data++ != erased_val)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check if a row can be left as it is instead of written
+ *
+ * The Secondary Slot of image 0 is erased by cy_ota_storage_open(), or before
+ * the write with CY_OTA_LAZY_ERASE, rows of the erased value are already there.
+ * Other slots are not erased by the OTA Agent and are always written.
+ *
+ * @param fap           currently open Flash Area for the row
+ * @param image         image (Secondary Slot) the Flash Area is for
+ * @param data          data for the row
+ *
+ * @return  true if the row does not need to be written
+ */
+static bool row_can_skip(const struct flash_area *fap, uint16_t image, const uint8_t *data)
+{
+    return ( (image == 0) && row_is_erased(data, flash_area_erased_val(fap)) );
+}
+
+/**
+ * @brief Write the row collected in a row buffer to FLASH
+ *
+ * @param fap           currently open Flash Area for the row
+ * @param image         image (Secondary Slot) the Flash Area is for
+ * @param row           row buffer
+ *
+ * @return  CY_UNTAR_SUCCESS
+ *          CY_UNTAR_ERROR
+ */
+static cy_untar_result_t write_row_buffer(const struct flash_area *fap, uint16_t image, cy_ota_row_buffer_t *row)
+{
+    if (row->valid == 0)
+    {
+        return CY_UNTAR_SUCCESS;
+    }
+    row->valid = 0;
+    if (row_can_skip(fap, image, row->data))
+    {
+        flash_skipped += sizeof(row->data);
+        return CY_UNTAR_SUCCESS;
+    }
+    flash_writes++;
+    if (flash_area_write(fap, row->row_base, row->data, sizeof(row->data)) != 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%d:%s() flash_area_write(0x%lx) failed\n", __LINE__, __func__, row->row_base);
+        return CY_UNTAR_ERROR;
+    }
+    return CY_UNTAR_SUCCESS;
+}
+
+/**
+ * @brief Write different sized chunks in CY_FLASH_SIZEOF_ROW blocks
+ *
+ * Whole rows are written straight from source. Data that does not fill a row
+ * is collected in the row buffer of the image and written when the row is full,
+ * when data for another row arrives, or by cy_ota_write_flush(). Sequential data
+ * writes each row once and reads none; a row is read from FLASH only when data
+ * was written in it before (out of order data). Rows of the erased value are not
+ * written to the erased Secondary Slot of image 0, see row_can_skip().
  *
  * @param fap           currently open Flash Area
+ * @param image         image (Secondary Slot) the Flash Area is for
  * @param offset        offset into the Flash Area to write data
  * @param source        data to use
  * @param size          amount of data in source to write
@@ -131,71 +251,154 @@ static uint8_t block_buffer[CY_FLASH_SIZEOF_ROW];
  *          CY_UNTAR_ERROR
  */
 static cy_untar_result_t write_data_to_flash( const struct flash_area *fap,
+        uint16_t image,
         uint32_t offset,
         uint8_t * const source,
         uint32_t size)
 {
+    cy_ota_row_buffer_t *row;
     uint32_t bytes_to_write;
     uint32_t curr_offset;
     uint8_t *curr_src;
 
+    if (image >= CY_OTA_SECONDARY_SLOTS)
+    {
+        return CY_UNTAR_ERROR;
+    }
+    row = &row_buffer[image];
+
     bytes_to_write = size;
     curr_offset = offset;
     curr_src = source;
+    flash_bytes += size;
 
     cy_log_msg(CYLF_OTA, CY_LOG_INFO, "%s() write_data_to_flash() fap_off:0x%08x   off: 0x%08x  curr_off: 0x%08x\n", __func__, fap->fa_off, offset, curr_offset);
 
     while (bytes_to_write > 0)
     {
-        uint32_t chunk_size = bytes_to_write;
-        if (chunk_size > CY_FLASH_SIZEOF_ROW)
-        {
-            chunk_size = CY_FLASH_SIZEOF_ROW;
-        }
+        uint32_t row_base   = (curr_offset / CY_FLASH_SIZEOF_ROW) * CY_FLASH_SIZEOF_ROW;
+        uint32_t row_offset = curr_offset - row_base;
+        uint32_t chunk_size;
 
-        /* Is the chunk_size smaller than a flash row? */
-        if ( (chunk_size % CY_FLASH_SIZEOF_ROW) != 0)
+        /* whole rows not in the row buffer go straight to FLASH */
+        if ( (row_offset == 0) && (bytes_to_write >= CY_FLASH_SIZEOF_ROW) &&
+             ( (row->valid == 0) || (row->row_base != row_base) ) )
         {
-            uint32_t row_offset;
-            uint32_t row_base;
-
-            row_base   = (curr_offset / CY_FLASH_SIZEOF_ROW) * CY_FLASH_SIZEOF_ROW;
-            row_offset = curr_offset - row_base;
+            int rc;
+            uint32_t rows;
 
-            /* we will read a CY_FLASH_SIZEOF_ROW byte block, write the new data into the block, then write the whole block */
-            if (flash_area_read(fap, row_base, block_buffer, sizeof(block_buffer)) != 0)
+            chunk_size = (bytes_to_write / CY_FLASH_SIZEOF_ROW) * CY_FLASH_SIZEOF_ROW;
+            if ( (row->valid != 0) && (row->row_base > row_base) && (row->row_base < (row_base + chunk_size)) )
             {
-                cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_read() failed\n", __func__);
-                return CY_UNTAR_ERROR;
+                chunk_size = row->row_base - row_base;
             }
-            memcpy (&block_buffer[row_offset], curr_src, chunk_size);
 
-            if (flash_area_write(fap, row_base, block_buffer, sizeof(block_buffer)) != 0)
+            if (row_can_skip(fap, image, curr_src))
             {
-                cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%d:%s() v() failed\n", __LINE__, __func__);
-                return CY_UNTAR_ERROR;
+                /* padding, the row is erased already */
+                chunk_size = CY_FLASH_SIZEOF_ROW;
+                flash_skipped += chunk_size;
+            }
+            else
+            {
+                /* write up to the next row that can be skipped */
+                for (rows = CY_FLASH_SIZEOF_ROW; rows < chunk_size; rows += CY_FLASH_SIZEOF_ROW)
+                {
+                    if (row_can_skip(fap, image, &curr_src[rows]))
+                    {
+                        chunk_size = rows;
+                        break;
+                    }
+                }
+                flash_writes++;
+                rc = flash_area_write(fap, curr_offset, curr_src, chunk_size);
+                if (rc != 0)
+                {
+                    cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%d:%s() flash_area_write() failed rc:%d\n", __LINE__, __func__, rc);
+                    return CY_UNTAR_ERROR;
+                }
             }
         }
         else
         {
-            int rc;
+            chunk_size = CY_FLASH_SIZEOF_ROW - row_offset;
+            if (chunk_size > bytes_to_write)
+            {
+                chunk_size = bytes_to_write;
+            }
+
+            if ( (row->valid != 0) && (row->row_base != row_base) )
+            {
+                /* data for another row, the collected row will not get more data */
+                if (write_row_buffer(fap, image, row) != CY_UNTAR_SUCCESS)
+                {
+                    return CY_UNTAR_ERROR;
+                }
+            }
+            if (row->valid == 0)
+            {
+                if (row_base >= row->high)
+                {
+                    /* nothing written at or after this row yet, it is erased */
+                    memset(row->data, flash_area_erased_val(fap), sizeof(row->data));
+                }
+                else
+                {
+                    /* keep what is in FLASH before the data */
+                    flash_row_reads++;
+                    if (flash_area_read(fap, row_base, row->data, sizeof(row->data)) != 0)
+                    {
+                        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_read() failed\n", __func__);
+                        return CY_UNTAR_ERROR;
+                    }
+                }
+                row->row_base = row_base;
+                row->end      = 0;
+                row->valid    = 1;
+            }
 
-            rc = flash_area_write(fap, curr_offset, curr_src, chunk_size);
-            if (rc != 0)
+            memcpy(&row->data[row_offset], curr_src, chunk_size);
+            if ( (row_offset + chunk_size) > row->end)
             {
-                cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%d:%s() flash_area_write() failed rc:%d\n", __LINE__, __func__, rc);
-                return CY_UNTAR_ERROR;
+                row->end = row_offset + chunk_size;
+            }
+            if (row->end == CY_FLASH_SIZEOF_ROW)
+            {
+                if (write_row_buffer(fap, image, row) != CY_UNTAR_SUCCESS)
+                {
+                    return CY_UNTAR_ERROR;
+                }
             }
         }
 
         curr_offset += chunk_size;
         curr_src += chunk_size;
         bytes_to_write -= chunk_size;
+        if (curr_offset > row->high)
+        {
+            row->high = curr_offset;
+        }
     }
 
     return CY_UNTAR_SUCCESS;
 }
 
+/**
+ * @brief End of the data of image 0 that is in FLASH
+ *
+ * @param end           end of the data written to the Secondary Slot
+ *
+ * @return  end, or the start of the row still in the row buffer if before end
+ */
+static uint32_t written_data_end(uint32_t end)
+{
+    if ( (row_buffer[0].valid != 0) && (row_buffer[0].row_base < end) )
+    {
+        return row_buffer[0].row_base;
+    }
+    return end;
+}
+
 /**
  * @brief callback to handle tar data
  *
@@ -245,20 +448,32 @@ static cy_untar_result_t ota_untar_write_callback(cy_untar_context_ptr ctxt,
         return CY_UNTAR_ERROR;
     }
 
-    if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(image), &fap) != 0)
+    /* only the Secondary Slot of image 0 is erased by storage open, other slots only take the FLASH lock */
+    if (cy_ota_storage_prepare_write((cy_ota_context_t *)cb_arg, file_offset, ((image == 0) ? chunk_size : 0)) != CY_RSLT_SUCCESS)
+    {
+        return CY_UNTAR_ERROR;
+    }
+
+    fap = (const struct flash_area *)cy_ota_storage_get_slot((cy_ota_context_t *)cb_arg, (uint16_t)image);
+    if (fap == NULL)
     {
-        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_open(%d) failed\n", __func__, image);
+        cy_ota_storage_write_done((cy_ota_context_t *)cb_arg);
         return CY_UNTAR_ERROR;
     }
 
-    if (write_data_to_flash(fap, file_offset, buffer, chunk_size) != 0)
+    if (write_data_to_flash(fap, (uint16_t)image, file_offset, buffer, chunk_size) != 0)
     {
         cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() write_data_to_flash() failed\n", __func__);
-        flash_area_close(fap);
+        cy_ota_storage_write_done((cy_ota_context_t *)cb_arg);
         return CY_UNTAR_ERROR;
     }
 
-    flash_area_close(fap);
+    cy_ota_storage_write_done((cy_ota_context_t *)cb_arg);
+
+    if (image == 0)
+    {
+        cy_ota_storage_image_hash((cy_ota_context_t *)cb_arg, file_offset, buffer, chunk_size);
+    }
 
     return CY_UNTAR_SUCCESS;
 }
@@ -274,7 +489,7 @@ static cy_untar_result_t ota_untar_write_callback(cy_untar_context_ptr ctxt,
  */
 static cy_untar_result_t cy_ota_untar_init_context(cy_ota_context_ptr ctx_ptr, cy_untar_context_t* ctx_untar )
 {
-    if (cy_untar_init( ctx_untar, ota_untar_write_callback, NULL ) == CY_RSLT_SUCCESS)
+    if (cy_untar_init( ctx_untar, ota_untar_write_callback, ctx_ptr ) == CY_RSLT_SUCCESS)
     {
         cy_ota_context_t *ctx = (cy_ota_context_t *)ctx_ptr;
         CY_OTA_CONTEXT_ASSERT(ctx);
@@ -418,22 +633,88 @@ cy_rslt_t cy_ota_write_incoming_data_block(cy_ota_context_ptr ctx_ptr, cy_ota_st
     {
         /* non-tarball OTA here, always image 0x00 */
         const struct flash_area *fap;
+        uint32_t start;
+        uint32_t end;
 
         cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() NON-TAR \n", __func__);
-        if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(0), &fap) != 0)
+        if (cy_ota_storage_prepare_write(ctx, chunk_info->offset, chunk_info->size) != CY_RSLT_SUCCESS)
+        {
+            return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+        }
+        fap = (const struct flash_area *)cy_ota_storage_get_slot(ctx, 0);
+        if (fap == NULL)
         {
-            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() flash_area_open()\n", __func__);
+            cy_ota_storage_write_done(ctx);
             return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
         }
 
-        if (write_data_to_flash( fap, chunk_info->offset, chunk_info->buffer, chunk_info->size) != CY_RSLT_SUCCESS)
+        start = written_data_end(chunk_info->offset);
+        if (write_data_to_flash( fap, 0, chunk_info->offset, chunk_info->buffer, chunk_info->size) != CY_RSLT_SUCCESS)
         {
             cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() WRITE FAILED\n", __func__);
+            cy_ota_storage_write_done(ctx);
             return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
         }
 
-        flash_area_close(fap);
+        /* note the progress of the data in FLASH, a row still being collected is not (the journal is written with the FLASH lock held) */
+        end = written_data_end(chunk_info->offset + chunk_info->size);
+        if (end > start)
+        {
+            cy_ota_storage_journal_update(ctx, start, (end - start));
+        }
+        cy_ota_storage_write_done(ctx);
+
+        /* hash outside of the FLASH lock, the erase-ahead thread can run meanwhile */
+        cy_ota_storage_image_hash(ctx, chunk_info->offset, chunk_info->buffer, chunk_info->size);
     }
 
     return CY_RSLT_SUCCESS;
 }
+
+cy_rslt_t cy_ota_write_flush(cy_ota_context_t *ctx)
+{
+    const struct flash_area *fap;
+    cy_rslt_t   result = CY_RSLT_SUCCESS;
+    uint16_t    image;
+
+    for (image = 0; image < CY_OTA_SECONDARY_SLOTS; image++)
+    {
+        if (row_buffer[image].valid == 0)
+        {
+            continue;
+        }
+        fap = (const struct flash_area *)cy_ota_storage_get_slot(ctx, image);
+        if (fap == NULL)
+        {
+            row_buffer[image].valid = 0;
+            result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+            continue;
+        }
+        /* the row was prepared for writing with its data, only take the FLASH lock */
+        cy_ota_storage_prepare_write(ctx, row_buffer[image].row_base, 0);
+        if (write_row_buffer(fap, image, &row_buffer[image]) != CY_UNTAR_SUCCESS)
+        {
+            result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+        }
+        cy_ota_storage_write_done(ctx);
+    }
+
+    if (flash_bytes > 0)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "Wrote %ld bytes: %ld FLASH writes, %ld row reads (%ld writes / %ld reads per MB), %ld erased bytes skipped\n",
+                   flash_bytes, flash_writes, flash_row_reads,
+                   (uint32_t)(((uint64_t)flash_writes << 20) / flash_bytes),
+                   (uint32_t)(((uint64_t)flash_row_reads << 20) / flash_bytes), flash_skipped);
+    }
+    cy_ota_write_discard();
+    return result;
+}
+
+void cy_ota_write_discard(void)
+{
+    memset(row_buffer, 0x00, sizeof(row_buffer));
+    flash_row_reads = 0;
+    flash_writes    = 0;
+    flash_bytes     = 0;
+    flash_skipped   = 0;
+}
@@ -0,0 +1,589 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ *  Cypress OTA Agent storage writer
+ *
+ *  Received chunks are copied into CY_OTA_WRITER_NUM_BUFFERS buffers and written
+ *  to FLASH by a separate thread, so the transport can receive the next chunk
+ *  while the previous one is being programmed.
+ *
+ *  With CY_OTA_WRITER_NUM_BUFFERS == 0, chunks are written in the receiving thread.
+ *
+ *  With CY_OTA_DECOMPRESS == 1, a compressed download is decompressed here in the
+ *  receiving thread, and the uncompressed data goes to the writer.
+ *
+ *  With CY_OTA_DELTA == 1, a delta patch (after decompression) is applied here to
+ *  the image in the Primary Slot, and the new image goes to the writer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cy_ota_api.h"
+#include "cy_ota_internal.h"
+
+#include "cyabs_rtos.h"
+#include "cy_log.h"
+
+#if (CY_OTA_WRITER_NUM_BUFFERS > 0)
+
+/***********************************************************************
+ *
+ * defines & enums
+ *
+ **********************************************************************/
+
+#define OTA_WRITER_THREAD_NAME      "CY OTA Writer"
+
+/***********************************************************************
+ *
+ * Writer thread
+ *
+ **********************************************************************/
+
+/**
+ * @brief Storage writer thread
+ *
+ * Writes buffers in the order they were filled. After a failure the remaining
+ * buffers are released without writing, the failure is reported back through
+ * cy_ota_writer_write() / cy_ota_writer_flush().
+ *
+ * @param[in]   arg - pointer to OTA agent context @ref cy_ota_context_t
+ */
+static void cy_ota_writer_thread(cy_thread_arg_t arg)
+{
+    cy_ota_context_t        *ctx = (cy_ota_context_t *)arg;
+    cy_ota_writer_buffer_t  *buff;
+    cy_rslt_t               result;
+    CY_OTA_CONTEXT_ASSERT(ctx);
+
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() Entered OTA Writer Thread\n", __func__);
+
+    while (1)
+    {
+        if (cy_rtos_get_semaphore(&ctx->writer.full_sem, CY_RTOS_NEVER_TIMEOUT, false) != CY_RSLT_SUCCESS)
+        {
+            continue;
+        }
+        if (ctx->writer.stop != 0)
+        {
+            break;
+        }
+
+        buff = &ctx->writer.buffers[ctx->writer.tail];
+        ctx->writer.tail = (ctx->writer.tail + 1) % CY_OTA_WRITER_NUM_BUFFERS;
+
+        if (ctx->writer.result == CY_RSLT_SUCCESS)
+        {
+            result = cy_ota_write_incoming_data_block(ctx, &buff->info);
+            if (result != CY_RSLT_SUCCESS)
+            {
+                cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Write failed offset:0x%lx size:%ld\n", __func__,
+                           buff->info.offset, buff->info.size);
+                ctx->writer.result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+                cy_rtos_setbits_event(&ctx->ota_event, (uint32_t)CY_OTA_EVENT_DATA_FAIL, 0);
+            }
+            ctx->writer.writes++;
+        }
+
+        cy_rtos_set_semaphore(&ctx->writer.free_sem, false);
+    }
+
+    cy_log_msg(CYLF_OTA, CY_LOG_DEBUG, "%s() exiting, %ld writes, waited %ld ms for buffers\n", __func__,
+               ctx->writer.writes, ctx->writer.wait_ms);
+
+    cy_rtos_exit_thread();
+}
+
+/**
+ * @brief Create the semaphores and start the writer thread
+ *
+ * @param[in]   ctx - pointer to OTA agent context @ref cy_ota_context_t
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_GENERAL
+ */
+static cy_rslt_t cy_ota_writer_start(cy_ota_context_t *ctx)
+{
+    cy_rslt_t result;
+
+    ctx->writer.stop    = 0;
+    ctx->writer.head    = 0;
+    ctx->writer.tail    = 0;
+    ctx->writer.result  = CY_RSLT_SUCCESS;
+    ctx->writer.writes  = 0;
+    ctx->writer.wait_ms = 0;
+
+    result = cy_rtos_init_semaphore(&ctx->writer.free_sem, CY_OTA_WRITER_NUM_BUFFERS, CY_OTA_WRITER_NUM_BUFFERS);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_rtos_init_semaphore(free) failed 0x%lx\n", __func__, result);
+        return CY_RSLT_OTA_ERROR_GENERAL;
+    }
+
+    result = cy_rtos_init_semaphore(&ctx->writer.full_sem, CY_OTA_WRITER_NUM_BUFFERS + 1, 0);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_rtos_init_semaphore(full) failed 0x%lx\n", __func__, result);
+        cy_rtos_deinit_semaphore(&ctx->writer.free_sem);
+        return CY_RSLT_OTA_ERROR_GENERAL;
+    }
+
+    result = cy_rtos_create_thread(&ctx->writer.thread, cy_ota_writer_thread,
+                                   OTA_WRITER_THREAD_NAME, NULL, CY_OTA_WRITER_THREAD_STACK_SIZE,
+                                   CY_RTOS_PRIORITY_NORMAL, ctx);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() cy_rtos_create_thread() failed 0x%lx\n", __func__, result);
+        cy_rtos_deinit_semaphore(&ctx->writer.full_sem);
+        cy_rtos_deinit_semaphore(&ctx->writer.free_sem);
+        return CY_RSLT_OTA_ERROR_GENERAL;
+    }
+
+    ctx->writer.running = 1;
+    return CY_RSLT_SUCCESS;
+}
+
+#endif  /* CY_OTA_WRITER_NUM_BUFFERS > 0 */
+
+/**
+ * @brief Write uncompressed data, or queue it for the writer thread
+ *
+ * @param[in]   ctx         - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   chunk_info  - pointer to chunk information
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+static cy_rslt_t cy_ota_writer_queue(cy_ota_context_t *ctx, cy_ota_storage_write_info_t *chunk_info)
+{
+#if (CY_OTA_WRITER_NUM_BUFFERS > 0)
+    cy_ota_writer_buffer_t  *buff;
+    cy_time_t               start_time;
+    cy_time_t               end_time;
+    uint32_t                done;
+    uint32_t                size;
+#endif
+
+#if (CY_OTA_WRITER_NUM_BUFFERS == 0)
+    return cy_ota_write_incoming_data_block(ctx, chunk_info);
+#else
+    if (ctx->writer.running == 0)
+    {
+        if (cy_ota_writer_start(ctx) != CY_RSLT_SUCCESS)
+        {
+            /* No thread - write from here */
+            return cy_ota_write_incoming_data_block(ctx, chunk_info);
+        }
+    }
+
+    for (done = 0; done < chunk_info->size; done += size)
+    {
+        if (ctx->writer.result != CY_RSLT_SUCCESS)
+        {
+            return ctx->writer.result;
+        }
+
+        size = chunk_info->size - done;
+        if (size > CY_OTA_CHUNK_SIZE)
+        {
+            size = CY_OTA_CHUNK_SIZE;
+        }
+
+        cy_rtos_get_time(&start_time);
+        if (cy_rtos_get_semaphore(&ctx->writer.free_sem, CY_OTA_WRITER_WAIT_MS, false) != CY_RSLT_SUCCESS)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Timed out waiting for a writer buffer\n", __func__);
+            return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+        }
+        cy_rtos_get_time(&end_time);
+        ctx->writer.wait_ms += (end_time - start_time);
+
+        buff = &ctx->writer.buffers[ctx->writer.head];
+        ctx->writer.head = (ctx->writer.head + 1) % CY_OTA_WRITER_NUM_BUFFERS;
+
+        memcpy(&buff->info, chunk_info, sizeof(cy_ota_storage_write_info_t));
+        memcpy(buff->data, &chunk_info->buffer[done], size);
+        buff->info.buffer = buff->data;
+        buff->info.offset = chunk_info->offset + done;
+        buff->info.size   = size;
+
+        cy_rtos_set_semaphore(&ctx->writer.full_sem, false);
+    }
+
+    return ctx->writer.result;
+#endif
+}
+
+#if (CY_OTA_DELTA == 1)
+
+/***********************************************************************
+ *
+ * Delta patch stage
+ *
+ **********************************************************************/
+
+/**
+ * @brief Decoder output callback, write one piece of the new image
+ *
+ * @param[in]   cb_arg  - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   offset  - offset of the data in the new OTA Image
+ * @param[in]   buffer  - new image data, in the decoder buffer
+ * @param[in]   size    - bytes of data
+ *
+ * @return  0 - OK, -1 - write failed
+ */
+static int cy_ota_delta_write_callback(void *cb_arg, uint32_t offset, const uint8_t *buffer, uint32_t size)
+{
+    cy_ota_context_t            *ctx = (cy_ota_context_t *)cb_arg;
+    cy_ota_storage_write_info_t info;
+
+    memcpy(&info, ctx->delta.chunk_info, sizeof(cy_ota_storage_write_info_t));
+    info.total_size = ctx->delta.decoder.new_size;
+    info.offset     = offset;
+    info.buffer     = (uint8_t *)buffer;
+    info.size       = size;
+
+    return (cy_ota_writer_queue(ctx, &info) == CY_RSLT_SUCCESS) ? 0 : -1;
+}
+
+/**
+ * @brief Apply a chunk of a delta patch, pass others through
+ *
+ * A download is a patch when its first chunk starts with the CY_DELTA_MAGIC.
+ * The old image is read from the Primary Slot, and the patch is refused before
+ * anything is written if that is not the image it was made from. The decoder
+ * needs the patch in order; data that was already applied is skipped, a gap is
+ * an error.
+ *
+ * @param[in]   ctx         - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   chunk_info  - pointer to chunk information, offset and size in the patch
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_OPEN_STORAGE
+ *          CY_RSLT_OTA_ERROR_INVALID_VERSION
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+static cy_rslt_t cy_ota_delta_write(cy_ota_context_t *ctx, cy_ota_storage_write_info_t *chunk_info)
+{
+    cy_ota_delta_context_t  *dc = &ctx->delta;
+    cy_delta_result_t       result;
+    uint32_t                skip = 0;
+
+    if (chunk_info->offset == 0)
+    {
+        dc->active = 0;
+        if (cy_delta_is_patch(chunk_info->buffer, chunk_info->size))
+        {
+            if (cy_ota_storage_primary_open(ctx) != CY_RSLT_SUCCESS)
+            {
+                return CY_RSLT_OTA_ERROR_OPEN_STORAGE;
+            }
+            if (cy_delta_init(&dc->decoder, dc->buffer, sizeof(dc->buffer), cy_ota_storage_primary_read,
+                              cy_ota_delta_write_callback, ctx) != CY_DELTA_SUCCESS)
+            {
+                cy_ota_storage_primary_close(ctx);
+                return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+            }
+            cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%s() Delta patch\n", __func__);
+            dc->active      = 1;
+            dc->next_offset = 0;
+
+            /* the decoder state is not in FLASH, a patch download can not be resumed */
+            ctx->journal.active = 0;
+        }
+    }
+
+    if (dc->active == 0)
+    {
+        return cy_ota_writer_queue(ctx, chunk_info);
+    }
+
+    if (chunk_info->offset > dc->next_offset)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Patch data out of order, expected offset:0x%lx got:0x%lx\n",
+                   __func__, dc->next_offset, chunk_info->offset);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+    skip = dc->next_offset - chunk_info->offset;
+    if (skip >= chunk_info->size)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    dc->chunk_info = chunk_info;
+    result = cy_delta_apply(&dc->decoder, &chunk_info->buffer[skip], (chunk_info->size - skip));
+    dc->next_offset = chunk_info->offset + chunk_info->size;
+    if (result == CY_DELTA_SUCCESS)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    cy_ota_storage_primary_close(ctx);
+    if (result == CY_DELTA_WRONG_BASE)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Patch is not for the image in the Primary Slot\n", __func__);
+        return CY_RSLT_OTA_ERROR_INVALID_VERSION;
+    }
+    if (result == CY_DELTA_ERROR)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Patch failed at offset:0x%lx\n", __func__, dc->decoder.input_bytes);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+    cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%s() Applied %ld byte patch, new image %ld bytes\n", __func__,
+               dc->decoder.input_bytes, dc->decoder.new_bytes);
+    return CY_RSLT_SUCCESS;
+}
+
+#endif  /* CY_OTA_DELTA == 1 */
+
+/**
+ * @brief Apply a delta patch, or write the data
+ *
+ * @param[in]   ctx         - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   chunk_info  - pointer to chunk information
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+static cy_rslt_t cy_ota_writer_patch(cy_ota_context_t *ctx, cy_ota_storage_write_info_t *chunk_info)
+{
+#if (CY_OTA_DELTA == 1)
+    return cy_ota_delta_write(ctx, chunk_info);
+#else
+    return cy_ota_writer_queue(ctx, chunk_info);
+#endif
+}
+
+#if (CY_OTA_DECOMPRESS == 1)
+
+/***********************************************************************
+ *
+ * Decompression stage
+ *
+ **********************************************************************/
+
+/**
+ * @brief Decoder output callback, write one piece of uncompressed data
+ *
+ * @param[in]   cb_arg  - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   offset  - offset of the data in the uncompressed OTA Image
+ * @param[in]   buffer  - uncompressed data, in the decoder window
+ * @param[in]   size    - bytes of uncompressed data
+ *
+ * @return  0 - OK, -1 - write failed
+ */
+static int cy_ota_decompress_write_callback(void *cb_arg, uint32_t offset, const uint8_t *buffer, uint32_t size)
+{
+    cy_ota_context_t            *ctx = (cy_ota_context_t *)cb_arg;
+    cy_ota_storage_write_info_t info;
+
+    memcpy(&info, ctx->decompress.chunk_info, sizeof(cy_ota_storage_write_info_t));
+    info.total_size = ctx->decompress.decoder.output_size;
+    info.offset     = offset;
+    info.buffer     = (uint8_t *)buffer;
+    info.size       = size;
+
+    return (cy_ota_writer_patch(ctx, &info) == CY_RSLT_SUCCESS) ? 0 : -1;
+}
+
+/**
+ * @brief Decompress a chunk of a compressed download, pass others through
+ *
+ * A download is compressed when its first chunk starts with the CY_LZSS_MAGIC.
+ * The decoder needs the compressed data in order; data that was already decoded
+ * is skipped, a gap is an error.
+ *
+ * @param[in]   ctx         - pointer to OTA agent context @ref cy_ota_context_t
+ * @param[in]   chunk_info  - pointer to chunk information, offset and size in the compressed download
+ *
+ * @return  CY_RSLT_SUCCESS
+ *          CY_RSLT_OTA_ERROR_WRITE_STORAGE
+ */
+static cy_rslt_t cy_ota_decompress_write(cy_ota_context_t *ctx, cy_ota_storage_write_info_t *chunk_info)
+{
+    cy_ota_decompress_context_t *dc = &ctx->decompress;
+    cy_lzss_result_t            result;
+    uint32_t                    skip = 0;
+
+    if (chunk_info->offset == 0)
+    {
+        dc->active = 0;
+        if (cy_lzss_is_compressed(chunk_info->buffer, chunk_info->size))
+        {
+            if (cy_lzss_init(&dc->decoder, dc->window, sizeof(dc->window),
+                             cy_ota_decompress_write_callback, ctx) != CY_LZSS_SUCCESS)
+            {
+                return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+            }
+            cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%s() Compressed OTA Image\n", __func__);
+            dc->active      = 1;
+            dc->next_offset = 0;
+
+            /* the decoder state is not in FLASH, a compressed download can not be resumed */
+            ctx->journal.active = 0;
+        }
+    }
+
+    if (dc->active == 0)
+    {
+        return cy_ota_writer_patch(ctx, chunk_info);
+    }
+
+    if (chunk_info->offset > dc->next_offset)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Compressed data out of order, expected offset:0x%lx got:0x%lx\n",
+                   __func__, dc->next_offset, chunk_info->offset);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+    skip = dc->next_offset - chunk_info->offset;
+    if (skip >= chunk_info->size)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    dc->chunk_info = chunk_info;
+    result = cy_lzss_decode(&dc->decoder, &chunk_info->buffer[skip], (chunk_info->size - skip));
+    dc->next_offset = chunk_info->offset + chunk_info->size;
+    if (result == CY_LZSS_ERROR)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Decompression failed at offset:0x%lx\n", __func__, dc->decoder.input_bytes);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+    if (result == CY_LZSS_DONE)
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_NOTICE, "%s() Decompressed %ld bytes to %ld bytes\n", __func__,
+                   dc->decoder.input_bytes, dc->decoder.output_bytes);
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+#endif  /* CY_OTA_DECOMPRESS == 1 */
+
+/***********************************************************************
+ *
+ * Functions
+ *
+ **********************************************************************/
+
+cy_rslt_t cy_ota_writer_write(cy_ota_context_t *ctx, cy_ota_storage_write_info_t *chunk_info)
+{
+    if ( (ctx == NULL) || (chunk_info == NULL) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Bad args\n", __func__);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+
+#if (CY_OTA_DECOMPRESS == 1)
+    return cy_ota_decompress_write(ctx, chunk_info);
+#else
+    return cy_ota_writer_patch(ctx, chunk_info);
+#endif
+}
+
+cy_rslt_t cy_ota_writer_flush(cy_ota_context_t *ctx)
+{
+#if (CY_OTA_WRITER_NUM_BUFFERS > 0)
+    uint32_t    i;
+    uint32_t    taken;
+
+    if ( (ctx == NULL) || (ctx->writer.running == 0) )
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    /* All buffers are free when we can take every one of them */
+    for (taken = 0; taken < CY_OTA_WRITER_NUM_BUFFERS; taken++)
+    {
+        if (cy_rtos_get_semaphore(&ctx->writer.free_sem, CY_OTA_WRITER_WAIT_MS, false) != CY_RSLT_SUCCESS)
+        {
+            cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Timed out waiting for writer\n", __func__);
+            ctx->writer.result = CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+            break;
+        }
+    }
+    for (i = 0; i < taken; i++)
+    {
+        cy_rtos_set_semaphore(&ctx->writer.free_sem, false);
+    }
+
+    return ctx->writer.result;
+#else
+    (void)ctx;
+    return CY_RSLT_SUCCESS;
+#endif
+}
+
+cy_rslt_t cy_ota_writer_check_complete(cy_ota_context_t *ctx)
+{
+    if (ctx == NULL)
+    {
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+
+#if (CY_OTA_DECOMPRESS == 1)
+    if ( (ctx->decompress.active != 0) &&
+         ( (ctx->decompress.decoder.state != CY_LZSS_STATE_DONE) ||
+           (ctx->decompress.decoder.output_bytes != ctx->decompress.decoder.output_size) ) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Compressed download ended early, %ld of %ld bytes\n", __func__,
+                   ctx->decompress.decoder.output_bytes, ctx->decompress.decoder.output_size);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+#endif
+#if (CY_OTA_DELTA == 1)
+    if ( (ctx->delta.active != 0) &&
+         ( (ctx->delta.decoder.state != CY_DELTA_STATE_DONE) ||
+           (ctx->delta.decoder.new_bytes != ctx->delta.decoder.new_size) ) )
+    {
+        cy_log_msg(CYLF_OTA, CY_LOG_ERR, "%s() Patch ended early, new image %ld of %ld bytes\n", __func__,
+                   ctx->delta.decoder.new_bytes, ctx->delta.decoder.new_size);
+        cy_ota_storage_primary_close(ctx);
+        return CY_RSLT_OTA_ERROR_WRITE_STORAGE;
+    }
+#endif
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_ota_writer_stop(cy_ota_context_t *ctx)
+{
+#if (CY_OTA_WRITER_NUM_BUFFERS > 0)
+    cy_rslt_t   result;
+
+    if ( (ctx == NULL) || (ctx->writer.running == 0) )
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    result = cy_ota_writer_flush(ctx);
+
+    ctx->writer.stop = 1;
+    cy_rtos_set_semaphore(&ctx->writer.full_sem, false);
+    cy_rtos_join_thread(&ctx->writer.thread);
+
+    cy_rtos_deinit_semaphore(&ctx->writer.full_sem);
+    cy_rtos_deinit_semaphore(&ctx->writer.free_sem);
+    ctx->writer.running = 0;
+
+    return result;
+#else
+    (void)ctx;
+    return CY_RSLT_SUCCESS;
+#endif
+}
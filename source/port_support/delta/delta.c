@@ -0,0 +1,400 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Apply an incoming delta patch
+ *
+ * NOTE: The patch arrives in pieces of any size, so all decoding state is kept
+ *       in the decoder structure. The output buffer is the only buffer: old data
+ *       is read straight into it, ADD bytes are added in place, and it is handed
+ *       to the write callback each time it fills.
+ *
+ *       Only standard headers are used so this can also be built on a host.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "delta.h"
+
+/*************************************************************
+ * Defines and enums
+ ************************************************************/
+#define DELTA_HEADER_VERSION_OFFSET     (4)
+#define DELTA_HEADER_OLD_SIZE_OFFSET    (8)
+#define DELTA_HEADER_OLD_CRC_OFFSET     (12)
+#define DELTA_HEADER_NEW_SIZE_OFFSET    (16)
+
+#define DELTA_CRC32_INIT                (0xFFFFFFFFU)
+#define DELTA_CRC32_POLY                (0xEDB88320U)       /* reflected IEEE 802.3 */
+
+/*************************************************************
+ * Static Functions
+ ************************************************************/
+
+static uint32_t delta_get_u32(const uint8_t *buffer)
+{
+    return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) |
+           ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+static uint32_t delta_crc32(uint32_t crc, const uint8_t *buffer, uint32_t size)
+{
+    uint32_t    bit;
+
+    while (size-- > 0)
+    {
+        crc ^= *buffer++;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (DELTA_CRC32_POLY & (0U - (crc & 1U)));
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Hand the output buffer to the write callback
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ *
+ * @return  true  - OK
+ *          false - write failed
+ */
+static bool delta_flush(cy_delta_decoder_t *decoder)
+{
+    if (decoder->buffer_fill == 0)
+    {
+        return true;
+    }
+    if (decoder->write_func(decoder->cb_arg, (decoder->new_bytes - decoder->buffer_fill),
+                            decoder->buffer, decoder->buffer_fill) != 0)
+    {
+        return false;
+    }
+    decoder->buffer_fill = 0;
+    return true;
+}
+
+/**
+ * @brief Bytes that fit in the output buffer, flushing it first if it is full
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ *
+ * @return  free bytes in the output buffer, 0 if the write failed
+ */
+static uint32_t delta_space(cy_delta_decoder_t *decoder)
+{
+    if ( (decoder->buffer_fill == decoder->buffer_size) && !delta_flush(decoder) )
+    {
+        return 0;
+    }
+    return decoder->buffer_size - decoder->buffer_fill;
+}
+
+/**
+ * @brief Check and use the patch header, check the old image
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ *
+ * @return  next state
+ */
+static cy_delta_state_t delta_process_header(cy_delta_decoder_t *decoder)
+{
+    uint32_t    old_crc = delta_get_u32(&decoder->header[DELTA_HEADER_OLD_CRC_OFFSET]);
+    uint32_t    crc = DELTA_CRC32_INIT;
+    uint32_t    offset;
+    uint32_t    size;
+
+    if ( !cy_delta_is_patch(decoder->header, CY_DELTA_HEADER_SIZE) ||
+         (decoder->header[DELTA_HEADER_VERSION_OFFSET] != CY_DELTA_VERSION) )
+    {
+        return CY_DELTA_STATE_ERROR;
+    }
+    decoder->old_size = delta_get_u32(&decoder->header[DELTA_HEADER_OLD_SIZE_OFFSET]);
+    decoder->new_size = delta_get_u32(&decoder->header[DELTA_HEADER_NEW_SIZE_OFFSET]);
+
+    /* the patch only makes sense on top of the image it was made from */
+    for (offset = 0; offset < decoder->old_size; offset += size)
+    {
+        size = decoder->old_size - offset;
+        if (size > decoder->buffer_size)
+        {
+            size = decoder->buffer_size;
+        }
+        if (decoder->read_func(decoder->cb_arg, offset, decoder->buffer, size) != 0)
+        {
+            return CY_DELTA_STATE_ERROR;
+        }
+        crc = delta_crc32(crc, decoder->buffer, size);
+    }
+    if ((uint32_t)(crc ^ DELTA_CRC32_INIT) != old_crc)
+    {
+        return CY_DELTA_STATE_WRONG_BASE;
+    }
+
+    return (decoder->new_size == 0) ? CY_DELTA_STATE_DONE : CY_DELTA_STATE_OPCODE;
+}
+
+/**
+ * @brief Copy old data to the output
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ *
+ * @return  true  - OK
+ *          false - read or write failed
+ */
+static bool delta_copy(cy_delta_decoder_t *decoder)
+{
+    while (decoder->remaining > 0)
+    {
+        uint32_t    size = delta_space(decoder);
+        if (size == 0)
+        {
+            return false;
+        }
+        if (size > decoder->remaining)
+        {
+            size = decoder->remaining;
+        }
+        if (decoder->read_func(decoder->cb_arg, decoder->old_offset, &decoder->buffer[decoder->buffer_fill], size) != 0)
+        {
+            return false;
+        }
+        decoder->old_offset  += size;
+        decoder->remaining   -= size;
+        decoder->buffer_fill += size;
+        decoder->new_bytes   += size;
+    }
+    return true;
+}
+
+/**
+ * @brief A command is complete, find what comes next
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ *
+ * @return  next state
+ */
+static cy_delta_state_t delta_next_command(cy_delta_decoder_t *decoder)
+{
+    if (decoder->new_bytes < decoder->new_size)
+    {
+        return CY_DELTA_STATE_OPCODE;
+    }
+    return delta_flush(decoder) ? CY_DELTA_STATE_DONE : CY_DELTA_STATE_ERROR;
+}
+
+/**
+ * @brief Check and start a command
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ *
+ * @return  next state
+ */
+static cy_delta_state_t delta_process_command(cy_delta_decoder_t *decoder)
+{
+    uint32_t    length;
+
+    if (decoder->opcode == CY_DELTA_OP_INSERT)
+    {
+        length = delta_get_u32(decoder->args);
+    }
+    else
+    {
+        decoder->old_offset = delta_get_u32(decoder->args);
+        length = delta_get_u32(&decoder->args[4]);
+        if ( (decoder->old_offset > decoder->old_size) || (length > (decoder->old_size - decoder->old_offset)) )
+        {
+            return CY_DELTA_STATE_ERROR;
+        }
+    }
+    if ( (length == 0) || (length > (decoder->new_size - decoder->new_bytes)) )
+    {
+        return CY_DELTA_STATE_ERROR;
+    }
+    decoder->remaining = length;
+
+    if (decoder->opcode == CY_DELTA_OP_COPY)
+    {
+        return delta_copy(decoder) ? delta_next_command(decoder) : CY_DELTA_STATE_ERROR;
+    }
+    return CY_DELTA_STATE_DATA;
+}
+
+/**
+ * @brief Use ADD or INSERT data bytes from the patch
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ * @param data[in]          patch data
+ * @param size[in]          bytes in data
+ * @param used[out]         bytes of data used
+ *
+ * @return  next state
+ */
+static cy_delta_state_t delta_process_data(cy_delta_decoder_t *decoder, const uint8_t *data, uint32_t size, uint32_t *used)
+{
+    uint8_t     *out;
+    uint32_t    count = delta_space(decoder);
+    uint32_t    i;
+
+    *used = 0;
+    if (count == 0)
+    {
+        return CY_DELTA_STATE_ERROR;
+    }
+    if (count > size)
+    {
+        count = size;
+    }
+    if (count > decoder->remaining)
+    {
+        count = decoder->remaining;
+    }
+
+    out = &decoder->buffer[decoder->buffer_fill];
+    if (decoder->opcode == CY_DELTA_OP_ADD)
+    {
+        if (decoder->read_func(decoder->cb_arg, decoder->old_offset, out, count) != 0)
+        {
+            return CY_DELTA_STATE_ERROR;
+        }
+        for (i = 0; i < count; i++)
+        {
+            out[i] = (uint8_t)(out[i] + data[i]);
+        }
+        decoder->old_offset += count;
+    }
+    else
+    {
+        memcpy(out, data, count);
+    }
+    decoder->remaining   -= count;
+    decoder->buffer_fill += count;
+    decoder->new_bytes   += count;
+    *used = count;
+
+    return (decoder->remaining == 0) ? delta_next_command(decoder) : CY_DELTA_STATE_DATA;
+}
+
+/*************************************************************
+ * Public Functions
+ ************************************************************/
+
+bool cy_delta_is_patch(const uint8_t *buffer, uint32_t size)
+{
+    return ( (buffer != NULL) && (size >= CY_DELTA_MAGIC_LEN) &&
+             (memcmp(buffer, CY_DELTA_MAGIC, CY_DELTA_MAGIC_LEN) == 0) );
+}
+
+cy_delta_result_t cy_delta_init(cy_delta_decoder_t *decoder, uint8_t *buffer, uint32_t buffer_size,
+                                cy_delta_read_callback_t read_func, cy_delta_write_callback_t write_func, void *cb_arg)
+{
+    if ( (decoder == NULL) || (buffer == NULL) || (buffer_size < CY_DELTA_MIN_BUFFER_SIZE) ||
+         (read_func == NULL) || (write_func == NULL) )
+    {
+        return CY_DELTA_ERROR;
+    }
+
+    memset(decoder, 0x00, sizeof(cy_delta_decoder_t));
+    decoder->state       = CY_DELTA_STATE_HEADER;
+    decoder->buffer      = buffer;
+    decoder->buffer_size = buffer_size;
+    decoder->read_func   = read_func;
+    decoder->write_func  = write_func;
+    decoder->cb_arg      = cb_arg;
+    return CY_DELTA_SUCCESS;
+}
+
+cy_delta_result_t cy_delta_apply(cy_delta_decoder_t *decoder, const uint8_t *data, uint32_t size)
+{
+    uint32_t    index = 0;
+    uint32_t    used;
+
+    if ( (decoder == NULL) || ( (data == NULL) && (size > 0) ) )
+    {
+        return CY_DELTA_ERROR;
+    }
+
+    while ( (index < size) && (decoder->state < CY_DELTA_STATE_DONE) )
+    {
+        uint8_t c = data[index];
+
+        switch (decoder->state)
+        {
+        case CY_DELTA_STATE_HEADER:
+            decoder->header[decoder->header_bytes++] = c;
+            if (decoder->header_bytes == CY_DELTA_HEADER_SIZE)
+            {
+                decoder->state = delta_process_header(decoder);
+            }
+            index++;
+            break;
+
+        case CY_DELTA_STATE_OPCODE:
+            decoder->opcode     = c;
+            decoder->args_bytes = 0;
+            if ( (c == CY_DELTA_OP_COPY) || (c == CY_DELTA_OP_ADD) )
+            {
+                decoder->args_size = 8;
+            }
+            else if (c == CY_DELTA_OP_INSERT)
+            {
+                decoder->args_size = 4;
+            }
+            else
+            {
+                decoder->state = CY_DELTA_STATE_ERROR;
+                break;
+            }
+            decoder->state = CY_DELTA_STATE_ARGS;
+            index++;
+            break;
+
+        case CY_DELTA_STATE_ARGS:
+            decoder->args[decoder->args_bytes++] = c;
+            if (decoder->args_bytes == decoder->args_size)
+            {
+                decoder->state = delta_process_command(decoder);
+            }
+            index++;
+            break;
+
+        case CY_DELTA_STATE_DATA:
+            decoder->state = delta_process_data(decoder, &data[index], (size - index), &used);
+            index += used;
+            break;
+
+        default:
+            break;
+        }
+    }
+    decoder->input_bytes += index;
+
+    switch (decoder->state)
+    {
+    case CY_DELTA_STATE_DONE:
+        return CY_DELTA_DONE;
+    case CY_DELTA_STATE_WRONG_BASE:
+        return CY_DELTA_WRONG_BASE;
+    case CY_DELTA_STATE_ERROR:
+        return CY_DELTA_ERROR;
+    default:
+        break;
+    }
+    return CY_DELTA_SUCCESS;
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Cypress streaming delta patch decoder.
+ *
+ */
+
+#ifndef DELTA_H__
+#define DELTA_H__   1
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Patch format, see scripts/ota_delta.py
+ *
+ * Header, CY_DELTA_HEADER_SIZE bytes, little endian:
+ *                                  offset  size
+ *      magic "CYDP"                 0       4
+ *      format version (1)           4       1
+ *      reserved (0)                 5       3
+ *      old image size               8       4
+ *      CRC-32 of the old image      12      4
+ *      new image size               16      4
+ *
+ * Followed by commands, each an opcode byte and little endian arguments:
+ *      CY_DELTA_OP_COPY    old offset (4), length (4)
+ *                          new data is the old data
+ *      CY_DELTA_OP_ADD     old offset (4), length (4), then <length> bytes
+ *                          new data is the old data plus each byte (modulo 256)
+ *      CY_DELTA_OP_INSERT  length (4), then <length> bytes
+ *                          new data is the bytes
+ *
+ * The new image is built in order. The old image is read through the read
+ * callback, the new image is handed to the write callback in pieces of the
+ * output buffer size, and the last part at the end of the patch.
+ */
+
+#define CY_DELTA_MAGIC              "CYDP"
+#define CY_DELTA_MAGIC_LEN          (4)
+#define CY_DELTA_VERSION            (1)
+#define CY_DELTA_HEADER_SIZE        (20)
+
+#define CY_DELTA_OP_COPY            (1)
+#define CY_DELTA_OP_ADD             (2)
+#define CY_DELTA_OP_INSERT          (3)
+
+#define CY_DELTA_MAX_ARGS_SIZE      (8)
+#define CY_DELTA_MIN_BUFFER_SIZE    (64)
+
+typedef enum {
+    CY_DELTA_SUCCESS = 0,                       /**< Data used, more output expected.                 */
+    CY_DELTA_DONE,                              /**< New image complete and written.                  */
+    CY_DELTA_WRONG_BASE,                        /**< Old image size or CRC does not match the patch.  */
+    CY_DELTA_ERROR,                             /**< Patch is invalid, or a read or write failed.     */
+} cy_delta_result_t;
+
+typedef enum {
+    CY_DELTA_STATE_HEADER = 0,                  /**< Collecting the patch header          */
+    CY_DELTA_STATE_OPCODE,                      /**< Next byte is an opcode               */
+    CY_DELTA_STATE_ARGS,                        /**< Collecting the command arguments     */
+    CY_DELTA_STATE_DATA,                        /**< Data bytes of ADD or INSERT          */
+    CY_DELTA_STATE_DONE,                        /**< New image complete                   */
+    CY_DELTA_STATE_WRONG_BASE,                  /**< Patch is for another old image       */
+    CY_DELTA_STATE_ERROR,                       /**< Patch invalid                        */
+} cy_delta_state_t;
+
+/**
+ * @brief Read data of the old image.
+ *
+ * @param cb_arg[in]        argument passed to cy_delta_init()
+ * @param offset[in]        offset in the old image
+ * @param buffer[out]       buffer for the data
+ * @param size[in]          bytes to read
+ *
+ * @return  0 - OK, other values stop the patch with CY_DELTA_ERROR
+ */
+typedef int (*cy_delta_read_callback_t)(void *cb_arg, uint32_t offset, uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Write data of the new image.
+ *
+ * @param cb_arg[in]        argument passed to cy_delta_init()
+ * @param offset[in]        offset in the new image
+ * @param buffer[in]        new image data
+ * @param size[in]          bytes of data
+ *
+ * @return  0 - OK, other values stop the patch with CY_DELTA_ERROR
+ */
+typedef int (*cy_delta_write_callback_t)(void *cb_arg, uint32_t offset, const uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Patch decoder state.
+ */
+typedef struct cy_delta_decoder_s {
+    cy_delta_state_t            state;                          /**< Current decoding state.                 */
+    uint8_t                     header[CY_DELTA_HEADER_SIZE];   /**< Patch header, collected.                */
+    uint8_t                     header_bytes;                   /**< Bytes in header[].                      */
+    uint8_t                     opcode;                         /**< Command being decoded.                  */
+    uint8_t                     args[CY_DELTA_MAX_ARGS_SIZE];   /**< Command arguments, collected.           */
+    uint8_t                     args_bytes;                     /**< Bytes in args[].                        */
+    uint8_t                     args_size;                      /**< Argument bytes of the command.          */
+    uint32_t                    old_size;                       /**< Old image size from the header.         */
+    uint32_t                    new_size;                       /**< New image size from the header.         */
+    uint32_t                    old_offset;                     /**< Next old offset of the command.         */
+    uint32_t                    remaining;                      /**< Bytes left in the command.              */
+    uint32_t                    new_bytes;                      /**< Bytes of new image produced.            */
+    uint32_t                    input_bytes;                    /**< Bytes of patch used.                    */
+    uint8_t                     *buffer;                        /**< Output buffer, from cy_delta_init().    */
+    uint32_t                    buffer_size;                    /**< Size of buffer.                         */
+    uint32_t                    buffer_fill;                    /**< Bytes in buffer.                        */
+    cy_delta_read_callback_t    read_func;                      /**< Old image read callback.                */
+    cy_delta_write_callback_t   write_func;                     /**< New image write callback.               */
+    void                        *cb_arg;                        /**< Argument for the callbacks.             */
+} cy_delta_decoder_t;
+
+/**
+ * @brief Check for the patch magic.
+ *
+ * @param buffer            start of the stream
+ * @param size              bytes in buffer
+ *
+ * @return  true if the buffer starts with CY_DELTA_MAGIC
+ */
+bool cy_delta_is_patch(const uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Initialize the decoder for a new patch.
+ *
+ * @param decoder           Pointer to the decoder structure.
+ * @param buffer            Output buffer, also used to check the old image.
+ * @param buffer_size       Size of buffer, at least CY_DELTA_MIN_BUFFER_SIZE.
+ * @param read_func         Old image read callback.
+ * @param write_func        New image write callback.
+ * @param cb_arg            Argument for the callbacks.
+ *
+ * @return  CY_DELTA_SUCCESS
+ *          CY_DELTA_ERROR
+ */
+cy_delta_result_t cy_delta_init(cy_delta_decoder_t *decoder, uint8_t *buffer, uint32_t buffer_size,
+                                cy_delta_read_callback_t read_func, cy_delta_write_callback_t write_func, void *cb_arg);
+
+/**
+ * @brief Apply the next piece of the patch.
+ *
+ * NOTE: Call with the patch in order, in pieces of any size. When the header is
+ *       complete, the old image is read once to check its CRC.
+ *
+ * @param decoder           Pointer to the decoder structure; gets updated.
+ * @param data              Next bytes of the patch.
+ * @param size              Bytes in data.
+ *
+ * @return  CY_DELTA_SUCCESS
+ *          CY_DELTA_DONE
+ *          CY_DELTA_WRONG_BASE
+ *          CY_DELTA_ERROR
+ */
+cy_delta_result_t cy_delta_apply(cy_delta_decoder_t *decoder, const uint8_t *data, uint32_t size);
+
+
+#ifdef __cplusplus
+} /*extern "C" */
+#endif
+
+
+#endif  /* DELTA_H__ */
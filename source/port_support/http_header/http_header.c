@@ -0,0 +1,527 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Parse an incoming HTTP response header
+ *
+ * NOTE: The header arrives over the network in pieces of any size, so all parsing
+ *       state is kept in the parser structure and each byte is looked at once.
+ *       Field names are matched as they arrive against the few names we need,
+ *       values of other fields are skipped without being stored.
+ *
+ *       Only standard headers are used so this can also be built on a host.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "http_header.h"
+
+/*************************************************************
+ * Defines and enums
+ ************************************************************/
+#define HTTP_HEADER_STATUS_PREFIX       "HTTP/"
+#define HTTP_HEADER_STATUS_CODE_DIGITS  (3)
+#define HTTP_HEADER_RANGE_UNIT          "bytes"
+
+/* Fields we keep - index into http_header_fields[] */
+#define HTTP_HEADER_FIELD_CONTENT_LENGTH    (0)
+#define HTTP_HEADER_FIELD_CONTENT_RANGE     (1)
+#define HTTP_HEADER_FIELD_ETAG              (2)
+#define HTTP_HEADER_FIELD_RETRY_AFTER       (3)
+#define HTTP_HEADER_FIELD_COUNT             (4)
+#define HTTP_HEADER_FIELD_NONE              (0xFF)
+
+#define HTTP_HEADER_ALL_CANDIDATES          ((1 << HTTP_HEADER_FIELD_COUNT) - 1)
+
+/* Content-Range parts */
+#define HTTP_HEADER_RANGE_PART_UNIT     (0)     /* "bytes"                      */
+#define HTTP_HEADER_RANGE_PART_START    (1)     /* first byte                   */
+#define HTTP_HEADER_RANGE_PART_END      (2)     /* last byte                    */
+#define HTTP_HEADER_RANGE_PART_TOTAL    (3)     /* full size                    */
+#define HTTP_HEADER_RANGE_PART_UNKNOWN  (4)     /* "*" full size not known      */
+#define HTTP_HEADER_RANGE_PART_BAD      (5)     /* not a form we understand     */
+
+/*************************************************************
+ * Data
+ ************************************************************/
+/* lower case, field names are not case sensitive */
+static const char *http_header_fields[HTTP_HEADER_FIELD_COUNT] =
+{
+    "content-length",
+    "content-range",
+    "etag",
+    "retry-after",
+};
+
+/*************************************************************
+ * Static Functions
+ ************************************************************/
+static inline bool http_header_is_space(uint8_t c)
+{
+    return ( (c == ' ') || (c == '\t') );
+}
+
+static inline bool http_header_is_digit(uint8_t c)
+{
+    return ( (c >= '0') && (c <= '9') );
+}
+
+static inline uint8_t http_header_to_lower(uint8_t c)
+{
+    return ( (c >= 'A') && (c <= 'Z') ) ? (uint8_t)(c + ('a' - 'A')) : c;
+}
+
+/**
+ * @brief Add a digit to the number being parsed
+ *
+ * @param parser[in,out]    ptr to the parser
+ * @param c[in]             '0' - '9'
+ *
+ * @return  true  - number still fits
+ *          false - number too large
+ */
+static bool http_header_add_digit(cy_http_header_parser_t *parser, uint8_t c)
+{
+    uint32_t    digit = (uint32_t)(c - '0');
+
+    if ( (parser->digits >= CY_HTTP_HEADER_MAX_DIGITS) ||
+         (parser->number > ((UINT32_MAX - digit) / 10)) )
+    {
+        return false;
+    }
+    parser->number = (parser->number * 10) + digit;
+    parser->digits++;
+    return true;
+}
+
+/**
+ * @brief Match the next field name character against the fields we keep
+ *
+ * @param parser[in,out]    ptr to the parser
+ * @param c[in]             lower case field name character
+ */
+static void http_header_match_name(cy_http_header_parser_t *parser, uint8_t c)
+{
+    uint8_t     index;
+
+    for (index = 0; index < HTTP_HEADER_FIELD_COUNT; index++)
+    {
+        if ( (parser->candidates & (1 << index)) &&
+             (http_header_fields[index][parser->count] != (char)c) )
+        {
+            /* also drops names that already ended, their '\0' never matches */
+            parser->candidates &= (uint8_t)~(1 << index);
+        }
+    }
+    parser->count++;
+}
+
+/**
+ * @brief Start parsing the value of the field whose name just ended
+ *
+ * @param parser[in,out]    ptr to the parser
+ */
+static void http_header_start_value(cy_http_header_parser_t *parser)
+{
+    uint8_t     index;
+
+    parser->field = HTTP_HEADER_FIELD_NONE;
+    for (index = 0; index < HTTP_HEADER_FIELD_COUNT; index++)
+    {
+        if ( (parser->candidates & (1 << index)) &&
+             (http_header_fields[index][parser->count] == '\0') )
+        {
+            parser->field = index;
+            break;
+        }
+    }
+    parser->part = HTTP_HEADER_RANGE_PART_UNIT;
+    parser->count = 0;
+    parser->number = 0;
+    parser->digits = 0;
+}
+
+/**
+ * @brief Parse the next Content-Range value character
+ *
+ * "bytes <start>-<end>/<total>", or "*" for a total that is not known
+ *
+ * @param parser[in,out]    ptr to the parser
+ * @param c[in]             value character, not leading space
+ *
+ * @return  true  - OK
+ *          false - number too large
+ */
+static bool http_header_range_char(cy_http_header_parser_t *parser, uint8_t c)
+{
+    switch (parser->part)
+    {
+    case HTTP_HEADER_RANGE_PART_UNIT:
+        if (parser->count < (sizeof(HTTP_HEADER_RANGE_UNIT) - 1))
+        {
+            if (http_header_to_lower(c) == (uint8_t)HTTP_HEADER_RANGE_UNIT[parser->count])
+            {
+                parser->count++;
+            }
+            else
+            {
+                parser->part = HTTP_HEADER_RANGE_PART_BAD;
+            }
+        }
+        else if (http_header_is_digit(c))
+        {
+            parser->part = HTTP_HEADER_RANGE_PART_START;
+            return http_header_add_digit(parser, c);
+        }
+        else if (!http_header_is_space(c))
+        {
+            parser->part = HTTP_HEADER_RANGE_PART_BAD;
+        }
+        break;
+
+    case HTTP_HEADER_RANGE_PART_START:
+    case HTTP_HEADER_RANGE_PART_END:
+    case HTTP_HEADER_RANGE_PART_TOTAL:
+        if (http_header_is_digit(c))
+        {
+            return http_header_add_digit(parser, c);
+        }
+        if ( (parser->digits > 0) && (parser->part == HTTP_HEADER_RANGE_PART_START) && (c == '-') )
+        {
+            parser->range_start = parser->number;
+            parser->part = HTTP_HEADER_RANGE_PART_END;
+        }
+        else if ( (parser->digits > 0) && (parser->part == HTTP_HEADER_RANGE_PART_END) && (c == '/') )
+        {
+            parser->range_end = parser->number;
+            parser->part = HTTP_HEADER_RANGE_PART_TOTAL;
+        }
+        else if ( (parser->digits == 0) && (parser->part == HTTP_HEADER_RANGE_PART_TOTAL) && (c == '*') )
+        {
+            parser->part = HTTP_HEADER_RANGE_PART_UNKNOWN;
+            parser->digits = 1;
+        }
+        else
+        {
+            parser->part = HTTP_HEADER_RANGE_PART_BAD;
+        }
+        if (parser->part != HTTP_HEADER_RANGE_PART_UNKNOWN)
+        {
+            parser->number = 0;
+            parser->digits = 0;
+        }
+        break;
+
+    case HTTP_HEADER_RANGE_PART_UNKNOWN:
+    default:
+        parser->part = HTTP_HEADER_RANGE_PART_BAD;
+        break;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse the next value character of a field we keep
+ *
+ * @param parser[in,out]    ptr to the parser
+ * @param c[in]             value character, not leading space
+ *
+ * @return  true  - OK
+ *          false - number too large
+ */
+static bool http_header_value_char(cy_http_header_parser_t *parser, uint8_t c)
+{
+    if (!http_header_is_space(c) && (c != '\r'))
+    {
+        parser->value_end = parser->position + 1;
+    }
+    else if (parser->field != HTTP_HEADER_FIELD_CONTENT_RANGE)
+    {
+        /* trailing space, the end of the value is already recorded */
+        return true;
+    }
+
+    switch (parser->field)
+    {
+    case HTTP_HEADER_FIELD_CONTENT_LENGTH:
+    case HTTP_HEADER_FIELD_RETRY_AFTER:
+        if (http_header_is_digit(c) && (parser->part == HTTP_HEADER_RANGE_PART_UNIT))
+        {
+            return http_header_add_digit(parser, c);
+        }
+        /* not a plain number (Retry-After HTTP-date), ignore the field */
+        parser->part = HTTP_HEADER_RANGE_PART_BAD;
+        break;
+
+    case HTTP_HEADER_FIELD_CONTENT_RANGE:
+        if (c == '\r')
+        {
+            break;
+        }
+        if (http_header_is_space(c) && (parser->part != HTTP_HEADER_RANGE_PART_UNIT))
+        {
+            break;
+        }
+        return http_header_range_char(parser, c);
+
+    default:
+        break;
+    }
+    return true;
+}
+
+/**
+ * @brief The value of a field we keep ended, store it
+ *
+ * @param parser[in,out]    ptr to the parser
+ */
+static void http_header_end_value(cy_http_header_parser_t *parser)
+{
+    switch (parser->field)
+    {
+    case HTTP_HEADER_FIELD_CONTENT_LENGTH:
+        if ( (parser->part == HTTP_HEADER_RANGE_PART_UNIT) && (parser->digits > 0) )
+        {
+            parser->has_content_length = true;
+            parser->content_length = parser->number;
+        }
+        break;
+
+    case HTTP_HEADER_FIELD_RETRY_AFTER:
+        if ( (parser->part == HTTP_HEADER_RANGE_PART_UNIT) && (parser->digits > 0) )
+        {
+            parser->has_retry_after = true;
+            parser->retry_after = parser->number;
+        }
+        break;
+
+    case HTTP_HEADER_FIELD_CONTENT_RANGE:
+        if ( (parser->part == HTTP_HEADER_RANGE_PART_TOTAL) && (parser->digits > 0) )
+        {
+            parser->has_content_range = true;
+            parser->range_total = parser->number;
+        }
+        else if (parser->part == HTTP_HEADER_RANGE_PART_UNKNOWN)
+        {
+            parser->has_content_range = true;
+            parser->range_total = 0;
+        }
+        break;
+
+    case HTTP_HEADER_FIELD_ETAG:
+        parser->etag_len = (parser->value_end > parser->etag_offset) ? (parser->value_end - parser->etag_offset) : 0;
+        break;
+
+    default:
+        break;
+    }
+    parser->field = HTTP_HEADER_FIELD_NONE;
+}
+
+/**
+ * @brief Parse one byte of the header
+ *
+ * @param parser[in,out]    ptr to the parser
+ * @param c[in]             next byte
+ *
+ * @return  next state
+ */
+static cy_http_header_state_t http_header_parse_char(cy_http_header_parser_t *parser, uint8_t c)
+{
+    switch (parser->state)
+    {
+    case CY_HTTP_HEADER_STATE_STATUS_PREFIX:
+        if (c != (uint8_t)HTTP_HEADER_STATUS_PREFIX[parser->count])
+        {
+            return CY_HTTP_HEADER_STATE_INVALID;
+        }
+        parser->count++;
+        if (parser->count < (sizeof(HTTP_HEADER_STATUS_PREFIX) - 1))
+        {
+            return CY_HTTP_HEADER_STATE_STATUS_PREFIX;
+        }
+        parser->count = 0;
+        return CY_HTTP_HEADER_STATE_STATUS_VERSION;
+
+    case CY_HTTP_HEADER_STATE_STATUS_VERSION:
+        if (http_header_is_digit(c) || (c == '.'))
+        {
+            return CY_HTTP_HEADER_STATE_STATUS_VERSION;
+        }
+        if (c == ' ')
+        {
+            return CY_HTTP_HEADER_STATE_STATUS_SPACE;
+        }
+        return CY_HTTP_HEADER_STATE_INVALID;
+
+    case CY_HTTP_HEADER_STATE_STATUS_SPACE:
+        if (c == ' ')
+        {
+            return CY_HTTP_HEADER_STATE_STATUS_SPACE;
+        }
+        /* fall through */
+    case CY_HTTP_HEADER_STATE_STATUS_CODE:
+        if (parser->count < HTTP_HEADER_STATUS_CODE_DIGITS)
+        {
+            if (!http_header_is_digit(c))
+            {
+                return CY_HTTP_HEADER_STATE_INVALID;
+            }
+            parser->status_code = (uint16_t)((parser->status_code * 10) + (c - '0'));
+            parser->count++;
+            return CY_HTTP_HEADER_STATE_STATUS_CODE;
+        }
+        if (c == '\n')
+        {
+            return CY_HTTP_HEADER_STATE_LINE_START;
+        }
+        if ( (c == ' ') || (c == '\r') )
+        {
+            return CY_HTTP_HEADER_STATE_STATUS_REASON;
+        }
+        return CY_HTTP_HEADER_STATE_INVALID;
+
+    case CY_HTTP_HEADER_STATE_STATUS_REASON:
+    case CY_HTTP_HEADER_STATE_SKIP_LINE:
+        return (c == '\n') ? CY_HTTP_HEADER_STATE_LINE_START : parser->state;
+
+    case CY_HTTP_HEADER_STATE_LINE_START:
+        if (c == '\r')
+        {
+            return CY_HTTP_HEADER_STATE_END_LF;
+        }
+        if (c == '\n')
+        {
+            return CY_HTTP_HEADER_STATE_DONE;
+        }
+        if (http_header_is_space(c))
+        {
+            /* obsolete line folding, continuation of a value we do not use */
+            return CY_HTTP_HEADER_STATE_SKIP_LINE;
+        }
+        parser->candidates = HTTP_HEADER_ALL_CANDIDATES;
+        parser->count = 0;
+        /* fall through */
+    case CY_HTTP_HEADER_STATE_NAME:
+        if (c == ':')
+        {
+            http_header_start_value(parser);
+            return CY_HTTP_HEADER_STATE_VALUE_SPACE;
+        }
+        if ( (c == '\r') || (c == '\n') || http_header_is_space(c) )
+        {
+            return CY_HTTP_HEADER_STATE_INVALID;
+        }
+        if (parser->candidates != 0)
+        {
+            http_header_match_name(parser, http_header_to_lower(c));
+        }
+        return CY_HTTP_HEADER_STATE_NAME;
+
+    case CY_HTTP_HEADER_STATE_VALUE_SPACE:
+        if (http_header_is_space(c))
+        {
+            return CY_HTTP_HEADER_STATE_VALUE_SPACE;
+        }
+        if (parser->field == HTTP_HEADER_FIELD_ETAG)
+        {
+            parser->etag_offset = parser->position;
+            parser->value_end = parser->position;
+        }
+        /* fall through */
+    case CY_HTTP_HEADER_STATE_VALUE:
+        if (c == '\n')
+        {
+            http_header_end_value(parser);
+            return CY_HTTP_HEADER_STATE_LINE_START;
+        }
+        if (parser->field == HTTP_HEADER_FIELD_NONE)
+        {
+            return CY_HTTP_HEADER_STATE_SKIP_LINE;
+        }
+        if (!http_header_value_char(parser, c))
+        {
+            return CY_HTTP_HEADER_STATE_INVALID;
+        }
+        return CY_HTTP_HEADER_STATE_VALUE;
+
+    case CY_HTTP_HEADER_STATE_END_LF:
+        return (c == '\n') ? CY_HTTP_HEADER_STATE_DONE : CY_HTTP_HEADER_STATE_INVALID;
+
+    case CY_HTTP_HEADER_STATE_DONE:
+    case CY_HTTP_HEADER_STATE_INVALID:
+    default:
+        break;
+    }
+    return parser->state;
+}
+
+/*************************************************************
+ * Public Functions
+ ************************************************************/
+
+void cy_http_header_init(cy_http_header_parser_t *parser)
+{
+    if (parser == NULL)
+    {
+        return;
+    }
+    memset(parser, 0x00, sizeof(cy_http_header_parser_t));
+    parser->state = CY_HTTP_HEADER_STATE_STATUS_PREFIX;
+    parser->field = HTTP_HEADER_FIELD_NONE;
+}
+
+cy_http_header_result_t cy_http_header_parse(cy_http_header_parser_t *parser, const uint8_t *data, uint32_t size, uint32_t *consumed)
+{
+    uint32_t    index;
+
+    if (consumed != NULL)
+    {
+        *consumed = 0;
+    }
+    if ( (parser == NULL) || ( (data == NULL) && (size > 0) ) )
+    {
+        return CY_HTTP_HEADER_INVALID;
+    }
+
+    for (index = 0; index < size; index++)
+    {
+        if ( (parser->state == CY_HTTP_HEADER_STATE_DONE) || (parser->state == CY_HTTP_HEADER_STATE_INVALID) )
+        {
+            break;
+        }
+        parser->state = http_header_parse_char(parser, data[index]);
+        parser->position++;
+    }
+
+    if (consumed != NULL)
+    {
+        *consumed = index;
+    }
+
+    if (parser->state == CY_HTTP_HEADER_STATE_DONE)
+    {
+        parser->header_len = parser->position;
+        return CY_HTTP_HEADER_DONE;
+    }
+    if (parser->state == CY_HTTP_HEADER_STATE_INVALID)
+    {
+        return CY_HTTP_HEADER_INVALID;
+    }
+    return CY_HTTP_HEADER_NEED_MORE;
+}
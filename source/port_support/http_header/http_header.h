@@ -0,0 +1,132 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Cypress incremental HTTP response header parser.
+ *
+ */
+
+#ifndef HTTP_HEADER_H__
+#define HTTP_HEADER_H__   1
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Incremental HTTP/1.x response header parser
+ *
+ * The response header is parsed in one pass, one byte at a time, as it arrives.
+ * It may be handed to cy_http_header_parse() in any number of pieces, split anywhere.
+ * Nothing is copied: numeric fields are converted on the fly, and the ETag value is
+ * reported as an offset from the first byte given to the parser, so a caller that
+ * receives the header into one buffer can use it in place.
+ *
+ * Fields kept:
+ *      status code
+ *      Content-Length
+ *      Content-Range   "bytes <start>-<end>/<total>"
+ *      ETag
+ *      Retry-After     delta-seconds form only
+ */
+
+#define CY_HTTP_HEADER_MAX_DIGITS   (10)        /**< Longer numbers are rejected. */
+
+typedef enum {
+    CY_HTTP_HEADER_NEED_MORE    = 0,            /**< Header not complete, all data consumed.  */
+    CY_HTTP_HEADER_DONE,                        /**< Header complete, body starts after consumed bytes. */
+    CY_HTTP_HEADER_INVALID,                     /**< Not an HTTP response header.             */
+} cy_http_header_result_t;
+
+typedef enum {
+    CY_HTTP_HEADER_STATE_STATUS_PREFIX = 0,     /**< "HTTP/"                                  */
+    CY_HTTP_HEADER_STATE_STATUS_VERSION,        /**< "1.1"                                    */
+    CY_HTTP_HEADER_STATE_STATUS_SPACE,          /**< spaces before the status code            */
+    CY_HTTP_HEADER_STATE_STATUS_CODE,           /**< three digits                             */
+    CY_HTTP_HEADER_STATE_STATUS_REASON,         /**< reason phrase up to the end of the line  */
+    CY_HTTP_HEADER_STATE_LINE_START,            /**< field name, or the empty line            */
+    CY_HTTP_HEADER_STATE_NAME,                  /**< field name up to ':'                     */
+    CY_HTTP_HEADER_STATE_VALUE_SPACE,           /**< spaces before the field value            */
+    CY_HTTP_HEADER_STATE_VALUE,                 /**< field value up to the end of the line    */
+    CY_HTTP_HEADER_STATE_SKIP_LINE,             /**< line we do not need                      */
+    CY_HTTP_HEADER_STATE_END_LF,                /**< LF of the empty line                     */
+    CY_HTTP_HEADER_STATE_DONE,                  /**< header complete                          */
+    CY_HTTP_HEADER_STATE_INVALID,               /**< header invalid                           */
+} cy_http_header_state_t;
+
+/**
+ * @brief Parser state and the fields found so far.
+ */
+typedef struct cy_http_header_parser_s {
+    cy_http_header_state_t  state;              /**< Current parsing state.                           */
+    uint8_t                 field;              /**< Field being parsed, index of a known field name.  */
+    uint8_t                 candidates;         /**< Known field names still matching the name.       */
+    uint8_t                 part;               /**< Content-Range number being parsed.              */
+    uint8_t                 digits;             /**< Digits in the number being parsed.              */
+    uint16_t                count;              /**< Characters of the prefix, code or name so far.   */
+    uint32_t                position;           /**< Bytes parsed since cy_http_header_init().        */
+    uint32_t                number;             /**< Number being parsed.                            */
+    uint32_t                value_end;          /**< Position after the last non-space value byte.   */
+
+    uint16_t                status_code;        /**< Status code, 200 for "HTTP/1.1 200 OK".          */
+    uint32_t                header_len;         /**< Bytes of header including the empty line, when done. */
+    bool                    has_content_length; /**< true if Content-Length was found.               */
+    uint32_t                content_length;     /**< Content-Length value.                           */
+    bool                    has_content_range;  /**< true if a complete Content-Range was found.     */
+    uint32_t                range_start;        /**< First byte in Content-Range.                     */
+    uint32_t                range_end;          /**< Last byte in Content-Range.                      */
+    uint32_t                range_total;        /**< Full size in Content-Range, 0 for "*".           */
+    uint32_t                etag_offset;        /**< Position of the ETag value.                     */
+    uint32_t                etag_len;           /**< Length of the ETag value, 0 if none.             */
+    bool                    has_retry_after;    /**< true if Retry-After in seconds was found.       */
+    uint32_t                retry_after;        /**< Retry-After value in seconds.                   */
+} cy_http_header_parser_t;
+
+/**
+ * @brief Initialize the parser for a new response.
+ *
+ * @param parser            Pointer to the parser structure.
+ */
+void cy_http_header_init(cy_http_header_parser_t *parser);
+
+/**
+ * @brief Parse the next piece of the response.
+ *
+ * NOTE: This is meant to be called for each piece of data received, until it
+ *       returns CY_HTTP_HEADER_DONE or CY_HTTP_HEADER_INVALID.
+ *
+ * @param parser            Pointer to the parser structure; gets updated.
+ * @param data              Next bytes of the response.
+ * @param size              Bytes in data.
+ * @param consumed          Bytes of data that belong to the header.
+ *                          When done, the body starts at data + consumed.
+ *
+ * @return  CY_HTTP_HEADER_NEED_MORE
+ *          CY_HTTP_HEADER_DONE
+ *          CY_HTTP_HEADER_INVALID
+ */
+cy_http_header_result_t cy_http_header_parse(cy_http_header_parser_t *parser, const uint8_t *data, uint32_t size, uint32_t *consumed);
+
+
+#ifdef __cplusplus
+} /*extern "C" */
+#endif
+
+
+#endif  /* HTTP_HEADER_H__ */
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Decode an incoming LZSS compressed stream
+ *
+ * NOTE: The compressed stream arrives in pieces of any size, so all decoding
+ *       state is kept in the decoder structure. The output window is the only
+ *       large buffer: a match copies from it, and each time it fills it is handed
+ *       to the write callback before it is overwritten.
+ *
+ *       Only standard headers are used so this can also be built on a host.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "lzss.h"
+
+/*************************************************************
+ * Defines and enums
+ ************************************************************/
+#define LZSS_HEADER_VERSION_OFFSET      (4)
+#define LZSS_HEADER_WINDOW_BITS_OFFSET  (5)
+#define LZSS_HEADER_SIZE_OFFSET         (8)
+
+#define LZSS_FLAG_BITS                  (8)
+
+/*************************************************************
+ * Static Functions
+ ************************************************************/
+
+/**
+ * @brief Hand the output not yet written to the callback
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ *
+ * @return  true  - OK
+ *          false - callback failed
+ */
+static bool lzss_write_output(cy_lzss_decoder_t *decoder)
+{
+    uint32_t    start = decoder->output_written & decoder->window_mask;
+    uint32_t    size = decoder->output_bytes - decoder->output_written;
+
+    if (size == 0)
+    {
+        return true;
+    }
+    if (decoder->cb_func(decoder->cb_arg, decoder->output_written, &decoder->window[start], size) != 0)
+    {
+        return false;
+    }
+    decoder->output_written = decoder->output_bytes;
+    return true;
+}
+
+/**
+ * @brief Add one byte of output
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ * @param c[in]             output byte
+ *
+ * @return  true  - OK
+ *          false - callback failed
+ */
+static inline bool lzss_put(cy_lzss_decoder_t *decoder, uint8_t c)
+{
+    decoder->window[decoder->output_bytes & decoder->window_mask] = c;
+    decoder->output_bytes++;
+
+    /* window full, or end of the stream */
+    if ( ((decoder->output_bytes & decoder->window_mask) == 0) ||
+         (decoder->output_bytes == decoder->output_size) )
+    {
+        return lzss_write_output(decoder);
+    }
+    return true;
+}
+
+/**
+ * @brief Check and use the stream header
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ *
+ * @return  next state
+ */
+static cy_lzss_state_t lzss_process_header(cy_lzss_decoder_t *decoder)
+{
+    const uint8_t   *header = decoder->header;
+    uint8_t         window_bits = header[LZSS_HEADER_WINDOW_BITS_OFFSET];
+
+    if ( (memcmp(header, CY_LZSS_MAGIC, CY_LZSS_MAGIC_LEN) != 0) ||
+         (header[LZSS_HEADER_VERSION_OFFSET] != CY_LZSS_VERSION) ||
+         (window_bits < CY_LZSS_MIN_WINDOW_BITS) || (window_bits > CY_LZSS_MAX_WINDOW_BITS) ||
+         ((1UL << window_bits) > decoder->window_size) )
+    {
+        return CY_LZSS_STATE_ERROR;
+    }
+
+    decoder->window_bits = window_bits;
+    decoder->window_mask = (1UL << window_bits) - 1;
+    decoder->output_size = (uint32_t)header[LZSS_HEADER_SIZE_OFFSET] |
+                           ((uint32_t)header[LZSS_HEADER_SIZE_OFFSET + 1] << 8) |
+                           ((uint32_t)header[LZSS_HEADER_SIZE_OFFSET + 2] << 16) |
+                           ((uint32_t)header[LZSS_HEADER_SIZE_OFFSET + 3] << 24);
+
+    return (decoder->output_size == 0) ? CY_LZSS_STATE_DONE : CY_LZSS_STATE_FLAGS;
+}
+
+/**
+ * @brief Copy a match to the output
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ * @param code[in]          match code from the stream
+ *
+ * @return  next state
+ */
+static cy_lzss_state_t lzss_process_match(cy_lzss_decoder_t *decoder, uint16_t code)
+{
+    uint32_t    distance = (uint32_t)(code & decoder->window_mask) + 1;
+    uint32_t    length = (uint32_t)(code >> decoder->window_bits) + CY_LZSS_MIN_MATCH;
+    uint32_t    from;
+
+    if ( (distance > decoder->output_bytes) ||
+         (length > (decoder->output_size - decoder->output_bytes)) )
+    {
+        return CY_LZSS_STATE_ERROR;
+    }
+
+    from = decoder->output_bytes - distance;
+    while (length-- > 0)
+    {
+        if (!lzss_put(decoder, decoder->window[from & decoder->window_mask]))
+        {
+            return CY_LZSS_STATE_ERROR;
+        }
+        from++;
+    }
+    return CY_LZSS_STATE_FLAGS;
+}
+
+/**
+ * @brief An item is complete, find what comes next
+ *
+ * @param decoder[in,out]   ptr to the decoder
+ *
+ * @return  next state
+ */
+static cy_lzss_state_t lzss_next_item(cy_lzss_decoder_t *decoder)
+{
+    if (decoder->output_bytes == decoder->output_size)
+    {
+        return CY_LZSS_STATE_DONE;
+    }
+    if (--decoder->flag_count == 0)
+    {
+        return CY_LZSS_STATE_FLAGS;
+    }
+    decoder->flags >>= 1;
+    return (decoder->flags & 0x01) ? CY_LZSS_STATE_LITERAL : CY_LZSS_STATE_MATCH_LOW;
+}
+
+/*************************************************************
+ * Public Functions
+ ************************************************************/
+
+bool cy_lzss_is_compressed(const uint8_t *buffer, uint32_t size)
+{
+    return ( (buffer != NULL) && (size >= CY_LZSS_MAGIC_LEN) &&
+             (memcmp(buffer, CY_LZSS_MAGIC, CY_LZSS_MAGIC_LEN) == 0) );
+}
+
+cy_lzss_result_t cy_lzss_init(cy_lzss_decoder_t *decoder, uint8_t *window, uint32_t window_size,
+                              cy_lzss_write_callback_t cb_func, void *cb_arg)
+{
+    if ( (decoder == NULL) || (window == NULL) || (cb_func == NULL) ||
+         (window_size < (1UL << CY_LZSS_MIN_WINDOW_BITS)) || ((window_size & (window_size - 1)) != 0) )
+    {
+        return CY_LZSS_ERROR;
+    }
+
+    memset(decoder, 0x00, sizeof(cy_lzss_decoder_t));
+    decoder->state       = CY_LZSS_STATE_HEADER;
+    decoder->window      = window;
+    decoder->window_size = window_size;
+    decoder->cb_func     = cb_func;
+    decoder->cb_arg      = cb_arg;
+    return CY_LZSS_SUCCESS;
+}
+
+cy_lzss_result_t cy_lzss_decode(cy_lzss_decoder_t *decoder, const uint8_t *buffer, uint32_t size)
+{
+    uint32_t    index;
+
+    if ( (decoder == NULL) || ( (buffer == NULL) && (size > 0) ) )
+    {
+        return CY_LZSS_ERROR;
+    }
+
+    for (index = 0; (index < size) && (decoder->state < CY_LZSS_STATE_DONE); index++)
+    {
+        uint8_t c = buffer[index];
+
+        switch (decoder->state)
+        {
+        case CY_LZSS_STATE_HEADER:
+            decoder->header[decoder->header_bytes++] = c;
+            if (decoder->header_bytes == CY_LZSS_HEADER_SIZE)
+            {
+                decoder->state = lzss_process_header(decoder);
+            }
+            break;
+
+        case CY_LZSS_STATE_FLAGS:
+            decoder->flags = c;
+            decoder->flag_count = LZSS_FLAG_BITS;
+            decoder->state = (decoder->flags & 0x01) ? CY_LZSS_STATE_LITERAL : CY_LZSS_STATE_MATCH_LOW;
+            break;
+
+        case CY_LZSS_STATE_LITERAL:
+            decoder->state = lzss_put(decoder, c) ? lzss_next_item(decoder) : CY_LZSS_STATE_ERROR;
+            break;
+
+        case CY_LZSS_STATE_MATCH_LOW:
+            decoder->match_low = c;
+            decoder->state = CY_LZSS_STATE_MATCH_HIGH;
+            break;
+
+        case CY_LZSS_STATE_MATCH_HIGH:
+            decoder->state = lzss_process_match(decoder, (uint16_t)(decoder->match_low | (c << 8)));
+            if (decoder->state != CY_LZSS_STATE_ERROR)
+            {
+                decoder->state = lzss_next_item(decoder);
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+    decoder->input_bytes += index;
+
+    if (decoder->state == CY_LZSS_STATE_DONE)
+    {
+        return CY_LZSS_DONE;
+    }
+    if (decoder->state == CY_LZSS_STATE_ERROR)
+    {
+        return CY_LZSS_ERROR;
+    }
+    return CY_LZSS_SUCCESS;
+}
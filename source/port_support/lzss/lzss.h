@@ -0,0 +1,158 @@
+/*
+ * Copyright 2022, Cypress Semiconductor Corporation (an Infineon company)
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Cypress streaming LZSS decoder.
+ *
+ */
+
+#ifndef LZSS_H__
+#define LZSS_H__   1
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Compressed stream format, see scripts/ota_compress.py
+ *
+ * Header, CY_LZSS_HEADER_SIZE bytes:
+ *                                  offset  size
+ *      magic "CYLZ"                 0       4
+ *      format version (1)           4       1
+ *      window bits (8 - 12)         5       1
+ *      reserved (0)                 6       2
+ *      uncompressed size            8       4       little endian
+ *
+ * Followed by groups of one flag byte and 8 items, flag bits LSB first:
+ *      1 - one literal byte
+ *      0 - a match, 2 bytes little endian:
+ *              low <window bits> bits      distance - 1
+ *              high bits                   length - CY_LZSS_MIN_MATCH
+ *
+ * The decoder keeps the last (1 << window bits) bytes of output in a window,
+ * and hands each window of output to the write callback when it is full, and
+ * the last part at the end of the stream. Output is handed over in order.
+ */
+
+#define CY_LZSS_MAGIC               "CYLZ"
+#define CY_LZSS_MAGIC_LEN           (4)
+#define CY_LZSS_VERSION             (1)
+#define CY_LZSS_HEADER_SIZE         (12)
+#define CY_LZSS_MIN_WINDOW_BITS     (8)
+#define CY_LZSS_MAX_WINDOW_BITS     (12)
+#define CY_LZSS_MIN_MATCH           (3)
+
+typedef enum {
+    CY_LZSS_SUCCESS = 0,                        /**< Data used, more output expected.         */
+    CY_LZSS_DONE,                               /**< All output produced and written.         */
+    CY_LZSS_ERROR,                              /**< Stream is invalid, or the write failed.   */
+} cy_lzss_result_t;
+
+typedef enum {
+    CY_LZSS_STATE_HEADER = 0,                   /**< Collecting the stream header             */
+    CY_LZSS_STATE_FLAGS,                        /**< Next byte is a flag byte                 */
+    CY_LZSS_STATE_LITERAL,                      /**< Next byte is a literal                   */
+    CY_LZSS_STATE_MATCH_LOW,                    /**< Next byte is the low byte of a match     */
+    CY_LZSS_STATE_MATCH_HIGH,                   /**< Next byte is the high byte of a match    */
+    CY_LZSS_STATE_DONE,                         /**< All output produced                      */
+    CY_LZSS_STATE_ERROR,                        /**< Stream is invalid                        */
+} cy_lzss_state_t;
+
+/**
+ * @brief Called with each piece of output.
+ *
+ * @param cb_arg[in]        argument passed to cy_lzss_init()
+ * @param offset[in]        offset of the data in the uncompressed output
+ * @param buffer[in]        output data
+ * @param size[in]          bytes of output data
+ *
+ * @return  0 - OK, other values stop decoding with CY_LZSS_ERROR
+ */
+typedef int (*cy_lzss_write_callback_t)(void *cb_arg, uint32_t offset, const uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Decoder state.
+ */
+typedef struct cy_lzss_decoder_s {
+    cy_lzss_state_t             state;                          /**< Current decoding state.                     */
+    uint8_t                     header[CY_LZSS_HEADER_SIZE];    /**< Stream header, collected.                   */
+    uint8_t                     header_bytes;                   /**< Bytes in header[].                          */
+    uint8_t                     window_bits;                    /**< Window bits from the stream header.         */
+    uint8_t                     flags;                          /**< Current flag byte, shifted.                 */
+    uint8_t                     flag_count;                     /**< Items left for the current flag byte.       */
+    uint8_t                     match_low;                      /**< Low byte of the match being read.           */
+    uint8_t                     *window;                        /**< Output window, from cy_lzss_init().         */
+    uint32_t                    window_size;                    /**< Size of window, from cy_lzss_init().        */
+    uint32_t                    window_mask;                    /**< (1 << window_bits) - 1.                     */
+    uint32_t                    output_size;                    /**< Uncompressed size from the stream header.   */
+    uint32_t                    output_bytes;                   /**< Bytes of output produced.                   */
+    uint32_t                    output_written;                 /**< Bytes of output handed to the callback.     */
+    uint32_t                    input_bytes;                    /**< Bytes of compressed stream used.            */
+    cy_lzss_write_callback_t    cb_func;                        /**< Output callback.                            */
+    void                        *cb_arg;                        /**< Argument for the output callback.           */
+} cy_lzss_decoder_t;
+
+/**
+ * @brief Check for the compressed stream magic.
+ *
+ * @param buffer            start of the stream
+ * @param size              bytes in buffer
+ *
+ * @return  true if the buffer starts with CY_LZSS_MAGIC
+ */
+bool cy_lzss_is_compressed(const uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Initialize the decoder for a new stream.
+ *
+ * @param decoder           Pointer to the decoder structure.
+ * @param window            Output window, at least (1 << window bits) of the stream.
+ * @param window_size       Size of window, a power of 2.
+ * @param cb_func           Output callback.
+ * @param cb_arg            Argument for the output callback.
+ *
+ * @return  CY_LZSS_SUCCESS
+ *          CY_LZSS_ERROR
+ */
+cy_lzss_result_t cy_lzss_init(cy_lzss_decoder_t *decoder, uint8_t *window, uint32_t window_size,
+                              cy_lzss_write_callback_t cb_func, void *cb_arg);
+
+/**
+ * @brief Decode the next piece of the compressed stream.
+ *
+ * NOTE: Call with the stream in order, in pieces of any size.
+ *
+ * @param decoder           Pointer to the decoder structure; gets updated.
+ * @param buffer            Next bytes of the compressed stream.
+ * @param size              Bytes in buffer.
+ *
+ * @return  CY_LZSS_SUCCESS
+ *          CY_LZSS_DONE
+ *          CY_LZSS_ERROR
+ */
+cy_lzss_result_t cy_lzss_decode(cy_lzss_decoder_t *decoder, const uint8_t *buffer, uint32_t size);
+
+
+#ifdef __cplusplus
+} /*extern "C" */
+#endif
+
+
+#endif  /* LZSS_H__ */